@@ -0,0 +1,637 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "nandftl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*===========================================================================*/
+/* Simulated NAND and FTL.                                                   */
+/*===========================================================================*/
+
+#define NAND_BLOCKS_COUNT         128
+#define NAND_PAGE_DATA_SIZE       2048
+#define NAND_PAGE_SPARE_SIZE      64
+#define NAND_PAGE_SIZE            (NAND_PAGE_SPARE_SIZE + NAND_PAGE_DATA_SIZE)
+#define NAND_PAGES_PER_BLOCK      64
+
+#define FTL_RESERVED_BLOCKS       8
+#define FTL_SECTORS               NANDFTL_SECTORS(NAND_BLOCKS_COUNT,        \
+                                                  FTL_RESERVED_BLOCKS,      \
+                                                  NAND_PAGES_PER_BLOCK)
+
+#define GC_STACK_SIZE             4096
+#define GC_PRIORITY               (NORMALPRIO - 1)
+
+static uint8_t nand_array[NANDSIM_ARRAY_SIZE(1, 1, NAND_BLOCKS_COUNT,
+                                             NAND_PAGES_PER_BLOCK,
+                                             NAND_PAGE_SIZE)];
+static uint32_t nand_erase_counts[NAND_BLOCKS_COUNT];
+
+/*
+ * Simulated device timings, a 2kB page SLC NAND on a 40MB/s bus.
+ */
+static const nandsim_timing_t nand_timing = {
+  .read_ns = 25000,
+  .prog_ns = 200000,
+  .erase_ns = 2000000,
+  .byte_ns = 25
+};
+
+static const NANDConfig nandcfg = {
+  .dies = 1,
+  .loguns = 1,
+  .planes = 1,
+  .blocks = NAND_BLOCKS_COUNT,
+  .page_data_size = NAND_PAGE_DATA_SIZE,
+  .page_spare_size = NAND_PAGE_SPARE_SIZE,
+  .pages_per_block = NAND_PAGES_PER_BLOCK,
+  .rowcycles = 3,
+  .colcycles = 2,
+  .extended_cmds = true,
+  .array = nand_array,
+  .erase_counts = nand_erase_counts,
+  .endurance = 0,
+  .timing = &nand_timing
+};
+
+static NandFTL ftl;
+static uint32_t ftl_map[FTL_SECTORS];
+static nandftl_block_t ftl_blocks[NAND_BLOCKS_COUNT];
+static uint16_t ftl_buffer[NAND_PAGE_SIZE / 2];
+
+static NandFTLConfig ftlcfg = {
+  .nandp = &NANDD1,
+  .first_block = 0,
+  .blocks = NAND_BLOCKS_COUNT,
+  .reserved_blocks = FTL_RESERVED_BLOCKS,
+  .wl_threshold = 0,
+  .gc_target = 4,
+  .map = ftl_map,
+  .blkinfo = ftl_blocks,
+  .buffer = (uint8_t *)ftl_buffer,
+  .ecc = NULL
+};
+
+/*
+ * Stamp of the last write of each sector, zero if never written.
+ */
+static uint32_t ref[FTL_SECTORS];
+static uint32_t stamp;
+static uint8_t wbuf[NAND_PAGE_DATA_SIZE];
+static uint8_t rbuf[NAND_PAGE_DATA_SIZE];
+
+/*
+ * Fills a sector with a pattern depending on the sector and on the stamp.
+ */
+static void fill(uint8_t *p, uint32_t sector, uint32_t s) {
+
+  uint32_t i, v;
+
+  for (i = 0; i < NAND_PAGE_DATA_SIZE; i += 4) {
+    v = (s * 2654435761U) ^ (sector << 12) ^ i;
+    memcpy(&p[i], &v, 4);
+  }
+}
+
+/*
+ * Powers the NAND and the FTL up again, the FTL is mounted from the array.
+ */
+static void power_up(void) {
+
+  NANDD1.power_cut = 0;
+  if (ftl.state != BLK_STOP)
+    nandftlStop(&ftl);
+  nandStart(&NANDD1, &nandcfg, NULL);
+  nandftlStart(&ftl, &ftlcfg);
+  if (ftl.state != BLK_READY)
+    chSysHalt("ERROR: FTL mount failed");
+}
+
+/*
+ * Reads all the sectors back. The sector being written when the power went
+ * away can hold either the previous or the new data.
+ */
+static void verify(uint32_t inflight, uint32_t inflight_stamp) {
+
+  uint32_t i;
+
+  for (i = 0; i < FTL_SECTORS; i++) {
+    if (blkRead(&ftl, i, rbuf, 1) != HAL_SUCCESS)
+      chSysHalt("ERROR: read failed");
+    if (ref[i] == 0) {
+      memset(wbuf, 0xFF, sizeof(wbuf));
+    }
+    else {
+      fill(wbuf, i, ref[i]);
+    }
+    if (memcmp(wbuf, rbuf, sizeof(rbuf)) == 0)
+      continue;
+    fill(wbuf, i, inflight_stamp);
+    if ((i != inflight) || (memcmp(wbuf, rbuf, sizeof(rbuf)) != 0))
+      chSysHalt("ERROR: data mismatch");
+    ref[i] = inflight_stamp;
+  }
+}
+
+/*
+ * Background collector, it runs when the writer sleeps.
+ */
+static THD_WORKING_AREA(gc_wa, GC_STACK_SIZE);
+static THD_FUNCTION(gc_thread, arg) {
+
+  (void)arg;
+
+  chRegSetThreadName("ftl_gc");
+  for (;;) {
+    if (nandftlGarbageCollect(&ftl, 1) == 0)
+      chThdSleepMilliseconds(1);
+  }
+}
+
+/*===========================================================================*/
+/* Write amplification and wear benchmark.                                   */
+/*===========================================================================*/
+
+#define BENCH_WRITES        200000
+#define BENCH_BURST         256
+#define POWER_CUTS          100
+
+typedef enum {
+  PATTERN_UNIFORM,
+  PATTERN_HOT_COLD,
+  PATTERN_STATIC
+} pattern_t;
+
+/*
+ * Picks the next sector to write.
+ * - uniform, any sector.
+ * - hot/cold, 80% of the writes go to 20% of the sectors.
+ * - static, all the writes go to 10% of the sectors.
+ */
+static uint32_t pick(pattern_t pattern) {
+
+  switch (pattern) {
+  case PATTERN_HOT_COLD:
+    if (rand() % 10 < 8)
+      return rand() % (FTL_SECTORS / 5);
+    return FTL_SECTORS / 5 + rand() % (FTL_SECTORS - FTL_SECTORS / 5);
+  case PATTERN_STATIC:
+    return rand() % (FTL_SECTORS / 10);
+  default:
+    return rand() % FTL_SECTORS;
+  }
+}
+
+static void write_sector(uint32_t sector) {
+
+  fill(wbuf, sector, ++stamp);
+  if (blkWrite(&ftl, sector, wbuf, 1) != HAL_SUCCESS)
+    chSysHalt("ERROR: write failed");
+  ref[sector] = stamp;
+}
+
+/*
+ * Fills the device, then rewrites sectors following a pattern, in bursts
+ * separated by pauses where the background collector runs.
+ */
+static void bench_run(const char *name, pattern_t pattern, uint32_t wl) {
+
+  uint32_t i, min, max;
+
+  memset(nand_array, 0xFF, sizeof(nand_array));
+  memset(nand_erase_counts, 0, sizeof(nand_erase_counts));
+  memset(ref, 0, sizeof(ref));
+  ftlcfg.wl_threshold = wl;
+  power_up();
+
+  for (i = 0; i < FTL_SECTORS; i++)
+    write_sector(i);
+
+  nandftlResetStats(&ftl);
+  for (i = 0; i < BENCH_WRITES; i++) {
+    write_sector(pick(pattern));
+    if (i % BENCH_BURST == 0)
+      chThdSleepMilliseconds(2);
+  }
+  verify(FTL_SECTORS, 0);
+
+  min = 0xFFFFFFFFU;
+  max = 0;
+  for (i = 0; i < NAND_BLOCKS_COUNT; i++) {
+    if (nand_erase_counts[i] < min)
+      min = nand_erase_counts[i];
+    if (nand_erase_counts[i] > max)
+      max = nand_erase_counts[i];
+  }
+  fprintf(stdout, "%-24s WA %5.2f, %6lu erases, erase counts %lu..%lu, "
+          "%lu GC and %lu WL copies\r\n", name,
+          (double)ftl.stats.page_writes / ftl.stats.host_writes,
+          (unsigned long)ftl.stats.erases, (unsigned long)min,
+          (unsigned long)max, (unsigned long)ftl.stats.gc_copies,
+          (unsigned long)ftl.stats.wl_copies);
+
+  /* Remount, nothing has to be flushed.*/
+  power_up();
+  verify(FTL_SECTORS, 0);
+}
+
+/*
+ * Cuts the power at random points, in the middle of a program or erase,
+ * then mounts again and checks every sector. Every other cut leaves the
+ * spare area of the page complete, the tag is valid but the data is torn.
+ */
+static void power_cut_test(void) {
+
+  uint32_t cut, torn = 0, sector = 0;
+
+  ftlcfg.wl_threshold = 20;
+  memset(nand_array, 0xFF, sizeof(nand_array));
+  memset(ref, 0, sizeof(ref));
+  power_up();
+
+  for (cut = 0; cut < POWER_CUTS; cut++) {
+    NANDD1.power_cut = 1 + rand() % 5000;
+    NANDD1.power_cut_spare = (cut & 1U) != 0U;
+    while (NANDD1.power_cut != 0xFFFFFFFFU) {
+      sector = pick((pattern_t)(rand() % 3));
+      fill(wbuf, sector, ++stamp);
+      if (blkWrite(&ftl, sector, wbuf, 1) != HAL_SUCCESS)
+        break;
+      ref[sector] = stamp;
+    }
+    power_up();
+    torn += ftl.stats.torn_pages;
+    verify(sector, stamp);
+  }
+  NANDD1.power_cut_spare = false;
+  fprintf(stdout, "%-24s %d power cuts, %u torn pages seen by the mounts, "
+          "all sectors intact\r\n",
+          "power loss", POWER_CUTS, (unsigned)torn);
+}
+
+/*===========================================================================*/
+/* ECC benchmark and bit flips.                                              */
+/*===========================================================================*/
+
+#define ECC_BENCH_SUBPAGES  100000
+#define ECC_FLIP_ROUNDS     10000
+
+static const struct {
+  const char        *name;
+  nandecc_type_t    type;
+} ecc_types[] = {
+  {"Hamming", NANDECC_HAMMING},
+  {"BCH-4", NANDECC_BCH4},
+  {"BCH-8", NANDECC_BCH8}
+};
+
+/*
+ * Codes after the FTL tag, 4 subpages of 7 bytes.
+ */
+static const NandECCConfig ecccfg = {
+  .type = NANDECC_BCH4,
+  .spare_offset = NANDFTL_TAG_OFFSET + NANDFTL_TAG_SIZE
+};
+
+static double mb_per_s(uint32_t subpages, systime_t start) {
+
+  uint32_t ms = TIME_I2MS(chVTTimeElapsedSinceX(start));
+
+  return (double)subpages * NANDECC_SUBPAGE_SIZE / 1000.0 /
+         (ms > 0 ? ms : 1);
+}
+
+/*
+ * Flips n distinct bits of a subpage and of its code.
+ */
+static void flip_bits(uint8_t *data, uint8_t *code, uint32_t codebits,
+                      uint32_t n) {
+
+  uint32_t pos[NANDECC_BCH8 + 2];
+  uint32_t i, j, b;
+
+  for (i = 0; i < n; i++) {
+    do {
+      b = rand() % (NANDECC_SUBPAGE_SIZE * 8 + codebits);
+      for (j = 0; (j < i) && (pos[j] != b); j++)
+        ;
+    } while (j < i);
+    pos[i] = b;
+    if (b < NANDECC_SUBPAGE_SIZE * 8)
+      data[b / 8] ^= 1U << (b % 8);
+    else
+      code[(b - NANDECC_SUBPAGE_SIZE * 8) / 8] ^= 0x80U >> (b % 8);
+  }
+}
+
+/*
+ * Encode and decode throughput, then random bit flips up to the code
+ * strength, which must be corrected, and one more, which must be detected
+ * as far as the code allows.
+ */
+static void ecc_bench(void) {
+
+  uint8_t code[NANDECC_CODE_SIZE(NANDECC_BCH8)];
+  uint8_t flipped[NANDECC_CODE_SIZE(NANDECC_BCH8)];
+  uint32_t i, k, t, n, codebits, detected;
+  double enc, dec;
+  systime_t start;
+
+  nandeccInit();
+  for (k = 0; k < sizeof(ecc_types) / sizeof(ecc_types[0]); k++) {
+    t = (uint32_t)ecc_types[k].type;
+    codebits = (t == 1) ? 24 : 13 * t;
+
+    start = chVTGetSystemTimeX();
+    for (i = 0; i < ECC_BENCH_SUBPAGES; i++) {
+      wbuf[0] = (uint8_t)i;
+      nandeccEncode(ecc_types[k].type, wbuf, code);
+    }
+    enc = mb_per_s(ECC_BENCH_SUBPAGES, start);
+    start = chVTGetSystemTimeX();
+    for (i = 0; i < ECC_BENCH_SUBPAGES; i++) {
+      if (nandeccCorrect(ecc_types[k].type, wbuf, code) != 0)
+        chSysHalt("ERROR: clean subpage corrected");
+    }
+    dec = mb_per_s(ECC_BENCH_SUBPAGES, start);
+
+    detected = 0;
+    start = chVTGetSystemTimeX();
+    for (i = 0; i < ECC_FLIP_ROUNDS; i++) {
+      fill(wbuf, i, ++stamp);
+      nandeccEncode(ecc_types[k].type, wbuf, code);
+      memcpy(rbuf, wbuf, NANDECC_SUBPAGE_SIZE);
+      memcpy(flipped, code, sizeof(code));
+      n = 1 + rand() % t;
+      flip_bits(rbuf, flipped, codebits, n);
+      if ((nandeccCorrect(ecc_types[k].type, rbuf, flipped) != (int32_t)n) ||
+          (memcmp(rbuf, wbuf, NANDECC_SUBPAGE_SIZE) != 0))
+        chSysHalt("ERROR: bit flips not corrected");
+    }
+    fprintf(stdout, "%-24s %2u bytes, encode %6.1f MB/s, decode %6.1f MB/s, "
+            "%5.1f us per corrected subpage\r\n", ecc_types[k].name,
+            (unsigned)NANDECC_CODE_SIZE(t), enc, dec,
+            1000.0 * TIME_I2MS(chVTTimeElapsedSinceX(start)) /
+            ECC_FLIP_ROUNDS);
+
+    for (i = 0; i < ECC_FLIP_ROUNDS; i++) {
+      fill(wbuf, i, ++stamp);
+      nandeccEncode(ecc_types[k].type, wbuf, code);
+      memcpy(flipped, code, sizeof(code));
+      flip_bits(wbuf, flipped, codebits, t + 1);
+      if (nandeccCorrect(ecc_types[k].type, wbuf, flipped) ==
+          NANDECC_UNCORRECTABLE)
+        detected++;
+    }
+    fprintf(stdout, "%-24s %lu of %d subpages with %lu bit flips detected\r\n",
+            "", (unsigned long)detected, ECC_FLIP_ROUNDS,
+            (unsigned long)(t + 1));
+  }
+}
+
+/*
+ * Mounts the FTL with BCH-4, flips up to 4 bits in each subpage of every
+ * written page, then reads everything back, before and after the
+ * collector has moved the pages.
+ */
+static void ecc_ftl_test(void) {
+
+  uint32_t i, s, page;
+  uint8_t *p;
+
+  ftlcfg.wl_threshold = 0;
+  ftlcfg.ecc = &ecccfg;
+  memset(nand_array, 0xFF, sizeof(nand_array));
+  memset(ref, 0, sizeof(ref));
+  power_up();
+
+  for (i = 0; i < FTL_SECTORS; i++)
+    write_sector(i);
+  for (i = 0; i < FTL_SECTORS; i++)
+    write_sector(pick(PATTERN_HOT_COLD));
+
+  for (page = 0; page < NAND_BLOCKS_COUNT * NAND_PAGES_PER_BLOCK; page++) {
+    p = &nand_array[page * NAND_PAGE_SIZE];
+    for (i = 0; i < NANDFTL_TAG_SIZE; i++) {
+      if (p[NAND_PAGE_DATA_SIZE + NANDFTL_TAG_OFFSET + i] != 0xFF)
+        break;
+    }
+    if (i == NANDFTL_TAG_SIZE)
+      continue;
+    for (s = 0; s < NAND_PAGE_DATA_SIZE / NANDECC_SUBPAGE_SIZE; s++) {
+      flip_bits(&p[s * NANDECC_SUBPAGE_SIZE],
+                &p[NAND_PAGE_DATA_SIZE + ecccfg.spare_offset +
+                   s * NANDECC_CODE_SIZE(NANDECC_BCH4)],
+                13 * 4, 1 + rand() % 4);
+    }
+  }
+
+  power_up();
+  verify(FTL_SECTORS, 0);
+  for (i = 0; i < FTL_SECTORS; i++)
+    write_sector(pick(PATTERN_UNIFORM));
+  verify(FTL_SECTORS, 0);
+  fprintf(stdout, "%-24s %lu pages corrected, %lu GC copies, "
+          "%lu CRC errors\r\n", "FTL with BCH-4",
+          (unsigned long)ftl.stats.ecc_corrected,
+          (unsigned long)ftl.stats.gc_copies,
+          (unsigned long)ftl.stats.crc_errors);
+  ftlcfg.ecc = NULL;
+}
+
+/*
+ * Controller code after the FTL tag.
+ */
+static const NandECCConfig hwecccfg = {
+  .type = NANDECC_HAMMING,
+  .spare_offset = NANDFTL_TAG_OFFSET + NANDFTL_TAG_SIZE,
+  .hw = true
+};
+
+/*
+ * Pages written with the code computed by the simulated controller, one
+ * bit flip in the data or in the code must be corrected, two in the data
+ * detected. An erased page reads clean.
+ */
+static void ecc_hw_test(void) {
+
+  uint8_t *p = (uint8_t *)ftl_buffer;
+  uint8_t *a, *flip;
+  uint32_t i, b, page, detected = 0;
+
+  if (ftl.state != BLK_STOP)
+    nandftlStop(&ftl);
+  memset(nand_array, 0xFF, sizeof(nand_array));
+  nandStart(&NANDD1, &nandcfg, NULL);
+
+  for (i = 0; i < ECC_FLIP_ROUNDS; i++) {
+    page = i % (NAND_BLOCKS_COUNT * NAND_PAGES_PER_BLOCK);
+    if ((page % NAND_PAGES_PER_BLOCK) == 0)
+      nandErase(&NANDD1, 0, 0, 0, page / NAND_PAGES_PER_BLOCK);
+    fill(wbuf, i, ++stamp);
+    memcpy(p, wbuf, NAND_PAGE_DATA_SIZE);
+    memset(&p[NAND_PAGE_DATA_SIZE], 0xFF, NAND_PAGE_SPARE_SIZE);
+    if (nandeccWritePage(&NANDD1, &hwecccfg, 0, 0, 0,
+                         page / NAND_PAGES_PER_BLOCK,
+                         page % NAND_PAGES_PER_BLOCK, p) & NAND_STATUS_FAIL)
+      chSysHalt("ERROR: program failed");
+
+    a = &nand_array[page * NAND_PAGE_SIZE];
+    b = rand() % (NAND_PAGE_DATA_SIZE * 8 + 28);
+    if (b < NAND_PAGE_DATA_SIZE * 8)
+      flip = &a[b / 8];
+    else
+      flip = &a[NAND_PAGE_DATA_SIZE + hwecccfg.spare_offset +
+                (b - NAND_PAGE_DATA_SIZE * 8) / 8];
+    *flip ^= 1U << (b % 8);
+    if ((nandeccReadPage(&NANDD1, &hwecccfg, 0, 0, 0,
+                         page / NAND_PAGES_PER_BLOCK,
+                         page % NAND_PAGES_PER_BLOCK, p) != 1) ||
+        (memcmp(p, wbuf, NAND_PAGE_DATA_SIZE) != 0))
+      chSysHalt("ERROR: bit flip not corrected");
+    *flip ^= 1U << (b % 8);
+
+    b = rand() % (NAND_PAGE_DATA_SIZE * 8);
+    a[b / 8] ^= 1U << (b % 8);
+    b = (b + 1 + rand() % (NAND_PAGE_DATA_SIZE * 8 - 1)) %
+        (NAND_PAGE_DATA_SIZE * 8);
+    a[b / 8] ^= 1U << (b % 8);
+    if (nandeccReadPage(&NANDD1, &hwecccfg, 0, 0, 0,
+                        page / NAND_PAGES_PER_BLOCK,
+                        page % NAND_PAGES_PER_BLOCK, p) ==
+        NANDECC_UNCORRECTABLE)
+      detected++;
+  }
+
+  nandErase(&NANDD1, 0, 0, 0, 0);
+  if (nandeccReadPage(&NANDD1, &hwecccfg, 0, 0, 0, 0, 0, p) != 0)
+    chSysHalt("ERROR: erased page corrected");
+
+  fprintf(stdout, "%-24s %d pages corrected, %lu of %d with 2 bit flips "
+          "detected\r\n", "controller Hamming", ECC_FLIP_ROUNDS,
+          (unsigned long)detected, ECC_FLIP_ROUNDS);
+}
+
+/*===========================================================================*/
+/* Cache operations benchmark.                                               */
+/*===========================================================================*/
+
+static uint16_t bench_buf[NAND_PAGES_PER_BLOCK * NAND_PAGE_SIZE / 2];
+
+static void print_rate(const char *name, uint64_t ns) {
+
+  fprintf(stdout, "%-24s %5.1f MB/s\r\n", name,
+          (double)NAND_PAGES_PER_BLOCK * NAND_PAGE_DATA_SIZE * 1000.0 / ns);
+}
+
+/*
+ * Programs and reads a block a page at a time and with the cache
+ * operations, the rates come from the simulated device time.
+ */
+static void cache_bench(void) {
+
+  uint8_t *p = (uint8_t *)bench_buf;
+  uint64_t start;
+  uint32_t i;
+
+  if (ftl.state != BLK_STOP)
+    nandftlStop(&ftl);
+  memset(nand_array, 0xFF, sizeof(nand_array));
+  nandStart(&NANDD1, &nandcfg, NULL);
+  for (i = 0; i < sizeof(bench_buf); i++)
+    p[i] = (uint8_t)rand();
+
+  start = NANDD1.stats.time_ns;
+  for (i = 0; i < NAND_PAGES_PER_BLOCK; i++)
+    nandWritePageWhole(&NANDD1, 0, 0, 0, 0, i, &p[i * NAND_PAGE_SIZE],
+                       NAND_PAGE_SIZE);
+  print_rate("page program", NANDD1.stats.time_ns - start);
+
+  start = NANDD1.stats.time_ns;
+  if (nandWritePagesCached(&NANDD1, 0, 0, 0, 1, 0, p, NAND_PAGE_SIZE,
+                           NAND_PAGES_PER_BLOCK) & NAND_STATUS_FAIL)
+    chSysHalt("ERROR: cache program failed");
+  print_rate("cache program", NANDD1.stats.time_ns - start);
+
+  start = NANDD1.stats.time_ns;
+  for (i = 0; i < NAND_PAGES_PER_BLOCK; i++)
+    nandReadPageWhole(&NANDD1, 0, 0, 0, 1, i, &p[i * NAND_PAGE_SIZE],
+                      NAND_PAGE_SIZE);
+  print_rate("page read", NANDD1.stats.time_ns - start);
+
+  start = NANDD1.stats.time_ns;
+  nandReadPagesCached(&NANDD1, 0, 0, 0, 1, 0, p, NAND_PAGE_SIZE,
+                      NAND_PAGES_PER_BLOCK);
+  print_rate("cache read", NANDD1.stats.time_ns - start);
+
+  /* Both blocks hold the same data.*/
+  if (memcmp(nand_array, &nand_array[sizeof(bench_buf)], sizeof(bench_buf)) ||
+      memcmp(p, nand_array, sizeof(bench_buf)))
+    chSysHalt("ERROR: cache read mismatch");
+}
+
+/*===========================================================================*/
+/* Initialization and main thread.                                           */
+/*===========================================================================*/
+
+/*
+ * Simulator main.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  nandftlObjectInit(&ftl);
+  chThdCreateStatic(gc_wa, sizeof(gc_wa), GC_PRIORITY, gc_thread, NULL);
+
+  bench_run("uniform", PATTERN_UNIFORM, 0);
+  bench_run("hot/cold 80/20", PATTERN_HOT_COLD, 0);
+  bench_run("static 90%", PATTERN_STATIC, 0);
+  bench_run("static 90%, WL 20", PATTERN_STATIC, 20);
+  power_cut_test();
+  ecc_bench();
+  ecc_ftl_test();
+  ecc_hw_test();
+  cache_bench();
+
+  exit(0);
+  return 0;
+}
+
+/*
+ * Critical error function.
+ */
+void halt(const char *reason) {
+
+  fflush(stdout);
+  fputs("\n", stdout);
+  fputs(reason, stderr);
+  fflush(stderr);
+  exit(1);
+}
@@ -17,6 +17,7 @@
 #include "ch.h"
 #include "hal.h"
 #include "tribuf.h"
+#include "nbuf.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -117,6 +118,99 @@ static THD_FUNCTION(reader_thread, arg) {
   }
 }
 
+/*===========================================================================*/
+/* Throughput benchmark.                                                     */
+/*===========================================================================*/
+
+#define BENCH_FRAMES        1000000
+#define BENCH_SLOTS         4
+
+static nbuf_t nbuf;
+static nbuf_slot_t nbuf_slots[BENCH_SLOTS];
+static char nbuf_buffers[BENCH_SLOTS];
+
+/*
+ * Prints the frame rate of a benchmark run.
+ */
+static void bench_report(const char *name, systime_t start, uint32_t frames,
+                         uint32_t dropped) {
+
+  sysinterval_t elapsed = chVTTimeElapsedSinceX(start);
+
+  if (elapsed == (sysinterval_t)0)
+    elapsed = (sysinterval_t)1;
+  fprintf(stdout, "%-24s %10lu frames/s, %lu dropped\r\n", name,
+          (unsigned long)(((uint64_t)frames * CH_CFG_ST_FREQUENCY) / elapsed),
+          (unsigned long)dropped);
+}
+
+/*
+ * Produces and consumes frames in the same thread, so that only the cost of
+ * the buffer handlers is measured.
+ */
+static void benchmark(void) {
+
+  void *const nbuf_ptrs[BENCH_SLOTS] = {
+    &nbuf_buffers[0], &nbuf_buffers[1], &nbuf_buffers[2], &nbuf_buffers[3]
+  };
+  systime_t start;
+  uint32_t i, expected, dropped;
+  char *p;
+
+  /* Triple buffer, every frame is published and consumed.*/
+  tribufObjectInit(&tribuf, &buffers[0], &buffers[1], &buffers[2]);
+  start = chVTGetSystemTimeX();
+  for (i = 0; i < BENCH_FRAMES; ++i) {
+    p = (char *)tribufGetBack(&tribuf);
+    *p = (char)i;
+    tribufSwapBack(&tribuf);
+    tribufWaitReady(&tribuf);
+    tribufSwapFront(&tribuf);
+    p = (char *)tribufGetFront(&tribuf);
+    (void)*p;
+  }
+  bench_report("tribuf", start, BENCH_FRAMES, 0);
+
+  /* N-buffer, every frame is published and consumed.*/
+  nbufObjectInit(&nbuf, nbuf_slots, nbuf_ptrs, BENCH_SLOTS, NBUF_BLOCK);
+  start = chVTGetSystemTimeX();
+  for (i = 0; i < BENCH_FRAMES; ++i) {
+    p = (char *)nbufGetBack(&nbuf);
+    *p = (char)i;
+    nbufSwapBack(&nbuf);
+    p = (char *)nbufSwapFront(&nbuf);
+    (void)*p;
+  }
+  bench_report("nbuf block", start, BENCH_FRAMES, 0);
+
+  /* N-buffer, two frames published per consumed one, the sequence numbers
+     are checked against the drop counter.*/
+  nbufObjectInit(&nbuf, nbuf_slots, nbuf_ptrs, BENCH_SLOTS, NBUF_DROP_OLDEST);
+  start = chVTGetSystemTimeX();
+  expected = 0;
+  dropped = 0;
+  for (i = 0; i < BENCH_FRAMES; ++i) {
+    p = (char *)nbufGetBack(&nbuf);
+    *p = (char)i;
+    nbufSwapBack(&nbuf);
+    if ((i & 1U) != 0U) {
+      uint32_t seq;
+
+      chSysLock();
+      (void)nbufSwapFrontI(&nbuf);
+      seq = nbufGetFrontSeqI(&nbuf);
+      chSysUnlock();
+      dropped += seq - expected;
+      expected = seq + 1U;
+    }
+  }
+  chSysLock();
+  if (dropped != nbufGetDroppedI(&nbuf))
+    chSysHalt("ERROR: benchmark() sequence numbers mismatch");
+  chSysUnlock();
+  bench_report("nbuf drop-oldest", start, BENCH_FRAMES, dropped);
+}
+
 /*===========================================================================*/
 /* Initialization and main thread.                                           */
 /*===========================================================================*/
@@ -136,6 +230,11 @@ int main(void) {
   halInit();
   chSysInit();
 
+  /*
+   * Buffer handlers throughput comparison.
+   */
+  benchmark();
+
   /*
    * Writer and reader threads started for triple buffer demo.
    */
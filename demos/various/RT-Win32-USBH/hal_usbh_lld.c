@@ -0,0 +1,81 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+
+#if HAL_USE_USBH
+
+#include "usbh/internal.h"
+#include <string.h>
+
+void usbh_lld_init(void) {
+}
+
+void usbh_lld_start(USBHDriver *host) {
+	(void)host;
+}
+
+void usbh_lld_stop(USBHDriver *host) {
+	(void)host;
+}
+
+void usbh_lld_ep_object_init(usbh_ep_t *ep) {
+	(void)ep;
+}
+
+void usbh_lld_ep_open(usbh_ep_t *ep) {
+	ep->status = USBH_EPSTATUS_OPEN;
+}
+
+void usbh_lld_ep_close(usbh_ep_t *ep) {
+	ep->status = USBH_EPSTATUS_CLOSED;
+}
+
+bool usbh_lld_ep_reset(usbh_ep_t *ep) {
+	(void)ep;
+	return TRUE;
+}
+
+void usbh_lld_urb_submit(usbh_urb_t *urb) {
+	/* no port, no device */
+	_usbh_urb_completeI(urb, USBH_URBSTATUS_DISCONNECTED);
+}
+
+bool usbh_lld_urb_abort(usbh_urb_t *urb, usbh_urbstatus_t status) {
+	_usbh_urb_completeI(urb, status);
+	return TRUE;
+}
+
+usbh_urbstatus_t usbh_lld_root_hub_request(USBHDriver *host, uint8_t bmRequestType, uint8_t bRequest,
+		uint16_t wvalue, uint16_t windex, uint16_t wlength, uint8_t *buf) {
+	(void)host;
+	(void)bmRequestType;
+	(void)bRequest;
+	(void)wvalue;
+	(void)windex;
+
+	/* the port status reads as nothing connected */
+	if (buf != NULL)
+		memset(buf, 0, wlength);
+	return USBH_URBSTATUS_OK;
+}
+
+uint8_t usbh_lld_roothub_get_statuschange_bitmap(USBHDriver *host) {
+	(void)host;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,464 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*===========================================================================*/
+/* Common.                                                                   */
+/*===========================================================================*/
+
+/*
+ * Duration of each throughput measurement.
+ */
+#define BENCH_MS                    500
+
+/*
+ * Returns the rate per second of a count measured since start.
+ */
+static uint32_t per_second(uint64_t count, systime_t start) {
+
+  sysinterval_t elapsed = chVTTimeElapsedSinceX(start);
+
+  if (elapsed == (sysinterval_t)0)
+    elapsed = (sysinterval_t)1;
+  return (uint32_t)((count * CH_CFG_ST_FREQUENCY) / elapsed);
+}
+
+/*
+ * Pseudo random numbers, the sequence is the same on every run. Only the
+ * upper bits are returned, the lower ones have short periods.
+ */
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void) {
+
+  rnd_state = rnd_state * 1103515245U + 12345U;
+  return rnd_state >> 16;
+}
+
+/*===========================================================================*/
+/* Configuration descriptors.                                                */
+/*===========================================================================*/
+
+/*
+ * The descriptors below follow the layout reported by common devices, with
+ * the string indexes cleared and some class-specific descriptors trimmed.
+ */
+
+/*
+ * Webcam: UVC function (IAD, control interface with an interrupt endpoint,
+ * streaming interface with three isochronous alternate settings) and UAC
+ * microphone function (IAD, control interface, streaming interface with one
+ * isochronous alternate setting).
+ */
+static const uint8_t webcam_cfg[] = {
+  /* configuration */
+  0x09, 0x02, 0x50, 0x01, 0x04, 0x01, 0x00, 0x80, 0xfa,
+  /* IAD, interfaces 0..1 */
+  0x08, 0x0b, 0x00, 0x02, 0x0e, 0x03, 0x00, 0x00,
+  /* interface 0, alternate setting 0 */
+  0x09, 0x04, 0x00, 0x00, 0x01, 0x0e, 0x01, 0x00, 0x00,
+  0x0d, 0x24, 0x01, 0x00, 0x01, 0x33, 0x00, 0x80, 0x8d, 0x5b, 0x00,
+  0x01, 0x01,
+  0x12, 0x24, 0x02, 0x01, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x03, 0x0e, 0x00, 0x00,
+  0x0b, 0x24, 0x05, 0x02, 0x01, 0x00, 0x00, 0x02, 0x7f, 0x17, 0x00,
+  0x09, 0x24, 0x03, 0x03, 0x01, 0x01, 0x00, 0x02, 0x00,
+  /* endpoint 0x87 */
+  0x07, 0x05, 0x87, 0x03, 0x10, 0x00, 0x08,
+  0x05, 0x25, 0x03, 0x10, 0x00,
+  /* interface 1, alternate setting 0 */
+  0x09, 0x04, 0x01, 0x00, 0x00, 0x0e, 0x02, 0x00, 0x00,
+  0x0e, 0x24, 0x01, 0x01, 0x5b, 0x00, 0x81, 0x00, 0x03, 0x00, 0x00,
+  0x00, 0x01, 0x00,
+  0x0b, 0x24, 0x06, 0x01, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x1e, 0x24, 0x07, 0x01, 0x00, 0x80, 0x02, 0xe0, 0x01, 0x00, 0x00,
+  0x77, 0x01, 0x00, 0x00, 0xca, 0x08, 0x00, 0x60, 0x09, 0x00, 0x15,
+  0x16, 0x05, 0x00, 0x01, 0x15, 0x16, 0x05, 0x00,
+  0x1e, 0x24, 0x07, 0x02, 0x00, 0x40, 0x01, 0xf0, 0x00, 0x00, 0xc0,
+  0x5d, 0x00, 0x00, 0x80, 0x32, 0x02, 0x00, 0x58, 0x02, 0x00, 0x15,
+  0x16, 0x05, 0x00, 0x01, 0x15, 0x16, 0x05, 0x00,
+  0x06, 0x24, 0x0d, 0x01, 0x01, 0x04,
+  /* interface 1, alternate setting 1 */
+  0x09, 0x04, 0x01, 0x01, 0x01, 0x0e, 0x02, 0x00, 0x00,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x05, 0x80, 0x00, 0x01,
+  /* interface 1, alternate setting 2 */
+  0x09, 0x04, 0x01, 0x02, 0x01, 0x0e, 0x02, 0x00, 0x00,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x05, 0x00, 0x02, 0x01,
+  /* interface 1, alternate setting 3 */
+  0x09, 0x04, 0x01, 0x03, 0x01, 0x0e, 0x02, 0x00, 0x00,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x05, 0xfc, 0x13, 0x01,
+  /* IAD, interfaces 2..3 */
+  0x08, 0x0b, 0x02, 0x02, 0x01, 0x02, 0x00, 0x00,
+  /* interface 2, alternate setting 0 */
+  0x09, 0x04, 0x02, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00,
+  0x09, 0x24, 0x01, 0x00, 0x01, 0x1e, 0x00, 0x01, 0x03,
+  0x0c, 0x24, 0x02, 0x01, 0x01, 0x02, 0x00, 0x01, 0x00, 0x00, 0x00,
+  0x00,
+  0x09, 0x24, 0x03, 0x02, 0x01, 0x01, 0x00, 0x01, 0x00,
+  /* interface 3, alternate setting 0 */
+  0x09, 0x04, 0x03, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00,
+  /* interface 3, alternate setting 1 */
+  0x09, 0x04, 0x03, 0x01, 0x01, 0x01, 0x02, 0x00, 0x00,
+  0x07, 0x24, 0x01, 0x02, 0x01, 0x01, 0x00,
+  0x0b, 0x24, 0x02, 0x01, 0x01, 0x02, 0x10, 0x01, 0x80, 0x3e, 0x00,
+  /* endpoint 0x86 */
+  0x09, 0x05, 0x86, 0x05, 0x44, 0x00, 0x04, 0x00, 0x00,
+  0x07, 0x25, 0x01, 0x01, 0x00, 0x00, 0x00
+};
+
+/*
+ * Composite device: CDC ACM function (IAD), then a mass storage interface and
+ * a HID keyboard interface outside of any IAD.
+ */
+static const uint8_t composite_cfg[] = {
+  /* configuration */
+  0x09, 0x02, 0x7b, 0x00, 0x04, 0x01, 0x00, 0xa0, 0x32,
+  /* IAD, interfaces 0..1 */
+  0x08, 0x0b, 0x00, 0x02, 0x02, 0x02, 0x01, 0x00,
+  /* interface 0, alternate setting 0 */
+  0x09, 0x04, 0x00, 0x00, 0x01, 0x02, 0x02, 0x01, 0x00,
+  0x05, 0x24, 0x00, 0x10, 0x01,
+  0x05, 0x24, 0x01, 0x00, 0x01,
+  0x04, 0x24, 0x02, 0x02,
+  0x05, 0x24, 0x06, 0x00, 0x01,
+  /* endpoint 0x82 */
+  0x07, 0x05, 0x82, 0x03, 0x08, 0x00, 0x10,
+  /* interface 1, alternate setting 0 */
+  0x09, 0x04, 0x01, 0x00, 0x02, 0x0a, 0x00, 0x00, 0x00,
+  /* endpoint 0x01 */
+  0x07, 0x05, 0x01, 0x02, 0x40, 0x00, 0x00,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x02, 0x40, 0x00, 0x00,
+  /* interface 2, alternate setting 0 */
+  0x09, 0x04, 0x02, 0x00, 0x02, 0x08, 0x06, 0x50, 0x00,
+  /* endpoint 0x83 */
+  0x07, 0x05, 0x83, 0x02, 0x40, 0x00, 0x00,
+  /* endpoint 0x03 */
+  0x07, 0x05, 0x03, 0x02, 0x40, 0x00, 0x00,
+  /* interface 3, alternate setting 0 */
+  0x09, 0x04, 0x03, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00,
+  0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x3f, 0x00,
+  /* endpoint 0x84 */
+  0x07, 0x05, 0x84, 0x03, 0x08, 0x00, 0x0a
+};
+
+/*
+ * Mass storage device, a single interface.
+ */
+static const uint8_t msd_cfg[] = {
+  /* configuration */
+  0x09, 0x02, 0x20, 0x00, 0x01, 0x01, 0x00, 0x80, 0xfa,
+  /* interface 0, alternate setting 0 */
+  0x09, 0x04, 0x00, 0x00, 0x02, 0x08, 0x06, 0x50, 0x00,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x02, 0x00, 0x02, 0x00,
+  /* endpoint 0x02 */
+  0x07, 0x05, 0x02, 0x02, 0x00, 0x02, 0x00
+};
+
+/*
+ * Dual port serial converter, two vendor interfaces without IAD.
+ */
+static const uint8_t dual_cfg[] = {
+  /* configuration */
+  0x09, 0x02, 0x37, 0x00, 0x02, 0x01, 0x00, 0x80, 0xfa,
+  /* interface 0, alternate setting 0 */
+  0x09, 0x04, 0x00, 0x00, 0x02, 0xff, 0xff, 0xff, 0x02,
+  /* endpoint 0x81 */
+  0x07, 0x05, 0x81, 0x02, 0x40, 0x00, 0x00,
+  /* endpoint 0x02 */
+  0x07, 0x05, 0x02, 0x02, 0x40, 0x00, 0x00,
+  /* interface 1, alternate setting 0 */
+  0x09, 0x04, 0x01, 0x00, 0x02, 0xff, 0xff, 0xff, 0x02,
+  /* endpoint 0x83 */
+  0x07, 0x05, 0x83, 0x02, 0x40, 0x00, 0x00,
+  /* endpoint 0x04 */
+  0x07, 0x05, 0x04, 0x02, 0x40, 0x00, 0x00
+};
+
+
+typedef struct {
+  const char                *name;
+  const uint8_t             *cfg;
+  uint16_t                  size;
+  /* expected index */
+  uint8_t                   if_count;
+  uint8_t                   ifnum_count;
+  uint8_t                   ep_count;
+  uint8_t                   iad_count;      /* interfaces inside an IAD */
+} cfg_blob_t;
+
+static const cfg_blob_t cfg_blobs[] = {
+  {"webcam",    webcam_cfg,    sizeof(webcam_cfg),    8, 4, 5, 8},
+  {"composite", composite_cfg, sizeof(composite_cfg), 4, 4, 6, 2},
+  {"msd",       msd_cfg,       sizeof(msd_cfg),       1, 1, 2, 0},
+  {"dual",      dual_cfg,      sizeof(dual_cfg),      2, 2, 4, 0}
+};
+
+/*===========================================================================*/
+/* Descriptor index.                                                         */
+/*===========================================================================*/
+
+/*
+ * Damaged copies checked for each descriptor.
+ */
+#define CORRUPT_RUNS                2000
+
+/*
+ * Index storage, large enough for any of the descriptors above even when
+ * damaged.
+ */
+static uint32_t index_storage[256];
+static uint8_t corrupt_cfg[512];
+
+/*
+ * Checks the index against a walk of the descriptor with the iterators:
+ * every interface and endpoint must be found at the same offset, with the
+ * same enclosing IAD, and the alternate settings of each interface number
+ * must be chained in descriptor order.
+ */
+static void descidx_check(const descidx_t *idx, const uint8_t *cfg,
+                          uint16_t size) {
+  generic_iterator_t icfg, iep;
+  if_iterator_t iif, jif;
+  uint8_t n, i, count;
+  uint16_t ifnum;
+
+  cfg_iter_init(&icfg, cfg, size);
+  n = 0;
+  for (if_iter_init(&iif, &icfg); iif.valid; if_iter_next(&iif), n++) {
+    if (n >= idx->if_count)
+      chSysHalt("ERROR: descidx_check() interface not indexed");
+    descidx_if_iter(idx, n, &jif);
+    if ((jif.curr != iif.curr) || (jif.rem != iif.rem) || (jif.iad != iif.iad))
+      chSysHalt("ERROR: descidx_check() wrong interface");
+
+    i = 0;
+    for (ep_iter_init(&iep, &iif); iep.valid; ep_iter_next(&iep), i++) {
+      if ((i >= idx->ifs[n].ep_count) ||
+          ((const uint8_t *)descidx_ep_get(idx, n, i) != iep.curr))
+        chSysHalt("ERROR: descidx_check() wrong endpoint");
+    }
+    if (i != idx->ifs[n].ep_count)
+      chSysHalt("ERROR: descidx_check() endpoint not found");
+  }
+  if (n != idx->if_count)
+    chSysHalt("ERROR: descidx_check() spurious interface");
+
+  count = 0;
+  for (ifnum = 0; ifnum < idx->ifnum_count; ifnum++) {
+    int last = -1;
+    for (n = descidx_if_first(idx, (uint8_t)ifnum); n != DESCIDX_NONE;
+         n = descidx_if_next_alt(idx, n), count++) {
+      if (((int)n <= last) ||
+          (descidx_if_get(idx, n)->bInterfaceNumber != ifnum))
+        chSysHalt("ERROR: descidx_check() wrong alternate setting chain");
+      last = n;
+    }
+  }
+  if (count != idx->if_count)
+    chSysHalt("ERROR: descidx_check() alternate settings not chained");
+  if ((idx->ifnum_count <= 0xffU) &&
+      (descidx_if_first(idx, (uint8_t)idx->ifnum_count) != DESCIDX_NONE))
+    chSysHalt("ERROR: descidx_check() interface number out of range");
+}
+
+/*
+ * Indexes a possibly damaged descriptor. When nothing can be indexed the
+ * iterators must not find any interface either, else the index is checked.
+ */
+static void descidx_check_any(const uint8_t *cfg, uint16_t size) {
+  generic_iterator_t icfg;
+  if_iterator_t iif;
+  descidx_t idx;
+  size_t need;
+
+  need = descidx_init(&idx, cfg, size, NULL, 0);
+  if (need == 0) {
+    cfg_iter_init(&icfg, cfg, size);
+    if (icfg.valid) {
+      if_iter_init(&iif, &icfg);
+      if (iif.valid)
+        chSysHalt("ERROR: descidx_check_any() interfaces not indexed");
+    }
+    return;
+  }
+
+  if (need > sizeof(index_storage))
+    chSysHalt("ERROR: descidx_check_any() index too large");
+  if (descidx_init(&idx, cfg, size, index_storage, need) != need)
+    chSysHalt("ERROR: descidx_check_any() wrong index size");
+  descidx_check(&idx, cfg, size);
+}
+
+/*
+ * Builds and checks the index of a descriptor, then of its truncations and
+ * of copies with a few random bytes overwritten.
+ */
+static void descidx_check_blob(const cfg_blob_t *blob) {
+  descidx_t idx;
+  size_t need;
+  uint16_t l;
+  uint8_t n, iads;
+  unsigned run, k;
+
+  need = descidx_init(&idx, blob->cfg, blob->size, NULL, 0);
+  if ((need == 0) || descidx_valid(&idx))
+    chSysHalt("ERROR: descidx_check_blob() wrong size query");
+  if ((descidx_init(&idx, blob->cfg, blob->size, index_storage,
+                    need - 1U) != need) || descidx_valid(&idx))
+    chSysHalt("ERROR: descidx_check_blob() index built in short storage");
+  if ((descidx_init(&idx, blob->cfg, blob->size, index_storage,
+                    need) != need) || !descidx_valid(&idx))
+    chSysHalt("ERROR: descidx_check_blob() index not built");
+
+  if ((idx.if_count != blob->if_count) ||
+      (idx.ifnum_count != blob->ifnum_count) ||
+      (idx.ep_count != blob->ep_count))
+    chSysHalt("ERROR: descidx_check_blob() wrong counts");
+  iads = 0;
+  for (n = 0; n < idx.if_count; n++) {
+    if (descidx_iad_get(&idx, n) != NULL)
+      iads++;
+  }
+  if (iads != blob->iad_count)
+    chSysHalt("ERROR: descidx_check_blob() wrong IADs");
+  descidx_check(&idx, blob->cfg, blob->size);
+
+  fprintf(stdout, "%-10s %4u bytes, %u interfaces, %u endpoints, "
+          "%u bytes of index\r\n", blob->name, blob->size,
+          idx.if_count, idx.ep_count, (unsigned)need);
+
+  for (l = 0; l <= blob->size; l++)
+    descidx_check_any(blob->cfg, l);
+
+  for (run = 0; run < CORRUPT_RUNS; run++) {
+    memcpy(corrupt_cfg, blob->cfg, blob->size);
+    for (k = 0; k < 3U; k++)
+      corrupt_cfg[rnd() % blob->size] = (uint8_t)rnd();
+    descidx_check_any(corrupt_cfg, blob->size);
+  }
+}
+
+/*
+ * Returns the lookups per second of the alternate settings of an interface,
+ * with the iterators or through the index.
+ */
+static uint32_t descidx_lookup_rate(const descidx_t *idx, const uint8_t *cfg,
+                                    uint16_t size, uint8_t ifnum,
+                                    bool use_index) {
+  generic_iterator_t icfg;
+  if_iterator_t iif;
+  volatile const uint8_t *found = NULL;
+  systime_t start;
+  uint64_t lookups = 0;
+  uint32_t i;
+  uint8_t n;
+
+  start = chVTGetSystemTimeX();
+  do {
+    for (i = 0; i < 1000U; i++) {
+      if (use_index) {
+        for (n = descidx_if_first(idx, ifnum); n != DESCIDX_NONE;
+             n = descidx_if_next_alt(idx, n))
+          found = (const uint8_t *)descidx_if_get(idx, n);
+      }
+      else {
+        cfg_iter_init(&icfg, cfg, size);
+        for (if_iter_init(&iif, &icfg); iif.valid; if_iter_next(&iif)) {
+          if (if_get(&iif)->bInterfaceNumber == ifnum)
+            found = iif.curr;
+        }
+      }
+    }
+    lookups += 1000U;
+  } while (chVTTimeElapsedSinceX(start) < TIME_MS2I(BENCH_MS));
+
+  if (found == NULL)
+    chSysHalt("ERROR: descidx_lookup_rate() interface not found");
+
+  return per_second(lookups, start);
+}
+
+/*
+ * Checks the index of every descriptor, then compares the search of the
+ * webcam streaming alternate settings with the iterators and the index.
+ */
+static void descidx_test(void) {
+  const cfg_blob_t *blob = &cfg_blobs[0];
+  descidx_t idx;
+  size_t need;
+  uint32_t walk, lookup;
+  unsigned i;
+
+  fprintf(stdout, "Configuration descriptor index\r\n");
+  for (i = 0; i < sizeof(cfg_blobs) / sizeof(cfg_blobs[0]); i++)
+    descidx_check_blob(&cfg_blobs[i]);
+
+  need = descidx_init(&idx, blob->cfg, blob->size, NULL, 0);
+  descidx_init(&idx, blob->cfg, blob->size, index_storage, need);
+  walk = descidx_lookup_rate(&idx, blob->cfg, blob->size, 1, false);
+  lookup = descidx_lookup_rate(&idx, blob->cfg, blob->size, 1, true);
+  fprintf(stdout, "%s streaming alternate settings: iterators %8lu/s "
+          "index %8lu/s %5.1fx\r\n", blob->name, (unsigned long)walk,
+          (unsigned long)lookup, (double)lookup / (double)walk);
+}
+
+/*===========================================================================*/
+/* Main.                                                                     */
+/*===========================================================================*/
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  descidx_test();
+
+  fflush(stdout);
+  return 0;
+}
+
+/*
+ * Critical error function.
+ */
+void halt(const char *reason) {
+
+  fflush(stdout);
+  fputs("\n", stdout);
+  fputs(reason, stderr);
+  fflush(stderr);
+  exit(1);
+}
@@ -0,0 +1,557 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "median.h"
+#include "ramdisk.h"
+#include "blkcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*===========================================================================*/
+/* Common.                                                                   */
+/*===========================================================================*/
+
+/*
+ * Duration of each throughput measurement.
+ */
+#define BENCH_MS                    500
+
+/*
+ * Returns the rate per second of a count measured since start.
+ */
+static uint32_t per_second(uint64_t count, systime_t start) {
+
+  sysinterval_t elapsed = chVTTimeElapsedSinceX(start);
+
+  if (elapsed == (sysinterval_t)0)
+    elapsed = (sysinterval_t)1;
+  return (uint32_t)((count * CH_CFG_ST_FREQUENCY) / elapsed);
+}
+
+/*
+ * Pseudo random numbers, the sequence is the same on every run. Only the
+ * upper bits are returned, the lower ones have short periods.
+ */
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void) {
+
+  rnd_state = rnd_state * 1103515245U + 12345U;
+  return rnd_state >> 16;
+}
+
+/*===========================================================================*/
+/* CRC related.                                                              */
+/*===========================================================================*/
+
+#define CRC_MAX_SIZE                65536
+
+static uint8_t crc_data[CRC_MAX_SIZE + 8];
+
+/*
+ * Built-in configurations with the byte at a time engine.
+ */
+static CRCConfig crc32_bytes_config;
+static CRCConfig crc16_bytes_config;
+
+/*
+ * Calculates the CRC of a buffer, in two steps when long enough so that the
+ * running value is carried between calls.
+ */
+static uint32_t crc_run(const CRCConfig *config, const uint8_t *buf,
+                        size_t n) {
+
+  size_t head = n / 3U;
+
+  crcStart(&CRCD1, config);
+  crcReset(&CRCD1);
+  if (head > 0U)
+    (void)crcCalc(&CRCD1, head, buf);
+  return crcCalc(&CRCD1, n - head, buf + head);
+}
+
+/*
+ * Checks the sliced engine against the byte loop for every alignment and
+ * for lengths crossing the head, body and tail split.
+ */
+static void crc_check(const CRCConfig *sliced, const CRCConfig *bytes) {
+
+  size_t offset, n;
+
+  for (offset = 0; offset < 8U; offset++) {
+    for (n = 1; n < 200U; n++) {
+      if (crc_run(sliced, &crc_data[offset], n) !=
+          crc_run(bytes, &crc_data[offset], n))
+        chSysHalt("ERROR: crc_check() sliced and byte results differ");
+    }
+  }
+}
+
+/*
+ * Returns the CRC throughput in kB/s.
+ */
+static uint32_t crc_rate(const CRCConfig *config, size_t n) {
+
+  systime_t start;
+  uint64_t bytes = 0;
+
+  crcStart(&CRCD1, config);
+  start = chVTGetSystemTimeX();
+  do {
+    crcReset(&CRCD1);
+    (void)crcCalc(&CRCD1, n, crc_data);
+    bytes += n;
+  } while (chVTTimeElapsedSinceX(start) < TIME_MS2I(BENCH_MS));
+
+  return per_second(bytes, start) / 1024U;
+}
+
+/*
+ * Compares the slicing-by-8 engine with the byte at a time lookup.
+ */
+static void crc_benchmark(void) {
+
+  static const uint8_t check[] = "123456789";
+  size_t i, n;
+  uint32_t bytes, sliced;
+
+  for (i = 0; i < sizeof(crc_data); i++)
+    crc_data[i] = (uint8_t)rnd();
+
+  crc32_bytes_config = crcsw_crc32_config;
+  crc32_bytes_config.slices = 1;
+  crc16_bytes_config = crcsw_crc16_config;
+  crc16_bytes_config.slices = 1;
+
+  /* Standard check values.*/
+  if (crc_run(CRCSW_CRC32_TABLE_CONFIG, check, 9) != 0xCBF43926U)
+    chSysHalt("ERROR: crc_benchmark() wrong CRC32 check value");
+  if (crc_run(CRCSW_CRC16_TABLE_CONFIG, check, 9) != 0xBB3DU)
+    chSysHalt("ERROR: crc_benchmark() wrong CRC16 check value");
+  crc_check(CRCSW_CRC32_TABLE_CONFIG, &crc32_bytes_config);
+  crc_check(CRCSW_CRC16_TABLE_CONFIG, &crc16_bytes_config);
+
+  fprintf(stdout, "CRC32 slicing-by-%d against the byte loop\r\n",
+          CRCSW_SLICING);
+  for (n = 16; n <= CRC_MAX_SIZE; n *= 4U) {
+    bytes = crc_rate(&crc32_bytes_config, n);
+    sliced = crc_rate(CRCSW_CRC32_TABLE_CONFIG, n);
+    fprintf(stdout, "%8lu bytes %8lu kB/s %8lu kB/s %5.1fx\r\n",
+            (unsigned long)n, (unsigned long)bytes, (unsigned long)sliced,
+            (double)sliced / (double)(bytes > 0U ? bytes : 1U));
+  }
+}
+
+/*===========================================================================*/
+/* Median filter related.                                                    */
+/*===========================================================================*/
+
+#define MEDIAN_MAX_SIZE             255
+#define MEDIAN_CHECK_SAMPLES        1000
+#define MEDIAN_CHANNELS             4
+#define MEDIAN_FRAMES               256
+
+static pair_t median_pairs[MEDIAN_MAX_SIZE];
+static median_slot_t median_slots[MEDIAN_MAX_SIZE];
+static median_slot_t median_batch_slots[MEDIAN_CHANNELS][MEDIAN_MAX_SIZE];
+static median_heap_t median_batch[MEDIAN_CHANNELS];
+static uint16_t median_history[MEDIAN_CHECK_SAMPLES];
+static uint16_t median_in[MEDIAN_CHANNELS * MEDIAN_FRAMES];
+static uint16_t median_out[MEDIAN_CHANNELS * MEDIAN_FRAMES];
+
+/*
+ * Returns a sample, never the zero stopper of the list filter. One third
+ * of the samples are small values so that the window holds duplicates.
+ */
+static uint16_t median_sample(void) {
+
+  if ((rnd() % 3U) == 0U)
+    return (uint16_t)((rnd() % 5U) + 1U);
+  return (uint16_t)((rnd() % 60000U) + 1U);
+}
+
+/*
+ * Returns the median of the n samples ending at last, by sorting them.
+ */
+static uint16_t median_reference(const uint16_t *last, uint16_t n) {
+
+  static uint16_t sorted[MEDIAN_MAX_SIZE];
+  uint16_t i, j, v;
+
+  for (i = 0; i < n; i++) {
+    v = *(last - i);
+    for (j = i; (j > 0U) && (sorted[j - 1U] > v); j--)
+      sorted[j] = sorted[j - 1U];
+    sorted[j] = v;
+  }
+  return sorted[n / 2U];
+}
+
+/*
+ * Checks the heap filter against the sorted window from the first sample,
+ * and the list filter once its window is full.
+ */
+static void median_check(uint16_t size) {
+
+  median_t list;
+  median_heap_t heap;
+  uint16_t i, n, expected;
+
+  memset(median_pairs, 0, sizeof(median_pairs));
+  median_init(&list, 0, median_pairs, size);
+  median_heap_init(&heap, median_slots, size);
+  for (i = 0; i < MEDIAN_CHECK_SAMPLES; i++) {
+    median_history[i] = median_sample();
+    n = (i + 1U < size) ? (uint16_t)(i + 1U) : size;
+    expected = median_reference(&median_history[i], n);
+    if (median_heap_filter(&heap, median_history[i]) != expected)
+      chSysHalt("ERROR: median_check() wrong heap filter median");
+    if ((median_filter(&list, median_history[i]) != expected) && (i >= size))
+      chSysHalt("ERROR: median_check() wrong list filter median");
+  }
+}
+
+/*
+ * Returns the samples per second filtered by the list filter or by the
+ * heap filter.
+ */
+static uint32_t median_rate(uint16_t size, bool use_heap) {
+
+  median_t list;
+  median_heap_t heap;
+  systime_t start;
+  uint64_t samples = 0;
+  volatile uint16_t result;
+  uint32_t i;
+
+  memset(median_pairs, 0, sizeof(median_pairs));
+  median_init(&list, 0, median_pairs, size);
+  median_heap_init(&heap, median_slots, size);
+  start = chVTGetSystemTimeX();
+  do {
+    for (i = 0; i < 1000U; i++) {
+      if (use_heap)
+        result = median_heap_filter(&heap, median_sample());
+      else
+        result = median_filter(&list, median_sample());
+    }
+    samples += 1000U;
+  } while (chVTTimeElapsedSinceX(start) < TIME_MS2I(BENCH_MS));
+  (void)result;
+
+  return per_second(samples, start);
+}
+
+/*
+ * Filters an interleaved multi-channel buffer in one call and checks it
+ * against one filter call per sample. Returns the samples per second.
+ */
+static uint32_t median_batch_rate(uint16_t size) {
+
+  median_heap_t single;
+  systime_t start;
+  uint64_t samples = 0;
+  uint32_t c, i;
+
+  for (c = 0; c < MEDIAN_CHANNELS; c++)
+    median_heap_init(&median_batch[c], median_batch_slots[c], size);
+  for (i = 0; i < MEDIAN_CHANNELS * MEDIAN_FRAMES; i++)
+    median_in[i] = median_sample();
+  median_heap_filter_batch(median_batch, MEDIAN_CHANNELS, median_in,
+                           median_out, MEDIAN_FRAMES);
+  for (c = 0; c < MEDIAN_CHANNELS; c++) {
+    median_heap_init(&single, median_slots, size);
+    for (i = c; i < MEDIAN_CHANNELS * MEDIAN_FRAMES; i += MEDIAN_CHANNELS) {
+      if (median_heap_filter(&single, median_in[i]) != median_out[i])
+        chSysHalt("ERROR: median_batch_rate() batch and single differ");
+    }
+  }
+
+  start = chVTGetSystemTimeX();
+  do {
+    median_heap_filter_batch(median_batch, MEDIAN_CHANNELS, median_in,
+                             median_out, MEDIAN_FRAMES);
+    samples += MEDIAN_CHANNELS * MEDIAN_FRAMES;
+  } while (chVTTimeElapsedSinceX(start) < TIME_MS2I(BENCH_MS));
+
+  return per_second(samples, start);
+}
+
+/*
+ * Compares the O(log N) heap filter with the O(N) sorted list filter.
+ */
+static void median_benchmark(void) {
+
+  uint16_t size;
+  uint32_t list, heap;
+
+  for (size = 3; size <= MEDIAN_MAX_SIZE; size += 2U)
+    median_check(size);
+
+  fprintf(stdout, "Median heap filter against the list filter\r\n");
+  for (size = 5; size <= MEDIAN_MAX_SIZE; size = (uint16_t)(size * 2U + 1U)) {
+    list = median_rate(size, false);
+    heap = median_rate(size, true);
+    fprintf(stdout, "%5u window %8lu samples/s %8lu samples/s %5.1fx\r\n",
+            size, (unsigned long)list, (unsigned long)heap,
+            (double)heap / (double)(list > 0U ? list : 1U));
+  }
+  fprintf(stdout, "%5u window, %u channels batch %8lu samples/s\r\n",
+          11, MEDIAN_CHANNELS, (unsigned long)median_batch_rate(11));
+}
+
+/*===========================================================================*/
+/* Block cache related.                                                      */
+/*===========================================================================*/
+
+#define CACHE_BLK_SIZE              512
+#define CACHE_BLK_NUM               256
+#define CACHE_SETS                  8
+#define CACHE_WAYS                  2
+#define CACHE_READAHEAD             4
+#define CACHE_MAX_BLOCKS            16
+#define CACHE_OPERATIONS            20000
+
+static uint8_t disk_storage[CACHE_BLK_NUM * CACHE_BLK_SIZE];
+static uint8_t disk_image[CACHE_BLK_NUM * CACHE_BLK_SIZE];
+static uint8_t cache_buffer[CACHE_SETS * CACHE_WAYS * CACHE_BLK_SIZE];
+static blkcache_line_t cache_lines[CACHE_SETS * CACHE_WAYS];
+static uint8_t cache_data[CACHE_MAX_BLOCKS * CACHE_BLK_SIZE];
+
+static RamDisk disk;
+static BlockCache cache;
+
+static const BlockCacheConfig cachecfg = {
+  .blkdev = (BaseBlockDevice *)&disk,
+  .buffer = cache_buffer,
+  .lines = cache_lines,
+  .sets = CACHE_SETS,
+  .ways = CACHE_WAYS,
+  .blk_size = CACHE_BLK_SIZE,
+  .readahead = CACHE_READAHEAD
+};
+
+/*
+ * The RAM disk methods are wrapped in order to count the accesses reaching
+ * the device.
+ */
+static const struct BaseBlockDeviceVMT *disk_vmt;
+static struct BaseBlockDeviceVMT counting_vmt;
+static uint32_t disk_reads, disk_writes;
+
+static bool counting_read(void *instance, uint32_t startblk,
+                          uint8_t *buffer, uint32_t n) {
+
+  disk_reads++;
+  return disk_vmt->read(instance, startblk, buffer, n);
+}
+
+static bool counting_write(void *instance, uint32_t startblk,
+                           const uint8_t *buffer, uint32_t n) {
+
+  disk_writes++;
+  return disk_vmt->write(instance, startblk, buffer, n);
+}
+
+/*
+ * Returns true if the RAM disk holds the expected content of a block.
+ */
+static bool disk_holds(uint32_t blk) {
+
+  return memcmp(&disk_storage[blk * CACHE_BLK_SIZE],
+                &disk_image[blk * CACHE_BLK_SIZE], CACHE_BLK_SIZE) == 0;
+}
+
+/*
+ * Writes random data through the cache and into the expected image.
+ */
+static bool cache_write(uint32_t blk, uint32_t n) {
+
+  uint32_t i;
+
+  for (i = 0; i < n * CACHE_BLK_SIZE; i++)
+    cache_data[i] = (uint8_t)rnd();
+  if (blk + n <= CACHE_BLK_NUM)
+    memcpy(&disk_image[blk * CACHE_BLK_SIZE], cache_data,
+           n * CACHE_BLK_SIZE);
+  return blkWrite(&cache, blk, cache_data, n);
+}
+
+/*
+ * Reads through the cache and compares with the expected image.
+ */
+static bool cache_read_check(uint32_t blk, uint32_t n) {
+
+  if (blkRead(&cache, blk, cache_data, n) != HAL_SUCCESS)
+    return false;
+  return memcmp(cache_data, &disk_image[blk * CACHE_BLK_SIZE],
+                n * CACHE_BLK_SIZE) == 0;
+}
+
+/*
+ * Checks write-back, eviction and flush on blocks of the same set.
+ */
+static void cache_check(void) {
+
+  uint32_t writes, reads;
+
+  /* Write-back, the device is not written while the set has room.*/
+  writes = disk_writes;
+  (void)cache_write(0, 1);
+  (void)cache_write(CACHE_SETS, 1);
+  if ((disk_writes != writes) || disk_holds(0) || disk_holds(CACHE_SETS))
+    chSysHalt("ERROR: cache_check() write reached the device");
+
+  /* Hits, the device is not read.*/
+  reads = disk_reads;
+  if (!cache_read_check(0, 1) || !cache_read_check(CACHE_SETS, 1) ||
+      (disk_reads != reads))
+    chSysHalt("ERROR: cache_check() cached blocks not hit");
+
+  /* Eviction, block 0 is the least recently used line of the set.*/
+  (void)cache_read_check(CACHE_SETS, 1);
+  (void)cache_write(2U * CACHE_SETS, 1);
+  if (!disk_holds(0) || disk_holds(CACHE_SETS) ||
+      disk_holds(2U * CACHE_SETS) || (cache.stats.writebacks != 1U))
+    chSysHalt("ERROR: cache_check() wrong line evicted");
+
+  /* Flush.*/
+  if ((blkcacheFlush(&cache) != HAL_SUCCESS) ||
+      !disk_holds(CACHE_SETS) || !disk_holds(2U * CACHE_SETS) ||
+      (cache.stats.writebacks != 3U))
+    chSysHalt("ERROR: cache_check() flush failed");
+}
+
+/*
+ * Random mix of single and multi-block reads and writes, mostly on a
+ * window of hot blocks moving across the device like the metadata of a
+ * file system, compared with the expected image.
+ */
+static void cache_random(void) {
+
+  uint32_t i, op, blk, n;
+
+  for (i = 0; i < CACHE_OPERATIONS; i++) {
+    op = rnd() % 10U;
+    n = ((rnd() % 3U) == 0U) ? (rnd() % CACHE_MAX_BLOCKS) + 1U : 1U;
+    if ((rnd() % 5U) == 0U)
+      blk = rnd() % CACHE_BLK_NUM;
+    else
+      blk = (rnd() % 20U) + ((i / 500U) % (CACHE_BLK_NUM - 40U));
+    if (blk + n > CACHE_BLK_NUM)
+      n = CACHE_BLK_NUM - blk;
+
+    if (op < 6U) {
+      if (!cache_read_check(blk, n))
+        chSysHalt("ERROR: cache_random() read mismatch");
+    }
+    else if (op < 9U) {
+      if (cache_write(blk, n) != HAL_SUCCESS)
+        chSysHalt("ERROR: cache_random() write failed");
+    }
+    else if ((i % 64U) == 0U) {
+      if ((blkSync(&cache) != HAL_SUCCESS) ||
+          (memcmp(disk_storage, disk_image, sizeof(disk_image)) != 0))
+        chSysHalt("ERROR: cache_random() sync mismatch");
+    }
+  }
+  if ((blkSync(&cache) != HAL_SUCCESS) ||
+      (memcmp(disk_storage, disk_image, sizeof(disk_image)) != 0))
+    chSysHalt("ERROR: cache_random() final image mismatch");
+}
+
+/*
+ * Stacks the caching block device on a RAM disk.
+ */
+static void cache_benchmark(void) {
+
+  uint32_t i;
+
+  for (i = 0; i < sizeof(disk_storage); i++)
+    disk_storage[i] = disk_image[i] = (uint8_t)rnd();
+  ramdiskObjectInit(&disk);
+  ramdiskStart(&disk, disk_storage, CACHE_BLK_SIZE, CACHE_BLK_NUM, false);
+  disk_vmt = disk.vmt;
+  counting_vmt = *disk.vmt;
+  counting_vmt.read = counting_read;
+  counting_vmt.write = counting_write;
+  disk.vmt = &counting_vmt;
+
+  blkcacheObjectInit(&cache);
+  blkcacheStart(&cache, &cachecfg);
+  cache_check();
+
+  blkcacheResetStats(&cache);
+  disk_reads = 0;
+  disk_writes = 0;
+  cache_random();
+  fprintf(stdout, "Block cache, %u sets of %u ways, %u operations\r\n",
+          CACHE_SETS, CACHE_WAYS, CACHE_OPERATIONS);
+  fprintf(stdout, "read hits %lu misses %lu, write hits %lu misses %lu\r\n",
+          (unsigned long)cache.stats.read_hits,
+          (unsigned long)cache.stats.read_misses,
+          (unsigned long)cache.stats.write_hits,
+          (unsigned long)cache.stats.write_misses);
+  fprintf(stdout, "%lu write-backs, %lu prefetched, device %lu reads "
+          "%lu writes\r\n",
+          (unsigned long)cache.stats.writebacks,
+          (unsigned long)cache.stats.prefetched,
+          (unsigned long)disk_reads, (unsigned long)disk_writes);
+  blkcacheStop(&cache);
+}
+
+/*===========================================================================*/
+/* Initialization and main thread.                                           */
+/*===========================================================================*/
+
+/*
+ * Simulator main.
+ */
+int main(void) {
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  crc_benchmark();
+  median_benchmark();
+  cache_benchmark();
+
+  fflush(stdout);
+  return 0;
+}
+
+/*
+ * Critical error function.
+ */
+void halt(const char *reason) {
+
+  fflush(stdout);
+  fputs("\n", stdout);
+  fputs(reason, stderr);
+  fflush(stderr);
+  exit(1);
+}
@@ -143,6 +143,8 @@ extern "C" {
   void crcResetI(CRCDriver *crcp);
   uint32_t crcCalc(CRCDriver *crcp, size_t n, const void *buf);
   uint32_t crcCalcI(CRCDriver *crcp, size_t n, const void *buf);
+  uint32_t crcCombine(const CRCConfig *config, uint32_t crc1, uint32_t crc2,
+                      size_t len2);
 #if CRC_USE_DMA == TRUE
   void crcStartCalc(CRCDriver *crcp, size_t n, const void *buf);
   void crcStartCalcI(CRCDriver *crcp, size_t n, const void *buf);
@@ -13,6 +13,59 @@
 
 #define EEPROM_DEV_24XX 24
 
+/**
+ * @brief   Interval between two polls of an IC busy with a write cycle.
+ */
+#if !defined(EEPROM_24XX_POLL_INTERVAL) || defined(__DOXYGEN__)
+#define EEPROM_24XX_POLL_INTERVAL       TIME_US2I(500)
+#endif
+
+/**
+ * @brief   Enables the thread flushing the write buffers in background.
+ */
+#if !defined(EEPROM_24XX_USE_FLUSHER) || defined(__DOXYGEN__)
+#define EEPROM_24XX_USE_FLUSHER         FALSE
+#endif
+
+/**
+ * @brief   Idle time after which the flush thread writes a buffered page.
+ */
+#if !defined(EEPROM_24XX_FLUSH_DELAY) || defined(__DOXYGEN__)
+#define EEPROM_24XX_FLUSH_DELAY         TIME_MS2I(20)
+#endif
+
+/**
+ * @brief   Stack size of the flush thread.
+ */
+#if !defined(EEPROM_24XX_FLUSHER_STACK_SIZE) || defined(__DOXYGEN__)
+#define EEPROM_24XX_FLUSHER_STACK_SIZE  256
+#endif
+
+#if EEPROM_24XX_USE_FLUSHER && !I2C_USE_MUTUAL_EXCLUSION
+#error "EEPROM_24XX_USE_FLUSHER requires I2C_USE_MUTUAL_EXCLUSION"
+#endif
+
+typedef struct I2CEepromFileStream I2CEepromFileStream;
+
+/**
+ * @brief   Write combining state of a file.
+ */
+typedef struct I2CEepromCache I2CEepromCache;
+
+struct I2CEepromCache {
+  /* Page held in the write buffer. */
+  uint32_t                  page;
+  /* Buffered bytes of the page, none when start equals end. */
+  uint16_t                  start;
+  uint16_t                  end;
+  /* Time of the last buffered write. */
+  systime_t                 time;
+  /* File the bytes were written to. */
+  I2CEepromFileStream       *efs;
+  /* Next cache with buffered data. */
+  I2CEepromCache            *next;
+};
+
 /**
  * @extends EepromFileConfig
  */
@@ -27,11 +80,18 @@ typedef struct {
    */
   i2caddr_t     addr;
   /**
-   * Pointer to write buffer. The safest size is (pagesize + 2)
+   * Pointer to write buffer of (pagesize + 2) bytes, it also holds the
+   * page being combined so every open file needs its own buffer.
    * Declare with CC_SECTION(".nocache") ... if using I2C with DMA to avoid
    * cache coherence issues.
    */
   uint8_t       *write_buf;
+  /**
+   * Write combining state, one per open file like the write buffer.
+   * I2CEepromFileOpen() resets it, it must be zeroed for EepromFileOpen().
+   * NULL writes every call through.
+   */
+  I2CEepromCache *cache;
 } I2CEepromFileConfig;
 
 /**
@@ -45,21 +105,27 @@ typedef struct {
  *
  * @brief   EEPROM file stream driver class for I2C device.
  */
-typedef struct {
+struct I2CEepromFileStream {
   const struct EepromFileStreamVMT *vmt;
   _eeprom_file_stream_data_i2c
   /* Overwritten parent data member. */
   const I2CEepromFileConfig *cfg;
-} I2CEepromFileStream;
+};
 
 
-/**
- * Open I2C EEPROM IC as file and return pointer to the file stream object
- * @note      Fucntion allways successfully open file. All checking makes
- *            in read/write functions.
- */
-#define I2CEepromFileOpen(efs, eepcfg, eepdev) \
-  EepromFileOpen((EepromFileStream *)efs, (EepromFileConfig *)eepcfg, eepdev);
+#ifdef __cplusplus
+extern "C" {
+#endif
+  EepromFileStream *I2CEepromFileOpen(I2CEepromFileStream *efs,
+                                      const I2CEepromFileConfig *eepcfg,
+                                      const EepromDevice *eepdev);
+  msg_t I2CEepromFileFlush(EepromFileStream *efs);
+#if EEPROM_24XX_USE_FLUSHER
+  void I2CEepromStartFlusher(tprio_t prio);
+#endif
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* #if defined(EEPROM_USE_EE24XX) && EEPROM_USE_EE24XX */
 
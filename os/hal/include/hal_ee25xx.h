@@ -13,6 +13,36 @@
 
 #define EEPROM_DEV_25XX 25
 
+/**
+ * @brief   Transfer counters of SPI EEPROM files.
+ */
+typedef struct {
+  /**
+   * Read transactions.
+   */
+  uint32_t        reads;
+  /**
+   * Bytes read.
+   */
+  uint32_t        bytes_read;
+  /**
+   * Page write transactions.
+   */
+  uint32_t        page_writes;
+  /**
+   * Bytes written.
+   */
+  uint32_t        bytes_written;
+  /**
+   * Status reads returning a write cycle in progress.
+   */
+  uint32_t        busy_polls;
+  /**
+   * Time spent waiting for write cycles.
+   */
+  sysinterval_t   busy_time;
+} SPIEepromStats;
+
 /**
  * @extends EepromFileConfig
  */
@@ -26,6 +56,32 @@ typedef struct {
    * Config associated with SPI driver.
    */
   const SPIConfig *spicfg;
+  /**
+   * Optional buffer of (pagesize + 4) bytes. When set the command, the
+   * address and the data of a page write are sent by a single transfer.
+   * Declare with CC_SECTION(".nocache") ... if using SPI with DMA to avoid
+   * cache coherence issues.
+   */
+  uint8_t         *write_buf;
+  /**
+   * Read with the FAST_READ command, for ICs supporting it.
+   */
+  bool            fast_read;
+  /**
+   * Interval between two status polls during a write cycle, the thread
+   * just yields when zero.
+   */
+  sysinterval_t   poll_interval;
+  /**
+   * Optional flag of a write cycle possibly in progress, shared by all the
+   * files on the IC. When set the status is only read by the access after
+   * a page write, otherwise it is read before every access.
+   */
+  bool            *pending;
+  /**
+   * Optional transfer counters, cleared by SPIEepromFileOpen().
+   */
+  SPIEepromStats  *stats;
 } SPIEepromFileConfig;
 
 /**
@@ -46,6 +102,9 @@ typedef struct {
   const SPIEepromFileConfig *cfg;
 } SPIEepromFileStream;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 /**
  * Open SPI EEPROM IC as file and return pointer to the file stream object
  * @note      Fucntion allways successfully open file. All checking makes
@@ -54,9 +113,10 @@ typedef struct {
 EepromFileStream *SPIEepromFileOpen(SPIEepromFileStream *efs,
                                     const SPIEepromFileConfig *eepcfg,
                                     const EepromDevice *eepdev);
-
-#define SPIEepromFileOpen(efs, eepcfg, eepdev) \
-  EepromFileOpen((EepromFileStream *)efs, (EepromFileConfig *)eepcfg, eepdev);
+msg_t SPIEepromFileSync(EepromFileStream *efs);
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* #if defined(EEPROM_USE_EE25XX) && EEPROM_USE_EE25XX */
 
@@ -37,7 +37,11 @@
 #define NAND_CMD_READ0          0x00
 #define NAND_CMD_RNDOUT         0x05
 #define NAND_CMD_PAGEPROG       0x10
+#define NAND_CMD_MULTIPROG      0x11
+#define NAND_CMD_CACHEPROG      0x15
 #define NAND_CMD_READ0_CONFIRM  0x30
+#define NAND_CMD_READ_CACHE     0x31
+#define NAND_CMD_READ_CACHE_END 0x3F
 #define NAND_CMD_READOOB        0x50
 #define NAND_CMD_ERASE          0x60
 #define NAND_CMD_STATUS         0x70
@@ -46,8 +50,18 @@
 #define NAND_CMD_RNDIN          0x85
 #define NAND_CMD_READID         0x90
 #define NAND_CMD_ERASE_CONFIRM  0xD0
+#define NAND_CMD_ERASE_MULTI    0xD1
+#define NAND_CMD_RNDOUT_START   0xE0
 #define NAND_CMD_RESET          0xFF
 
+/*
+ * Status register bits
+ */
+#define NAND_STATUS_FAIL        0x01
+#define NAND_STATUS_FAILC       0x02
+#define NAND_STATUS_READY       0x40
+#define NAND_STATUS_NOT_PROT    0x80
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -128,6 +142,17 @@ extern "C" {
   uint8_t nandWritePageSpare(NANDDriver *nandp, uint32_t die, uint32_t logun,
                              uint32_t plane, uint32_t block, uint32_t page,
                              const void *spare, size_t sparelen);
+  void nandReadPagesCached(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                           uint32_t plane, uint32_t block, uint32_t page,
+                           void *data, size_t datalen, uint32_t n);
+  uint8_t nandWritePagesCached(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                               uint32_t plane, uint32_t block, uint32_t page,
+                               const void *data, size_t datalen, uint32_t n);
+  uint8_t nandWritePageMultiPlane(NANDDriver *nandp, uint32_t die,
+                                  uint32_t logun, uint32_t block, uint32_t page,
+                                  const void *data, size_t datalen);
+  uint8_t nandEraseMultiPlane(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                              uint32_t block);
   uint16_t nandReadBadMark(NANDDriver *nandp, uint32_t die, uint32_t logun,
                            uint32_t plane, uint32_t block, uint32_t page);
   void nandMarkBad(NANDDriver *nandp, uint32_t die, uint32_t logun, 
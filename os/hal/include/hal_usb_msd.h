@@ -53,6 +53,31 @@
 #define MSD_THD_PRIO                    NORMALPRIO
 #endif
 
+/**
+ * @brief Maximum number of logical units, each one backed by a block device.
+ */
+#if !defined(USB_MSD_MAX_LUNS) || defined(__DOXYGEN__)
+#define USB_MSD_MAX_LUNS                1
+#endif
+
+/**
+ * @brief Enables the pipelined worker.
+ * @details The CSW is transmitted asynchronously and the receive of the next
+ *          CBW is armed while it is in flight, instead of serializing the
+ *          CBW, data and CSW stages with blocking calls.
+ */
+#if !defined(USB_MSD_USE_PIPELINE) || defined(__DOXYGEN__)
+#define USB_MSD_USE_PIPELINE            TRUE
+#endif
+
+/**
+ * @brief Enables the per-command latency and throughput counters.
+ * @note  The counters are based on the HAL realtime counter.
+ */
+#if !defined(USB_MSD_USE_STATISTICS) || defined(__DOXYGEN__)
+#define USB_MSD_USE_STATISTICS          FALSE
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -65,6 +90,10 @@
 #error "Mass storage Driver requires USB_USE_WAIT"
 #endif
 
+#if (USB_MSD_MAX_LUNS < 1) || (USB_MSD_MAX_LUNS > 16)
+#error "USB_MSD_MAX_LUNS must be within 1 and 16"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -108,6 +137,57 @@ typedef struct {
   uint8_t   status;
 } msd_csw_t;
 
+/**
+ * @brief   Counters of a class of commands.
+ * @details The throughput is @p bytes over @p cumulative, converted with
+ *          @p RTC2US(halGetCounterFrequency(), cumulative).
+ */
+typedef struct {
+  /**
+   * @brief   Number of executed commands.
+   */
+  uint32_t  n;
+  /**
+   * @brief   Number of failed commands.
+   */
+  uint32_t  failed;
+  /**
+   * @brief   Execution time of the last command in counter ticks.
+   */
+  rtcnt_t   last;
+  /**
+   * @brief   Worst execution time in counter ticks.
+   */
+  rtcnt_t   worst;
+  /**
+   * @brief   Total execution time in counter ticks.
+   */
+  uint64_t  cumulative;
+  /**
+   * @brief   Total number of data bytes moved.
+   */
+  uint64_t  bytes;
+} usb_msd_cmd_stats_t;
+
+/**
+ * @brief   Mass storage driver counters.
+ * @details Commands are classified by the direction of their data stage.
+ */
+typedef struct {
+  /**
+   * @brief   Commands transmitting data to the host.
+   */
+  usb_msd_cmd_stats_t           read;
+  /**
+   * @brief   Commands receiving data from the host.
+   */
+  usb_msd_cmd_stats_t           write;
+  /**
+   * @brief   Commands without data stage.
+   */
+  usb_msd_cmd_stats_t           other;
+} usb_msd_stats_t;
+
 /**
  * @brief   Transport handler passed to SCSI layer.
  */
@@ -152,13 +232,21 @@ struct USBMassStorageDriver {
    */
   thread_reference_t            worker;
   /**
-   * @brief   SCSI target driver structure.
+   * @brief   SCSI target driver structures, one per logical unit.
+   */
+  SCSITarget                    scsi_target[USB_MSD_MAX_LUNS];
+  /**
+   * @brief   SCSI target configuration structures, one per logical unit.
    */
-  SCSITarget                    scsi_target;
+  SCSITargetConfig              scsi_config[USB_MSD_MAX_LUNS];
   /**
-   * @brief   SCSI target configuration structure.
+   * @brief   Number of configured logical units, logical unit 0 included.
    */
-  SCSITargetConfig              scsi_config;
+  uint8_t                       luns;
+  /**
+   * @brief   Get max LUN request response buffer.
+   */
+  uint8_t                       max_lun;
   /**
    * @brief   SCSI transport structure.
    */
@@ -167,6 +255,12 @@ struct USBMassStorageDriver {
    * @brief   SCSI over USB transport handler structure.
    */
   usb_scsi_transport_handler_t  usb_scsi_transport_handler;
+#if (USB_MSD_USE_STATISTICS == TRUE) || defined(__DOXYGEN__)
+  /**
+   * @brief   Per-command counters, reset by @p msdStart().
+   */
+  usb_msd_stats_t               stats;
+#endif
 };
 
 
@@ -185,9 +279,13 @@ extern "C" {
 #endif
   void msdObjectInit(USBMassStorageDriver *msdp);
   void msdStart(USBMassStorageDriver *msdp, USBDriver *usbp,
-                BaseBlockDevice *blkdev, uint8_t *blkbuf,
+                BaseBlockDevice *blkdev, uint8_t *blkbuf, size_t blkbufsize,
                 const scsi_inquiry_response_t *scsi_inquiry_response,
                 const scsi_unit_serial_number_inquiry_response_t *serialInquiry);
+  bool msdAddLUN(USBMassStorageDriver *msdp, BaseBlockDevice *blkdev,
+                 const scsi_inquiry_response_t *inquiry,
+                 const scsi_unit_serial_number_inquiry_response_t *serialInquiry);
+  void msdSetUnmap(USBMassStorageDriver *msdp, uint8_t lun, scsi_unmap_t unmap);
   void msdStop(USBMassStorageDriver *msdp);
   bool msd_request_hook(USBDriver *usbp);
 #ifdef __cplusplus
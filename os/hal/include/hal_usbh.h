@@ -56,11 +56,26 @@
 #define HAL_USBH_USE_IAD     HAL_USBH_USE_UVC
 #endif
 
+/* Internal thread running the main loop when a port status changes, instead
+ * of the application calling usbhMainLoop() periodically */
+#ifndef HAL_USBH_USE_MAIN_THREAD
+#define HAL_USBH_USE_MAIN_THREAD	FALSE
+#endif
+
+#ifndef HAL_USBH_MAIN_THREAD_WA_SIZE
+#define HAL_USBH_MAIN_THREAD_WA_SIZE	1024
+#endif
+
+#ifndef HAL_USBH_MAIN_THREAD_PRIO
+#define HAL_USBH_MAIN_THREAD_PRIO	NORMALPRIO
+#endif
+
 #if (HAL_USE_USBH == TRUE) || defined(__DOXYGEN__)
 
 #include "osal.h"
 #include "usbh/list.h"
 #include "usbh/defs.h"
+#include "usbh/desciter.h"
 
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
@@ -72,6 +87,9 @@
 #define USBH_MAX_ADDRESSES				(HAL_USBHHUB_MAX_PORTS + 1)
 #endif
 
+/* Event flags broadcast on the driver event source */
+#define USBH_EVENT_STATUS_CHANGE		1	/* usbhMainLoop() has work to do */
+
 enum usbh_status {
 	USBH_STATUS_STOPPED = 0,
 	USBH_STATUS_STARTED,
@@ -214,6 +232,7 @@ struct usbh_device {
 	USBH_DECLARE_STRUCT_MEMBER(usbh_config_descriptor_t basicConfigDesc);
 
 	uint8_t *fullConfigurationDescriptor;
+	descidx_t cfgIndex;		/* built along with fullConfigurationDescriptor */
 	uint8_t keepFullCfgDesc;
 
 	uint8_t address;
@@ -277,6 +296,15 @@ struct USBHDriver {
 	struct list_head hubs;
 #endif
 
+	/* status changes, from the low level driver and the hubs */
+	event_source_t event;
+	bool statuschange;
+#if HAL_USBH_USE_MAIN_THREAD
+	thread_reference_t main_tr;
+	thread_t *main_thread;
+	THD_WORKING_AREA(main_wa, HAL_USBH_MAIN_THREAD_WA_SIZE);
+#endif
+
 	/* Low level part */
 	_usbhdriver_ll_data
 
@@ -311,6 +339,9 @@ extern "C" {
 	void usbhStop(USBHDriver *usbh);
 	void usbhSuspend(USBHDriver *usbh);
 	void usbhResume(USBHDriver *usbh);
+	static inline event_source_t *usbhGetEventSource(USBHDriver *usbh) {
+		return &usbh->event;
+	}
 
 	/* Device-related */
 #if	USBH_DEBUG_ENABLE && USBH_DEBUG_ENABLE_INFO
@@ -459,9 +490,39 @@ struct usbh_classdriver_vmt {
 	/* TODO: add power control, suspend, etc */
 };
 
+/* Match table entry, -1 fields are wildcards. The core only calls load() for
+ * a descriptor (device, IAD or interface) matching at least one entry */
+typedef struct usbh_classdriver_match {
+	int16_t type;		/* USBH_DT_DEVICE, USBH_DT_INTERFACE_ASSOCIATION or USBH_DT_INTERFACE */
+	int32_t vid;
+	int32_t pid;
+	int16_t _class;
+	int16_t subclass;
+	int16_t protocol;
+} usbh_classdriver_match_t;
+
+#define USBH_MATCH_DEVICE(vid, pid, _class, subclass, protocol)		\
+	{USBH_DT_DEVICE, (vid), (pid), (_class), (subclass), (protocol)}
+#define USBH_MATCH_IAD(_class, subclass, protocol)					\
+	{USBH_DT_INTERFACE_ASSOCIATION, -1, -1, (_class), (subclass), (protocol)}
+#define USBH_MATCH_INTERFACE(_class, subclass, protocol)			\
+	{USBH_DT_INTERFACE, -1, -1, (_class), (subclass), (protocol)}
+#define USBH_MATCH_VENDOR_INTERFACE(vid, pid, _class, subclass, protocol)	\
+	{USBH_DT_INTERFACE, (vid), (pid), (_class), (subclass), (protocol)}
+
 struct usbh_classdriverinfo {
 	const char *name;
 	const usbh_classdriver_vmt_t *vmt;
+	/* NULL: load() is tried on every descriptor */
+	const usbh_classdriver_match_t *match;
+	uint8_t match_count;
+};
+
+/* Node linking a class driver in the registry */
+typedef struct usbh_classdriverlink usbh_classdriverlink_t;
+struct usbh_classdriverlink {
+	const usbh_classdriverinfo_t *info;
+	usbh_classdriverlink_t *next;
 };
 
 #define _usbh_base_classdriver_data		\
@@ -473,6 +534,15 @@ struct usbh_baseclassdriver {
 	_usbh_base_classdriver_data
 };
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+	void usbhClassDriverRegister(usbh_classdriverlink_t *link,
+			const usbh_classdriverinfo_t *info);
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
 #endif /* HAL_USBH_H_ */
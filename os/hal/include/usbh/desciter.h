@@ -58,6 +58,57 @@ static inline const usbh_endpoint_descriptor_t *ep_get(generic_iterator_t *iep)
 	return (const usbh_endpoint_descriptor_t *)iep->curr;
 }
 
+
+/* DESCRIPTOR INDEX */
+/* Offsets of the interface and endpoint descriptors of a configuration
+ * descriptor, parsed once so that lookups don't rescan the descriptor */
+#define DESCIDX_NONE	0xff
+
+typedef struct {
+	uint16_t offset;	/* interface descriptor */
+	uint16_t iad;		/* enclosing IAD, 0 if none */
+	uint8_t ep_first;	/* first entry of the endpoint table */
+	uint8_t ep_count;
+	uint8_t next_alt;	/* next alternate setting of this interface, or DESCIDX_NONE */
+} descidx_if_t;
+
+typedef struct {
+	const uint8_t *cfg;
+	uint16_t total;
+	uint8_t if_count;	/* interface descriptors, all alternate settings */
+	uint16_t ifnum_count;	/* highest bInterfaceNumber + 1 */
+	uint8_t ep_count;
+	descidx_if_t *ifs;	/* in descriptor order */
+	uint16_t *eps;
+	uint8_t *ifnum_first;	/* bInterfaceNumber -> first alternate setting, or DESCIDX_NONE */
+} descidx_t;
+
+size_t descidx_init(descidx_t *idx, const uint8_t *buff, uint16_t rem,
+		void *storage, size_t size);
+void descidx_if_iter(const descidx_t *idx, uint8_t n, if_iterator_t *iif);
+static inline bool descidx_valid(const descidx_t *idx) {
+	return idx->ifs != NULL;
+}
+static inline uint8_t descidx_if_first(const descidx_t *idx, uint8_t ifnum) {
+	if (ifnum >= idx->ifnum_count)
+		return DESCIDX_NONE;
+	return idx->ifnum_first[ifnum];
+}
+static inline uint8_t descidx_if_next_alt(const descidx_t *idx, uint8_t n) {
+	return idx->ifs[n].next_alt;
+}
+static inline const usbh_interface_descriptor_t *descidx_if_get(const descidx_t *idx, uint8_t n) {
+	return (const usbh_interface_descriptor_t *)(idx->cfg + idx->ifs[n].offset);
+}
+static inline const usbh_ia_descriptor_t *descidx_iad_get(const descidx_t *idx, uint8_t n) {
+	if (idx->ifs[n].iad == 0)
+		return NULL;
+	return (const usbh_ia_descriptor_t *)(idx->cfg + idx->ifs[n].iad);
+}
+static inline const usbh_endpoint_descriptor_t *descidx_ep_get(const descidx_t *idx, uint8_t n, uint8_t i) {
+	return (const usbh_endpoint_descriptor_t *)(idx->cfg + idx->eps[idx->ifs[n].ep_first + i]);
+}
+
 #endif
 
 #endif /* USBH_DESCITER_H_ */
@@ -26,9 +26,37 @@
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/* Ring mode: HAL_USBHAOA_RING_URBS IN URBs stay queued on the Bulk IN
+ * endpoint, data goes through buffers queues and a partially filled OUT
+ * buffer is sent HAL_USBHAOA_RING_FLUSH_MS after the first write into it,
+ * or once the buffers before it are sent if that is later */
+#ifndef HAL_USBHAOA_USE_RING
+#define HAL_USBHAOA_USE_RING			FALSE
+#endif
+
+#ifndef HAL_USBHAOA_RING_URBS
+#define HAL_USBHAOA_RING_URBS			4
+#endif
+
+#ifndef HAL_USBHAOA_RING_BUFFERS
+#define HAL_USBHAOA_RING_BUFFERS		8
+#endif
+
+#ifndef HAL_USBHAOA_RING_FLUSH_MS
+#define HAL_USBHAOA_RING_FLUSH_MS		2
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
+#if HAL_USBHAOA_USE_RING
+#if (HAL_USBHAOA_RING_URBS < 1) || (HAL_USBHAOA_RING_URBS > 255)
+#error "HAL_USBHAOA_RING_URBS must be between 1 and 255"
+#endif
+#if HAL_USBHAOA_RING_BUFFERS < 2
+#error "HAL_USBHAOA_RING_BUFFERS must be at least 2"
+#endif
+#endif
 
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
@@ -85,18 +113,34 @@ struct USBHAOAChannel {
 	_base_asynchronous_channel_data
 
 	usbh_ep_t epin;
+#if HAL_USBHAOA_USE_RING
+	usbh_urb_t iq_urbs[HAL_USBHAOA_RING_URBS];
+	USBH_DECLARE_STRUCT_MEMBER(uint8_t iq_buffs[HAL_USBHAOA_RING_URBS][64]);
+	/* completed IN URBs waiting for a free buffer, oldest first */
+	usbh_urb_t *iq_held[HAL_USBHAOA_RING_URBS];
+	uint8_t iq_held_head;
+	uint8_t iq_held_count;
+	input_buffers_queue_t ibqueue;
+	USBH_DECLARE_STRUCT_MEMBER(uint8_t ib[BQ_BUFFER_SIZE(HAL_USBHAOA_RING_BUFFERS, 64)]);
+#else
 	usbh_urb_t iq_urb;
 	threads_queue_t	iq_waiting;
 	uint32_t iq_counter;
 	USBH_DECLARE_STRUCT_MEMBER(uint8_t iq_buff[64]);
 	uint8_t *iq_ptr;
+#endif
 
 	usbh_ep_t epout;
 	usbh_urb_t oq_urb;
+#if HAL_USBHAOA_USE_RING
+	output_buffers_queue_t obqueue;
+	USBH_DECLARE_STRUCT_MEMBER(uint8_t ob[BQ_BUFFER_SIZE(HAL_USBHAOA_RING_BUFFERS, 64)]);
+#else
 	threads_queue_t	oq_waiting;
 	uint32_t oq_counter;
 	USBH_DECLARE_STRUCT_MEMBER(uint8_t oq_buff[64]);
 	uint8_t *oq_ptr;
+#endif
 
 	virtual_timer_t vt;
 
@@ -34,9 +34,26 @@
 #define HAL_USBHHID_USE_INTERRUPT_OUT 				FALSE
 #endif
 
+/* Report descriptor parser: the descriptor is read at load and compiled into
+ * a table of input fields, decoded by usbhhidDecodeReport() */
+#if !defined(HAL_USBHHID_USE_PARSER)
+#define HAL_USBHHID_USE_PARSER 						FALSE
+#endif
+
+#if !defined(HAL_USBHHID_MAX_FIELDS)
+#define HAL_USBHHID_MAX_FIELDS 						32
+#endif
+
+#if !defined(HAL_USBHHID_MAX_REPORT_DESCRIPTOR)
+#define HAL_USBHHID_MAX_REPORT_DESCRIPTOR 			256
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
+#if HAL_USBHHID_USE_PARSER && (HAL_USBHHID_MAX_FIELDS > 255)
+#error "HAL_USBHHID_MAX_FIELDS must be at most 255"
+#endif
 
 
 /*===========================================================================*/
@@ -67,6 +84,23 @@ typedef enum {
 	USBHHID_PROTOCOL_REPORT = 1,
 } usbhhid_protocol_t;
 
+#if HAL_USBHHID_USE_PARSER
+#define USBHHID_FIELD_ARRAY 		0x01	/* value selects a usage from usage */
+#define USBHHID_FIELD_RELATIVE 		0x02
+#define USBHHID_FIELD_SIGNED 		0x04
+
+typedef struct {
+	uint16_t usage_page;
+	uint16_t usage;			/* for arrays, usage of value logical_min */
+	uint16_t bit_offset;	/* from the first byte after the report ID */
+	uint8_t bit_size;
+	uint8_t report_id;
+	uint8_t flags;
+	int32_t logical_min;
+	int32_t logical_max;
+} usbhhid_field_t;
+#endif
+
 typedef struct USBHHIDDriver USBHHIDDriver;
 typedef struct USBHHIDConfig USBHHIDConfig;
 
@@ -97,6 +131,14 @@ struct USBHHIDDriver {
 	const USBHHIDConfig *config;
 
 	semaphore_t sem;
+
+#if HAL_USBHHID_USE_PARSER
+	/* input fields, in descriptor order */
+	usbhhid_field_t fields[HAL_USBHHID_MAX_FIELDS];
+	uint8_t field_count;
+	/* reports start with a report ID byte */
+	bool report_ids;
+#endif
 };
 
 
@@ -135,6 +177,21 @@ extern "C" {
 	}
 
 	void usbhhidStart(USBHHIDDriver *hidp, const USBHHIDConfig *cfg);
+
+#if HAL_USBHHID_USE_PARSER
+	/* Report descriptor fields, valid in ACTIVE and READY states */
+	static inline uint8_t usbhhidGetFieldCount(USBHHIDDriver *hidp) {
+		return hidp->field_count;
+	}
+
+	static inline const usbhhid_field_t *usbhhidGetField(USBHHIDDriver *hidp, uint8_t i) {
+		return &hidp->fields[i];
+	}
+
+	int usbhhidFindField(USBHHIDDriver *hidp, uint16_t usage_page, uint16_t usage);
+	uint8_t usbhhidDecodeReport(USBHHIDDriver *hidp, const uint8_t *report,
+			uint16_t len, int32_t *values);
+#endif
 #ifdef __cplusplus
 }
 #endif
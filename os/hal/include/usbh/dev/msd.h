@@ -33,11 +33,45 @@
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/* Keep several data URBs queued on the bulk endpoint during READ/WRITE, and
+ * pre-arm the CSW, so that the host controller never idles between phases */
+#if !defined(HAL_USBHMSD_USE_PIPELINE)
+#define HAL_USBHMSD_USE_PIPELINE					TRUE
+#endif
+
+/* Number of data URBs kept queued */
+#if !defined(HAL_USBHMSD_PIPELINE_URBS)
+#define HAL_USBHMSD_PIPELINE_URBS					3
+#endif
+
+/* Bytes moved by each data URB; bounds the transfer programmed in the
+ * channel, and must be a multiple of the bulk packet size */
+#if !defined(HAL_USBHMSD_PIPELINE_CHUNK)
+#define HAL_USBHMSD_PIPELINE_CHUNK					4096
+#endif
+
+/* Number of times a failed READ/WRITE is reissued */
+#if !defined(HAL_USBHMSD_MAX_RETRIES)
+#define HAL_USBHMSD_MAX_RETRIES						3
+#endif
+
+/* Delay before the first retry, in milliseconds; doubled at each retry */
+#if !defined(HAL_USBHMSD_RETRY_DELAY)
+#define HAL_USBHMSD_RETRY_DELAY						10
+#endif
 
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if HAL_USBHMSD_USE_PIPELINE
+#if (HAL_USBHMSD_PIPELINE_URBS < 2) || (HAL_USBHMSD_PIPELINE_URBS > 8)
+#error "HAL_USBHMSD_PIPELINE_URBS must be between 2 and 8"
+#endif
+#if (HAL_USBHMSD_PIPELINE_CHUNK == 0) || ((HAL_USBHMSD_PIPELINE_CHUNK % 512) != 0)
+#error "HAL_USBHMSD_PIPELINE_CHUNK must be a non-zero multiple of 512"
+#endif
+#endif
 
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
@@ -53,6 +87,16 @@ struct USBHMassStorageDriverVMT {
 typedef struct USBHMassStorageLUNDriver USBHMassStorageLUNDriver;
 typedef struct USBHMassStorageDriver USBHMassStorageDriver;
 
+/* error recovery counters of a LUN */
+typedef struct {
+	uint32_t retries;			/* commands reissued */
+	uint32_t recovered;			/* commands that succeeded after a retry */
+	uint32_t failed;			/* commands that failed after all retries */
+	uint32_t transport_errors;	/* BOT transactions that failed */
+	uint32_t check_conditions;	/* commands that completed with an error */
+	uint32_t resets;			/* BOT reset recoveries */
+} usbhmsd_lun_stats_t;
+
 struct USBHMassStorageLUNDriver {
 	/* inherited from abstract block driver */
 	const struct USBHMassStorageDriverVMT *vmt;
@@ -64,6 +108,16 @@ struct USBHMassStorageLUNDriver {
 	BlockDeviceInfo info;
 	USBHMassStorageDriver *msdp;
 
+	/* the medium is addressed with READ/WRITE(16) */
+	bool cdb16;
+
+	/* sense data of the last failed command */
+	uint8_t sense_key;
+	uint8_t asc;
+	uint8_t ascq;
+
+	usbhmsd_lun_stats_t stats;
+
 	USBHMassStorageLUNDriver *next;
 };
 
@@ -28,11 +28,17 @@
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/* Frame assembly mode: payloads are written straight into application frame
+ * buffers and complete frames are posted, see usbhuvcStreamStartFrames() */
+#ifndef HAL_USBHUVC_USE_FRAMES
+#define HAL_USBHUVC_USE_FRAMES			FALSE
+#endif
 
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 #define USBHUVC_MAX_STATUS_PACKET_SZ	16
+#define USBHUVC_MAX_HEADER_SZ			12
 
 
 /*===========================================================================*/
@@ -312,6 +318,7 @@ typedef struct USBHUVCDriver USBHUVCDriver;
 
 #define USBHUVC_MESSAGETYPE_STATUS	1
 #define USBHUVC_MESSAGETYPE_DATA	2
+#define USBHUVC_MESSAGETYPE_FRAME	3
 
 
 #define _usbhuvc_message_base_data				\
@@ -334,6 +341,31 @@ typedef struct {
 } usbhuvc_message_status_t;
 
 
+#if HAL_USBHUVC_USE_FRAMES
+/* Frame flags, besides UVC_HDR_ERR and UVC_HDR_STILL copied from the payload headers */
+#define USBHUVC_FRAME_OVERFLOW		(1 << 0)	/* data didn't fit in the buffer and was dropped */
+#define USBHUVC_FRAME_LOST			(1 << 1)	/* packets of this frame were lost */
+
+/* Application frame buffer; posted as a message once complete. The length
+ * field of the message header is not used, see len. */
+typedef struct {
+	_usbhuvc_message_base_data
+	uint8_t *buff;
+	uint32_t size;		/* size of buff, set by the application */
+	uint32_t len;		/* payload bytes assembled */
+	uint32_t seq;		/* frame sequence number */
+	uint8_t flags;
+} usbhuvc_frame_t;
+
+typedef struct {
+	uint32_t frames;			/* frames posted */
+	uint32_t dropped_frames;	/* frames dropped for lack of buffers or mailbox space */
+	uint32_t dropped_packets;	/* ISO packets lost or with an invalid header */
+	uint32_t error_frames;		/* frames posted with UVC_HDR_ERR or USBHUVC_FRAME_LOST */
+	uint32_t overflows;			/* frames posted with USBHUVC_FRAME_OVERFLOW */
+} usbhuvc_frame_stats_t;
+#endif
+
 typedef enum {
 	USBHUVC_STATE_UNINITIALIZED = 0,	//must call usbhuvcObjectInit
 	USBHUVC_STATE_STOP	 		= 1,	//the device is disconnected
@@ -373,6 +405,20 @@ struct USBHUVCDriver {
 	usbhuvc_message_status_t mp_status_buffer[HAL_USBHUVC_STATUS_PACKETS_COUNT];
 
 	mutex_t mtx;
+
+#if HAL_USBHUVC_USE_FRAMES
+	usbhuvc_frame_t *frames;	/* NULL if not streaming in frame mode */
+	usbhuvc_frame_t *frame;		/* frame being assembled */
+	uint32_t frames_free;
+	uint32_t frame_seq;
+	uint8_t frames_n;
+	uint8_t fid;
+	bool synced;				/* a frame boundary has been seen */
+	bool lost;					/* packets lost since the last valid one */
+	uint8_t hdr_len;			/* expected payload header length */
+	uint8_t hdr_save[USBHUVC_MAX_HEADER_SZ];
+	usbhuvc_frame_stats_t frame_stats;
+#endif
 };
 
 
@@ -427,6 +473,14 @@ extern "C" {
 
 	bool usbhuvcStreamStart(USBHUVCDriver *uvcdp, uint16_t min_ep_sz);
 	bool usbhuvcStreamStop(USBHUVCDriver *uvcdp);
+#if HAL_USBHUVC_USE_FRAMES
+	bool usbhuvcStreamStartFrames(USBHUVCDriver *uvcdp, uint16_t min_ep_sz,
+			usbhuvc_frame_t *frames, uint8_t n);
+	void usbhuvcFreeFrame(USBHUVCDriver *uvcdp, usbhuvc_frame_t *frame);
+	static inline const usbhuvc_frame_stats_t *usbhuvcGetFrameStats(USBHUVCDriver *uvcdp) {
+		return &uvcdp->frame_stats;
+	}
+#endif
 
 	static inline msg_t usbhuvcLockAndFetchS(USBHUVCDriver *uvcdp, msg_t *msg, systime_t timeout) {
 		chMtxLockS(&uvcdp->mtx);
@@ -256,6 +256,11 @@ static void nand_lld_serve_transfer_end_irq(NANDDriver *nandp, uint32_t flags) {
     /* thread will be woken up from ready_isr() */
     break;
 
+  case NAND_WRITE:     /* data loaded, the caller issues the command */
+    nandp->state = NAND_READY;
+    wakeup_isr(nandp);
+    break;
+
   case NAND_DMA_RX:
     nandp->state = NAND_READY;
     nandp->rxdata = NULL;
@@ -572,6 +577,99 @@ void nand_lld_write_cmd(NANDDriver *nandp, uint8_t cmd) {
   nandp->map_cmd[0] = cmd;
 }
 
+/**
+ * @brief   Send command followed by address cycles to NAND.
+ * @note    The device is not waited for.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cmd           command value
+ * @param[in] addr          pointer to address array, @NULL if none
+ * @param[in] addrlen       length of address array
+ *
+ * @notapi
+ */
+void nand_lld_write_cmd_addr(NANDDriver *nandp, uint8_t cmd,
+                             const uint8_t *addr, size_t addrlen) {
+
+  set_16bit_bus(nandp);
+  nand_lld_write_cmd(nandp, cmd);
+  __DSB();
+  nand_lld_write_addr(nandp, addr, addrlen);
+  __DSB();
+  set_8bit_bus(nandp);
+}
+
+/**
+ * @brief   Send command to NAND and wait for ready.
+ * @details Used for the confirm commands of the cache and multi-plane
+ *          sequences, the thread is woken up from ready ISR.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cmd           command value
+ *
+ * @notapi
+ */
+void nand_lld_write_cmd_wait(NANDDriver *nandp, uint8_t cmd) {
+
+  nandp->state = NAND_PROGRAM;
+
+  set_16bit_bus(nandp);
+  osalSysLock();
+  nand_lld_write_cmd(nandp, cmd);
+  __DSB();
+  set_8bit_bus(nandp);
+
+  nand_lld_suspend_thread(nandp);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Read data from NAND page buffer.
+ * @details No command is issued, the data comes from the current column.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[out] data         pointer to data buffer
+ * @param[in] datalen       size of data buffer in bytes
+ *
+ * @notapi
+ */
+void nand_lld_read_buf(NANDDriver *nandp, uint16_t *data, size_t datalen) {
+
+  align_check(data, datalen);
+
+  osalSysLock();
+  nandp->state = NAND_DMA_RX;
+  nandp->rxdata = data;
+  nandp->datalen = datalen;
+  dmaStartMemCopy(nandp->dma, nandp->dmamode, nandp->map_data, data,
+                  datalen/AHB_TRANSACTION_WIDTH);
+  nand_lld_suspend_thread(nandp);
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Write data to NAND page buffer.
+ * @details No command is issued, the caller confirms the program.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] data          buffer with data to be written
+ * @param[in] datalen       size of data buffer in bytes
+ *
+ * @notapi
+ */
+void nand_lld_write_buf(NANDDriver *nandp, const uint16_t *data,
+                        size_t datalen) {
+
+  align_check(data, datalen);
+
+  osalSysLock();
+  nandp->state = NAND_WRITE;
+  dmaStartMemCopy(nandp->dma, nandp->dmamode, data, nandp->map_data,
+                  datalen/AHB_TRANSACTION_WIDTH);
+  nand_lld_suspend_thread(nandp);
+  osalSysUnlock();
+}
+
 /**
  * @brief   Read status byte from NAND.
  *
@@ -175,6 +175,14 @@ typedef struct {
    * @brief   Number of write cycles for column addressing.
    */
   uint8_t                   colcycles;
+  /**
+   * @brief   The device implements the cache read, cache program, random
+   *          data output and multi-plane commands.
+   * @details When false the cached and multi-plane functions work a page
+   *          at a time and the bad block scan reads the marks one page
+   *          at a time.
+   */
+  bool                      extended_cmds;
 
   /* End of the mandatory fields.*/
   /**
@@ -287,6 +295,12 @@ extern "C" {
                 size_t datalen, uint8_t *addr, size_t addrlen, uint32_t *ecc);
   void nand_lld_write_addr(NANDDriver *nandp, const uint8_t *addr, size_t len);
   void nand_lld_write_cmd(NANDDriver *nandp, uint8_t cmd);
+  void nand_lld_write_cmd_addr(NANDDriver *nandp, uint8_t cmd,
+                               const uint8_t *addr, size_t addrlen);
+  void nand_lld_write_cmd_wait(NANDDriver *nandp, uint8_t cmd);
+  void nand_lld_read_buf(NANDDriver *nandp, uint16_t *data, size_t datalen);
+  void nand_lld_write_buf(NANDDriver *nandp, const uint16_t *data,
+                          size_t datalen);
   uint8_t nand_lld_write_data(NANDDriver *nandp, const uint16_t *data,
                 size_t datalen, uint8_t *addr, size_t addrlen, uint32_t *ecc);
   uint8_t nand_lld_read_status(NANDDriver *nandp);
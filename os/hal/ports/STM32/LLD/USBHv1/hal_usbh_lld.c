@@ -156,10 +156,45 @@ USBHDriver USBHD2;
 /*===========================================================================*/
 /* Little helper functions.                                                  */
 /*===========================================================================*/
+#define FRNUM_MASK 0x3FFFU
+
+static inline uint16_t _frame_number(USBHDriver *host) {
+	return host->otg->HFNUM & FRNUM_MASK;
+}
+
+static inline uint16_t _frames_since(USBHDriver *host, uint16_t frame) {
+	return (_frame_number(host) - frame) & FRNUM_MASK;
+}
+
 static inline void _move_to_pending_queue(usbh_ep_t *ep) {
+#if STM32_USBH_LATENCY_HISTOGRAM
+	ep->xfer.pending_frame = _frame_number(ep->device->host);
+#endif
 	list_move_tail(&ep->node, ep->pending_list);
 }
 
+#if STM32_USBH_LATENCY_HISTOGRAM
+static inline void _record_latency(USBHDriver *host, usbh_ep_t *ep) {
+	uint16_t frames = _frames_since(host, ep->xfer.pending_frame);
+	uint8_t bucket = 0;
+
+	while (frames && (bucket < STM32_USBH_LATENCY_BUCKETS - 1)) {
+		frames >>= 1;
+		++bucket;
+	}
+	++ep->latency[bucket];
+}
+#endif
+
+#if STM32_USBH_NAK_BACKOFF_FRAMES
+static inline void _park_ep(USBHDriver *host, usbh_ep_t *ep) {
+	ep->xfer.u.frame_counter = STM32_USBH_NAK_BACKOFF_FRAMES;
+	++ep->park_count;
+	list_move_tail(&ep->node, &host->ep_parked_list);
+	host->otg->GINTMSK |= GINTMSK_SOFM;
+}
+#endif
+
 static inline usbh_urb_t *_active_urb(usbh_ep_t *ep) {
 	return list_first_entry(&ep->urb_list, usbh_urb_t, node);
 }
@@ -224,7 +259,7 @@ static void _halt_channel(USBHDriver *host, stm32_hc_management_t *hcm, usbh_lld
 static void _release_channel(USBHDriver *host, stm32_hc_management_t *hcm) {
 	usbh_ep_t *const ep = hcm->ep;
 #if USBH_DEBUG_ENABLE && USBH_LLD_DEBUG_ENABLE_TRACE
-	static const char *reason[] =  {"XFRC",	"XFRC",	"NAK", "STALL",	"ERROR", "ABORT"};
+	static const char *reason[] =  {"XFRC",	"XFRC",	"NAK", "STALL",	"ERROR", "ABORT", "PREEMPT"};
 	uepdbgf("release (%s)", reason[hcm->halt_reason]);
 #endif
 	hcm->hc->HCINTMSK = 0;
@@ -392,6 +427,10 @@ static bool _activate_ep(USBHDriver *host, usbh_ep_t *ep) {
 
 	ep->xfer.len = xfer_len;
 	ep->xfer.packets = (uint16_t)xfer_packets;
+	ep->xfer.start_frame = _frame_number(host);
+#if STM32_USBH_LATENCY_HISTOGRAM
+	_record_latency(host, ep);
+#endif
 
 	/* remove the channel from the free list, link endpoint <-> channel and move to the active queue*/
 	list_del(&hcm->node);
@@ -453,44 +492,135 @@ static void _try_commit_np(USBHDriver *host) {
 
 	list_for_each_entry_safe(item, usbh_ep_t, tmp, &host->ep_pending_lists[USBH_EPTYPE_CTRL], node) {
 		if (!_activate_ep(host, item))
-			return;
+			goto blocked;
 	}
 
 	list_for_each_entry_safe(item, usbh_ep_t, tmp, &host->ep_pending_lists[USBH_EPTYPE_BULK], node) {
 		if (!_activate_ep(host, item))
-			return;
+			goto blocked;
 	}
+	return;
+
+blocked:
+#if STM32_USBH_NP_SLICE_FRAMES
+	/* check the time slices of the active transfers on the next SOFs */
+	host->otg->GINTMSK |= GINTMSK_SOFM;
+#endif
+	return;
+}
+
+static inline bool _np_waiting(USBHDriver *host) {
+#if STM32_USBH_NP_SLICE_FRAMES
+	return !list_empty(&host->ep_pending_lists[USBH_EPTYPE_CTRL])
+			|| !list_empty(&host->ep_pending_lists[USBH_EPTYPE_BULK]);
+#else
+	(void)host;
+	return FALSE;
+#endif
+}
+
+static inline int32_t _periodic_cost(usbh_ep_t *ep) {
+	/* a low speed transaction takes 8 times longer */
+	if (ep->device->speed == USBH_DEVSPEED_LOW)
+		return ep->wMaxPacketSize * 8;
+	return ep->wMaxPacketSize;
+}
+
+static inline bool _periodic_fits(USBHDriver *host, int32_t cost) {
+	/* an endpoint larger than the budget still gets a frame for itself */
+	return (cost <= host->p_budget) || (host->p_budget == STM32_USBH_PERIODIC_BUDGET);
 }
 
 static void _try_commit_p(USBHDriver *host, bool sof) {
 	usbh_ep_t *item, *tmp;
+	bool blocked = FALSE;	/* no channel or queue space left */
+	int32_t cost;
 
 	list_for_each_entry_safe(item, usbh_ep_t, tmp, &host->ep_pending_lists[USBH_EPTYPE_ISO], node) {
-		if (!_activate_ep(host, item))
-			return;
+		cost = _periodic_cost(item);
+		if (!_periodic_fits(host, cost))
+			continue;
+		if (!_activate_ep(host, item)) {
+			blocked = TRUE;
+			break;
+		}
+		host->p_budget -= cost;
 	}
 
 	list_for_each_entry_safe(item, usbh_ep_t, tmp, &host->ep_pending_lists[USBH_EPTYPE_INT], node) {
 		osalDbgCheck(item);
-		/* TODO: improve this */
-		if (sof && item->xfer.u.frame_counter)
-			--item->xfer.u.frame_counter;
+		/* keep counting frames for all the endpoints, even if they can't be
+		 * activated in this frame; the ones left due stay ahead in the queue */
+		if (sof && item->xfer.u.frame_counter) {
+			if (--item->xfer.u.frame_counter == 0) {
+#if STM32_USBH_LATENCY_HISTOGRAM
+				item->xfer.pending_frame = _frame_number(host);
+#endif
+			}
+		}
 
-		if (item->xfer.u.frame_counter == 0) {
-			if (!_activate_ep(host, item))
-				return;
-			item->xfer.u.frame_counter = item->bInterval;
+		if (blocked || (item->xfer.u.frame_counter != 0))
+			continue;
+
+		cost = _periodic_cost(item);
+		if (!_periodic_fits(host, cost))
+			continue;
+		if (!_activate_ep(host, item)) {
+			blocked = TRUE;
+			continue;
 		}
+		host->p_budget -= cost;
+		item->xfer.u.frame_counter = item->bInterval;
 	}
 
 	if (list_empty(&host->ep_pending_lists[USBH_EPTYPE_ISO])
-		&& list_empty(&host->ep_pending_lists[USBH_EPTYPE_INT])) {
+		&& list_empty(&host->ep_pending_lists[USBH_EPTYPE_INT])
+		&& list_empty(&host->ep_parked_list)
+		&& !_np_waiting(host)) {
 		host->otg->GINTMSK &= ~GINTMSK_SOFM;
 	} else {
 		host->otg->GINTMSK |= GINTMSK_SOFM;
 	}
 }
 
+#if STM32_USBH_NAK_BACKOFF_FRAMES
+static void _unpark_np(USBHDriver *host) {
+	usbh_ep_t *item, *tmp;
+	bool unparked = FALSE;
+
+	list_for_each_entry_safe(item, usbh_ep_t, tmp, &host->ep_parked_list, node) {
+		if (--item->xfer.u.frame_counter == 0) {
+			_move_to_pending_queue(item);
+			unparked = TRUE;
+		}
+	}
+
+	if (unparked)
+		_try_commit_np(host);
+}
+#endif
+
+#if STM32_USBH_NP_SLICE_FRAMES
+static void _preempt_np(USBHDriver *host) {
+	usbh_ep_t *item;
+
+	if (!_np_waiting(host) || !list_empty(&host->ch_free[1]))
+		return;
+
+	/* transfers are in activation order: halt the oldest one whose time slice
+	 * is over, it will be queued again behind the waiting endpoints */
+	list_for_each_entry(item, usbh_ep_t, &host->ep_active_lists[USBH_EPTYPE_BULK], node) {
+		stm32_hc_management_t *const hcm = item->xfer.hcm;
+		if (_frames_since(host, item->xfer.start_frame) < STM32_USBH_NP_SLICE_FRAMES)
+			return;
+		if (hcm->halt_reason == USBH_LLD_HALTREASON_NONE) {
+			_halt_channel(host, hcm, USBH_LLD_HALTREASON_PREEMPT);
+			return;
+		}
+	}
+}
+#endif
+
 static void _purge_queue(USBHDriver *host, struct list_head *list) {
 	usbh_ep_t *ep, *tmp;
 	list_for_each_entry_safe(ep, usbh_ep_t, tmp, list, node) {
@@ -518,6 +648,7 @@ static void _purge_pending(USBHDriver *host) {
 	_purge_queue(host, &host->ep_pending_lists[1]);
 	_purge_queue(host, &host->ep_pending_lists[2]);
 	_purge_queue(host, &host->ep_pending_lists[3]);
+	_purge_queue(host, &host->ep_parked_list);
 }
 
 static uint32_t _write_packet(struct list_head *list, uint32_t space_available) {
@@ -624,6 +755,11 @@ void usbh_lld_ep_object_init(usbh_ep_t *ep) {
 	INIT_LIST_HEAD(&ep->urb_list);
 	INIT_LIST_HEAD(&ep->node);
 
+	ep->nak_count = 0;
+	ep->park_count = 0;
+#if STM32_USBH_LATENCY_HISTOGRAM
+	memset(ep->latency, 0, sizeof(ep->latency));
+#endif
 	ep->hcintmsk = hcintmsk;
 	ep->hcchar = HCCHAR_CHENA
 			| HCCHAR_DAD(ep->device->address)
@@ -790,7 +926,13 @@ static inline void _frmor_int(USBHDriver *host, stm32_hc_management_t *hcm, stm3
 static inline void _nak_int(USBHDriver *host, stm32_hc_management_t *hcm, stm32_otg_host_chn_t *hc) {
 	usbh_ep_t *const ep = hcm->ep;
 	osalDbgAssert(hcm->ep->type != USBH_EPTYPE_ISO, "NAK should not happen in ISO endpoints");
-	if (!ep->in || (ep->type == USBH_EPTYPE_INT)) {
+	++ep->nak_count;
+	if (!ep->in || (ep->type == USBH_EPTYPE_INT)
+#if STM32_USBH_NAK_BACKOFF_FRAMES
+			/* don't poll an idle Bulk IN endpoint at bus speed, park it instead */
+			|| (ep->type == USBH_EPTYPE_BULK)
+#endif
+			) {
 		hc->HCINTMSK &= ~HCINTMSK_NAKM;
 		_halt_channel(host, hcm, USBH_LLD_HALTREASON_NAK);
 	} else {
@@ -888,6 +1030,14 @@ static inline void _xfrc_int(USBHDriver *host, stm32_hc_management_t *hcm, stm32
 
 	hc->HCINTMSK &= ~HCINTMSK_XFRCM;
 
+#if STM32_USBH_NP_SLICE_FRAMES
+	if (hcm->halt_reason == USBH_LLD_HALTREASON_PREEMPT) {
+		/* completed while being preempted, finish it on the CHH interrupt */
+		hcm->halt_reason = USBH_LLD_HALTREASON_XFRC;
+		return;
+	}
+#endif
+
 	switch (ep->type) {
 	case USBH_EPTYPE_CTRL:
 		if (ep->xfer.u.ctrl_phase == USBH_LLD_CTRLPHASE_SETUP) {
@@ -940,7 +1090,7 @@ static inline void _chh_int(USBHDriver *host, stm32_hc_management_t *hcm, stm32_
 	}
 
 	if (reason == USBH_LLD_HALTREASON_XFRC) {
-		osalDbgCheck(ep->in);
+		osalDbgCheck(ep->in || (ep->type == USBH_EPTYPE_BULK));
 		switch (ep->type) {
 		case USBH_EPTYPE_CTRL:
 			_complete_control(host, hcm, ep, urb, hctsiz);
@@ -964,6 +1114,12 @@ static inline void _chh_int(USBHDriver *host, stm32_hc_management_t *hcm, stm32_
 				_transfer_completedI(ep, urb, USBH_URBSTATUS_TIMEOUT);
 			} else {
 				ep->xfer.error_count = 0;
+#if STM32_USBH_NAK_BACKOFF_FRAMES
+				if ((ep->type == USBH_EPTYPE_BULK) && ep->in) {
+					_park_ep(host, ep);
+					break;
+				}
+#endif
 				_move_to_pending_queue(ep);
 			}
 			break;
@@ -993,6 +1149,15 @@ static inline void _chh_int(USBHDriver *host, stm32_hc_management_t *hcm, stm32_
 			_transfer_completedI(ep, urb, urb->status);
 			break;
 
+		case USBH_LLD_HALTREASON_PREEMPT:
+			if (done) {
+				_transfer_completedI(ep, urb, USBH_URBSTATUS_OK);
+			} else {
+				uepdbgf("Preempted");
+				_move_to_pending_queue(ep);
+			}
+			break;
+
 		default:
 			osalDbgCheck(0);
 			break;
@@ -1119,6 +1284,14 @@ static inline void _sof_int(USBHDriver *host) {
 
 	/* real SOF interrupt */
 	udbg("SOF");
+	++host->sof_count;
+	host->p_budget = STM32_USBH_PERIODIC_BUDGET;
+#if STM32_USBH_NAK_BACKOFF_FRAMES
+	_unpark_np(host);
+#endif
+#if STM32_USBH_NP_SLICE_FRAMES
+	_preempt_np(host);
+#endif
 	_try_commit_p(host, TRUE);
 }
 
@@ -1371,6 +1544,8 @@ static void usb_lld_serve_interrupt(USBHDriver *host) {
 	stm32_otg_t *const otg = host->otg;
 	uint32_t gintsts = otg->GINTSTS;
 
+	++host->irq_count;
+
 	/* check host mode */
 	if (!(gintsts & GINTSTS_CMOD)) {
 		uerr("Device mode");
@@ -1394,6 +1569,8 @@ static void usb_lld_serve_interrupt(USBHDriver *host) {
 
 	otg->GINTSTS = gintsts;
 
+	const usbh_portcstatus_t c_status = host->rootport.lld_c_status;
+
 	if (gintsts & GINTSTS_SOF)
 		_sof_int(host);
 	if (gintsts & GINTSTS_RXFLVL)
@@ -1411,6 +1588,10 @@ static void usb_lld_serve_interrupt(USBHDriver *host) {
 	if (gintsts & GINTSTS_IPXFR) {
 		uerr("IPXFRM");
 	}
+
+	/* new root port changes, wake up the main loop */
+	if (host->rootport.lld_c_status & ~c_status)
+		_usbh_statuschangeI(host);
 }
 
 
@@ -1516,6 +1697,10 @@ static void _init(USBHDriver *host) {
 		INIT_LIST_HEAD(&host->ep_active_lists[i]);
 		INIT_LIST_HEAD(&host->ep_pending_lists[i]);
 	}
+	INIT_LIST_HEAD(&host->ep_parked_list);
+	host->p_budget = STM32_USBH_PERIODIC_BUDGET;
+	host->irq_count = 0;
+	host->sof_count = 0;
 }
 
 void usbh_lld_init(void) {
@@ -1807,6 +1992,8 @@ usbh_urbstatus_t usbh_lld_root_hub_request(USBHDriver *host, uint8_t bmRequestTy
 			otg->HPRT = hprt;
 			osalThreadSleepS(OSAL_MS2I(10));
 			host->rootport.lld_c_status |= USBH_PORTSTATUS_C_RESET;
+			_usbh_statuschangeI(host);
+			osalOsRescheduleS();
 			osalSysUnlock();
 		} 	break;
 
@@ -25,6 +25,34 @@
 #include "osal.h"
 #include "stm32_otg.h"
 
+/* Number of frames a Bulk IN endpoint waits after a NAK before it is retried;
+ * 0 restarts the channel from the NAK interrupt (one interrupt per NAK).
+ * The wait adds up to that many frames of latency to every Bulk IN transfer
+ * the device doesn't answer at once, enable it for idle polled ports */
+#if !defined(STM32_USBH_NAK_BACKOFF_FRAMES)
+#define STM32_USBH_NAK_BACKOFF_FRAMES 0
+#endif
+
+/* Number of frames a Bulk transfer may keep a channel while other
+ * non-periodic endpoints wait for one; 0 disables the time slicing */
+#if !defined(STM32_USBH_NP_SLICE_FRAMES)
+#define STM32_USBH_NP_SLICE_FRAMES 4
+#endif
+
+/* Bytes of periodic transactions started per frame (90% of a FS frame) */
+#if !defined(STM32_USBH_PERIODIC_BUDGET)
+#define STM32_USBH_PERIODIC_BUDGET 1350
+#endif
+
+/* Keep a histogram of the frames each endpoint waits for a channel */
+#if !defined(STM32_USBH_LATENCY_HISTOGRAM)
+#define STM32_USBH_LATENCY_HISTOGRAM FALSE
+#endif
+
+/* Bucket 0 counts the waits shorter than one frame, bucket n the waits of
+ * 2^(n-1) to 2^n - 1 frames; the last bucket also counts the longer ones */
+#define STM32_USBH_LATENCY_BUCKETS 8
+
 /* TODO:
  *
  * - Implement ISO/INT OUT and test
@@ -46,7 +74,8 @@ typedef enum {
 	USBH_LLD_HALTREASON_NAK,
 	USBH_LLD_HALTREASON_STALL,
 	USBH_LLD_HALTREASON_ERROR,
-	USBH_LLD_HALTREASON_ABORT
+	USBH_LLD_HALTREASON_ABORT,
+	USBH_LLD_HALTREASON_PREEMPT
 } usbh_lld_halt_reason_t;
 
 
@@ -72,8 +101,22 @@ typedef struct stm32_hc_management {
 	/* Enpoints being processed */									\
 	struct list_head ep_active_lists[4];							\
 	/* Pending endpoints */											\
-	struct list_head ep_pending_lists[4];
-
+	struct list_head ep_pending_lists[4];							\
+	/* Bulk IN endpoints waiting for a SOF after a NAK */			\
+	struct list_head ep_parked_list;								\
+	/* periodic bytes left in this frame */							\
+	int32_t p_budget;												\
+	/* statistics */												\
+	uint32_t irq_count;												\
+	uint32_t sof_count;
+
+
+#if STM32_USBH_LATENCY_HISTOGRAM
+#define _usbh_ep_ll_latency_data														\
+		uint32_t			latency[STM32_USBH_LATENCY_BUCKETS]; /* channel wait */
+#else
+#define _usbh_ep_ll_latency_data
+#endif
 
 #define _usbh_ep_ll_data																\
 		struct list_head	*active_list;		/* shortcut to ep list */				\
@@ -84,6 +127,9 @@ typedef struct stm32_hc_management {
 		uint32_t			hcchar;														\
 		uint32_t 			dt_mask;			/* data-toggle mask */					\
 		int32_t				trace_level;		/* enable tracing */					\
+		uint32_t			nak_count;			/* NAKs received */						\
+		uint32_t			park_count;			/* times parked after a NAK */			\
+		_usbh_ep_ll_latency_data														\
 		/* current transfer */															\
 		struct {																		\
 			stm32_hc_management_t *hcm;				/* assigned channel */				\
@@ -92,10 +138,12 @@ typedef struct stm32_hc_management {
 			uint32_t			partial;			/* this transfer's partial length */\
 			uint16_t			packets;			/* packets allocated */				\
 			union {																		\
-				uint32_t			frame_counter;		/* frame counter (for INT) */	\
+				uint32_t			frame_counter;		/* frame counter (for INT, BULK) */\
 				usbh_lld_ctrlphase_t	ctrl_phase;		/* control phase (for CTRL) */	\
 			} u;																		\
 			uint8_t				error_count;		/* error count */					\
+			uint16_t			pending_frame;		/* frame it started waiting */		\
+			uint16_t			start_frame;		/* frame the channel was assigned */\
 		} xfer;
 
 
@@ -0,0 +1,748 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_nand_lld.c
+ * @brief   RAM backed NAND simulator low level driver source.
+ *
+ * @addtogroup NAND
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+#include <string.h>
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   ID returned by the 0x90 command, ONFI signature.
+ */
+#define NANDSIM_ID              0x49464E4FU
+
+/**
+ * @brief   Size of the page registers, data plus spare.
+ */
+#define NANDSIM_REG_SIZE        (NAND_MAX_PAGE_SIZE + NAND_MAX_PAGE_SIZE / 8)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   NAND1 driver identifier.
+ */
+#if SIM_NAND_USE_NAND1 || defined(__DOXYGEN__)
+NANDDriver NANDD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Cache register, the data cycles are served from here.
+ */
+static uint8_t cache_reg[NANDSIM_REG_SIZE];
+
+/**
+ * @brief   Page registers loaded by the program sequences, one per plane.
+ */
+static uint8_t page_regs[SIM_NAND_MAX_PLANES][NANDSIM_REG_SIZE];
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static size_t page_size(const NANDConfig *cfg) {
+
+  return cfg->page_data_size + cfg->page_spare_size;
+}
+
+static uint32_t rows_total(const NANDConfig *cfg) {
+
+  return cfg->loguns * cfg->planes * cfg->blocks * cfg->pages_per_block;
+}
+
+static uint32_t decode(const uint8_t *addr, size_t len) {
+
+  uint32_t val = 0;
+
+  while (len-- > 0U) {
+    val = (val << 8) | addr[len];
+  }
+  return val;
+}
+
+/**
+ * @brief   Hamming code of the transferred data, as the STM32 FSMC does.
+ * @details The code covers the first @p page_data_size bytes, bit 2k+1 is
+ *          the parity of the bits whose position has bit k set, bit 2k
+ *          of those with bit k clear.
+ *
+ * @notapi
+ */
+static uint32_t calc_ecc(const NANDConfig *cfg, const uint8_t *data,
+                         size_t datalen) {
+
+  uint32_t i, b, k, pos = 0U, all = 0U, ecc = 0U;
+  uint32_t bits = 0U;
+
+  if (datalen > cfg->page_data_size) {
+    datalen = cfg->page_data_size;
+  }
+  for (i = 0; i < datalen; i++) {
+    for (b = 0; b < 8U; b++) {
+      if ((data[i] & (1U << b)) != 0U) {
+        pos ^= i * 8U + b;
+        all ^= 1U;
+      }
+    }
+  }
+  for (k = cfg->page_data_size * 8U; k > 1U; k >>= 1) {
+    bits++;
+  }
+  for (k = 0; k < bits; k++) {
+    ecc |= ((((pos >> k) & 1U) ^ all) << (2U * k)) |
+           (((pos >> k) & 1U) << (2U * k + 1U));
+  }
+  return ecc;
+}
+
+/**
+ * @brief   Accounts a program or erase operation against the power cut.
+ *
+ * @return              The fraction of the operation to be carried out.
+ * @retval 2            the whole operation.
+ * @retval 1            half of it, power goes away meanwhile.
+ * @retval 0            nothing, power is gone.
+ *
+ * @notapi
+ */
+static unsigned power_check(NANDDriver *nandp) {
+
+  if (nandp->power_cut == 0U) {
+    return 2;
+  }
+  if (nandp->power_cut == 1U) {
+    nandp->power_cut = 0xFFFFFFFFU;
+    return 1;
+  }
+  if (nandp->power_cut == 0xFFFFFFFFU) {
+    return 0;
+  }
+  nandp->power_cut--;
+  return 2;
+}
+
+/**
+ * @brief   Accounts bus cycles in the timing model.
+ *
+ * @notapi
+ */
+static void time_bus(NANDDriver *nandp, size_t bytes) {
+
+  if (NULL != nandp->config->timing) {
+    nandp->stats.time_ns += (uint64_t)bytes * nandp->config->timing->byte_ns;
+  }
+}
+
+/**
+ * @brief   Starts an array operation in the timing model.
+ * @details The operation starts once the previous one is over, with
+ *          @p wait the host waits for it to complete too.
+ *
+ * @notapi
+ */
+static void time_array(NANDDriver *nandp, uint32_t ns, bool wait) {
+
+  if (nandp->stats.time_ns < nandp->array_ready) {
+    nandp->stats.time_ns = nandp->array_ready;
+  }
+  nandp->array_ready = nandp->stats.time_ns + ns;
+  if (wait) {
+    nandp->stats.time_ns = nandp->array_ready;
+  }
+}
+
+static uint32_t t_read(NANDDriver *nandp) {
+
+  return NULL != nandp->config->timing ? nandp->config->timing->read_ns : 0U;
+}
+
+static uint32_t t_prog(NANDDriver *nandp) {
+
+  return NULL != nandp->config->timing ? nandp->config->timing->prog_ns : 0U;
+}
+
+static uint32_t t_erase(NANDDriver *nandp) {
+
+  return NULL != nandp->config->timing ? nandp->config->timing->erase_ns : 0U;
+}
+
+/**
+ * @brief   Programs bytes of a page into the array.
+ * @details When the power goes away meanwhile the first half of the bytes
+ *          is programmed, plus the spare area ones with
+ *          @p power_cut_spare.
+ *
+ * @return              The operation outcome.
+ * @retval true         if the whole buffer was programmed.
+ * @retval false        if power went away meanwhile.
+ *
+ * @notapi
+ */
+static bool program(NANDDriver *nandp, uint32_t row, uint32_t col,
+                    const uint8_t *src, size_t len) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint8_t *dst = &cfg->array[row * page_size(cfg) + col];
+  size_t i, n, spare;
+
+  osalDbgCheck((row < rows_total(cfg)) && (col + len <= page_size(cfg)));
+
+  n = (power_check(nandp) * len) / 2U;
+  spare = len;
+  if ((n > 0U) && (n < len) && nandp->power_cut_spare) {
+    spare = col < cfg->page_data_size ? cfg->page_data_size - col : 0U;
+  }
+  for (i = 0; i < len; i++) {
+    if ((i < n) || (i >= spare)) {
+      dst[i] &= src[i];
+    }
+  }
+  nandp->stats.page_programs++;
+  if (n < len) {
+    nandp->stats.failures++;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Erases the block holding a row.
+ * @details Blocks beyond the configured endurance fail to erase.
+ *
+ * @return              The operation outcome.
+ * @retval true         if the block was erased.
+ * @retval false        if power went away meanwhile or the block is worn.
+ *
+ * @notapi
+ */
+static bool erase(NANDDriver *nandp, uint32_t row) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint32_t blk = row / cfg->pages_per_block;
+  size_t len = cfg->pages_per_block * page_size(cfg);
+
+  osalDbgCheck(row < rows_total(cfg));
+
+  len = (power_check(nandp) * len) / 2U;
+  if (NULL != cfg->erase_counts) {
+    cfg->erase_counts[blk]++;
+    if ((cfg->endurance > 0U) && (cfg->erase_counts[blk] > cfg->endurance)) {
+      /* Worn out, the cells no longer erase completely.*/
+      len /= 2U;
+    }
+  }
+  memset(&cfg->array[blk * cfg->pages_per_block * page_size(cfg)], 0xFF, len);
+  nandp->stats.block_erases++;
+  if (len < cfg->pages_per_block * page_size(cfg)) {
+    nandp->stats.failures++;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief   Decodes the latched column and row address cycles.
+ *
+ * @notapi
+ */
+static void latch_addr(NANDDriver *nandp, uint32_t *colp, uint32_t *rowp) {
+
+  const NANDConfig *cfg = nandp->config;
+
+  osalDbgCheck(nandp->addrlen == (size_t)cfg->colcycles + cfg->rowcycles);
+
+  *colp = decode(nandp->addr, cfg->colcycles);
+  *rowp = decode(&nandp->addr[cfg->colcycles], cfg->rowcycles);
+  osalDbgCheck((*rowp < rows_total(cfg)) && (*colp < page_size(cfg)));
+  nandp->addrlen = 0;
+}
+
+/**
+ * @brief   Loads a page from the array into the cache register.
+ *
+ * @notapi
+ */
+static void load_cache(NANDDriver *nandp, uint32_t row) {
+
+  const NANDConfig *cfg = nandp->config;
+
+  memcpy(cache_reg, &cfg->array[row * page_size(cfg)], page_size(cfg));
+  nandp->column = 0;
+}
+
+/**
+ * @brief   Programs the pages queued by a program sequence.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cache         @p true for a cache program
+ *
+ * @notapi
+ */
+static void confirm_program(NANDDriver *nandp, bool cache) {
+
+  uint8_t status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  uint32_t i;
+
+  /* The previous cache program completes before the registers move on.*/
+  time_array(nandp, 0, false);
+  if (nandp->caching && ((nandp->status & NAND_STATUS_FAIL) != 0U)) {
+    status |= NAND_STATUS_FAILC;
+  }
+  for (i = 0; i < nandp->nrows; i++) {
+    if (!program(nandp, nandp->rows[i], 0, page_regs[i],
+                 page_size(nandp->config))) {
+      status |= NAND_STATUS_FAIL;
+    }
+  }
+  nandp->nrows = 0;
+  nandp->caching = cache;
+  nandp->status = status;
+  time_array(nandp, t_prog(nandp), !cache);
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level NAND driver initialization.
+ *
+ * @notapi
+ */
+void nand_lld_init(void) {
+
+#if SIM_NAND_USE_NAND1
+  /* Driver initialization.*/
+  nandObjectInit(&NANDD1);
+  NANDD1.cmd        = NAND_CMD_RESET;
+  NANDD1.status     = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  NANDD1.power_cut  = 0;
+  NANDD1.power_cut_spare = false;
+  NANDD1.addrlen    = 0;
+  NANDD1.nrows      = 0;
+  NANDD1.caching    = false;
+  NANDD1.array_ready = 0;
+  NANDD1.bb_map     = NULL;
+  memset(&NANDD1.stats, 0, sizeof(NANDD1.stats));
+#endif /* SIM_NAND_USE_NAND1 */
+}
+
+/**
+ * @brief   Configures and activates the NAND peripheral.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ *
+ * @notapi
+ */
+void nand_lld_start(NANDDriver *nandp) {
+
+  osalDbgCheck((nandp->config->array != NULL) &&
+               (nandp->config->dies == 1U) &&
+               (page_size(nandp->config) <= NANDSIM_REG_SIZE));
+
+  if (nandp->state == NAND_STOP) {
+    nandp->status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  }
+}
+
+/**
+ * @brief   Deactivates the NAND peripheral.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ *
+ * @notapi
+ */
+void nand_lld_stop(NANDDriver *nandp) {
+
+  (void)nandp;
+}
+
+/**
+ * @brief   Read data from NAND.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[out] data         pointer to data buffer
+ * @param[in] datalen       size of data buffer in bytes
+ * @param[in] addr          pointer to address buffer
+ * @param[in] addrlen       length of address
+ * @param[out] ecc          pointer to store computed ECC. Ignored when NULL.
+ *
+ * @notapi
+ */
+void nand_lld_read_data(NANDDriver *nandp, uint16_t *data, size_t datalen,
+                        uint8_t *addr, size_t addrlen, uint32_t *ecc) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint32_t col = decode(addr, cfg->colcycles);
+  uint32_t row = decode(&addr[cfg->colcycles], addrlen - cfg->colcycles);
+
+  osalDbgCheck((row < rows_total(cfg)) && (col + datalen <= page_size(cfg)));
+
+  nandp->state = NAND_READ;
+  nandp->cmd = NAND_CMD_READ0;
+  time_array(nandp, t_read(nandp), true);
+  memcpy(data, &cfg->array[row * page_size(cfg) + col], datalen);
+  time_bus(nandp, datalen);
+  nandp->stats.page_reads++;
+  if (NULL != ecc) {
+    *ecc = calc_ecc(cfg, (const uint8_t *)data, datalen);
+  }
+  nandp->state = NAND_READY;
+}
+
+/**
+ * @brief   Write data to NAND.
+ * @details As on the real device programmed bits can not return to one.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] data          buffer with data to be written
+ * @param[in] datalen       size of data buffer in bytes
+ * @param[in] addr          pointer to address buffer
+ * @param[in] addrlen       length of address
+ * @param[out] ecc          pointer to store computed ECC. Ignored when NULL.
+ *
+ * @return    The operation status reported by NAND IC (0x70 command).
+ *
+ * @notapi
+ */
+uint8_t nand_lld_write_data(NANDDriver *nandp, const uint16_t *data,
+                size_t datalen, uint8_t *addr, size_t addrlen, uint32_t *ecc) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint32_t col = decode(addr, cfg->colcycles);
+  uint32_t row = decode(&addr[cfg->colcycles], addrlen - cfg->colcycles);
+
+  nandp->state = NAND_WRITE;
+  nandp->cmd = NAND_CMD_WRITE;
+  nandp->status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  nandp->caching = false;
+
+  time_bus(nandp, datalen);
+  if (!program(nandp, row, col, (const uint8_t *)data, datalen)) {
+    nandp->status |= NAND_STATUS_FAIL;
+  }
+  time_array(nandp, t_prog(nandp), true);
+  if (NULL != ecc) {
+    *ecc = calc_ecc(cfg, (const uint8_t *)data, datalen);
+  }
+  nandp->state = NAND_READY;
+
+  return nand_lld_read_status(nandp);
+}
+
+/**
+ * @brief   Soft reset NAND device.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ *
+ * @notapi
+ */
+void nand_lld_reset(NANDDriver *nandp) {
+
+  nandp->cmd = NAND_CMD_RESET;
+  nandp->status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  nandp->addrlen = 0;
+  nandp->nrows = 0;
+  nandp->caching = false;
+}
+
+/**
+ * @brief   Erase block.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] addr          pointer to address buffer
+ * @param[in] addrlen       length of address
+ *
+ * @return    The operation status reported by NAND IC (0x70 command).
+ *
+ * @notapi
+ */
+uint8_t nand_lld_erase(NANDDriver *nandp, uint8_t *addr, size_t addrlen) {
+
+
+  nandp->state = NAND_ERASE;
+  nandp->cmd = NAND_CMD_ERASE;
+  nandp->status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+  nandp->caching = false;
+
+  if (!erase(nandp, decode(addr, addrlen))) {
+    nandp->status |= NAND_STATUS_FAIL;
+  }
+  time_array(nandp, t_erase(nandp), true);
+  nandp->state = NAND_READY;
+
+  return nand_lld_read_status(nandp);
+}
+
+/**
+ * @brief   Send addres to NAND.
+ * @note    The cycles are latched until the next command.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] len           length of address array
+ * @param[in] addr          pointer to address array
+ *
+ * @notapi
+ */
+void nand_lld_write_addr(NANDDriver *nandp, const uint8_t *addr, size_t len) {
+
+  osalDbgCheck(nandp->addrlen + len <= sizeof(nandp->addr));
+
+  memcpy(&nandp->addr[nandp->addrlen], addr, len);
+  nandp->addrlen += len;
+  time_bus(nandp, len);
+}
+
+/**
+ * @brief   Send command to NAND.
+ * @details The page read, cache read, random data output, program and
+ *          erase sequences are simulated, including the multi-plane
+ *          variants.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cmd           command value
+ *
+ * @notapi
+ */
+void nand_lld_write_cmd(NANDDriver *nandp, uint8_t cmd) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint32_t col, row, i;
+
+  switch (cmd) {
+  case NAND_CMD_READ0_CONFIRM:
+    latch_addr(nandp, &col, &row);
+    time_array(nandp, t_read(nandp), true);
+    load_cache(nandp, row);
+    nandp->column = col;
+    nandp->data_row = row;
+    nandp->stats.page_reads++;
+    break;
+
+  case NAND_CMD_READ_CACHE:
+    /* Random when an address was given, else the next page.*/
+    row = nandp->data_row + 1U;
+    if (nandp->addrlen > 0U) {
+      latch_addr(nandp, &col, &row);
+    }
+    osalDbgCheck(row < rows_total(cfg));
+    time_array(nandp, 0, false);
+    load_cache(nandp, nandp->data_row);
+    nandp->data_row = row;
+    time_array(nandp, t_read(nandp), false);
+    nandp->stats.page_reads++;
+    break;
+
+  case NAND_CMD_READ_CACHE_END:
+    time_array(nandp, 0, false);
+    load_cache(nandp, nandp->data_row);
+    break;
+
+  case NAND_CMD_RNDOUT_START:
+    osalDbgCheck(nandp->addrlen == cfg->colcycles);
+    nandp->column = decode(nandp->addr, cfg->colcycles);
+    nandp->addrlen = 0;
+    break;
+
+  case NAND_CMD_MULTIPROG:
+    osalDbgCheck(nandp->nrows < SIM_NAND_MAX_PLANES - 1U);
+    nandp->nrows++;
+    break;
+
+  case NAND_CMD_CACHEPROG:
+  case NAND_CMD_PAGEPROG:
+    nandp->nrows++;
+    confirm_program(nandp, cmd == NAND_CMD_CACHEPROG);
+    break;
+
+  case NAND_CMD_ERASE_MULTI:
+  case NAND_CMD_ERASE_CONFIRM:
+    osalDbgCheck((nandp->addrlen == cfg->rowcycles) &&
+                 (nandp->nrows < SIM_NAND_MAX_PLANES));
+    nandp->rows[nandp->nrows++] = decode(nandp->addr, cfg->rowcycles);
+    nandp->addrlen = 0;
+    if (cmd == NAND_CMD_ERASE_CONFIRM) {
+      nandp->status = NAND_STATUS_READY | NAND_STATUS_NOT_PROT;
+      for (i = 0; i < nandp->nrows; i++) {
+        if (!erase(nandp, nandp->rows[i])) {
+          nandp->status |= NAND_STATUS_FAIL;
+        }
+      }
+      nandp->nrows = 0;
+      nandp->caching = false;
+      time_array(nandp, t_erase(nandp), true);
+    }
+    break;
+
+  case NAND_CMD_WRITE:
+    osalDbgCheck(nandp->nrows < SIM_NAND_MAX_PLANES);
+    memset(page_regs[nandp->nrows], 0xFF, page_size(cfg));
+    nandp->addrlen = 0;
+    break;
+
+  case NAND_CMD_READ0:
+  case NAND_CMD_RNDOUT:
+  case NAND_CMD_RNDIN:
+  case NAND_CMD_ERASE:
+    nandp->addrlen = 0;
+    break;
+
+  default:
+    break;
+  }
+  nandp->cmd = cmd;
+}
+
+/**
+ * @brief   Send command followed by address cycles to NAND.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cmd           command value
+ * @param[in] addr          pointer to address array, @NULL if none
+ * @param[in] addrlen       length of address array
+ *
+ * @notapi
+ */
+void nand_lld_write_cmd_addr(NANDDriver *nandp, uint8_t cmd,
+                             const uint8_t *addr, size_t addrlen) {
+
+  nand_lld_write_cmd(nandp, cmd);
+  if (addrlen > 0U) {
+    nand_lld_write_addr(nandp, addr, addrlen);
+  }
+}
+
+/**
+ * @brief   Send command to NAND and wait for ready.
+ * @note    The simulated operations complete synchronously.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] cmd           command value
+ *
+ * @notapi
+ */
+void nand_lld_write_cmd_wait(NANDDriver *nandp, uint8_t cmd) {
+
+  nand_lld_write_cmd(nandp, cmd);
+}
+
+/**
+ * @brief   Read data from NAND cache register.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[out] data         pointer to data buffer
+ * @param[in] datalen       size of data buffer in bytes
+ *
+ * @notapi
+ */
+void nand_lld_read_buf(NANDDriver *nandp, uint16_t *data, size_t datalen) {
+
+  osalDbgCheck(nandp->column + datalen <= page_size(nandp->config));
+
+  memcpy(data, &cache_reg[nandp->column], datalen);
+  nandp->column += datalen;
+  time_bus(nandp, datalen);
+}
+
+/**
+ * @brief   Write data to NAND page register.
+ * @details The address latched after the 0x80 command sets the row and
+ *          the column of the page register being loaded, the one after
+ *          0x85 the column only.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] data          buffer with data to be written
+ * @param[in] datalen       size of data buffer in bytes
+ *
+ * @notapi
+ */
+void nand_lld_write_buf(NANDDriver *nandp, const uint16_t *data,
+                        size_t datalen) {
+
+  if (nandp->addrlen == nandp->config->colcycles) {
+    /* Column change after 0x85.*/
+    nandp->column = decode(nandp->addr, nandp->addrlen);
+    nandp->addrlen = 0;
+  }
+  else if (nandp->addrlen > 0U) {
+    latch_addr(nandp, &nandp->column, &nandp->rows[nandp->nrows]);
+  }
+  osalDbgCheck(nandp->column + datalen <= page_size(nandp->config));
+
+  memcpy(&page_regs[nandp->nrows][nandp->column], data, datalen);
+  nandp->column += datalen;
+  time_bus(nandp, datalen);
+}
+
+/**
+ * @brief   Read status byte from NAND.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ *
+ * @return    Status byte.
+ *
+ * @notapi
+ */
+uint8_t nand_lld_read_status(NANDDriver *nandp) {
+
+  nandp->cmd = NAND_CMD_STATUS;
+  return nandp->status;
+}
+
+/**
+ * @brief   Read ID of the nand flash
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ *
+ * @return    4 bytes ID of the nandflash
+ *
+ * @notapi
+ */
+uint32_t nand_lld_read_id(NANDDriver *nandp) {
+
+  nandp->cmd = NAND_CMD_READID;
+  return NANDSIM_ID;
+}
+
+#endif /* HAL_USE_NAND */
+
+/** @} */
@@ -0,0 +1,323 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_nand_lld.h
+ * @brief   RAM backed NAND simulator low level driver header.
+ * @details The memory array lives in a RAM buffer supplied through the
+ *          configuration. Programming can only clear bits and erasing sets
+ *          a whole block to 0xFF, as on the real device, so that the upper
+ *          layers can be exercised and benchmarked on the host.
+ *          The cache and multi-plane command sequences are simulated with
+ *          a cache register and a page register per plane. An optional
+ *          timing model accounts the busy times of the array and the bus
+ *          transfers, including the overlap of the cache operations.
+ *
+ * @addtogroup NAND
+ * @{
+ */
+
+#ifndef HAL_NAND_LLD_H_
+#define HAL_NAND_LLD_H_
+
+#include "bitmap.h"
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+#define NAND_MIN_PAGE_SIZE       256
+#define NAND_MAX_PAGE_SIZE       8192
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   NAND driver enable switch.
+ * @details If set to @p TRUE the support for the simulated NAND1 is
+ *          included.
+ */
+#if !defined(SIM_NAND_USE_NAND1) || defined(__DOXYGEN__)
+#define SIM_NAND_USE_NAND1                TRUE
+#endif
+
+/**
+ * @brief   Maximum number of planes in a multi-plane operation.
+ */
+#if !defined(SIM_NAND_MAX_PLANES) || defined(__DOXYGEN__)
+#define SIM_NAND_MAX_PLANES               4
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !SIM_NAND_USE_NAND1
+#error "NAND driver activated but no NAND peripheral assigned"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a structure representing an NAND driver.
+ */
+typedef struct NANDDriver NANDDriver;
+
+/**
+ * @brief   Simulator operation counters.
+ */
+typedef struct {
+  uint32_t                  page_reads;     /**< @brief Read commands.*/
+  uint32_t                  page_programs;  /**< @brief Program commands.*/
+  uint32_t                  block_erases;   /**< @brief Erase commands.*/
+  uint32_t                  failures;       /**< @brief Failed operations.*/
+  uint64_t                  time_ns;        /**< @brief Simulated time.*/
+} nandsim_stats_t;
+
+/**
+ * @brief   Simulator timing model.
+ */
+typedef struct {
+  uint32_t                  read_ns;        /**< @brief Page read, tR.*/
+  uint32_t                  prog_ns;        /**< @brief Page program, tPROG.*/
+  uint32_t                  erase_ns;       /**< @brief Block erase, tBERS.*/
+  uint32_t                  byte_ns;        /**< @brief Bus cycle per byte.*/
+} nandsim_timing_t;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Number of dies in NAND device.
+   */
+  uint32_t                  dies;
+  /**
+   * @brief   Number of logical units in NAND device.
+   */
+  uint32_t                  loguns;
+  /**
+   * @brief   Number of planes in NAND device.
+   */
+  uint32_t                  planes;
+  /**
+   * @brief   Number of erase blocks in NAND device.
+   */
+  uint32_t                  blocks;
+  /**
+   * @brief   Number of data bytes in page.
+   */
+  uint32_t                  page_data_size;
+  /**
+   * @brief   Number of spare bytes in page.
+   */
+  uint32_t                  page_spare_size;
+  /**
+   * @brief   Number of pages in block.
+   */
+  uint32_t                  pages_per_block;
+  /**
+   * @brief   Number of write cycles for row addressing.
+   */
+  uint8_t                   rowcycles;
+  /**
+   * @brief   Number of write cycles for column addressing.
+   */
+  uint8_t                   colcycles;
+  /**
+   * @brief   The device implements the cache read, cache program, random
+   *          data output and multi-plane commands.
+   * @details When false the cached and multi-plane functions work a page
+   *          at a time and the bad block scan reads the marks one page
+   *          at a time.
+   */
+  bool                      extended_cmds;
+
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Memory array.
+   * @details One page after the other, data and spare, for
+   *          @p loguns * @p planes * @p blocks * @p pages_per_block pages.
+   *          The rows produced by the row address hooks index this array,
+   *          a single die is simulated.
+   */
+  uint8_t                   *array;
+  /**
+   * @brief   Per block erase counters, @NULL if not needed.
+   */
+  uint32_t                  *erase_counts;
+  /**
+   * @brief   Erase cycles after which a block fails, zero for no limit.
+   * @note    Requires @p erase_counts.
+   */
+  uint32_t                  endurance;
+  /**
+   * @brief   Timing model, @NULL if not needed.
+   */
+  const nandsim_timing_t    *timing;
+} NANDConfig;
+
+/**
+ * @brief   Structure representing an NAND driver.
+ */
+struct NANDDriver {
+  /**
+   * @brief   Driver state.
+   */
+  nandstate_t               state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const NANDConfig          *config;
+#if NAND_USE_MUTUAL_EXCLUSION || defined(__DOXYGEN__)
+#if CH_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+  /**
+   * @brief   Mutex protecting the bus.
+   */
+  mutex_t                   mutex;
+#elif CH_CFG_USE_SEMAPHORES
+  semaphore_t               semaphore;
+#endif
+#endif /* NAND_USE_MUTUAL_EXCLUSION */
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Last command written.
+   */
+  uint8_t                   cmd;
+  /**
+   * @brief   Status byte returned by the next 0x70 command.
+   */
+  uint8_t                   status;
+  /**
+   * @brief   Address cycles written after the last command.
+   */
+  uint8_t                   addr[8];
+  /**
+   * @brief   Number of latched address cycles.
+   */
+  size_t                    addrlen;
+  /**
+   * @brief   Column of the next data cycle.
+   */
+  uint32_t                  column;
+  /**
+   * @brief   Row being loaded into the data register by a cache read.
+   */
+  uint32_t                  data_row;
+  /**
+   * @brief   Rows queued by the multi-plane commands.
+   */
+  uint32_t                  rows[SIM_NAND_MAX_PLANES];
+  /**
+   * @brief   Number of queued rows.
+   */
+  uint32_t                  nrows;
+  /**
+   * @brief   A cache program is in progress.
+   */
+  bool                      caching;
+  /**
+   * @brief   Simulated time at which the array becomes ready.
+   */
+  uint64_t                  array_ready;
+  /**
+   * @brief   Program and erase operations before a simulated power cut.
+   * @details Zero disables the feature. The operation hitting zero is only
+   *          half done and all the following ones are ignored, until the
+   *          counter is rewritten.
+   */
+  uint32_t                  power_cut;
+  /**
+   * @brief   The program hit by the power cut leaves the spare area complete.
+   * @details The data area is only half done then, as if the tag had been
+   *          programmed before the data.
+   */
+  bool                      power_cut_spare;
+  /**
+   * @brief   Operation counters.
+   */
+  nandsim_stats_t           stats;
+  /**
+   * @brief   Pointer to bad block map.
+   * @details One bit per block. All memory allocation is user's responsibility.
+   */
+  bitmap_t                  *bb_map;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of the memory array for a configuration.
+ *
+ * @param[in] loguns    number of logical units
+ * @param[in] planes    number of planes
+ * @param[in] blocks    number of blocks per plane
+ * @param[in] pages     number of pages per block
+ * @param[in] pagesize  data plus spare bytes of a page
+ */
+#define NANDSIM_ARRAY_SIZE(loguns, planes, blocks, pages, pagesize)         \
+  ((size_t)(loguns) * (planes) * (blocks) * (pages) * (pagesize))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if SIM_NAND_USE_NAND1 && !defined(__DOXYGEN__)
+extern NANDDriver NANDD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void nand_lld_init(void);
+  void nand_lld_start(NANDDriver *nandp);
+  void nand_lld_stop(NANDDriver *nandp);
+  uint8_t nand_lld_erase(NANDDriver *nandp, uint8_t *addr, size_t addrlen);
+  void nand_lld_read_data(NANDDriver *nandp, uint16_t *data,
+                size_t datalen, uint8_t *addr, size_t addrlen, uint32_t *ecc);
+  void nand_lld_write_addr(NANDDriver *nandp, const uint8_t *addr, size_t len);
+  void nand_lld_write_cmd(NANDDriver *nandp, uint8_t cmd);
+  void nand_lld_write_cmd_addr(NANDDriver *nandp, uint8_t cmd,
+                               const uint8_t *addr, size_t addrlen);
+  void nand_lld_write_cmd_wait(NANDDriver *nandp, uint8_t cmd);
+  void nand_lld_read_buf(NANDDriver *nandp, uint16_t *data, size_t datalen);
+  void nand_lld_write_buf(NANDDriver *nandp, const uint16_t *data,
+                          size_t datalen);
+  uint8_t nand_lld_write_data(NANDDriver *nandp, const uint16_t *data,
+                size_t datalen, uint8_t *addr, size_t addrlen, uint32_t *ecc);
+  uint8_t nand_lld_read_status(NANDDriver *nandp);
+  void nand_lld_reset(NANDDriver *nandp);
+  uint32_t nand_lld_read_id(NANDDriver *nandp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_NAND */
+
+#endif /* HAL_NAND_LLD_H_ */
+
+/** @} */
@@ -37,6 +37,83 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Reflects the lower @p bits bits of @p data.
+ */
+static uint32_t crc_reflect(uint32_t data, uint32_t bits) {
+  uint32_t reflection = 0U;
+  uint32_t bit;
+
+  for (bit = 0U; bit < bits; bit++) {
+    reflection = (reflection << 1) | (data & 1U);
+    data >>= 1;
+  }
+
+  return reflection;
+}
+
+/**
+ * @brief   Multiplies two remainders modulo the CRC polynomial.
+ * @details Both operands and the result are polynomials over GF(2) of
+ *          degree lower than @p poly_size, MSB first.
+ */
+static uint32_t crc_mulmod(uint32_t a, uint32_t b,
+                           uint32_t poly, uint32_t poly_size) {
+  uint32_t top = 1U << (poly_size - 1U);
+  uint32_t mask = top | (top - 1U);
+  uint32_t r = 0U;
+  uint32_t bit = top;
+
+  while (bit != 0U) {
+    /* r = r * x mod P.*/
+    if ((r & top) != 0U) {
+      r = ((r << 1) ^ poly) & mask;
+    }
+    else {
+      r = (r << 1) & mask;
+    }
+    if ((b & bit) != 0U) {
+      r ^= a;
+    }
+    bit >>= 1;
+  }
+
+  return r;
+}
+
+/**
+ * @brief   Computes x^(8 * n) modulo the CRC polynomial.
+ * @details Square and multiply, O(log n) modular multiplications. This is
+ *          the operator that shifts a CRC register over @p n zero bytes.
+ */
+static uint32_t crc_xpow8n(size_t n, uint32_t poly, uint32_t poly_size) {
+  uint32_t top = 1U << (poly_size - 1U);
+  uint32_t mask = top | (top - 1U);
+  uint32_t base = 1U;
+  uint32_t r = 1U;
+  unsigned i;
+
+  /* base = x^8 mod P.*/
+  for (i = 0U; i < 8U; i++) {
+    if ((base & top) != 0U) {
+      base = ((base << 1) ^ poly) & mask;
+    }
+    else {
+      base = (base << 1) & mask;
+    }
+  }
+
+  while (n != 0U) {
+    if ((n & 1U) != 0U) {
+      r = crc_mulmod(r, base, poly, poly_size);
+    }
+    base = crc_mulmod(base, base, poly, poly_size);
+    n >>= 1;
+  }
+
+  return r;
+}
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -227,6 +304,59 @@ void crcStartCalcI(CRCDriver *crcp, size_t n, const void *buf) {
 }
 #endif
 
+/**
+ * @brief   Combines the CRCs of two consecutive data segments.
+ * @details Given the CRC of segment A and the CRC of segment B, both
+ *          calculated from a reset driver with the same configuration,
+ *          returns the CRC of A followed by B without accessing the data.
+ *          Segments can then be checksummed independently, by different
+ *          units or threads, and merged afterward.
+ * @note    The cost is O(log(len2)) polynomial multiplications and does not
+ *          depend on the length of segment A.
+ * @note    This function does not access the CRC unit and can be used
+ *          with any configuration, including the ones not supported by
+ *          the hardware.
+ *
+ * @param[in] config    the @p CRCConfig used for both segments
+ * @param[in] crc1      CRC of the first segment
+ * @param[in] crc2      CRC of the second segment
+ * @param[in] len2      length of the second segment in bytes
+ * @return              The CRC of the concatenated segments.
+ *
+ * @api
+ */
+uint32_t crcCombine(const CRCConfig *config, uint32_t crc1, uint32_t crc2,
+                    size_t len2) {
+  uint32_t size, mask, r1, r2;
+
+  osalDbgCheck(config != NULL);
+  osalDbgCheck((config->poly_size > 0U) && (config->poly_size <= 32U));
+
+  size = config->poly_size;
+  mask = 1U << (size - 1U);
+  mask |= (mask - 1U);
+
+  /* Back to the MSB first register domain, final XOR removed.*/
+  r1 = (crc1 ^ config->final_val) & mask;
+  r2 = (crc2 ^ config->final_val) & mask;
+  if (config->reflect_remainder) {
+    r1 = crc_reflect(r1, size);
+    r2 = crc_reflect(r2, size);
+  }
+
+  /* The register of A is shifted over len2 zero bytes, the initial value
+     contribution already present in B is cancelled.*/
+  r1 = crc_mulmod(r1 ^ (config->initial_val & mask),
+                  crc_xpow8n(len2, config->poly & mask, size),
+                  config->poly & mask, size) ^ r2;
+
+  if (config->reflect_remainder) {
+    r1 = crc_reflect(r1, size);
+  }
+
+  return (r1 ^ config->final_val) & mask;
+}
+
 #if (CRC_USE_MUTUAL_EXCLUSION == TRUE) || defined(__DOXYGEN__)
 /**
  * @brief   Gains exclusive access to the CRC unit.
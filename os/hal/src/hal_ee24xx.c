@@ -40,6 +40,12 @@ Note:
   page boundary, the result is that the data wraps around to the beginning of
   the current page (overwriting data previously stored there), instead of
   being written to the next page as might be expected.
+
+Acknowledge polling:
+  The IC does not acknowledge its address while the internal write cycle is
+  in progress, it is ready as soon as it does. Sequential writes are combined
+  into whole pages and the write cycle is only waited for by the next
+  transaction to the IC.
 *********************************************************************/
 
 #include "hal_ee24xx.h"
@@ -72,6 +78,13 @@ Note:
  * GLOBAL VARIABLES
  ******************************************************************************
  */
+#if EEPROM_24XX_USE_FLUSHER
+/* Caches with buffered data, the list and the buffers are protected by the
+   mutex. */
+static I2CEepromCache *dirty_list;
+static MUTEX_DECL(cache_mtx);
+static THD_WORKING_AREA(flusher_wa, EEPROM_24XX_FLUSHER_STACK_SIZE);
+#endif
 
 /*
  *******************************************************************************
@@ -89,6 +102,18 @@ Note:
     (txbuf)[1] = ((uint8_t)(addr & 0xFF));                                     \
   }
 
+static void cache_lock(void) {
+#if EEPROM_24XX_USE_FLUSHER
+  chMtxLock(&cache_mtx);
+#endif
+}
+
+static void cache_unlock(void) {
+#if EEPROM_24XX_USE_FLUSHER
+  chMtxUnlock(&cache_mtx);
+#endif
+}
+
 /*
  *******************************************************************************
  * EXPORTED FUNCTIONS
@@ -108,6 +133,49 @@ static systime_t calc_timeout(I2CDriver *i2cp, size_t txbytes, size_t rxbytes) {
   return TIME_MS2I(tmo);
 }
 
+/**
+ * @brief   EEPROM transaction with acknowledge polling.
+ * @details While a write cycle is in progress the IC does not acknowledge
+ *          its address, the transaction is retried until it does or the
+ *          write time has elapsed.
+ *
+ * @param[in] eepcfg    pointer to configuration structure of eeprom file
+ * @param[in] txbuf     pointer to address and data to be sent
+ * @param[in] txbytes   number of bytes to be sent
+ * @param[out] rxbuf    pointer to buffer for received data
+ * @param[in] rxbytes   number of bytes to be received
+ */
+static msg_t eeprom_transfer(const I2CEepromFileConfig *eepcfg,
+                             const uint8_t *txbuf, size_t txbytes,
+                             uint8_t *rxbuf, size_t rxbytes) {
+
+  msg_t status = MSG_RESET;
+  systime_t tmo = calc_timeout(eepcfg->i2cp, txbytes, rxbytes);
+  systime_t start = chVTGetSystemTimeX();
+  i2cflags_t errors;
+
+  while (true) {
+#if I2C_USE_MUTUAL_EXCLUSION
+    i2cAcquireBus(eepcfg->i2cp);
+#endif
+
+    status = i2cMasterTransmitTimeout(eepcfg->i2cp, eepcfg->addr,
+                                      txbuf, txbytes, rxbuf, rxbytes, tmo);
+    errors = i2cGetErrors(eepcfg->i2cp);
+
+#if I2C_USE_MUTUAL_EXCLUSION
+    i2cReleaseBus(eepcfg->i2cp);
+#endif
+
+    if ((status != MSG_RESET) || ((errors & I2C_ACK_FAILURE) == 0) ||
+        (chVTTimeElapsedSinceX(start) > eepcfg->write_time))
+      return status;
+
+    /* IC still busy, poll again */
+    chThdSleep(EEPROM_24XX_POLL_INTERVAL);
+  }
+}
+
 /**
  * @brief   EEPROM read routine.
  *
@@ -119,69 +187,131 @@ static systime_t calc_timeout(I2CDriver *i2cp, size_t txbytes, size_t rxbytes) {
 static msg_t eeprom_read(const I2CEepromFileConfig *eepcfg,
                          uint32_t offset, uint8_t *data, size_t len) {
 
-  msg_t status = MSG_RESET;
-  systime_t tmo = calc_timeout(eepcfg->i2cp, 2, len);
-
   osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
              "out of device bounds");
 
   eeprom_split_addr(eepcfg->write_buf, (offset + eepcfg->barrier_low));
 
-#if I2C_USE_MUTUAL_EXCLUSION
-  i2cAcquireBus(eepcfg->i2cp);
-#endif
+  return eeprom_transfer(eepcfg, eepcfg->write_buf, 2, data, len);
+}
 
-  status = i2cMasterTransmitTimeout(eepcfg->i2cp, eepcfg->addr,
-                                    eepcfg->write_buf, 2, data, len, tmo);
+/**
+ * @brief   Waits for the end of the write cycle.
+ * @details Sends a bare address, it does not start a new write cycle.
+ *
+ * @param[in] eepcfg  pointer to configuration structure of eeprom file
+ */
+static msg_t eeprom_wait_ready(const I2CEepromFileConfig *eepcfg) {
 
-#if I2C_USE_MUTUAL_EXCLUSION
-  i2cReleaseBus(eepcfg->i2cp);
+  eeprom_split_addr(eepcfg->write_buf, eepcfg->barrier_low);
+
+  return eeprom_transfer(eepcfg, eepcfg->write_buf, 2, NULL, 0);
+}
+
+/**
+ * @brief   Writes the buffered bytes to EEPROM.
+ * @details The address is put in front of the buffered bytes, in place of
+ *          the two bytes before them, and the write cycle is not waited for.
+ *          A failure is reported by the file error too.
+ * @pre     Lock must be held.
+ *
+ * @param[in] efs     pointer to the file stream object
+ */
+static msg_t cache_flush(I2CEepromFileStream *efs) {
+
+  const I2CEepromFileConfig *eepcfg = efs->cfg;
+  I2CEepromCache *cache = eepcfg->cache;
+  uint8_t *txbuf;
+  uint32_t addr;
+  msg_t status;
+
+  if ((cache == NULL) || (cache->end == cache->start))
+    return MSG_OK;
+
+  txbuf = &eepcfg->write_buf[cache->start];
+  addr = (cache->page * eepcfg->pagesize) + cache->start;
+  eeprom_split_addr(txbuf, addr);
+  status = eeprom_transfer(eepcfg, txbuf,
+                           (cache->end - cache->start) + 2, NULL, 0);
+  if (status != MSG_OK)
+    efs->errors = FILE_ERROR;
+  cache->start = 0;
+  cache->end   = 0;
+
+#if EEPROM_24XX_USE_FLUSHER
+  /* unlink from list of dirty caches */
+  I2CEepromCache **pp = &dirty_list;
+  while (*pp != cache)
+    pp = &(*pp)->next;
+  *pp = cache->next;
+  cache->next = NULL;
 #endif
 
   return status;
 }
 
 /**
- * @brief   EEPROM write routine.
- * @details Function writes data to EEPROM.
- * @pre     Data must be fit to single EEPROM page.
+ * @brief   Puts data that fits in one page into the write buffer.
+ * @details Only one contiguous range of one page is held, anything else
+ *          flushes the buffer first. A page buffered up to its end is
+ *          written at once. Without cache the data is written at once.
+ * @pre     Lock must be held.
  *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file
- * @param[in] offset  addres of 1-st byte to be write
+ * @param[in] efs     pointer to the file stream object
+ * @param[in] offset  absolute addres of 1-st byte to be written
  * @param[in] data    pointer to buffer with data to be written
  * @param[in] len     number of bytes to be written
  */
-static msg_t eeprom_write(const I2CEepromFileConfig *eepcfg, uint32_t offset,
-                          const uint8_t *data, size_t len) {
-  msg_t status = MSG_RESET;
-  systime_t tmo = calc_timeout(eepcfg->i2cp, (len + 2), 0);
-
-  osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
-             "out of device bounds");
-  osalDbgAssert((((offset + eepcfg->barrier_low) / eepcfg->pagesize) ==
-              (((offset + eepcfg->barrier_low) + len - 1) / eepcfg->pagesize)),
-             "data can not be fitted in single page");
-
-  /* write address bytes */
-  eeprom_split_addr(eepcfg->write_buf, (offset + eepcfg->barrier_low));
-  /* write data bytes */
-  memcpy(&(eepcfg->write_buf[2]), data, len);
-
-#if I2C_USE_MUTUAL_EXCLUSION
-  i2cAcquireBus(eepcfg->i2cp);
-#endif
+static msg_t cache_write(I2CEepromFileStream *efs, uint32_t offset,
+                         const uint8_t *data, size_t len) {
+
+  const I2CEepromFileConfig *eepcfg = efs->cfg;
+  I2CEepromCache *cache = eepcfg->cache;
+  uint32_t page  = offset / eepcfg->pagesize;
+  uint16_t start = offset % eepcfg->pagesize;
+  uint16_t end   = start + len;
+  msg_t status;
+
+  osalDbgAssert(end <= eepcfg->pagesize, "data can not be fitted in single page");
+
+  if (cache == NULL) {
+    eeprom_split_addr(eepcfg->write_buf, offset);
+    memcpy(&eepcfg->write_buf[2], data, len);
+    status = eeprom_transfer(eepcfg, eepcfg->write_buf, len + 2, NULL, 0);
+    if (status != MSG_OK)
+      efs->errors = FILE_ERROR;
+    return status;
+  }
 
-  status = i2cMasterTransmitTimeout(eepcfg->i2cp, eepcfg->addr,
-                                    eepcfg->write_buf, (len + 2), NULL, 0, tmo);
+  if ((cache->end != cache->start) &&
+      ((page != cache->page) ||
+       (start > cache->end) || (end < cache->start))) {
+    if (cache_flush(efs) != MSG_OK)
+      return MSG_RESET;
+  }
 
-#if I2C_USE_MUTUAL_EXCLUSION
-  i2cReleaseBus(eepcfg->i2cp);
+  if (cache->end == cache->start) {
+    cache->page  = page;
+    cache->start = start;
+    cache->end   = end;
+    cache->efs   = efs;
+#if EEPROM_24XX_USE_FLUSHER
+    cache->next  = dirty_list;
+    dirty_list   = cache;
 #endif
+  }
+  else {
+    if (start < cache->start)
+      cache->start = start;
+    if (end > cache->end)
+      cache->end = end;
+  }
+  memcpy(&eepcfg->write_buf[2 + start], data, len);
+  cache->time = chVTGetSystemTimeX();
 
-  /* wait until EEPROM process data */
-  chThdSleep(eepcfg->write_time);
-
-  return status;
+  if (cache->end == eepcfg->pagesize)
+    return cache_flush(efs);
+  return MSG_OK;
 }
 
 /**
@@ -195,39 +325,22 @@ static size_t __clamp_size(void *ip, size_t n) {
     return n;
 }
 
-/**
- * @brief   Write data that can be fitted in one page boundary
- */
-static msg_t __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *written) {
-
-  msg_t status = MSG_RESET;
-
-  osalDbgAssert(len > 0, "len must be greater than 0");
-
-  status = eeprom_write(((I2CEepromFileStream *)ip)->cfg,
-                        eepfs_getposition(ip, NULL), data, len);
-  if (status == MSG_OK) {
-    *written += len;
-    eepfs_lseek(ip, eepfs_getposition(ip, NULL) + len);
-  }
-
-  return status;
-}
-
 /**
  * @brief     Write data to EEPROM.
  * @details   Only one EEPROM page can be written at once. So function
- *            splits large data chunks in small EEPROM transactions if needed.
- * @note      To achieve the maximum efficiency use write operations
- *            aligned to EEPROM page boundaries.
+ *            splits large data chunks in page sized pieces and combines
+ *            small sequential writes in the write buffer, which is written
+ *            when a page is complete, another page is written, the file
+ *            position leaves the page or the file is closed or flushed.
+ * @note      Errors of a deferred write are reported by the file error.
  */
 static size_t write(void *ip, const uint8_t *bp, size_t n) {
 
-  size_t   len = 0;      /* bytes to be written per transaction */
+  I2CEepromFileStream *efs = ip;
+  size_t   len;          /* bytes to be written per page */
   uint32_t written = 0;  /* total bytes successfully written */
   uint16_t pagesize;
-  uint32_t firstpage;
-  uint32_t lastpage;
+  uint32_t offset;
 
   osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
 
@@ -238,43 +351,21 @@ static size_t write(void *ip, const uint8_t *bp, size_t n) {
   if (n == 0)
     return 0;
 
-  pagesize  =  ((EepromFileStream *)ip)->cfg->pagesize;
-  firstpage = (((EepromFileStream *)ip)->cfg->barrier_low +
-               eepfs_getposition(ip, NULL)) / pagesize;
-  lastpage  = (((EepromFileStream *)ip)->cfg->barrier_low +
-               eepfs_getposition(ip, NULL) + n - 1) / pagesize;
-
-  /* data fits in single page */
-  if (firstpage == lastpage) {
-    len = n;
-    __fitted_write(ip, bp, len, &written);
-    return written;
-  }
+  pagesize = efs->cfg->pagesize;
 
-  else {
-    /* write first piece of data to first page boundary */
-    len =  ((firstpage + 1) * pagesize) - eepfs_getposition(ip, NULL);
-    len -= ((EepromFileStream *)ip)->cfg->barrier_low;
-    if (__fitted_write(ip, bp, len, &written) != MSG_OK)
-      return written;
+  cache_lock();
+  while (written < n) {
+    offset = efs->cfg->barrier_low + eepfs_getposition(ip, NULL);
+    len = pagesize - (offset % pagesize);
+    if (len > (n - written))
+      len = n - written;
+    if (cache_write(efs, offset, bp, len) != MSG_OK)
+      break;
     bp += len;
-
-    /* now write page sized blocks (zero or more) */
-    while ((n - written) > pagesize) {
-      len = pagesize;
-      if (__fitted_write(ip, bp, len, &written) != MSG_OK)
-        return written;
-      bp += len;
-    }
-
-    /* write tail */
-    len = n - written;
-    if (len == 0)
-      return written;
-    else {
-      __fitted_write(ip, bp, len, &written);
-    }
+    written += len;
+    eepfs_lseek(ip, eepfs_getposition(ip, NULL) + len);
   }
+  cache_unlock();
 
   return written;
 }
@@ -284,11 +375,9 @@ static size_t write(void *ip, const uint8_t *bp, size_t n) {
  * read operation the position pointer will be increased by the number
  * of read bytes.
  */
-static size_t read(void *ip, uint8_t *bp, size_t n) {
+static size_t __read(void *ip, uint8_t *bp, size_t n) {
   msg_t status = MSG_OK;
 
-  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
-
   if (n == 0)
     return 0;
 
@@ -303,7 +392,7 @@ static size_t read(void *ip, uint8_t *bp, size_t n) {
     uint8_t __buf[2];
     /* if NOT last byte of file requested */
     if ((eepfs_getposition(ip, NULL) + 1) < eepfs_getsize(ip, NULL)) {
-      if (read(ip, __buf, 2) == 2) {
+      if (__read(ip, __buf, 2) == 2) {
         eepfs_lseek(ip, (eepfs_getposition(ip, NULL) + 1));
         bp[0] = __buf[0];
         return 1;
@@ -313,7 +402,7 @@ static size_t read(void *ip, uint8_t *bp, size_t n) {
     }
     else {
       eepfs_lseek(ip, (eepfs_getposition(ip, NULL) - 1));
-      if (read(ip, __buf, 2) == 2) {
+      if (__read(ip, __buf, 2) == 2) {
         eepfs_lseek(ip, (eepfs_getposition(ip, NULL) + 2));
         bp[0] = __buf[1];
         return 1;
@@ -335,17 +424,83 @@ static size_t read(void *ip, uint8_t *bp, size_t n) {
   }
 }
 
+/**
+ * @brief   Read data, the buffered bytes of the range are written first.
+ */
+static size_t read(void *ip, uint8_t *bp, size_t n) {
+
+  I2CEepromFileStream *efs = ip;
+  I2CEepromCache *cache;
+  uint32_t offset, pageoffset;
+
+  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
+
+  cache_lock();
+  cache = efs->cfg->cache;
+  offset = efs->cfg->barrier_low + eepfs_getposition(ip, NULL);
+  if ((cache != NULL) && (cache->end != cache->start)) {
+    pageoffset = cache->page * efs->cfg->pagesize;
+    if ((offset < pageoffset + cache->end) &&
+        (offset + n > pageoffset + cache->start) &&
+        (cache_flush(efs) != MSG_OK)) {
+      cache_unlock();
+      return 0;
+    }
+  }
+  n = __read(ip, bp, n);
+  cache_unlock();
+
+  return n;
+}
+
+/**
+ * @brief   Set position, the buffered page is written when it is left.
+ */
+static msg_t lseek(void *ip, fileoffset_t offset) {
+
+  I2CEepromFileStream *efs = ip;
+  I2CEepromCache *cache;
+
+  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
+
+  cache_lock();
+  cache = efs->cfg->cache;
+  if ((cache != NULL) &&
+      ((efs->cfg->barrier_low + offset) / efs->cfg->pagesize != cache->page))
+    (void)cache_flush(efs);
+  cache_unlock();
+
+  return eepfs_lseek(ip, offset);
+}
+
+/**
+ * @brief   Close file, the buffered bytes are written and the write cycle
+ *          waited for.
+ * @details The file is closed anyway, a failure of the final write is
+ *          returned as its status.
+ */
+static msg_t close(void *ip) {
+
+  msg_t status;
+
+  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
+
+  status = I2CEepromFileFlush(ip);
+  (void)eepfs_close(ip);
+  return status;
+}
+
 static const struct EepromFileStreamVMT vmt = {
   (size_t)0,
   write,
   read,
   eepfs_put,
   eepfs_get,
-  eepfs_close,
+  close,
   eepfs_geterror,
   eepfs_getsize,
   eepfs_getposition,
-  eepfs_lseek,
+  lseek,
 };
 
 EepromDevice eepdev_24xx = {
@@ -353,4 +508,103 @@ EepromDevice eepdev_24xx = {
   &vmt
 };
 
+#if EEPROM_24XX_USE_FLUSHER
+/**
+ * @brief   Writes the pages left idle in the write buffers.
+ */
+static THD_FUNCTION(flusher_thread, arg) {
+
+  I2CEepromCache *cache, *next;
+
+  (void)arg;
+  chRegSetThreadName("ee24xx_flush");
+
+  while (true) {
+    chThdSleep(EEPROM_24XX_FLUSH_DELAY);
+    cache_lock();
+    for (cache = dirty_list; cache != NULL; cache = next) {
+      next = cache->next;
+      if (chVTTimeElapsedSinceX(cache->time) >= EEPROM_24XX_FLUSH_DELAY)
+        (void)cache_flush(cache->efs);
+    }
+    cache_unlock();
+  }
+}
+
+/**
+ * @brief   Starts the thread flushing the write buffers in background.
+ * @details A page is written once it has not been written to for
+ *          @p EEPROM_24XX_FLUSH_DELAY.
+ *
+ * @param[in] prio    priority of the thread
+ */
+void I2CEepromStartFlusher(tprio_t prio) {
+
+  chThdCreateStatic(flusher_wa, sizeof(flusher_wa), prio,
+                    flusher_thread, NULL);
+}
+#endif /* EEPROM_24XX_USE_FLUSHER */
+
+/**
+ * Open I2C EEPROM IC as file and return pointer to the file stream object
+ * @note      Fucntion allways successfully open file. All checking makes
+ *            in read/write functions.
+ */
+EepromFileStream *I2CEepromFileOpen(I2CEepromFileStream *efs,
+                                    const I2CEepromFileConfig *eepcfg,
+                                    const EepromDevice *eepdev) {
+
+  I2CEepromCache *cache = eepcfg->cache;
+  EepromFileStream *ret;
+
+  cache_lock();
+#if EEPROM_24XX_USE_FLUSHER
+  /* drops the data buffered by a previous open of the file or of the
+     cache, the flusher must not see them any more */
+  I2CEepromCache **pp = &dirty_list;
+  while (*pp != NULL) {
+    if ((*pp == cache) || ((*pp)->efs == efs)) {
+      (*pp)->start = 0;
+      (*pp)->end   = 0;
+      *pp = (*pp)->next;
+    }
+    else
+      pp = &(*pp)->next;
+  }
+#endif
+  if (cache != NULL) {
+    cache->page  = 0;
+    cache->start = 0;
+    cache->end   = 0;
+    cache->efs   = efs;
+    cache->next  = NULL;
+  }
+  ret = EepromFileOpen((EepromFileStream *)efs,
+                       (const EepromFileConfig *)eepcfg, eepdev);
+  cache_unlock();
+
+  return ret;
+}
+
+/**
+ * @brief   Writes the buffered bytes and waits for the end of the write
+ *          cycle.
+ *
+ * @param[in] efs     pointer to an open I2C EEPROM file stream
+ */
+msg_t I2CEepromFileFlush(EepromFileStream *efs) {
+
+  msg_t status;
+
+  osalDbgCheck((efs != NULL) && (efs->vmt == &vmt));
+
+  cache_lock();
+  status = cache_flush((I2CEepromFileStream *)efs);
+  if (status == MSG_OK)
+    status = eeprom_wait_ready(((I2CEepromFileStream *)efs)->cfg);
+  cache_unlock();
+
+  return status;
+}
+
 #endif /* EEPROM_USE_EE24XX */
@@ -61,6 +61,8 @@ Note:
                                operations). */
 #define CMD_RDSR    0x05  /**< Read STATUS register. */
 #define CMD_WRSR    0x01  /**< Write STATUS register. */
+#define CMD_FAST_READ 0x0B /**< @brief Read data at higher speed, one dummy
+                                byte follows the address. */
 
 /** @} */
 
@@ -75,8 +77,45 @@ Note:
 
 /** @} */
 
+/**
+ * @brief   Adds to a transfer counter of the file, if counted.
+ */
+#define ll_eeprom_count(eepcfg, field, n) do {                                \
+    if ((eepcfg)->stats != NULL)                                               \
+      (eepcfg)->stats->field += (n);                                           \
+  } while (false)
+
+/**
+ * @brief   Gains exclusive access to the IC for a whole access.
+ *
+ * @param[in]  eepcfg pointer to configuration structure of eeprom file.
+ */
+static void ll_25xx_acquire(const SPIEepromFileConfig *eepcfg) {
+
+#if SPI_USE_MUTUAL_EXCLUSION
+  spiAcquireBus(eepcfg->spip);
+#else
+  (void)eepcfg;
+#endif
+}
+
+/**
+ * @brief   Releases exclusive access to the IC.
+ *
+ * @param[in]  eepcfg pointer to configuration structure of eeprom file.
+ */
+static void ll_25xx_release(const SPIEepromFileConfig *eepcfg) {
+
+#if SPI_USE_MUTUAL_EXCLUSION
+  spiReleaseBus(eepcfg->spip);
+#else
+  (void)eepcfg;
+#endif
+}
+
 /**
  * @brief 25XX low level write then read rountine.
+ * @pre   Bus must be acquired.
  *
  * @param[in]  eepcfg pointer to configuration structure of eeprom file.
  * @param[in]  txbuf  pointer to buffer to be transfered.
@@ -88,18 +127,11 @@ static void ll_25xx_transmit_receive(const SPIEepromFileConfig *eepcfg,
                                      const uint8_t *txbuf, size_t txlen,
                                      uint8_t *rxbuf, size_t rxlen) {
 
-#if SPI_USE_MUTUAL_EXCLUSION
-  spiAcquireBus(eepcfg->spip);
-#endif
   spiSelect(eepcfg->spip);
   spiSend(eepcfg->spip, txlen, txbuf);
   if (rxlen) /* Check if receive is needed. */
       spiReceive(eepcfg->spip, rxlen, rxbuf);
   spiUnselect(eepcfg->spip);
-
-#if SPI_USE_MUTUAL_EXCLUSION
-  spiReleaseBus(eepcfg->spip);
-#endif
 }
 
 /**
@@ -118,17 +150,6 @@ static bool ll_eeprom_is_busy(const SPIEepromFileConfig *eepcfg) {
   return FALSE;
 }
 
-/**
- * @brief Lock device.
- *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file.
- */
-static void ll_eeprom_lock(const SPIEepromFileConfig *eepcfg) {
-
-  uint8_t cmd = CMD_WRDI;
-  ll_25xx_transmit_receive(eepcfg, &cmd, 1, NULL, 0);
-}
-
 /**
  * @brief Unlock device.
  *
@@ -173,19 +194,73 @@ static uint8_t ll_eeprom_prepare_seq(uint8_t *seq, uint32_t size, uint8_t cmd,
   return 2;
 }
 
+/**
+ * @brief   Waits for the end of the write cycle.
+ * @pre     Bus must be acquired.
+ *
+ * @param[in] eepcfg  pointer to configuration structure of eeprom file.
+ */
+static msg_t ll_eeprom_wait_ready(const SPIEepromFileConfig *eepcfg) {
+
+  systime_t now = chVTGetSystemTimeX();
+  msg_t status = MSG_OK;
+
+  while (ll_eeprom_is_busy(eepcfg)) {
+    ll_eeprom_count(eepcfg, busy_polls, 1);
+    if (chVTTimeElapsedSinceX(now) > eepcfg->write_time) {
+      status = MSG_TIMEOUT;
+      break;
+    }
+
+    if (eepcfg->poll_interval > (sysinterval_t)0)
+      chThdSleep(eepcfg->poll_interval);
+    else
+      chThdYield();
+  }
+  ll_eeprom_count(eepcfg, busy_time, chVTTimeElapsedSinceX(now));
+
+  return status;
+}
+
+/**
+ * @brief   Waits for the write cycle of the last page write, if any.
+ * @details The end of a page write is waited for by the next access to
+ *          the IC, so the caller runs during the write cycle. Without the
+ *          pending flag the status is read every time.
+ * @pre     Bus must be acquired.
+ *
+ * @param[in] eepcfg  pointer to configuration structure of eeprom file.
+ */
+static msg_t ll_eeprom_wait_pending(const SPIEepromFileConfig *eepcfg) {
+
+  msg_t status;
+
+  if ((eepcfg->pending != NULL) && !*eepcfg->pending)
+    return MSG_OK;
+
+  status = ll_eeprom_wait_ready(eepcfg);
+  if ((status == MSG_OK) && (eepcfg->pending != NULL))
+    *eepcfg->pending = false;
+  return status;
+}
+
 /**
  * @brief   EEPROM read routine.
+ * @details Command, address and data are transferred in a single chip
+ *          select cycle.
  *
- * @param[in]  eepcfg   pointer to configuration structure of eeprom file.
+ * @param[in]  efs      pointer to the file stream object.
  * @param[in]  offset   addres of 1-st byte to be read.
  * @param[out] data     pointer to buffer with data to be written.
  * @param[in]  len      number of bytes to be red.
  */
-static msg_t ll_eeprom_read(const SPIEepromFileConfig *eepcfg, uint32_t offset,
+static msg_t ll_eeprom_read(SPIEepromFileStream *efs, uint32_t offset,
                             uint8_t *data, size_t len) {
 
-  uint8_t txbuff[4];
+  const SPIEepromFileConfig *eepcfg = efs->cfg;
+  uint8_t txbuff[5];
   uint8_t txlen;
+  msg_t status;
 
   osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
              "out of device bounds");
@@ -193,29 +268,52 @@ static msg_t ll_eeprom_read(const SPIEepromFileConfig *eepcfg, uint32_t offset,
   if (eepcfg->spip->state != SPI_READY)
       return MSG_RESET;
 
-  txlen = ll_eeprom_prepare_seq(txbuff, eepcfg->size, CMD_READ,
-                                (offset + eepcfg->barrier_low));
+  ll_25xx_acquire(eepcfg);
+
+  /* The array can not be read during a write cycle. */
+  status = ll_eeprom_wait_pending(eepcfg);
+  if (status != MSG_OK) {
+    ll_25xx_release(eepcfg);
+    return status;
+  }
+
+  if (eepcfg->fast_read) {
+    txlen = ll_eeprom_prepare_seq(txbuff, eepcfg->size, CMD_FAST_READ,
+                                  (offset + eepcfg->barrier_low));
+    txbuff[txlen++] = 0; /* Dummy byte. */
+  }
+  else {
+    txlen = ll_eeprom_prepare_seq(txbuff, eepcfg->size, CMD_READ,
+                                  (offset + eepcfg->barrier_low));
+  }
   ll_25xx_transmit_receive(eepcfg, txbuff, txlen, data, len);
+  ll_25xx_release(eepcfg);
 
+  ll_eeprom_count(eepcfg, reads, 1);
+  ll_eeprom_count(eepcfg, bytes_read, len);
   return MSG_OK;
 }
 
 /**
  * @brief   EEPROM write routine.
- * @details Function writes data to EEPROM.
+ * @details Function writes data to EEPROM. The end of the write cycle is
+ *          not waited for, it is done by the next access to the IC.
+ * @note    The write enable latch is reset by the IC at the end of the
+ *          write cycle.
  * @pre     Data must be fit to single EEPROM page.
  *
- * @param[in] eepcfg  pointer to configuration structure of eeprom file.
+ * @param[in] efs     pointer to the file stream object.
  * @param[in] offset  addres of 1-st byte to be writen.
  * @param[in] data    pointer to buffer with data to be written.
  * @param[in] len     number of bytes to be written.
  */
-static msg_t ll_eeprom_write(const SPIEepromFileConfig *eepcfg, uint32_t offset,
+static msg_t ll_eeprom_write(SPIEepromFileStream *efs, uint32_t offset,
                              const uint8_t *data, size_t len) {
 
+  const SPIEepromFileConfig *eepcfg = efs->cfg;
   uint8_t txbuff[4];
   uint8_t txlen;
-  systime_t now;
+  msg_t status;
 
   osalDbgAssert(((len <= eepcfg->size) && ((offset + len) <= eepcfg->size)),
              "out of device bounds");
@@ -226,37 +324,61 @@ static msg_t ll_eeprom_write(const SPIEepromFileConfig *eepcfg, uint32_t offset,
   if (eepcfg->spip->state != SPI_READY)
       return MSG_RESET;
 
+  ll_25xx_acquire(eepcfg);
+
+  /* Wait until EEPROM process previous data. */
+  status = ll_eeprom_wait_pending(eepcfg);
+  if (status != MSG_OK) {
+    ll_25xx_release(eepcfg);
+    return status;
+  }
+
   /* Unlock array for writting. */
   ll_eeprom_unlock(eepcfg);
 
-#if SPI_USE_MUTUAL_EXCLUSION
-  spiAcquireBus(eepcfg->spip);
-#endif
-
   spiSelect(eepcfg->spip);
-  txlen = ll_eeprom_prepare_seq(txbuff, eepcfg->size, CMD_WRITE,
-                                (offset + eepcfg->barrier_low));
-  spiSend(eepcfg->spip, txlen, txbuff);
-  spiSend(eepcfg->spip, len, data);
+  if (eepcfg->write_buf != NULL) {
+    /* Command, address and data in a single transfer. */
+    txlen = ll_eeprom_prepare_seq(eepcfg->write_buf, eepcfg->size, CMD_WRITE,
+                                  (offset + eepcfg->barrier_low));
+    memcpy(&eepcfg->write_buf[txlen], data, len);
+    spiSend(eepcfg->spip, txlen + len, eepcfg->write_buf);
+  }
+  else {
+    txlen = ll_eeprom_prepare_seq(txbuff, eepcfg->size, CMD_WRITE,
+                                  (offset + eepcfg->barrier_low));
+    spiSend(eepcfg->spip, txlen, txbuff);
+    spiSend(eepcfg->spip, len, data);
+  }
   spiUnselect(eepcfg->spip);
 
-#if SPI_USE_MUTUAL_EXCLUSION
-  spiReleaseBus(eepcfg->spip);
-#endif
+  if (eepcfg->pending != NULL)
+    *eepcfg->pending = true;
+  ll_25xx_release(eepcfg);
 
-  /* Wait until EEPROM process data. */
-  now = chVTGetSystemTimeX();
-  while (ll_eeprom_is_busy(eepcfg)) {
-    if ((chVTGetSystemTimeX() - now) > eepcfg->write_time) {
-      return MSG_TIMEOUT;
-    }
+  ll_eeprom_count(eepcfg, page_writes, 1);
+  ll_eeprom_count(eepcfg, bytes_written, len);
+  return MSG_OK;
+}
 
-    chThdYield();
-  }
+/**
+ * @brief   Waits for the write cycle of the last page written, if any.
+ * @details A failure is reported by the file error too.
+ *
+ * @param[in] efs     pointer to the file stream object
+ */
+static msg_t ll_eeprom_sync(SPIEepromFileStream *efs) {
 
-  /* Lock array preventing unexpected access */
-  ll_eeprom_lock(eepcfg);
-  return MSG_OK;
+  const SPIEepromFileConfig *eepcfg = efs->cfg;
+  msg_t status;
+
+  ll_25xx_acquire(eepcfg);
+  status = ll_eeprom_wait_pending(eepcfg);
+  ll_25xx_release(eepcfg);
+  if (status != MSG_OK)
+    efs->errors = FILE_ERROR;
+
+  return status;
 }
 
 /**
@@ -270,40 +392,22 @@ static size_t __clamp_size(void *ip, size_t n) {
     return n;
 }
 
-/**
- * @brief   Write data that can be fitted in one page boundary
- */
-static msg_t __fitted_write(void *ip, const uint8_t *data, size_t len, uint32_t *written) {
-
-  msg_t status = MSG_RESET;
-
-  osalDbgAssert(len > 0, "len must be greater than 0");
-
-  status = ll_eeprom_write(((SPIEepromFileStream *)ip)->cfg,
-                           eepfs_getposition(ip, NULL), data, len);
-  if (status == MSG_OK) {
-    *written += len;
-    eepfs_lseek(ip, eepfs_getposition(ip, NULL) + len);
-  }
-  return status;
-}
-
 /**
  * @brief     Write data to EEPROM.
  * @details   Only one EEPROM page can be written at once. So function
  *            splits large data chunks in small EEPROM transactions if needed.
+ *            Each page is sent as soon as the write cycle of the previous
+ *            one ends, the last write cycle ends during the caller run.
  * @note      To achieve the maximum efficiency use write operations
  *            aligned to EEPROM page boundaries.
  */
 static size_t write(void *ip, const uint8_t *bp, size_t n) {
 
-  size_t   len = 0;      /* bytes to be written per transaction */
+  SPIEepromFileStream *efs = ip;
+  size_t   len;          /* bytes to be written per transaction */
   uint32_t written = 0;  /* total bytes successfully written */
   uint16_t pagesize;
-  uint32_t firstpage;
-  uint32_t lastpage;
-
-  volatile const SPIEepromFileConfig *cfg = ((SPIEepromFileStream *)ip)->cfg;
+  uint32_t offset;
 
   osalDbgCheck((ip != NULL) && (((SPIEepromFileStream *)ip)->vmt != NULL));
 
@@ -314,42 +418,24 @@ static size_t write(void *ip, const uint8_t *bp, size_t n) {
   if (n == 0)
     return 0;
 
-  pagesize  = cfg->pagesize;
-  firstpage = (cfg->barrier_low + eepfs_getposition(ip, NULL)) / pagesize;
-  lastpage  = ((cfg->barrier_low + eepfs_getposition(ip, NULL) + n) - 1) / pagesize;
+  pagesize = efs->cfg->pagesize;
+  offset   = eepfs_getposition(ip, NULL);
 
-  /* data fits in single page */
-  if (firstpage == lastpage) {
-    len = n;
-    __fitted_write(ip, bp, len, &written);
-    return written;
-  }
-  
-  else {
-    /* write first piece of data to first page boundary */
-    len =  ((firstpage + 1) * pagesize) - eepfs_getposition(ip, NULL);
-    len -= cfg->barrier_low;
-    if (__fitted_write(ip, bp, len, &written) != MSG_OK)
-      return written;
-    bp += len;
-
-    /* now write page sized blocks (zero or more) */
-    while ((n - written) > pagesize) {
-      len = pagesize;
-      if (__fitted_write(ip, bp, len, &written) != MSG_OK)
-        return written;
-      bp += len;
-    }
+  while (written < n) {
+    /* Up to the page boundary. */
+    len = pagesize - ((efs->cfg->barrier_low + offset) % pagesize);
+    if (len > (n - written))
+      len = n - written;
 
-    /* write tail */
-    len = n - written;
-    if (len == 0)
-      return written;
-    else {
-      __fitted_write(ip, bp, len, &written);
-    }
+    if (ll_eeprom_write(efs, offset, bp, len) != MSG_OK)
+      break;
+
+    written += len;
+    offset  += len;
+    bp      += len;
   }
 
+  eepfs_lseek(ip, offset);
   return written;
 }
 
@@ -372,7 +458,7 @@ static size_t read(void *ip, uint8_t *bp, size_t n) {
     return 0;
 
   /* call low level function */
-  status = ll_eeprom_read(((SPIEepromFileStream *)ip)->cfg,
+  status = ll_eeprom_read((SPIEepromFileStream *)ip,
                           eepfs_getposition(ip, NULL), bp, n);
   if (status != MSG_OK)
     return 0;
@@ -382,13 +468,28 @@ static size_t read(void *ip, uint8_t *bp, size_t n) {
   }
 }
 
+/**
+ * Waits for the end of the write cycle and closes the file. The file is
+ * closed anyway, a failure of the write cycle is returned as its status.
+ */
+static msg_t close(void *ip) {
+
+  msg_t status;
+
+  osalDbgCheck((ip != NULL) && (((EepromFileStream *)ip)->vmt != NULL));
+
+  status = ll_eeprom_sync(ip);
+  (void)eepfs_close(ip);
+  return status;
+}
+
 static const struct EepromFileStreamVMT vmt = {
   (size_t)0,
   write,
   read,
   eepfs_put,
   eepfs_get,
-  eepfs_close,
+  close,
   eepfs_geterror,
   eepfs_getsize,
   eepfs_getposition,
@@ -400,4 +501,33 @@ EepromDevice eepdev_25xx = {
   &vmt
 };
 
+/**
+ * Open SPI EEPROM IC as file and return pointer to the file stream object.
+ * The transfer counters are cleared.
+ */
+EepromFileStream *SPIEepromFileOpen(SPIEepromFileStream *efs,
+                                    const SPIEepromFileConfig *eepcfg,
+                                    const EepromDevice *eepdev) {
+
+  if (eepcfg->stats != NULL)
+    memset(eepcfg->stats, 0, sizeof(*eepcfg->stats));
+  return EepromFileOpen((EepromFileStream *)efs,
+                        (const EepromFileConfig *)eepcfg, eepdev);
+}
+
+/**
+ * @brief   Waits for the end of the write cycle of the last page written.
+ * @details A write returns before the IC has committed its last page, a
+ *          failure of that write cycle is otherwise reported by the next
+ *          access to the IC.
+ *
+ * @param[in] efs     pointer to an open SPI EEPROM file stream
+ */
+msg_t SPIEepromFileSync(EepromFileStream *efs) {
+
+  osalDbgCheck((efs != NULL) && (efs->vmt == &vmt));
+
+  return ll_eeprom_sync((SPIEepromFileStream *)efs);
+}
+
 #endif /* EEPROM_USE_EE25XX */
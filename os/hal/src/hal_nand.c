@@ -264,6 +264,72 @@ static bool read_is_page_bad(NANDDriver *nandp, uint32_t die, uint32_t logun,
     return false;
 }
 
+/**
+ * @brief   Read bad mark out of the cache register.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] col           column address of the spare area
+ *
+ * @return                  Bad mark.
+ *
+ * @notapi
+ */
+static uint16_t read_cached_mark(NANDDriver *nandp, const uint8_t *col) {
+  uint16_t bb_mark;
+
+  nand_lld_write_cmd_addr(nandp, NAND_CMD_RNDOUT, col,
+                          nandp->config->colcycles);
+  nand_lld_write_cmd_addr(nandp, NAND_CMD_RNDOUT_START, NULL, 0);
+  nand_lld_read_buf(nandp, &bb_mark, sizeof(bb_mark));
+  return bb_mark;
+}
+
+/**
+ * @brief   Scan a plane for bad blocks with random cache reads.
+ * @details The marks of the first two pages of every block are read so
+ *          that each page is fetched from the array while the mark of the
+ *          previous one is transferred.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] logun         logical unit number in nand flash
+ * @param[in] plane         plane number in nand flash
+ * @param[in] first         bit of the first block of the plane in the map
+ *
+ * @notapi
+ */
+static void scan_plane_cached(NANDDriver *nandp, uint32_t logun,
+                              uint32_t plane, size_t first) {
+
+  const NANDConfig *cfg = nandp->config;
+  const size_t addrlen = cfg->rowcycles + cfg->colcycles;
+  uint8_t addr[addrlen];
+  size_t b, pg;
+  bool bad = false;
+
+  for (b = 0; b < cfg->blocks; b++) {
+    for (pg = 0; pg < 2; pg++) {
+      calc_addr(cfg, logun, plane, b, pg, cfg->page_data_size, addr, addrlen);
+      nand_lld_write_cmd_addr(nandp, NAND_CMD_READ0, addr, addrlen);
+      if ((b == 0) && (pg == 0)) {
+        nand_lld_write_cmd_wait(nandp, NAND_CMD_READ0_CONFIRM);
+        continue;
+      }
+      /* Fetches this page, the previous one is in the cache.*/
+      nand_lld_write_cmd_wait(nandp, NAND_CMD_READ_CACHE);
+      bad |= 0xFFFF != read_cached_mark(nandp, addr);
+      if (pg == 0) {
+        if (bad)
+          bitmapSet(nandp->bb_map, first + b - 1);
+        bad = false;
+      }
+    }
+  }
+  nand_lld_write_cmd_wait(nandp, NAND_CMD_READ_CACHE_END);
+  bad |= 0xFFFF != read_cached_mark(nandp, addr);
+  if (bad)
+    bitmapSet(nandp->bb_map, first + b - 1);
+}
+
 /**
  * @brief   Scan for bad blocks and fill map with their numbers.
  *
@@ -291,6 +357,11 @@ static void scan_bad_blocks(NANDDriver *nandp) {
     hook_for_chipselect_nand_flash(d);
     for(l = 0; l < loguns; l++){
       for(p = 0; p < planes; p++){
+        if (nandp->config->extended_cmds) {
+          scan_plane_cached(nandp, l, p, block_number_of_total_blocks);
+          block_number_of_total_blocks += blocks;
+          continue;
+        }
         for (b = 0; b < blocks; b++, block_number_of_total_blocks++) {
           if (readIsBlockBad(nandp, d, l, p, b)) {
             bitmapSet(nandp->bb_map, block_number_of_total_blocks);
@@ -704,6 +775,255 @@ uint8_t nandErase(NANDDriver *nandp, uint32_t die, uint32_t logun,
   return nand_lld_erase(nandp, addr, addrlen);
 }
 
+/**
+ * @brief   Read consecutive pages with cache read.
+ * @details While a page is transferred the device fetches the next one
+ *          from the array, so that tR is hidden behind the transfers.
+ * @note    Without @p extended_cmds in the configuration the pages are
+ *          read one at a time.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] die           die number in nand flash
+ * @param[in] logun         logical unit number in nand flash
+ * @param[in] plane         plane number in nand flash
+ * @param[in] block         block number
+ * @param[in] page          first page number related to begin of block
+ * @param[out] data         buffer to store data, half word aligned
+ * @param[in] datalen       length of data read from each page in bytes,
+ *                          half word aligned
+ * @param[in] n             number of pages, within the block
+ *
+ * @api
+ */
+void nandReadPagesCached(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                         uint32_t plane, uint32_t block, uint32_t page,
+                         void *data, size_t datalen, uint32_t n) {
+
+  const NANDConfig *cfg = nandp->config;
+  const size_t addrlen = cfg->rowcycles + cfg->colcycles;
+  uint8_t addr[addrlen];
+  uint8_t *p = data;
+  uint32_t i;
+
+  osalDbgCheck((nandp != NULL) && (data != NULL) && (n > 0));
+  osalDbgCheck((datalen <= (cfg->page_data_size + cfg->page_spare_size)));
+  osalDbgAssert(nandp->state == NAND_READY, "invalid state");
+  osalDbgCheck(die <= cfg->dies);
+  osalDbgCheck(logun <= cfg->loguns);
+  osalDbgCheck(plane <= cfg->planes);
+  osalDbgCheck(block <= cfg->blocks);
+  osalDbgCheck(page + n <= cfg->pages_per_block);
+
+  if (!cfg->extended_cmds) {
+    for (i = 0; i < n; i++) {
+      nandReadPageWhole(nandp, die, logun, plane, block, page + i,
+                        p, datalen);
+      p += datalen;
+    }
+    return;
+  }
+
+  /* generates chipselect for a particular die if need be */
+  hook_for_chipselect_nand_flash(die);
+  calc_addr(cfg, logun, plane, block, page, 0, addr, addrlen);
+  nand_lld_write_cmd_addr(nandp, NAND_CMD_READ0, addr, addrlen);
+  nand_lld_write_cmd_wait(nandp, NAND_CMD_READ0_CONFIRM);
+  for (i = 0; i < n; i++) {
+    if (n > 1) {
+      nand_lld_write_cmd_wait(nandp, (i + 1 < n) ? NAND_CMD_READ_CACHE :
+                                                   NAND_CMD_READ_CACHE_END);
+    }
+    nand_lld_read_buf(nandp, (uint16_t *)p, datalen);
+    p += datalen;
+  }
+}
+
+/**
+ * @brief   Write consecutive pages with cache program.
+ * @details Each page is loaded while the device programs the previous one,
+ *          so that tPROG is hidden behind the transfers.
+ * @note    Without @p extended_cmds in the configuration the pages are
+ *          programmed one at a time.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] die           die number in nand flash
+ * @param[in] logun         logical unit number in nand flash
+ * @param[in] plane         plane number in nand flash
+ * @param[in] block         block number
+ * @param[in] page          first page number related to begin of block
+ * @param[in] data          buffer with data to be written, half word aligned
+ * @param[in] datalen       length of data written to each page in bytes,
+ *                          half word aligned
+ * @param[in] n             number of pages, within the block
+ *
+ * @return    The status reported by NAND IC (0x70 command) after the last
+ *            page, with @p NAND_STATUS_FAIL set if any page failed.
+ *
+ * @api
+ */
+uint8_t nandWritePagesCached(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                             uint32_t plane, uint32_t block, uint32_t page,
+                             const void *data, size_t datalen, uint32_t n) {
+
+  const NANDConfig *cfg = nandp->config;
+  const size_t addrlen = cfg->rowcycles + cfg->colcycles;
+  uint8_t addr[addrlen];
+  const uint8_t *p = data;
+  uint8_t status = 0, fail = 0;
+  uint32_t i;
+
+  osalDbgCheck((nandp != NULL) && (data != NULL) && (n > 0));
+  osalDbgCheck((datalen <= (cfg->page_data_size + cfg->page_spare_size)));
+  osalDbgAssert(nandp->state == NAND_READY, "invalid state");
+  osalDbgCheck(die <= cfg->dies);
+  osalDbgCheck(logun <= cfg->loguns);
+  osalDbgCheck(plane <= cfg->planes);
+  osalDbgCheck(block <= cfg->blocks);
+  osalDbgCheck(page + n <= cfg->pages_per_block);
+
+  if (!cfg->extended_cmds) {
+    for (i = 0; i < n; i++) {
+      status = nandWritePageWhole(nandp, die, logun, plane, block, page + i,
+                                  p, datalen);
+      fail |= status & NAND_STATUS_FAIL;
+      p += datalen;
+    }
+    return status | fail;
+  }
+
+  /* generates chipselect for a particular die if need be */
+  hook_for_chipselect_nand_flash(die);
+  for (i = 0; i < n; i++) {
+    calc_addr(cfg, logun, plane, block, page + i, 0, addr, addrlen);
+    nand_lld_write_cmd_addr(nandp, NAND_CMD_WRITE, addr, addrlen);
+    nand_lld_write_buf(nandp, (const uint16_t *)p, datalen);
+    nand_lld_write_cmd_wait(nandp, (i + 1 < n) ? NAND_CMD_CACHEPROG :
+                                                 NAND_CMD_PAGEPROG);
+    /* FAILC reports the page before this one, FAIL is only final once the
+       last page is programmed.*/
+    status = nand_lld_read_status(nandp);
+    if (i > 0)
+      fail |= status & NAND_STATUS_FAILC;
+    if (i + 1 == n)
+      fail |= status & NAND_STATUS_FAIL;
+    p += datalen;
+  }
+
+  if (0 != fail)
+    status |= NAND_STATUS_FAIL;
+  return status;
+}
+
+/**
+ * @brief   Write the same page of a block in every plane at once.
+ * @details The pages are loaded one after the other and programmed
+ *          together, in the time of a single page.
+ * @note    Without @p extended_cmds in the configuration the planes are
+ *          programmed one at a time.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] die           die number in nand flash
+ * @param[in] logun         logical unit number in nand flash
+ * @param[in] block         block number
+ * @param[in] page          page number related to begin of block
+ * @param[in] data          buffer with data to be written, one page after
+ *                          the other starting from plane 0, half word aligned
+ * @param[in] datalen       length of data written to each page in bytes,
+ *                          half word aligned
+ *
+ * @return    The operation status reported by NAND IC (0x70 command).
+ *
+ * @api
+ */
+uint8_t nandWritePageMultiPlane(NANDDriver *nandp, uint32_t die,
+                                uint32_t logun, uint32_t block, uint32_t page,
+                                const void *data, size_t datalen) {
+
+  const NANDConfig *cfg = nandp->config;
+  const size_t addrlen = cfg->rowcycles + cfg->colcycles;
+  uint8_t addr[addrlen];
+  const uint8_t *p = data;
+  uint8_t status = 0;
+  uint32_t plane;
+
+  osalDbgCheck((nandp != NULL) && (data != NULL));
+  osalDbgCheck((datalen <= (cfg->page_data_size + cfg->page_spare_size)));
+  osalDbgAssert(nandp->state == NAND_READY, "invalid state");
+  osalDbgCheck(die <= cfg->dies);
+  osalDbgCheck(logun <= cfg->loguns);
+  osalDbgCheck(block <= cfg->blocks);
+
+  if (!cfg->extended_cmds) {
+    for (plane = 0; plane < cfg->planes; plane++) {
+      status |= nandWritePageWhole(nandp, die, logun, plane, block, page,
+                                   p, datalen);
+      p += datalen;
+    }
+    return status;
+  }
+
+  /* generates chipselect for a particular die if need be */
+  hook_for_chipselect_nand_flash(die);
+  for (plane = 0; plane < cfg->planes; plane++) {
+    calc_addr(cfg, logun, plane, block, page, 0, addr, addrlen);
+    nand_lld_write_cmd_addr(nandp, NAND_CMD_WRITE, addr, addrlen);
+    nand_lld_write_buf(nandp, (const uint16_t *)p, datalen);
+    nand_lld_write_cmd_wait(nandp, (plane + 1 < cfg->planes) ?
+                            NAND_CMD_MULTIPROG : NAND_CMD_PAGEPROG);
+    p += datalen;
+  }
+
+  return nand_lld_read_status(nandp);
+}
+
+/**
+ * @brief   Erase the same block in every plane at once.
+ * @note    Without @p extended_cmds in the configuration the planes are
+ *          erased one at a time.
+ *
+ * @param[in] nandp         pointer to the @p NANDDriver object
+ * @param[in] die           die number in nand flash
+ * @param[in] logun         logical unit number in nand flash
+ * @param[in] block         block number
+ *
+ * @return    The operation status reported by NAND IC (0x70 command).
+ *
+ * @api
+ */
+uint8_t nandEraseMultiPlane(NANDDriver *nandp, uint32_t die, uint32_t logun,
+                            uint32_t block) {
+
+  const NANDConfig *cfg = nandp->config;
+  const size_t addrlen = cfg->rowcycles;
+  uint8_t addr[addrlen];
+  uint8_t status = 0;
+  uint32_t plane;
+
+  osalDbgCheck(nandp != NULL);
+  osalDbgAssert(nandp->state == NAND_READY, "invalid state");
+  osalDbgCheck(die <= cfg->dies);
+  osalDbgCheck(logun <= cfg->loguns);
+  osalDbgCheck(block <= cfg->blocks);
+
+  if (!cfg->extended_cmds) {
+    for (plane = 0; plane < cfg->planes; plane++) {
+      status |= nandErase(nandp, die, logun, plane, block);
+    }
+    return status;
+  }
+
+  /* generates chipselect for a particular die if need be */
+  hook_for_chipselect_nand_flash(die);
+  for (plane = 0; plane < cfg->planes; plane++) {
+    calc_blk_addr(cfg, logun, plane, block, addr, addrlen);
+    nand_lld_write_cmd_addr(nandp, NAND_CMD_ERASE, addr, addrlen);
+    nand_lld_write_cmd_wait(nandp, (plane + 1 < cfg->planes) ?
+                            NAND_CMD_ERASE_MULTI : NAND_CMD_ERASE_CONFIRM);
+  }
+
+  return nand_lld_read_status(nandp);
+}
+
 /**
  * @brief   Check block badness.
  *
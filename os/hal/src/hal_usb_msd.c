@@ -39,6 +39,7 @@
 #define MSD_CSW_SIGNATURE               0x53425355
 
 #define CBW_FLAGS_RESERVED_MASK         0b01111111
+#define CBW_FLAGS_DIR_IN                0b10000000
 #define CBW_LUN_RESERVED_MASK           0b11110000
 #define CBW_CMD_LEN_RESERVED_MASK       0b11000000
 
@@ -132,6 +133,7 @@ static bool cbw_valid(const msd_cbw_t *cbw, msg_t recvd) {
  *          • and both bCBWCBLength and the content of the CBWCB are in
  *            accordance with bInterfaceSubClass.
  *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
  * @param[in] cbw       pointer to the @p msd_cbw_t object
  *
  * @return              Operation status.
@@ -140,10 +142,11 @@ static bool cbw_valid(const msd_cbw_t *cbw, msg_t recvd) {
  *
  * @notapi
  */
-static bool cbw_meaningful(const msd_cbw_t *cbw) {
+static bool cbw_meaningful(const USBMassStorageDriver *msdp,
+                           const msd_cbw_t *cbw) {
   if (((cbw->cmd_len & CBW_CMD_LEN_RESERVED_MASK) != 0)
       || ((cbw->flags & CBW_FLAGS_RESERVED_MASK) != 0)
-      || (cbw->lun != 0)) {
+      || (cbw->lun >= msdp->luns)) {
     return false;
   }
   else {
@@ -151,6 +154,157 @@ static bool cbw_meaningful(const msd_cbw_t *cbw) {
   }
 }
 
+/**
+ * @brief   Records the block device and inquiry data of a logical unit.
+ *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
+ * @param[in] lun       logical unit number
+ * @param[in] blkdev    pointer to the @p BaseBlockDevice object
+ * @param[in] inquiry   pointer to the SCSI inquiry response structure,
+ *                      @p NULL for the default hardcoded value
+ * @param[in] serialInquiry pointer to the SCSI unit serial number inquiry
+ *                      response structure, @p NULL for the default value
+ *
+ * @notapi
+ */
+static void lun_config(USBMassStorageDriver *msdp, uint8_t lun,
+                       BaseBlockDevice *blkdev,
+                       const scsi_inquiry_response_t *inquiry,
+                       const scsi_unit_serial_number_inquiry_response_t *serialInquiry) {
+
+  SCSITargetConfig *config = &msdp->scsi_config[lun];
+
+  if (NULL == inquiry) {
+    config->inquiry_response = &default_scsi_inquiry_response;
+  }
+  else {
+    config->inquiry_response = inquiry;
+  }
+  if (NULL == serialInquiry) {
+    config->unit_serial_number_inquiry_response = &default_scsi_unit_serial_number_inquiry_response;
+  }
+  else {
+    config->unit_serial_number_inquiry_response = serialInquiry;
+  }
+  config->blkdev = blkdev;
+}
+
+/**
+ * @brief   Starts an asynchronous transmission.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] data      payload, must stay valid until the transfer ends
+ * @param[in] len       number of bytes to be transmitted
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  The transfer has been started.
+ * @retval HAL_FAILED   The endpoint is busy or the device is not active.
+ *
+ * @notapi
+ */
+static bool start_transmit(USBDriver *usbp, usbep_t ep,
+                           const uint8_t *data, size_t len) {
+
+  bool ret = HAL_FAILED;
+
+  osalSysLock();
+  if ((usbGetDriverStateI(usbp) == USB_ACTIVE) &&
+      !usbGetTransmitStatusI(usbp, ep)) {
+    usbStartTransmitI(usbp, ep, data, len);
+    ret = HAL_SUCCESS;
+  }
+  osalSysUnlock();
+  return ret;
+}
+
+/**
+ * @brief   Waits for the end of a transmission started by
+ *          @p start_transmit().
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @return              The operation status.
+ * @retval MSG_OK       The transfer has been completed.
+ * @retval MSG_RESET    The device has been reset or deconfigured.
+ *
+ * @notapi
+ */
+static msg_t wait_transmit(USBDriver *usbp, usbep_t ep) {
+
+  msg_t status = MSG_OK;
+
+  osalSysLock();
+  if (usbGetTransmitStatusI(usbp, ep)) {
+    status = osalThreadSuspendS(&usbp->epc[ep]->in_state->thread);
+  }
+  else if (usbGetDriverStateI(usbp) != USB_ACTIVE) {
+    status = MSG_RESET;
+  }
+  osalSysUnlock();
+  return status;
+}
+
+/**
+ * @brief   Starts an asynchronous reception.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[out] data     receive buffer, must stay valid until the transfer
+ *                      ends
+ * @param[in] len       number of bytes to be received
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  The transfer has been started.
+ * @retval HAL_FAILED   The endpoint is busy or the device is not active.
+ *
+ * @notapi
+ */
+static bool start_receive(USBDriver *usbp, usbep_t ep,
+                          uint8_t *data, size_t len) {
+
+  bool ret = HAL_FAILED;
+
+  osalSysLock();
+  if ((usbGetDriverStateI(usbp) == USB_ACTIVE) &&
+      !usbGetReceiveStatusI(usbp, ep)) {
+    usbStartReceiveI(usbp, ep, data, len);
+    ret = HAL_SUCCESS;
+  }
+  osalSysUnlock();
+  return ret;
+}
+
+/**
+ * @brief   Waits for the end of a reception started by @p start_receive().
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @return              The number of received bytes.
+ * @retval MSG_RESET    The device has been reset or deconfigured.
+ *
+ * @notapi
+ */
+static msg_t wait_receive(USBDriver *usbp, usbep_t ep) {
+
+  msg_t status;
+
+  osalSysLock();
+  if (usbGetReceiveStatusI(usbp, ep)) {
+    status = osalThreadSuspendS(&usbp->epc[ep]->out_state->thread);
+  }
+  else if (usbGetDriverStateI(usbp) != USB_ACTIVE) {
+    status = MSG_RESET;
+  }
+  else {
+    status = (msg_t)usbGetReceiveTransactionSizeX(usbp, ep);
+  }
+  osalSysUnlock();
+  return status;
+}
+
 /**
  * @brief   SCSI transport transmit function.
  *
@@ -196,7 +350,84 @@ static uint32_t scsi_transport_receive(const SCSITransport *transport,
 }
 
 /**
- * @brief   Fills and sends CSW message.
+ * @brief   SCSI transport asynchronous transmit start function.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ * @param[in] data      payload
+ * @param[in] len       number of bytes to be transmitted
+ *
+ * @return              The operation status.
+ *
+ * @notapi
+ */
+static bool scsi_transport_start_transmit(const SCSITransport *transport,
+                                          const uint8_t *data, size_t len) {
+
+  usb_scsi_transport_handler_t *trp = transport->handler;
+
+  return start_transmit(trp->usbp, trp->ep, data, len);
+}
+
+/**
+ * @brief   SCSI transport asynchronous transmit wait function.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ *
+ * @return              Number of successfully transmitted bytes.
+ *
+ * @notapi
+ */
+static uint32_t scsi_transport_wait_transmit(const SCSITransport *transport) {
+
+  usb_scsi_transport_handler_t *trp = transport->handler;
+
+  if (MSG_OK == wait_transmit(trp->usbp, trp->ep))
+    return trp->usbp->epc[trp->ep]->in_state->txsize;
+  else
+    return 0;
+}
+
+/**
+ * @brief   SCSI transport asynchronous receive start function.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ * @param[in] data      payload
+ * @param[in] len       number bytes to be received
+ *
+ * @return              The operation status.
+ *
+ * @notapi
+ */
+static bool scsi_transport_start_receive(const SCSITransport *transport,
+                                         uint8_t *data, size_t len) {
+
+  usb_scsi_transport_handler_t *trp = transport->handler;
+
+  return start_receive(trp->usbp, trp->ep, data, len);
+}
+
+/**
+ * @brief   SCSI transport asynchronous receive wait function.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ *
+ * @return              Number of successfully received bytes.
+ *
+ * @notapi
+ */
+static uint32_t scsi_transport_wait_receive(const SCSITransport *transport) {
+
+  usb_scsi_transport_handler_t *trp = transport->handler;
+  msg_t status = wait_receive(trp->usbp, trp->ep);
+
+  if (MSG_RESET != status)
+    return status;
+  else
+    return 0;
+}
+
+/**
+ * @brief   Fills CSW message.
  *
  * @param[in] msdp      pointer to the @p USBMassStorageDriver object
  * @param[in] status    status returned by SCSI layer
@@ -204,18 +435,141 @@ static uint32_t scsi_transport_receive(const SCSITransport *transport,
  *
  * @notapi
  */
-static void send_csw(USBMassStorageDriver *msdp, uint8_t status,
+static void fill_csw(USBMassStorageDriver *msdp, uint8_t status,
                      uint32_t residue) {
 
   msdp->csw.signature = MSD_CSW_SIGNATURE;
   msdp->csw.data_residue = residue;
   msdp->csw.tag = msdp->cbw.tag;
   msdp->csw.status = status;
+}
+
+#if (USB_MSD_USE_STATISTICS == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Accounts an executed command.
+ *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
+ * @param[in] start     realtime counter value at command start
+ *
+ * @notapi
+ */
+static void update_stats(USBMassStorageDriver *msdp, rtcnt_t start) {
+
+  usb_msd_cmd_stats_t *stp;
+  rtcnt_t elapsed = halGetCounterValue() - start;
+  uint32_t len = msdp->cbw.data_len;
+
+  if (len == 0U) {
+    stp = &msdp->stats.other;
+  }
+  else if ((msdp->cbw.flags & CBW_FLAGS_DIR_IN) != 0U) {
+    stp = &msdp->stats.read;
+  }
+  else {
+    stp = &msdp->stats.write;
+  }
+
+  stp->n++;
+  if (msdp->csw.status != CSW_STATUS_PASSED) {
+    stp->failed++;
+  }
+  stp->last = elapsed;
+  if (elapsed > stp->worst) {
+    stp->worst = elapsed;
+  }
+  stp->cumulative += elapsed;
+  if (msdp->csw.data_residue < len) {
+    stp->bytes += len - msdp->csw.data_residue;
+  }
+}
+#endif /* USB_MSD_USE_STATISTICS == TRUE */
+
+/**
+ * @brief   Executes the command of the received CBW and fills the CSW.
+ *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
+ *
+ * @notapi
+ */
+static void execute_cbw(USBMassStorageDriver *msdp) {
+
+  SCSITarget *scsip = &msdp->scsi_target[msdp->cbw.lun];
+#if USB_MSD_USE_STATISTICS == TRUE
+  rtcnt_t start = halGetCounterValue();
+#endif
+
+  if (SCSI_SUCCESS == scsiExecCmd(scsip, msdp->cbw.cmd_data)) {
+    fill_csw(msdp, CSW_STATUS_PASSED, 0);
+  }
+  else {
+    fill_csw(msdp, CSW_STATUS_FAILED, scsiResidue(scsip));
+  }
 
-  usbTransmit(msdp->usbp, USB_MSD_DATA_EP, (uint8_t *)&msdp->csw,
-      sizeof(msd_csw_t));
+#if USB_MSD_USE_STATISTICS == TRUE
+  update_stats(msdp, start);
+#endif
 }
 
+#if (USB_MSD_USE_PIPELINE == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Mass storage worker thread, pipelined version.
+ * @details The CSW is sent asynchronously and the next CBW reception is
+ *          armed right away, so the device is ready as soon as the host
+ *          has the status. The CSW completion is collected only when the
+ *          IN endpoint is needed again.
+ *
+ * @param[in] arg     pointer to the @p USBMassStorageDriver object
+ *
+ * @notapi
+ */
+static THD_FUNCTION(usb_msd_worker, arg) {
+  USBMassStorageDriver *msdp = arg;
+  USBDriver *usbp = msdp->usbp;
+  bool csw_pending = false, execute;
+  msg_t status;
+  chRegSetThreadName("usb_msd_worker");
+
+  while(! chThdShouldTerminateX()) {
+    if (HAL_SUCCESS != start_receive(usbp, USB_MSD_DATA_EP,
+                                     (uint8_t *)&msdp->cbw, sizeof(msd_cbw_t))) {
+      status = MSG_RESET;
+    }
+    else {
+      status = wait_receive(usbp, USB_MSD_DATA_EP);
+    }
+
+    execute = (MSG_RESET != status) && cbw_valid(&msdp->cbw, status) &&
+              cbw_meaningful(msdp, &msdp->cbw);
+
+    /* The previous CSW must be out before the IN endpoint is reused. It is
+       collected on failures too, otherwise the endpoint could be found still
+       busy by the next CSW. The wait returns at once if the device is no
+       more active.*/
+    if (csw_pending && (execute || (MSG_RESET == status))) {
+      (void)wait_transmit(usbp, USB_MSD_DATA_EP);
+      csw_pending = false;
+    }
+
+    if (MSG_RESET == status) {
+      osalThreadSleepMilliseconds(50);
+    }
+    else if (execute) {
+      execute_cbw(msdp);
+      csw_pending = HAL_SUCCESS == start_transmit(usbp, USB_MSD_DATA_EP,
+                                                  (uint8_t *)&msdp->csw,
+                                                  sizeof(msd_csw_t));
+    }
+    else {
+      ; /* do NOT send CSW here. Incorrect CBW must be silently ignored */
+    }
+  }
+
+  if (csw_pending) {
+    (void)wait_transmit(usbp, USB_MSD_DATA_EP);
+  }
+  chThdExit(MSG_OK);
+}
+#else /* USB_MSD_USE_PIPELINE == FALSE */
 /**
  * @brief   Mass storage worker thread.
  *
@@ -233,13 +587,10 @@ static THD_FUNCTION(usb_msd_worker, arg) {
     if (MSG_RESET == status) {
       osalThreadSleepMilliseconds(50);
     }
-    else if (cbw_valid(&msdp->cbw, status) && cbw_meaningful(&msdp->cbw)) {
-      if (SCSI_SUCCESS == scsiExecCmd(&msdp->scsi_target, msdp->cbw.cmd_data)) {
-        send_csw(msdp, CSW_STATUS_PASSED, 0);
-      }
-      else {
-        send_csw(msdp, CSW_STATUS_FAILED, scsiResidue(&msdp->scsi_target));
-      }
+    else if (cbw_valid(&msdp->cbw, status) && cbw_meaningful(msdp, &msdp->cbw)) {
+      execute_cbw(msdp);
+      usbTransmit(msdp->usbp, USB_MSD_DATA_EP, (uint8_t *)&msdp->csw,
+                  sizeof(msd_csw_t));
     }
     else {
       ; /* do NOT send CSW here. Incorrect CBW must be silently ignored */
@@ -248,6 +599,7 @@ static THD_FUNCTION(usb_msd_worker, arg) {
 
   chThdExit(MSG_OK);
 }
+#endif /* USB_MSD_USE_PIPELINE == FALSE */
 
 /*===========================================================================*/
 /* Driver exported functions.                                                */
@@ -261,8 +613,10 @@ static THD_FUNCTION(usb_msd_worker, arg) {
  * @notapi
  */
 bool msd_request_hook(USBDriver *usbp) {
-  /* check that the request is for interface 0.*/
-  if (MSD_SETUP_INDEX(usbp->setup) != 0)
+  USBMassStorageDriver *msdp = usbp->in_params[USB_MSD_DATA_EP - 1U];
+
+  /* check that the request is for interface 0 of a started driver.*/
+  if ((MSD_SETUP_INDEX(usbp->setup) != 0) || (msdp == NULL))
     return false;
 
   if (usbp->setup[0] == (USB_RTYPE_TYPE_CLASS | USB_RTYPE_RECIPIENT_INTERFACE | USB_RTYPE_DIR_HOST2DEV)
@@ -282,8 +636,8 @@ bool msd_request_hook(USBDriver *usbp) {
   } else if (usbp->setup[0] == (USB_RTYPE_TYPE_CLASS | USB_RTYPE_RECIPIENT_INTERFACE | USB_RTYPE_DIR_DEV2HOST)
     && usbp->setup[1] == MSD_REQ_GET_MAX_LUN) {
     /* Return the maximum supported LUN. */
-    static uint8_t zero = 0;
-    usbSetupTransfer(usbp, &zero, 1, NULL);
+    msdp->max_lun = msdp->luns - 1;
+    usbSetupTransfer(usbp, &msdp->max_lun, 1, NULL);
     return true;
     /* OR */
     /* Return false to stall to indicate that we don't support LUN */
@@ -302,12 +656,18 @@ bool msd_request_hook(USBDriver *usbp) {
  */
 void msdObjectInit(USBMassStorageDriver *msdp) {
 
+  unsigned i;
+
   memset(msdp, 0x55, sizeof(USBMassStorageDriver));
   msdp->state = USB_MSD_STOP;
   msdp->usbp = NULL;
   msdp->worker = NULL;
+  msdp->luns = 1;
 
-  scsiObjectInit(&msdp->scsi_target);
+  for (i = 0; i < USB_MSD_MAX_LUNS; i++) {
+    scsiObjectInit(&msdp->scsi_target[i]);
+    msdp->scsi_config[i].unmap = NULL;
+  }
 }
 
 /**
@@ -319,13 +679,22 @@ void msdObjectInit(USBMassStorageDriver *msdp) {
  */
 void msdStop(USBMassStorageDriver *msdp) {
 
+  unsigned i;
+
   osalDbgCheck(msdp != NULL);
   osalDbgAssert((msdp->state == USB_MSD_READY), "invalid state");
 
   chThdTerminate(msdp->worker);
   chThdWait(msdp->worker);
 
-  scsiStop(&msdp->scsi_target);
+  osalSysLock();
+  msdp->usbp->in_params[USB_MSD_DATA_EP - 1U]  = NULL;
+  msdp->usbp->out_params[USB_MSD_DATA_EP - 1U] = NULL;
+  osalSysUnlock();
+
+  for (i = 0; i < msdp->luns; i++) {
+    scsiStop(&msdp->scsi_target[i]);
+  }
 
   msdp->worker = NULL;
   msdp->state = USB_MSD_STOP;
@@ -340,16 +709,25 @@ void msdStop(USBMassStorageDriver *msdp) {
  * @param[in] blkdev    pointer to the @p BaseBlockDevice object
  * @param[in] blkbuf    pointer to the working area buffer, must be allocated
  *                      by user, must be big enough to store 1 data block
+ * @param[in] blkbufsize size of the working area buffer in bytes, with room
+ *                      for two blocks or more USB transfers and block device
+ *                      accesses are overlapped
  * @param[in] inquiry   pointer to the SCSI inquiry response structure,
  *                      set it to @p NULL to use default hardcoded value.
+ * @param[in] serialInquiry pointer to the SCSI unit serial number inquiry
+ *                      response structure, @p NULL for the default value.
+ * @note    The block device becomes logical unit 0, more logical units can
+ *          be added with @p msdAddLUN() before starting the driver.
  *
  * @api
  */
 void msdStart(USBMassStorageDriver *msdp, USBDriver *usbp,
-              BaseBlockDevice *blkdev, uint8_t *blkbuf,
+              BaseBlockDevice *blkdev, uint8_t *blkbuf, size_t blkbufsize,
               const scsi_inquiry_response_t *inquiry,
               const scsi_unit_serial_number_inquiry_response_t *serialInquiry) {
 
+  unsigned i;
+
   osalDbgCheck((msdp != NULL) && (usbp != NULL)
               && (blkdev != NULL) && (blkbuf != NULL));
   osalDbgAssert((msdp->state == USB_MSD_STOP), "invalid state");
@@ -361,30 +739,93 @@ void msdStart(USBMassStorageDriver *msdp, USBDriver *usbp,
   msdp->scsi_transport.handler  = &msdp->usb_scsi_transport_handler;
   msdp->scsi_transport.transmit = scsi_transport_transmit;
   msdp->scsi_transport.receive  = scsi_transport_receive;
-
-  if (NULL == inquiry) {
-    msdp->scsi_config.inquiry_response = &default_scsi_inquiry_response;
-  }
-  else {
-    msdp->scsi_config.inquiry_response = inquiry;
+  msdp->scsi_transport.start_transmit = scsi_transport_start_transmit;
+  msdp->scsi_transport.wait_transmit  = scsi_transport_wait_transmit;
+  msdp->scsi_transport.start_receive  = scsi_transport_start_receive;
+  msdp->scsi_transport.wait_receive   = scsi_transport_wait_receive;
+
+  /* All the logical units share the working area buffer, commands are
+     executed one at a time by the worker thread.*/
+  lun_config(msdp, 0, blkdev, inquiry, serialInquiry);
+  for (i = 0; i < msdp->luns; i++) {
+    msdp->scsi_config[i].blkbuf = blkbuf;
+    msdp->scsi_config[i].blkbuf_size = blkbufsize;
+    msdp->scsi_config[i].transport = &msdp->scsi_transport;
+    scsiStart(&msdp->scsi_target[i], &msdp->scsi_config[i]);
   }
-  if (NULL == serialInquiry) {
-    msdp->scsi_config.unit_serial_number_inquiry_response = &default_scsi_unit_serial_number_inquiry_response;
-  }
-  else {
-    msdp->scsi_config.unit_serial_number_inquiry_response = serialInquiry;
-  }
-  msdp->scsi_config.blkbuf = blkbuf;
-  msdp->scsi_config.blkdev = blkdev;
-  msdp->scsi_config.transport = &msdp->scsi_transport;
+#if USB_MSD_USE_STATISTICS == TRUE
+  memset(&msdp->stats, 0, sizeof(msdp->stats));
+#endif
 
-  scsiStart(&msdp->scsi_target, &msdp->scsi_config);
+  osalSysLock();
+  usbp->in_params[USB_MSD_DATA_EP - 1U]  = msdp;
+  usbp->out_params[USB_MSD_DATA_EP - 1U] = msdp;
+  osalSysUnlock();
 
   msdp->state = USB_MSD_READY;
   msdp->worker = chThdCreateStatic(msdp->waMSDWorker, sizeof(msdp->waMSDWorker),
                                    MSD_THD_PRIO, usb_msd_worker, msdp);
 }
 
+/**
+ * @brief   Adds a logical unit to the USB mass storage driver.
+ * @details The logical unit number is the number of units already present,
+ *          the first call adds logical unit 1. The working area buffer given
+ *          to @p msdStart() is shared by all the logical units. The units
+ *          are kept until the object is initialized again.
+ * @note    The driver must be stopped, the logical units are read by the
+ *          worker thread and by the GET_MAX_LUN request without locking.
+ *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
+ * @param[in] blkdev    pointer to the @p BaseBlockDevice object
+ * @param[in] inquiry   pointer to the SCSI inquiry response structure,
+ *                      set it to @p NULL to use default hardcoded value.
+ * @param[in] serialInquiry pointer to the SCSI unit serial number inquiry
+ *                      response structure, @p NULL for the default value.
+ *
+ * @return              The operation status.
+ * @retval HAL_SUCCESS  The logical unit has been added.
+ * @retval HAL_FAILED   All the @p USB_MSD_MAX_LUNS logical units are in use.
+ *
+ * @api
+ */
+bool msdAddLUN(USBMassStorageDriver *msdp, BaseBlockDevice *blkdev,
+               const scsi_inquiry_response_t *inquiry,
+               const scsi_unit_serial_number_inquiry_response_t *serialInquiry) {
+
+  osalDbgCheck((msdp != NULL) && (blkdev != NULL));
+  osalDbgAssert((msdp->state == USB_MSD_STOP), "invalid state");
+
+  if (msdp->luns >= USB_MSD_MAX_LUNS) {
+    return HAL_FAILED;
+  }
+
+  lun_config(msdp, msdp->luns, blkdev, inquiry, serialInquiry);
+  msdp->luns++;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Sets the unmap call of a logical unit.
+ * @details With an unmap call the logical unit advertises thin provisioning
+ *          and the host TRIM requests reach the block device as UNMAP
+ *          commands.
+ * @note    The driver must be stopped.
+ *
+ * @param[in] msdp      pointer to the @p USBMassStorageDriver object
+ * @param[in] lun       logical unit number
+ * @param[in] unmap     block device unmap call, @p NULL to disable
+ *
+ * @api
+ */
+void msdSetUnmap(USBMassStorageDriver *msdp, uint8_t lun, scsi_unmap_t unmap) {
+
+  osalDbgCheck((msdp != NULL) && (lun < msdp->luns));
+  osalDbgAssert((msdp->state == USB_MSD_STOP), "invalid state");
+
+  msdp->scsi_config[lun].unmap = unmap;
+}
+
 #endif /* HAL_USE_USB_MSD */
 
 /** @} */
@@ -67,6 +67,40 @@ static inline void _check_urb(usbh_urb_t *urb) {
 	//TODO: add more checks.
 }
 
+/*===========================================================================*/
+/* Status change notification.                                               */
+/*===========================================================================*/
+
+/* Called by the low level driver and the hub driver when a port or hub
+ * status changes; _usbh_statuschangeI may require a reschedule if called
+ * from a S-locked state */
+void _usbh_statuschangeI(USBHDriver *usbh) {
+	osalDbgCheckClassI();
+	usbh->statuschange = TRUE;
+	osalEventBroadcastFlagsI(&usbh->event, USBH_EVENT_STATUS_CHANGE);
+#if HAL_USBH_USE_MAIN_THREAD
+	osalThreadResumeI(&usbh->main_tr, MSG_OK);
+#endif
+}
+
+#if HAL_USBH_USE_MAIN_THREAD
+static void _usbh_main_thread(void *arg) {
+	USBHDriver *const usbh = (USBHDriver *)arg;
+
+	chRegSetThreadName("USBH");
+	usbh->main_thread = chThdGetSelfX();
+
+	for (;;) {
+		osalSysLock();
+		while (!usbh->statuschange)
+			osalThreadSuspendS(&usbh->main_tr);
+		osalSysUnlock();
+
+		usbhMainLoop(usbh);
+	}
+}
+#endif
+
 /*===========================================================================*/
 /* Main driver API.                                                          */
 /*===========================================================================*/
@@ -74,6 +108,7 @@ static inline void _check_urb(usbh_urb_t *urb) {
 void usbhObjectInit(USBHDriver *usbh) {
 	memset(usbh, 0, sizeof(*usbh));
 	usbh->status = USBH_STATUS_STOPPED;
+	osalEventObjectInit(&usbh->event);
 #if HAL_USBH_USE_HUB
 	INIT_LIST_HEAD(&usbh->hubs);
 	_usbhub_port_object_init(&usbh->rootport, usbh, 0, 1);
@@ -93,7 +128,17 @@ void usbhStart(USBHDriver *usbh) {
 	osalDbgAssert((usbh->status == USBH_STATUS_STOPPED), "invalid state");
 	usbh_lld_start(usbh);
 	usbh->status = USBH_STATUS_STARTED;
+	/* process the initial port status */
+	_usbh_statuschangeI(usbh);
+	osalOsRescheduleS();
 	osalSysUnlock();
+
+#if HAL_USBH_USE_MAIN_THREAD
+	if (usbh->main_thread == NULL) {
+		usbh->main_thread = chThdCreateStatic(usbh->main_wa, sizeof(usbh->main_wa),
+				HAL_USBH_MAIN_THREAD_PRIO, _usbh_main_thread, usbh);
+	}
+#endif
 }
 
 void usbhStop(USBHDriver *usbh) {
@@ -542,11 +587,40 @@ static inline bool _device_read_basic_cfgdesc(usbh_device_t *dev, uint8_t bConfi
 			sizeof(dev->basicConfigDesc), (uint8_t *)&dev->basicConfigDesc);
 }
 
+static void _device_free_cfgindex(usbh_device_t *dev) {
+	if (dev->cfgIndex.ifs != NULL) {
+		chHeapFree(dev->cfgIndex.ifs);
+		dev->cfgIndex.ifs = NULL;
+	}
+}
+
+static void _device_build_cfgindex(usbh_device_t *dev) {
+	size_t size;
+	void *storage;
+
+	size = descidx_init(&dev->cfgIndex, dev->fullConfigurationDescriptor,
+			dev->basicConfigDesc.wTotalLength, NULL, 0);
+	if (size == 0) {
+		udevwarn("No interfaces to index in the configuration descriptor");
+		return;
+	}
+
+	storage = chHeapAlloc(0, size);
+	if (storage == NULL) {
+		udevwarn("Can't alloc the configuration descriptor index");
+		return;
+	}
+
+	descidx_init(&dev->cfgIndex, dev->fullConfigurationDescriptor,
+			dev->basicConfigDesc.wTotalLength, storage, size);
+}
+
 static void _device_read_full_cfgdesc(usbh_device_t *dev, uint8_t bConfiguration) {
 	_check_dev(dev);
 
 	uint8_t i;
 
+	_device_free_cfgindex(dev);
 	if (dev->fullConfigurationDescriptor != NULL) {
 		chHeapFree(dev->fullConfigurationDescriptor);
 	}
@@ -561,6 +635,7 @@ static void _device_read_full_cfgdesc(usbh_device_t *dev, uint8_t bConfiguration
 		if (usbhStdReqGetConfigurationDescriptor(dev, bConfiguration,
 				dev->basicConfigDesc.wTotalLength,
 				dev->fullConfigurationDescriptor) == HAL_SUCCESS) {
+			_device_build_cfgindex(dev);
 			return;
 		}
 		osalThreadSleepMilliseconds(200);
@@ -573,6 +648,7 @@ static void _device_read_full_cfgdesc(usbh_device_t *dev, uint8_t bConfiguration
 
 static void _device_free_full_cfgdesc(usbh_device_t *dev) {
 	osalDbgCheck(dev);
+	_device_free_cfgindex(dev);
 	if (dev->fullConfigurationDescriptor != NULL) {
 		chHeapFree(dev->fullConfigurationDescriptor);
 		dev->fullConfigurationDescriptor = NULL;
@@ -1152,6 +1228,15 @@ static void _hub_process(USBHDriver *host) {
 /*===========================================================================*/
 void usbhMainLoop(USBHDriver *usbh) {
 
+#if HAL_USBH_USE_MAIN_THREAD
+	osalDbgAssert(chThdGetSelfX() == usbh->main_thread, "called outside of the USBH thread");
+#endif
+
+	/* changes signaled from now on will cause another pass */
+	osalSysLock();
+	usbh->statuschange = FALSE;
+	osalSysUnlock();
+
 	if (usbh->status == USBH_STATUS_STOPPED)
 		return;
 
@@ -1232,7 +1317,7 @@ bool _usbh_match_descriptor(const uint8_t *descriptor, uint16_t rem,
 	return HAL_FAILED;
 }
 
-static const usbh_classdriverinfo_t *usbh_classdrivers_lookup[] = {
+static const usbh_classdriverinfo_t *const usbh_classdrivers_builtin[] = {
 #if HAL_USBH_USE_ADDITIONAL_CLASS_DRIVERS
 	/* user-defined out of tree class drivers */
 	HAL_USBH_ADDITIONAL_CLASS_DRIVERS
@@ -1252,19 +1337,94 @@ static const usbh_classdriverinfo_t *usbh_classdrivers_lookup[] = {
 #if HAL_USBH_USE_HID
 	&usbhhidClassDriverInfo,
 #endif
-#if HAL_USBH_USE_UVC
-	&usbhuvcClassDriverInfo,
-#endif
 #if HAL_USBH_USE_AOA
 	&usbhaoaClassDriverInfo,	/* Leave always last */
 #endif
 };
 
-static bool _classdriver_load(usbh_device_t *dev, uint8_t *descbuff, uint16_t rem) {
+static usbh_classdriverlink_t usbh_classdrivers_links[sizeof_array(usbh_classdrivers_builtin) + 1];
+static usbh_classdriverlink_t *usbh_classdrivers;
+
+/* Class/subclass/protocol of a device, IAD or interface descriptor, decoded
+ * once per descriptor and compared against every driver's match table */
+typedef struct {
+	uint8_t type;
+	uint8_t _class;
+	uint8_t subclass;
+	uint8_t protocol;
+} usbh_matchkey_t;
+
+static bool _matchkey_init(usbh_matchkey_t *key, const uint8_t *descriptor, uint16_t rem) {
+	if ((rem < 2) || (rem < descriptor[0]))
+		return HAL_FAILED;
+
+	key->type = descriptor[1];
+	switch (key->type) {
+	case USBH_DT_DEVICE: {
+		if (rem < USBH_DT_DEVICE_SIZE)
+			return HAL_FAILED;
+		const usbh_device_descriptor_t *const desc = (const usbh_device_descriptor_t *)descriptor;
+		key->_class = desc->bDeviceClass;
+		key->subclass = desc->bDeviceSubClass;
+		key->protocol = desc->bDeviceProtocol;
+	}	break;
+	case USBH_DT_INTERFACE: {
+		if (rem < USBH_DT_INTERFACE_SIZE)
+			return HAL_FAILED;
+		const usbh_interface_descriptor_t *const desc = (const usbh_interface_descriptor_t *)descriptor;
+		key->_class = desc->bInterfaceClass;
+		key->subclass = desc->bInterfaceSubClass;
+		key->protocol = desc->bInterfaceProtocol;
+	}	break;
+	case USBH_DT_INTERFACE_ASSOCIATION: {
+		if (rem < USBH_DT_INTERFACE_ASSOCIATION_SIZE)
+			return HAL_FAILED;
+		const usbh_ia_descriptor_t *const desc = (const usbh_ia_descriptor_t *)descriptor;
+		key->_class = desc->bFunctionClass;
+		key->subclass = desc->bFunctionSubClass;
+		key->protocol = desc->bFunctionProtocol;
+	}	break;
+	default:
+		return HAL_FAILED;
+	}
+
+	return HAL_SUCCESS;
+}
+
+static bool _classdriver_match(const usbh_classdriverinfo_t *info,
+		const usbh_device_t *dev, const usbh_matchkey_t *key) {
 	uint8_t i;
+
+	if (info->match == NULL)
+		return HAL_SUCCESS;
+
+	for (i = 0; i < info->match_count; i++) {
+		const usbh_classdriver_match_t *const m = &info->match[i];
+		if (((m->type < 0) || (m->type == key->type))
+			&& ((m->vid < 0) || (m->vid == dev->devDesc.idVendor))
+			&& ((m->pid < 0) || (m->pid == dev->devDesc.idProduct))
+			&& ((m->_class < 0) || (m->_class == key->_class))
+			&& ((m->subclass < 0) || (m->subclass == key->subclass))
+			&& ((m->protocol < 0) || (m->protocol == key->protocol)))
+			return HAL_SUCCESS;
+	}
+
+	return HAL_FAILED;
+}
+
+static bool _classdriver_load(usbh_device_t *dev, uint8_t *descbuff, uint16_t rem) {
 	usbh_baseclassdriver_t *drv = NULL;
-	for (i = 0; i < sizeof_array(usbh_classdrivers_lookup); i++) {
-		const usbh_classdriverinfo_t *const info = usbh_classdrivers_lookup[i];
+	const usbh_classdriverlink_t *link;
+	usbh_matchkey_t key;
+
+	if (_matchkey_init(&key, descbuff, rem) != HAL_SUCCESS)
+		return HAL_FAILED;
+
+	for (link = usbh_classdrivers; link != NULL; link = link->next) {
+		const usbh_classdriverinfo_t *const info = link->info;
+
+		if (_classdriver_match(info, dev, &key) != HAL_SUCCESS)
+			continue;
 
 		udevinfof("Try load driver %s", info->name);
 		drv = info->vmt->load(dev, descbuff, rem);
@@ -1285,6 +1445,39 @@ success:
 	return HAL_SUCCESS;
 }
 
+/* Interface walk of the full configuration descriptor, through the index
+ * when it could be built, else with the descriptor iterators. */
+static bool _cfg_if_iter_init(usbh_device_t *dev, if_iterator_t *iif, uint8_t *n) {
+	const descidx_t *const idx = &dev->cfgIndex;
+	generic_iterator_t icfg;
+
+	*n = 0;
+	if (descidx_valid(idx)) {
+		descidx_if_iter(idx, 0, iif);
+		return HAL_SUCCESS;
+	}
+
+	cfg_iter_init(&icfg, dev->fullConfigurationDescriptor,
+			dev->basicConfigDesc.wTotalLength);
+	if (!icfg.valid)
+		return HAL_FAILED;
+
+	if_iter_init(iif, &icfg);
+	return HAL_SUCCESS;
+}
+
+static void _cfg_if_iter_next(usbh_device_t *dev, if_iterator_t *iif, uint8_t *n) {
+	const descidx_t *const idx = &dev->cfgIndex;
+
+	if (!descidx_valid(idx)) {
+		if_iter_next(iif);
+	} else if (++*n < idx->if_count) {
+		descidx_if_iter(idx, *n, iif);
+	} else {
+		iif->valid = 0;
+	}
+}
+
 static void _classdriver_process_device(usbh_device_t *dev) {
 	udevinfo("New device found.");
 	const usbh_device_descriptor_t *const devdesc = &dev->devDesc;
@@ -1313,6 +1506,9 @@ static void _classdriver_process_device(usbh_device_t *dev) {
 	usbhDevicePrintConfiguration(dev, dev->fullConfigurationDescriptor,
 			dev->basicConfigDesc.wTotalLength);
 
+	if_iterator_t iif;
+	uint8_t n;
+
 #if HAL_USBH_USE_IAD
 	if (dev->devDesc.bDeviceClass == 0xef
 			&& dev->devDesc.bDeviceSubClass == 0x02
@@ -1320,18 +1516,14 @@ static void _classdriver_process_device(usbh_device_t *dev) {
 
 		udevinfo("Load a driver for each IF collection.");
 
-		generic_iterator_t icfg;
-		if_iterator_t iif;
 		const usbh_ia_descriptor_t *last_iad = 0;
 
-		cfg_iter_init(&icfg, dev->fullConfigurationDescriptor,
-				dev->basicConfigDesc.wTotalLength);
-		if (!icfg.valid) {
+		if (_cfg_if_iter_init(dev, &iif, &n) != HAL_SUCCESS) {
 			udeverr("Invalid configuration descriptor.");
 			goto exit;
 		}
 
-		for (if_iter_init(&iif, &icfg); iif.valid; if_iter_next(&iif)) {
+		for (; iif.valid; _cfg_if_iter_next(dev, &iif, &n)) {
 			if (iif.iad && (iif.iad != last_iad)) {
 				last_iad = iif.iad;
 				if (_classdriver_load(dev,
@@ -1353,18 +1545,14 @@ static void _classdriver_process_device(usbh_device_t *dev) {
 			/* each interface defines its own device class/subclass/protocol */
 			udevinfo("Try load a driver for each IF.");
 
-			generic_iterator_t icfg;
-			if_iterator_t iif;
 			uint8_t last_if = 0xff;
 
-			cfg_iter_init(&icfg, dev->fullConfigurationDescriptor,
-					dev->basicConfigDesc.wTotalLength);
-			if (!icfg.valid) {
+			if (_cfg_if_iter_init(dev, &iif, &n) != HAL_SUCCESS) {
 				udeverr("Invalid configuration descriptor.");
 				goto exit;
 			}
 
-			for (if_iter_init(&iif, &icfg); iif.valid; if_iter_next(&iif)) {
+			for (; iif.valid; _cfg_if_iter_next(dev, &iif, &n)) {
 				const usbh_interface_descriptor_t *const ifdesc = if_get(&iif);
 				if (ifdesc->bInterfaceNumber != last_if) {
 					last_if = ifdesc->bInterfaceNumber;
@@ -1384,13 +1572,41 @@ exit:
 	}
 }
 
+/*===========================================================================*/
+/* Class driver registry.                                                    */
+/*===========================================================================*/
+
+/* Drivers registered at runtime are tried before the built-in ones, in
+ * reverse registration order. Devices already enumerated are not matched
+ * against a driver registered later. */
+void usbhClassDriverRegister(usbh_classdriverlink_t *link,
+		const usbh_classdriverinfo_t *info) {
+	osalDbgCheck((link != NULL) && (info != NULL) && (info->vmt != NULL));
+
+	if (info->vmt->init) {
+		info->vmt->init();
+	}
+
+	link->info = info;
+	osalSysLock();
+	link->next = usbh_classdrivers;
+	usbh_classdrivers = link;
+	osalSysUnlock();
+}
+
 void usbhInit(void) {
 	uint8_t i;
-	for (i = 0; i < sizeof_array(usbh_classdrivers_lookup); i++) {
-		if (usbh_classdrivers_lookup[i]->vmt->init) {
-			usbh_classdrivers_lookup[i]->vmt->init();
+	usbh_classdriverlink_t **tail = &usbh_classdrivers;
+	for (i = 0; i < sizeof_array(usbh_classdrivers_builtin); i++) {
+		const usbh_classdriverinfo_t *const info = usbh_classdrivers_builtin[i];
+		if (info->vmt->init) {
+			info->vmt->init();
 		}
+		usbh_classdrivers_links[i].info = info;
+		*tail = &usbh_classdrivers_links[i];
+		tail = &usbh_classdrivers_links[i].next;
 	}
+	*tail = NULL;
 	usbh_lld_init();
 }
 
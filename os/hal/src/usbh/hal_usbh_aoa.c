@@ -105,8 +105,16 @@ static const usbh_classdriver_vmt_t class_driver_vmt = {
 	_aoa_unload
 };
 
+/* Any device may be switched to accessory mode; once switched, only the
+ * accessory interface of a Google device is of interest */
+static const usbh_classdriver_match_t class_driver_match[] = {
+	USBH_MATCH_DEVICE(-1, -1, -1, -1, -1),
+	USBH_MATCH_VENDOR_INTERFACE(AOA_GOOGLE_VID, -1, 0xff, 0xff, 0x00),
+};
+
 const usbh_classdriverinfo_t usbhaoaClassDriverInfo = {
-	"AOA", &class_driver_vmt
+	"AOA", &class_driver_vmt,
+	class_driver_match, sizeof_array(class_driver_match)
 };
 
 #if defined(HAL_USBHAOA_FILTER_CALLBACK)
@@ -283,6 +291,183 @@ static void _aoa_unload(usbh_baseclassdriver_t *drv) {
 /*      Accessory data channel          */
 /* ------------------------------------ */
 
+#if HAL_USBHAOA_USE_RING
+
+/* Ring mode: each IN URB owns a packet buffer and stays queued on the
+ * endpoint; on completion the data is copied to the input buffers queue
+ * and the URB is resubmitted at once. With the queue full the URB is held,
+ * so that the device NAKs, until the reader releases a buffer. */
+
+static bool _post_inI(USBHAOAChannel *aoacp, usbh_urb_t *urb) {
+	uint8_t *buf = ibqGetEmptyBufferI(&aoacp->ibqueue);
+	if (buf == NULL)
+		return false;
+	memcpy(buf, urb->buff, urb->actualLength);
+	ibqPostFullBufferI(&aoacp->ibqueue, urb->actualLength);
+	chnAddFlagsI(aoacp, CHN_INPUT_AVAILABLE);
+	return true;
+}
+
+static void _in_cb(usbh_urb_t *urb) {
+	USBHAOAChannel *const aoacp = (USBHAOAChannel *)urb->userData;
+	switch (urb->status) {
+	case USBH_URBSTATUS_OK:
+		if (urb->actualLength == 0) {
+			uurbdbgf("AOA: URB IN no data");
+			break;
+		}
+		if ((aoacp->iq_held_count == 0) && _post_inI(aoacp, urb))
+			break;
+		uurbdbg("AOA: URB IN held, input queue full");
+		aoacp->iq_held[(aoacp->iq_held_head + aoacp->iq_held_count)
+				% HAL_USBHAOA_RING_URBS] = urb;
+		aoacp->iq_held_count++;
+		return;
+	case USBH_URBSTATUS_DISCONNECTED:
+		uurbwarn("AOA: URB IN disconnected");
+		if (aoacp->state == USBHAOA_CHANNEL_STATE_READY) {
+			ibqResetI(&aoacp->ibqueue);
+			obqResetI(&aoacp->obqueue);
+			chnAddFlagsI(aoacp, CHN_DISCONNECTED);
+			aoacp->state = USBHAOA_CHANNEL_STATE_ACTIVE;
+			container_of(aoacp, USBHAOADriver, channel)->state = USBHAOA_STATE_ACTIVE;
+		}
+		return;
+	default:
+		uurberrf("AOA: URB IN status unexpected = %d", urb->status);
+		break;
+	}
+	usbhURBObjectResetI(urb);
+	usbhURBSubmitI(urb);
+}
+
+static void _ibnotify(io_buffers_queue_t *bqp) {
+	USBHAOAChannel *const aoacp = bqGetLinkX(bqp);
+
+	if (aoacp->state != USBHAOA_CHANNEL_STATE_READY)
+		return;
+
+	while (aoacp->iq_held_count) {
+		usbh_urb_t *const urb = aoacp->iq_held[aoacp->iq_held_head];
+		if (!_post_inI(aoacp, urb))
+			return;
+		aoacp->iq_held_head = (aoacp->iq_held_head + 1) % HAL_USBHAOA_RING_URBS;
+		aoacp->iq_held_count--;
+		usbhURBObjectResetI(urb);
+		usbhURBSubmitI(urb);
+	}
+}
+
+/* The OUT URB sends the full buffers of the output queue in place, one
+ * after the other. */
+static bool _submitOutI(USBHAOAChannel *aoacp) {
+	size_t n;
+	uint8_t *buf = obqGetFullBufferI(&aoacp->obqueue, &n);
+	if (buf == NULL)
+		return false;
+	uclassdrvdbgf("AOA: Submit OUT %d", n);
+	usbhURBObjectResetI(&aoacp->oq_urb);
+	aoacp->oq_urb.buff = buf;
+	aoacp->oq_urb.requestedLength = n;
+	usbhURBSubmitI(&aoacp->oq_urb);
+	return true;
+}
+
+static void _out_cb(usbh_urb_t *urb) {
+	USBHAOAChannel *const aoacp = (USBHAOAChannel *)urb->userData;
+	switch (urb->status) {
+	case USBH_URBSTATUS_OK:
+		obqReleaseEmptyBufferI(&aoacp->obqueue);
+		/* the flush timer can't post a partial buffer while a full one is
+		 * in flight; post it now if the timer already expired */
+		if (obqIsEmptyI(&aoacp->obqueue) && !chVTIsArmedI(&aoacp->vt))
+			obqTryFlushI(&aoacp->obqueue);
+		if (_submitOutI(aoacp))
+			chnAddFlagsI(aoacp, CHN_OUTPUT_EMPTY);
+		else
+			chnAddFlagsI(aoacp, CHN_OUTPUT_EMPTY | CHN_TRANSMISSION_END);
+		return;
+	case USBH_URBSTATUS_DISCONNECTED:
+		uclassdrvwarn("AOA: URB OUT disconnected");
+		chnAddFlagsI(aoacp, CHN_OUTPUT_EMPTY);
+		return;
+	default:
+		uclassdrverrf("AOA: URB OUT status unexpected = %d", urb->status);
+		break;
+	}
+	usbhURBObjectResetI(&aoacp->oq_urb);
+	usbhURBSubmitI(&aoacp->oq_urb);
+}
+
+static void _obnotify(io_buffers_queue_t *bqp) {
+	USBHAOAChannel *const aoacp = bqGetLinkX(bqp);
+
+	if ((aoacp->state == USBHAOA_CHANNEL_STATE_READY)
+			&& !usbhURBIsBusy(&aoacp->oq_urb))
+		_submitOutI(aoacp);
+}
+
+/* OUT coalescing: small writes accumulate in the current buffer, which is
+ * sent when full or by this timer, armed by the writes. */
+static void _vt(void *p) {
+	USBHAOAChannel *const aoacp = (USBHAOAChannel *)p;
+	osalSysLockFromISR();
+	if ((aoacp->state == USBHAOA_CHANNEL_STATE_READY)
+			&& obqTryFlushI(&aoacp->obqueue)
+			&& !usbhURBIsBusy(&aoacp->oq_urb)) {
+		_submitOutI(aoacp);
+	}
+	osalSysUnlockFromISR();
+}
+
+static void _arm_flush(USBHAOAChannel *aoacp) {
+	osalSysLock();
+	if (!chVTIsArmedI(&aoacp->vt))
+		chVTSetI(&aoacp->vt, OSAL_MS2I(HAL_USBHAOA_RING_FLUSH_MS), _vt, aoacp);
+	osalSysUnlock();
+}
+
+static size_t _write_timeout(USBHAOAChannel *aoacp, const uint8_t *bp,
+		size_t n, systime_t timeout) {
+	size_t w;
+
+	chDbgCheck(n > 0U);
+
+	if (aoacp->state != USBHAOA_CHANNEL_STATE_READY)
+		return 0;
+	w = obqWriteTimeout(&aoacp->obqueue, bp, n, timeout);
+	_arm_flush(aoacp);
+	return w;
+}
+
+static msg_t _put_timeout(USBHAOAChannel *aoacp, uint8_t b, systime_t timeout) {
+	msg_t msg;
+
+	if (aoacp->state != USBHAOA_CHANNEL_STATE_READY)
+		return Q_RESET;
+	msg = obqPutTimeout(&aoacp->obqueue, b, timeout);
+	if (msg == Q_OK)
+		_arm_flush(aoacp);
+	return msg;
+}
+
+static size_t _read_timeout(USBHAOAChannel *aoacp, uint8_t *bp,
+		size_t n, systime_t timeout) {
+	chDbgCheck(n > 0U);
+
+	if (aoacp->state != USBHAOA_CHANNEL_STATE_READY)
+		return 0;
+	return ibqReadTimeout(&aoacp->ibqueue, bp, n, timeout);
+}
+
+static msg_t _get_timeout(USBHAOAChannel *aoacp, systime_t timeout) {
+	if (aoacp->state != USBHAOA_CHANNEL_STATE_READY)
+		return Q_RESET;
+	return ibqGetTimeout(&aoacp->ibqueue, timeout);
+}
+
+#else
+
 static void _submitOutI(USBHAOAChannel *aoacp, uint32_t len) {
 	uclassdrvdbgf("AOA: Submit OUT %d", len);
 	aoacp->oq_urb.requestedLength = len;
@@ -370,14 +555,6 @@ static msg_t _put_timeout(USBHAOAChannel *aoacp, uint8_t b, systime_t timeout) {
 	return Q_OK;
 }
 
-static size_t _write(USBHAOAChannel *aoacp, const uint8_t *bp, size_t n) {
-	return _write_timeout(aoacp, bp, n, TIME_INFINITE);
-}
-
-static msg_t _put(USBHAOAChannel *aoacp, uint8_t b) {
-	return _put_timeout(aoacp, b, TIME_INFINITE);
-}
-
 static void _submitInI(USBHAOAChannel *aoacp) {
 	uclassdrvdbg("AOA: Submit IN");
 	usbhURBObjectResetI(&aoacp->iq_urb);
@@ -474,6 +651,16 @@ static msg_t _get_timeout(USBHAOAChannel *aoacp, systime_t timeout) {
 	return (msg_t)b;
 }
 
+#endif
+
+static size_t _write(USBHAOAChannel *aoacp, const uint8_t *bp, size_t n) {
+	return _write_timeout(aoacp, bp, n, TIME_INFINITE);
+}
+
+static msg_t _put(USBHAOAChannel *aoacp, uint8_t b) {
+	return _put_timeout(aoacp, b, TIME_INFINITE);
+}
+
 static msg_t _get(USBHAOAChannel *aoacp) {
 	return _get_timeout(aoacp, TIME_INFINITE);
 }
@@ -509,13 +696,19 @@ static void _stop_channelS(USBHAOAChannel *aoacp) {
 	chVTResetI(&aoacp->vt);
 	usbhEPCloseS(&aoacp->epin);
 	usbhEPCloseS(&aoacp->epout);
+#if HAL_USBHAOA_USE_RING
+	ibqResetI(&aoacp->ibqueue);
+	obqResetI(&aoacp->obqueue);
+#else
 	chThdDequeueAllI(&aoacp->iq_waiting, Q_RESET);
 	chThdDequeueAllI(&aoacp->oq_waiting, Q_RESET);
+#endif
 	chnAddFlagsI(aoacp, CHN_DISCONNECTED);
 	aoacp->state = USBHAOA_CHANNEL_STATE_ACTIVE;
 	osalOsRescheduleS();
 }
 
+#if !HAL_USBHAOA_USE_RING
 static void _vt(void *p) {
 	USBHAOAChannel *const aoacp = (USBHAOAChannel *)p;
 	osalSysLockFromISR();
@@ -531,6 +724,7 @@ static void _vt(void *p) {
 	}
 	osalSysUnlockFromISR();
 }
+#endif
 
 void usbhaoaChannelStart(USBHAOADriver *aoap) {
 
@@ -546,6 +740,26 @@ void usbhaoaChannelStart(USBHAOADriver *aoap) {
 	if (aoacp->state == USBHAOA_CHANNEL_STATE_READY)
 		return;
 
+#if HAL_USBHAOA_USE_RING
+	uint8_t i;
+
+	usbhURBObjectInit(&aoacp->oq_urb, &aoacp->epout, _out_cb, aoacp, aoacp->ob, 0);
+	obqObjectInit(&aoacp->obqueue, false, aoacp->ob,
+			64, HAL_USBHAOA_RING_BUFFERS, _obnotify, aoacp);
+	usbhEPOpen(&aoacp->epout);
+
+	ibqObjectInit(&aoacp->ibqueue, false, aoacp->ib,
+			64, HAL_USBHAOA_RING_BUFFERS, _ibnotify, aoacp);
+	aoacp->iq_held_head = 0;
+	aoacp->iq_held_count = 0;
+	usbhEPOpen(&aoacp->epin);
+	for (i = 0; i < HAL_USBHAOA_RING_URBS; i++) {
+		usbhURBObjectInit(&aoacp->iq_urbs[i], &aoacp->epin, _in_cb, aoacp, aoacp->iq_buffs[i], 64);
+		usbhURBSubmit(&aoacp->iq_urbs[i]);
+	}
+
+	chVTObjectInit(&aoacp->vt);
+#else
 	usbhURBObjectInit(&aoacp->oq_urb, &aoacp->epout, _out_cb, aoacp, aoacp->oq_buff, 0);
 	chThdQueueObjectInit(&aoacp->oq_waiting);
 	aoacp->oq_counter = 64;
@@ -561,6 +775,7 @@ void usbhaoaChannelStart(USBHAOADriver *aoap) {
 
 	chVTObjectInit(&aoacp->vt);
 	chVTSet(&aoacp->vt, OSAL_MS2I(16), _vt, aoacp);
+#endif
 
 	aoacp->state = USBHAOA_CHANNEL_STATE_READY;
 
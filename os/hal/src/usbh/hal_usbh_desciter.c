@@ -21,6 +21,7 @@
 
 #include "usbh/defs.h"
 #include "usbh/desciter.h"
+#include <string.h>
 
 void cfg_iter_init(generic_iterator_t *icfg, const uint8_t *buff, uint16_t rem) {
 	icfg->valid = 0;
@@ -158,4 +159,130 @@ void cs_iter_init(generic_iterator_t *ics, const generic_iterator_t *iter) {
 	cs_iter_next(ics);
 }
 
+/* Builds the index in storage; returns the storage size the index needs, or
+ * 0 if the descriptor is invalid. If size is too small nothing is built, so
+ * the function can be called with a NULL storage to query the size first. */
+size_t descidx_init(descidx_t *idx, const uint8_t *buff, uint16_t rem,
+		void *storage, size_t size) {
+	generic_iterator_t icfg;
+	const usbh_ia_descriptor_t *iad;
+	const uint8_t *curr;
+	uint16_t if_count, ep_count, ifnum_count;
+	bool in_if, fill;
+	size_t need = 0;
+	uint16_t i;
+
+	memset(idx, 0, sizeof(*idx));
+
+	cfg_iter_init(&icfg, buff, rem);
+	if (!icfg.valid || (icfg.rem < icfg.curr[0]))
+		return 0;
+
+	for (fill = false;; fill = true) {
+		iad = NULL;
+		in_if = false;
+		if_count = ep_count = ifnum_count = 0;
+		curr = icfg.curr;
+		rem = icfg.rem;
+
+		for (;;) {
+			rem -= curr[0];
+			curr += curr[0];
+
+			if ((rem < 2) || (curr[0] < 2) || (rem < curr[0]))
+				break;
+
+			if (curr[1] == USBH_DT_INTERFACE_ASSOCIATION) {
+				if (curr[0] < USBH_DT_INTERFACE_ASSOCIATION_SIZE)
+					break;
+				iad = (const usbh_ia_descriptor_t *)curr;
+				in_if = false;
+
+			} else if (curr[1] == USBH_DT_INTERFACE) {
+				if (curr[0] < USBH_DT_INTERFACE_SIZE)
+					break;
+				if (if_count >= DESCIDX_NONE)
+					return 0;
+
+				if (iad) {
+					if ((curr[2] < iad->bFirstInterface)
+						|| (curr[2] >= (iad->bFirstInterface + iad->bInterfaceCount)))
+						iad = NULL;
+				}
+
+				if (fill) {
+					descidx_if_t *const e = &idx->ifs[if_count];
+					e->offset = (uint16_t)(curr - buff);
+					e->iad = iad ? (uint16_t)((const uint8_t *)iad - buff) : 0;
+					e->ep_first = (uint8_t)ep_count;
+					e->ep_count = 0;
+					e->next_alt = DESCIDX_NONE;
+
+					/* append to the alternate settings of this interface */
+					uint8_t *link = &idx->ifnum_first[curr[2]];
+					while (*link != DESCIDX_NONE)
+						link = &idx->ifs[*link].next_alt;
+					*link = (uint8_t)if_count;
+				}
+
+				if (curr[2] >= ifnum_count)
+					ifnum_count = curr[2] + 1;
+				if_count++;
+				in_if = true;
+
+			} else if (curr[1] == USBH_DT_ENDPOINT) {
+				/* same as ep_iter_next: a short endpoint ends the list */
+				if (!in_if || (curr[0] < USBH_DT_ENDPOINT_SIZE)) {
+					in_if = false;
+					continue;
+				}
+				if (ep_count >= 0xff)
+					return 0;
+
+				if (fill) {
+					idx->eps[ep_count] = (uint16_t)(curr - buff);
+					idx->ifs[if_count - 1].ep_count++;
+				}
+				ep_count++;
+
+			} else if (curr[1] == USBH_DT_CONFIG) {
+				in_if = false;
+			}
+		}
+
+		if (fill)
+			break;
+
+		if (if_count == 0)
+			return 0;
+
+		need = if_count * sizeof(descidx_if_t)
+				+ ep_count * sizeof(uint16_t)
+				+ ifnum_count;
+
+		if ((storage == NULL) || (size < need))
+			return need;
+
+		idx->ifs = (descidx_if_t *)storage;
+		idx->eps = (uint16_t *)(idx->ifs + if_count);
+		idx->ifnum_first = (uint8_t *)(idx->eps + ep_count);
+		for (i = 0; i < ifnum_count; i++)
+			idx->ifnum_first[i] = DESCIDX_NONE;
+	}
+
+	idx->cfg = buff;
+	idx->total = icfg.rem;
+	idx->if_count = (uint8_t)if_count;
+	idx->ifnum_count = ifnum_count;
+	idx->ep_count = (uint8_t)ep_count;
+	return need;
+}
+
+void descidx_if_iter(const descidx_t *idx, uint8_t n, if_iterator_t *iif) {
+	iif->iad = descidx_iad_get(idx, n);
+	iif->curr = idx->cfg + idx->ifs[n].offset;
+	iif->rem = idx->total - idx->ifs[n].offset;
+	iif->valid = 1;
+}
+
 #endif
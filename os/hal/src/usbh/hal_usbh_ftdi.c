@@ -52,8 +52,18 @@ static const usbh_classdriver_vmt_t class_driver_vmt = {
 	_ftdi_unload
 };
 
+static const usbh_classdriver_match_t class_driver_match[] = {
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0x6001, 0xff, 0xff, 0xff),
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0x6010, 0xff, 0xff, 0xff),
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0x6011, 0xff, 0xff, 0xff),
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0x6014, 0xff, 0xff, 0xff),
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0x6015, 0xff, 0xff, 0xff),
+	USBH_MATCH_VENDOR_INTERFACE(0x0403, 0xE2E6, 0xff, 0xff, 0xff),
+};
+
 const usbh_classdriverinfo_t usbhftdiClassDriverInfo = {
-	"FTDI", &class_driver_vmt
+	"FTDI", &class_driver_vmt,
+	class_driver_match, sizeof_array(class_driver_match)
 };
 
 static USBHFTDIPortDriver *_find_port(void) {
@@ -69,25 +79,7 @@ static usbh_baseclassdriver_t *_ftdi_load(usbh_device_t *dev, const uint8_t *des
 	int i;
 	USBHFTDIDriver *ftdip;
 
-	if (_usbh_match_vid_pid(dev, 0x0403, -1) != HAL_SUCCESS)
-		return NULL;
-
-	switch (dev->devDesc.idProduct) {
-	case 0x6001:
-	case 0x6010:
-	case 0x6011:
-	case 0x6014:
-	case 0x6015:
-	case 0xE2E6:
-		break;
-	default:
-		udeverr("FTDI: Unrecognized PID");
-		return NULL;
-	}
-
-	if (_usbh_match_descriptor(descriptor, rem, USBH_DT_INTERFACE,
-			0xff, 0xff, 0xff) != HAL_SUCCESS)
-		return NULL;
+	(void)rem;
 
 	if (((const usbh_interface_descriptor_t *)descriptor)->bInterfaceNumber != 0) {
 		udevwarn("FTDI: Will allocate driver along with IF #0");
@@ -376,6 +368,174 @@ static usbh_urbstatus_t _set_baudrate(USBHFTDIPortDriver *ftdipp, uint32_t baudr
 }
 
 
+#if HAL_USBHFTDI_USE_RING
+
+/* Ring mode: each IN URB owns a packet buffer and stays queued on the
+ * endpoint; on completion the payload is copied to the input buffers queue
+ * and the URB is resubmitted at once. With the queue full the URB is held,
+ * so that the device NAKs, until the reader releases a buffer. */
+
+static bool _post_inI(USBHFTDIPortDriver *ftdipp, usbh_urb_t *urb) {
+	uint8_t *buf = ibqGetEmptyBufferI(&ftdipp->ibqueue);
+	if (buf == NULL)
+		return false;
+	memcpy(buf, (const uint8_t *)urb->buff + 2, urb->actualLength - 2);
+	ibqPostFullBufferI(&ftdipp->ibqueue, urb->actualLength - 2);
+	return true;
+}
+
+static void _in_cb(usbh_urb_t *urb) {
+	USBHFTDIPortDriver *const ftdipp = (USBHFTDIPortDriver *)urb->userData;
+	switch (urb->status) {
+	case USBH_URBSTATUS_OK:
+		if (urb->actualLength < 2) {
+			uurbwarnf("FTDI: URB IN actualLength = %d, < 2", urb->actualLength);
+			break;
+		}
+		if (((uint8_t *)urb->buff)[1] & FTDI_RS_OE)
+			ftdipp->overruns++;
+		if (urb->actualLength == 2)
+			break;
+		if ((ftdipp->iq_held_count == 0) && _post_inI(ftdipp, urb))
+			break;
+		uurbdbg("FTDI: URB IN held, input queue full");
+		ftdipp->iq_held[(ftdipp->iq_held_head + ftdipp->iq_held_count)
+				% HAL_USBHFTDI_RING_URBS] = urb;
+		ftdipp->iq_held_count++;
+		return;
+	case USBH_URBSTATUS_DISCONNECTED:
+		uurbwarn("FTDI: URB IN disconnected");
+		return;
+	default:
+		uurberrf("FTDI: URB IN status unexpected = %d", urb->status);
+		break;
+	}
+	usbhURBObjectResetI(urb);
+	usbhURBSubmitI(urb);
+}
+
+static void _ibnotify(io_buffers_queue_t *bqp) {
+	USBHFTDIPortDriver *const ftdipp = bqGetLinkX(bqp);
+
+	if (ftdipp->state != USBHFTDIP_STATE_READY)
+		return;
+
+	while (ftdipp->iq_held_count) {
+		usbh_urb_t *const urb = ftdipp->iq_held[ftdipp->iq_held_head];
+		if (!_post_inI(ftdipp, urb))
+			return;
+		ftdipp->iq_held_head = (ftdipp->iq_held_head + 1) % HAL_USBHFTDI_RING_URBS;
+		ftdipp->iq_held_count--;
+		usbhURBObjectResetI(urb);
+		usbhURBSubmitI(urb);
+	}
+}
+
+/* The OUT URB sends the full buffers of the output queue in place, one
+ * after the other. */
+static void _submitOutI(USBHFTDIPortDriver *ftdipp) {
+	size_t n;
+	uint8_t *buf = obqGetFullBufferI(&ftdipp->obqueue, &n);
+	if (buf == NULL)
+		return;
+	uclassdrvdbgf("FTDI: Submit OUT %d", n);
+	usbhURBObjectResetI(&ftdipp->oq_urb);
+	ftdipp->oq_urb.buff = buf;
+	ftdipp->oq_urb.requestedLength = n;
+	usbhURBSubmitI(&ftdipp->oq_urb);
+}
+
+static void _out_cb(usbh_urb_t *urb) {
+	USBHFTDIPortDriver *const ftdipp = (USBHFTDIPortDriver *)urb->userData;
+	switch (urb->status) {
+	case USBH_URBSTATUS_OK:
+		obqReleaseEmptyBufferI(&ftdipp->obqueue);
+		/* the flush timer can't post a partial buffer while a full one is
+		 * in flight; post it now if the timer already expired */
+		if (obqIsEmptyI(&ftdipp->obqueue) && !chVTIsArmedI(&ftdipp->vt))
+			obqTryFlushI(&ftdipp->obqueue);
+		_submitOutI(ftdipp);
+		return;
+	case USBH_URBSTATUS_DISCONNECTED:
+		uurbwarn("FTDI: URB OUT disconnected");
+		return;
+	default:
+		uurberrf("FTDI: URB OUT status unexpected = %d", urb->status);
+		break;
+	}
+	usbhURBObjectResetI(&ftdipp->oq_urb);
+	usbhURBSubmitI(&ftdipp->oq_urb);
+}
+
+static void _obnotify(io_buffers_queue_t *bqp) {
+	USBHFTDIPortDriver *const ftdipp = bqGetLinkX(bqp);
+
+	if ((ftdipp->state == USBHFTDIP_STATE_READY)
+			&& !usbhURBIsBusy(&ftdipp->oq_urb))
+		_submitOutI(ftdipp);
+}
+
+/* OUT coalescing: small writes accumulate in the current buffer, which is
+ * sent when full or by this timer, armed by the writes. */
+static void _vt(void *p) {
+	USBHFTDIPortDriver *const ftdipp = (USBHFTDIPortDriver *)p;
+	osalSysLockFromISR();
+	if ((ftdipp->state == USBHFTDIP_STATE_READY)
+			&& obqTryFlushI(&ftdipp->obqueue)
+			&& !usbhURBIsBusy(&ftdipp->oq_urb)) {
+		_submitOutI(ftdipp);
+	}
+	osalSysUnlockFromISR();
+}
+
+static void _arm_flush(USBHFTDIPortDriver *ftdipp) {
+	osalSysLock();
+	if (!chVTIsArmedI(&ftdipp->vt))
+		chVTSetI(&ftdipp->vt, OSAL_MS2I(HAL_USBHFTDI_RING_FLUSH_MS), _vt, ftdipp);
+	osalSysUnlock();
+}
+
+static size_t _write_timeout(USBHFTDIPortDriver *ftdipp, const uint8_t *bp,
+		size_t n, systime_t timeout) {
+	size_t w;
+
+	chDbgCheck(n > 0U);
+
+	if (ftdipp->state != USBHFTDIP_STATE_READY)
+		return 0;
+	w = obqWriteTimeout(&ftdipp->obqueue, bp, n, timeout);
+	_arm_flush(ftdipp);
+	return w;
+}
+
+static msg_t _put_timeout(USBHFTDIPortDriver *ftdipp, uint8_t b, systime_t timeout) {
+	msg_t msg;
+
+	if (ftdipp->state != USBHFTDIP_STATE_READY)
+		return Q_RESET;
+	msg = obqPutTimeout(&ftdipp->obqueue, b, timeout);
+	if (msg == Q_OK)
+		_arm_flush(ftdipp);
+	return msg;
+}
+
+static size_t _read_timeout(USBHFTDIPortDriver *ftdipp, uint8_t *bp,
+		size_t n, systime_t timeout) {
+	chDbgCheck(n > 0U);
+
+	if (ftdipp->state != USBHFTDIP_STATE_READY)
+		return 0;
+	return ibqReadTimeout(&ftdipp->ibqueue, bp, n, timeout);
+}
+
+static msg_t _get_timeout(USBHFTDIPortDriver *ftdipp, systime_t timeout) {
+	if (ftdipp->state != USBHFTDIP_STATE_READY)
+		return Q_RESET;
+	return ibqGetTimeout(&ftdipp->ibqueue, timeout);
+}
+
+#else
+
 static void _submitOutI(USBHFTDIPortDriver *ftdipp, uint32_t len) {
 	uclassdrvdbgf("FTDI: Submit OUT %d", len);
 	ftdipp->oq_urb.requestedLength = len;
@@ -461,14 +621,6 @@ static msg_t _put_timeout(USBHFTDIPortDriver *ftdipp, uint8_t b, systime_t timeo
 	return Q_OK;
 }
 
-static size_t _write(USBHFTDIPortDriver *ftdipp, const uint8_t *bp, size_t n) {
-	return _write_timeout(ftdipp, bp, n, TIME_INFINITE);
-}
-
-static msg_t _put(USBHFTDIPortDriver *ftdipp, uint8_t b) {
-	return _put_timeout(ftdipp, b, TIME_INFINITE);
-}
-
 static void _submitInI(USBHFTDIPortDriver *ftdipp) {
 	uclassdrvdbg("FTDI: Submit IN");
 	usbhURBObjectResetI(&ftdipp->iq_urb);
@@ -481,7 +633,11 @@ static void _in_cb(usbh_urb_t *urb) {
 	case USBH_URBSTATUS_OK:
 		if (urb->actualLength < 2) {
 			uurbwarnf("FTDI: URB IN actualLength = %d, < 2", urb->actualLength);
-		} else if (urb->actualLength > 2) {
+			break;
+		}
+		if (((uint8_t *)urb->buff)[1] & FTDI_RS_OE)
+			ftdipp->overruns++;
+		if (urb->actualLength > 2) {
 			uurbdbgf("FTDI: URB IN data len=%d, status=%02x %02x",
 					urb->actualLength - 2,
 					((uint8_t *)urb->buff)[0],
@@ -570,6 +726,30 @@ static msg_t _get_timeout(USBHFTDIPortDriver *ftdipp, systime_t timeout) {
 	return (msg_t)b;
 }
 
+static void _vt(void *p) {
+	USBHFTDIPortDriver *const ftdipp = (USBHFTDIPortDriver *)p;
+	osalSysLockFromISR();
+	uint32_t len = ftdipp->oq_ptr - ftdipp->oq_buff;
+	if (len && !usbhURBIsBusy(&ftdipp->oq_urb)) {
+		_submitOutI(ftdipp, len);
+	}
+	if ((ftdipp->iq_counter == 0) && !usbhURBIsBusy(&ftdipp->iq_urb)) {
+		_submitInI(ftdipp);
+	}
+	chVTSetI(&ftdipp->vt, OSAL_MS2I(16), _vt, ftdipp);
+	osalSysUnlockFromISR();
+}
+
+#endif
+
+static size_t _write(USBHFTDIPortDriver *ftdipp, const uint8_t *bp, size_t n) {
+	return _write_timeout(ftdipp, bp, n, TIME_INFINITE);
+}
+
+static msg_t _put(USBHFTDIPortDriver *ftdipp, uint8_t b) {
+	return _put_timeout(ftdipp, b, TIME_INFINITE);
+}
+
 static msg_t _get(USBHFTDIPortDriver *ftdipp) {
 	return _get_timeout(ftdipp, TIME_INFINITE);
 }
@@ -585,20 +765,6 @@ static msg_t _ctl(USBHFTDIPortDriver *ftdipp, unsigned int operation, void *arg)
 	return MSG_OK;
 }
 
-static void _vt(void *p) {
-	USBHFTDIPortDriver *const ftdipp = (USBHFTDIPortDriver *)p;
-	osalSysLockFromISR();
-	uint32_t len = ftdipp->oq_ptr - ftdipp->oq_buff;
-	if (len && !usbhURBIsBusy(&ftdipp->oq_urb)) {
-		_submitOutI(ftdipp, len);
-	}
-	if ((ftdipp->iq_counter == 0) && !usbhURBIsBusy(&ftdipp->iq_urb)) {
-		_submitInI(ftdipp);
-	}
-	chVTSetI(&ftdipp->vt, OSAL_MS2I(16), _vt, ftdipp);
-	osalSysUnlockFromISR();
-}
-
 static const struct FTDIPortDriverVMT async_channel_vmt = {
 	(size_t)0,
 	(size_t (*)(void *, const uint8_t *, size_t))_write,
@@ -619,8 +785,13 @@ static void _stopS(USBHFTDIPortDriver *ftdipp) {
 	chVTResetI(&ftdipp->vt);
 	usbhEPCloseS(&ftdipp->epin);
 	usbhEPCloseS(&ftdipp->epout);
+#if HAL_USBHFTDI_USE_RING
+	ibqResetI(&ftdipp->ibqueue);
+	obqResetI(&ftdipp->obqueue);
+#else
 	chThdDequeueAllI(&ftdipp->iq_waiting, Q_RESET);
 	chThdDequeueAllI(&ftdipp->oq_waiting, Q_RESET);
+#endif
 	ftdipp->state = USBHFTDIP_STATE_ACTIVE;
 	osalOsRescheduleS();
 }
@@ -656,6 +827,9 @@ void usbhftdipStart(USBHFTDIPortDriver *ftdipp, const USBHFTDIPortConfig *config
 		config = &default_config;
 
 	uint16_t wValue = 0;
+#if HAL_USBHFTDI_USE_RING
+	uint8_t i;
+#endif
 	_ftdi_port_control(ftdipp, FTDI_COMMAND_RESET, FTDI_RESET_ALL, 0, 0, NULL);
 	_set_baudrate(ftdipp, config->speed);
 	_ftdi_port_control(ftdipp, FTDI_COMMAND_SETDATA, config->framing, 0, 0, NULL);
@@ -663,6 +837,25 @@ void usbhftdipStart(USBHFTDIPortDriver *ftdipp, const USBHFTDIPortConfig *config
 		wValue = (config->xoff_character << 8) | config->xon_character;
 	_ftdi_port_control(ftdipp, FTDI_COMMAND_SETFLOW, wValue, config->handshake, 0, NULL);
 
+	ftdipp->overruns = 0;
+#if HAL_USBHFTDI_USE_RING
+	usbhURBObjectInit(&ftdipp->oq_urb, &ftdipp->epout, _out_cb, ftdipp, ftdipp->ob, 0);
+	obqObjectInit(&ftdipp->obqueue, false, ftdipp->ob,
+			64, HAL_USBHFTDI_RING_BUFFERS, _obnotify, ftdipp);
+	usbhEPOpen(&ftdipp->epout);
+
+	ibqObjectInit(&ftdipp->ibqueue, false, ftdipp->ib,
+			64, HAL_USBHFTDI_RING_BUFFERS, _ibnotify, ftdipp);
+	ftdipp->iq_held_head = 0;
+	ftdipp->iq_held_count = 0;
+	usbhEPOpen(&ftdipp->epin);
+	for (i = 0; i < HAL_USBHFTDI_RING_URBS; i++) {
+		usbhURBObjectInit(&ftdipp->iq_urbs[i], &ftdipp->epin, _in_cb, ftdipp, ftdipp->iq_buffs[i], 64);
+		usbhURBSubmit(&ftdipp->iq_urbs[i]);
+	}
+
+	chVTObjectInit(&ftdipp->vt);
+#else
 	usbhURBObjectInit(&ftdipp->oq_urb, &ftdipp->epout, _out_cb, ftdipp, ftdipp->oq_buff, 0);
 	chThdQueueObjectInit(&ftdipp->oq_waiting);
 	ftdipp->oq_counter = 64;
@@ -678,6 +871,7 @@ void usbhftdipStart(USBHFTDIPortDriver *ftdipp, const USBHFTDIPortConfig *config
 
 	chVTObjectInit(&ftdipp->vt);
 	chVTSet(&ftdipp->vt, OSAL_MS2I(16), _vt, ftdipp);
+#endif
 
 	ftdipp->state = USBHFTDIP_STATE_READY;
 	osalMutexUnlock(&ftdipp->ftdip->mtx);
@@ -58,18 +58,342 @@ static const usbh_classdriver_vmt_t class_driver_vmt = {
 	_hid_unload
 };
 
+static const usbh_classdriver_match_t class_driver_match[] = {
+	USBH_MATCH_INTERFACE(0x03, -1, -1),
+};
+
 const usbh_classdriverinfo_t usbhhidClassDriverInfo = {
-	"HID", &class_driver_vmt
+	"HID", &class_driver_vmt,
+	class_driver_match, sizeof_array(class_driver_match)
 };
 
+#if HAL_USBHHID_USE_PARSER
+/*===========================================================================*/
+/* Report descriptor parser.                                                 */
+/*===========================================================================*/
+
+#define USBH_HID_DT_HID				0x21
+#define USBH_HID_DT_REPORT			0x22
+
+#define HID_ITEM_TYPE_MAIN			0
+#define HID_ITEM_TYPE_GLOBAL		1
+#define HID_ITEM_TYPE_LOCAL			2
+#define HID_ITEM_LONG				0xFE
+
+#define HID_MAIN_INPUT				0x8
+#define HID_MAIN_OUTPUT				0x9
+#define HID_MAIN_COLLECTION			0xA
+#define HID_MAIN_FEATURE			0xB
+#define HID_MAIN_END_COLLECTION		0xC
+
+#define HID_GLOBAL_USAGE_PAGE		0x0
+#define HID_GLOBAL_LOGICAL_MIN		0x1
+#define HID_GLOBAL_LOGICAL_MAX		0x2
+#define HID_GLOBAL_REPORT_SIZE		0x7
+#define HID_GLOBAL_REPORT_ID		0x8
+#define HID_GLOBAL_REPORT_COUNT		0x9
+#define HID_GLOBAL_PUSH				0xA
+#define HID_GLOBAL_POP				0xB
+
+#define HID_LOCAL_USAGE				0x0
+#define HID_LOCAL_USAGE_MIN			0x1
+#define HID_LOCAL_USAGE_MAX			0x2
+
+#define HID_INPUT_CONSTANT			0x01
+#define HID_INPUT_VARIABLE			0x02
+#define HID_INPUT_RELATIVE			0x04
+
+#define HID_PARSER_MAX_USAGES		16
+#define HID_PARSER_MAX_REPORTS		8
+#define HID_PARSER_STACK_DEPTH		2
+
+typedef struct {
+	uint16_t usage_page;
+	uint8_t report_size;
+	uint8_t report_id;
+	uint16_t report_count;
+	int32_t logical_min;
+	int32_t logical_max;
+} _hid_globals_t;
+
+typedef struct {
+	_hid_globals_t g;
+	_hid_globals_t stack[HID_PARSER_STACK_DEPTH];
+	uint8_t sp;
+
+	/* usages, with the page in the high half if given as extended usage */
+	uint32_t usages[HID_PARSER_MAX_USAGES];
+	uint8_t n_usages;
+	bool range;
+	uint32_t usage_min;
+	uint32_t usage_max;
+
+	/* input report sizes so far, in bits */
+	struct {
+		uint8_t id;
+		uint16_t bits;
+	} reports[HID_PARSER_MAX_REPORTS];
+	uint8_t n_reports;
+} _hid_parser_t;
+
+static uint16_t *_report_bits(_hid_parser_t *p, uint8_t id) {
+	uint8_t i;
+	for (i = 0; i < p->n_reports; i++) {
+		if (p->reports[i].id == id)
+			return &p->reports[i].bits;
+	}
+	if (p->n_reports == HID_PARSER_MAX_REPORTS)
+		return NULL;
+	p->reports[i].id = id;
+	p->reports[i].bits = 0;
+	p->n_reports++;
+	return &p->reports[i].bits;
+}
+
+static uint32_t _element_usage(const _hid_parser_t *p, uint16_t i, bool variable) {
+	uint32_t usage;
+
+	if (!variable)
+		i = 0;
+
+	if (p->range) {
+		usage = p->usage_min + i;
+		if (usage > p->usage_max)
+			usage = p->usage_max;
+	} else if (p->n_usages == 0) {
+		usage = 0;
+	} else if (i < p->n_usages) {
+		usage = p->usages[i];
+	} else {
+		usage = p->usages[p->n_usages - 1];
+	}
+
+	if ((usage >> 16) == 0)
+		usage |= (uint32_t)p->g.usage_page << 16;
+	return usage;
+}
+
+static bool _parse_input(USBHHIDDriver *hidp, _hid_parser_t *p, uint32_t flags) {
+	uint16_t *const bits = _report_bits(p, p->g.report_id);
+	uint16_t i;
+
+	if (bits == NULL)
+		return HAL_FAILED;
+
+	for (i = 0; i < p->g.report_count; i++) {
+		if (!(flags & HID_INPUT_CONSTANT)
+				&& (p->g.report_size > 0) && (p->g.report_size <= 32)
+				&& (hidp->field_count < HAL_USBHHID_MAX_FIELDS)) {
+			usbhhid_field_t *const f = &hidp->fields[hidp->field_count++];
+			const uint32_t usage = _element_usage(p, i, flags & HID_INPUT_VARIABLE);
+			f->usage_page = usage >> 16;
+			f->usage = (uint16_t)usage;
+			f->bit_offset = *bits;
+			f->bit_size = p->g.report_size;
+			f->report_id = p->g.report_id;
+			f->flags = 0;
+			if (!(flags & HID_INPUT_VARIABLE))
+				f->flags |= USBHHID_FIELD_ARRAY;
+			if (flags & HID_INPUT_RELATIVE)
+				f->flags |= USBHHID_FIELD_RELATIVE;
+			if (p->g.logical_min < 0)
+				f->flags |= USBHHID_FIELD_SIGNED;
+			f->logical_min = p->g.logical_min;
+			f->logical_max = p->g.logical_max;
+		}
+		*bits += p->g.report_size;
+	}
+	return HAL_SUCCESS;
+}
+
+static bool _parse_report_descriptor(USBHHIDDriver *hidp, const uint8_t *desc, uint16_t len) {
+	_hid_parser_t p;
+
+	memset(&p, 0, sizeof(p));
+	hidp->field_count = 0;
+	hidp->report_ids = false;
+
+	while (len) {
+		const uint8_t prefix = *desc;
+		uint8_t size = prefix & 3;
+		uint32_t udata = 0;
+		int32_t sdata = 0;
+
+		if (prefix == HID_ITEM_LONG) {
+			if ((len < 3) || (len < 3 + desc[1]))
+				return HAL_FAILED;
+			len -= 3 + desc[1];
+			desc += 3 + desc[1];
+			continue;
+		}
+
+		if (size == 3)
+			size = 4;
+		if (len < 1 + size)
+			return HAL_FAILED;
+
+		switch (size) {
+		case 1:
+			udata = desc[1];
+			sdata = (int8_t)desc[1];
+			break;
+		case 2:
+			udata = desc[1] | (desc[2] << 8);
+			sdata = (int16_t)udata;
+			break;
+		case 4:
+			udata = desc[1] | (desc[2] << 8) | (desc[3] << 16) | ((uint32_t)desc[4] << 24);
+			sdata = (int32_t)udata;
+			break;
+		}
+
+		switch ((prefix >> 2) & 3) {
+		case HID_ITEM_TYPE_MAIN:
+			switch (prefix >> 4) {
+			case HID_MAIN_INPUT:
+				if (_parse_input(hidp, &p, udata) != HAL_SUCCESS)
+					return HAL_FAILED;
+				break;
+			case HID_MAIN_OUTPUT:
+			case HID_MAIN_FEATURE:
+			case HID_MAIN_COLLECTION:
+			case HID_MAIN_END_COLLECTION:
+				break;
+			default:
+				return HAL_FAILED;
+			}
+			p.n_usages = 0;
+			p.range = false;
+			break;
+
+		case HID_ITEM_TYPE_GLOBAL:
+			switch (prefix >> 4) {
+			case HID_GLOBAL_USAGE_PAGE:
+				p.g.usage_page = udata;
+				break;
+			case HID_GLOBAL_LOGICAL_MIN:
+				p.g.logical_min = sdata;
+				break;
+			case HID_GLOBAL_LOGICAL_MAX:
+				p.g.logical_max = sdata;
+				/* a common mistake: 0..255 encoded as 0..-1 */
+				if ((p.g.logical_min >= 0) && (sdata < 0))
+					p.g.logical_max = udata;
+				break;
+			case HID_GLOBAL_REPORT_SIZE:
+				p.g.report_size = (udata > 255) ? 255 : udata;
+				break;
+			case HID_GLOBAL_REPORT_ID:
+				p.g.report_id = udata;
+				hidp->report_ids = true;
+				break;
+			case HID_GLOBAL_REPORT_COUNT:
+				p.g.report_count = udata;
+				break;
+			case HID_GLOBAL_PUSH:
+				if (p.sp == HID_PARSER_STACK_DEPTH)
+					return HAL_FAILED;
+				p.stack[p.sp++] = p.g;
+				break;
+			case HID_GLOBAL_POP:
+				if (p.sp == 0)
+					return HAL_FAILED;
+				p.g = p.stack[--p.sp];
+				break;
+			default:
+				break;
+			}
+			break;
+
+		case HID_ITEM_TYPE_LOCAL:
+			if (size < 4)
+				udata &= 0xFFFF;
+			switch (prefix >> 4) {
+			case HID_LOCAL_USAGE:
+				if (p.n_usages < HID_PARSER_MAX_USAGES)
+					p.usages[p.n_usages++] = udata;
+				break;
+			case HID_LOCAL_USAGE_MIN:
+				p.usage_min = udata;
+				p.range = true;
+				break;
+			case HID_LOCAL_USAGE_MAX:
+				p.usage_max = udata;
+				p.range = true;
+				break;
+			default:
+				break;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		len -= 1 + size;
+		desc += 1 + size;
+	}
+
+	return HAL_SUCCESS;
+}
+
+static void _load_report_descriptor(USBHHIDDriver *hidp, usbh_device_t *dev, if_iterator_t *iif) {
+	USBH_DEFINE_BUFFER(static uint8_t desc[HAL_USBHHID_MAX_REPORT_DESCRIPTOR]);
+	generic_iterator_t ics;
+	uint16_t len = 0;
+
+	hidp->field_count = 0;
+	hidp->report_ids = false;
+
+	for (cs_iter_init(&ics, (generic_iterator_t *)iif); ics.valid; cs_iter_next(&ics)) {
+		const uint8_t *const hiddesc = ics.curr;
+		uint8_t i;
+		if ((hiddesc[1] != USBH_HID_DT_HID) || (hiddesc[0] < 6))
+			continue;
+		for (i = 0; (i < hiddesc[5]) && (9 + 3 * i <= hiddesc[0]); i++) {
+			if (hiddesc[6 + 3 * i] == USBH_HID_DT_REPORT) {
+				len = hiddesc[7 + 3 * i] | (hiddesc[8 + 3 * i] << 8);
+				break;
+			}
+		}
+		break;
+	}
+
+	if (len == 0) {
+		udevwarn("HID: Report descriptor not found");
+		return;
+	}
+	if (len > HAL_USBHHID_MAX_REPORT_DESCRIPTOR) {
+		udevwarnf("HID: Report descriptor too long (%d bytes)", len);
+		return;
+	}
+
+	if (usbhControlRequest(dev,
+			USBH_REQTYPE_STANDARDIN(USBH_REQTYPE_RECIP_INTERFACE), USBH_REQ_GET_DESCRIPTOR,
+			USBH_HID_DT_REPORT << 8, hidp->ifnum, len, desc) != USBH_URBSTATUS_OK) {
+		udevwarn("HID: Can't read the report descriptor");
+		return;
+	}
+
+	if (_parse_report_descriptor(hidp, desc, len) != HAL_SUCCESS) {
+		udevwarn("HID: Invalid report descriptor");
+		hidp->field_count = 0;
+		hidp->report_ids = false;
+		return;
+	}
+
+	udevinfof("HID: %d input fields%s", hidp->field_count,
+			hidp->report_ids ? ", numbered reports" : "");
+	if (hidp->field_count == HAL_USBHHID_MAX_FIELDS) {
+		udevwarn("HID: Field table full, further fields are not decoded");
+	}
+}
+#endif
+
 static usbh_baseclassdriver_t *_hid_load(usbh_device_t *dev, const uint8_t *descriptor, uint16_t rem) {
 	int i;
 	USBHHIDDriver *hidp;
 
-	if (_usbh_match_descriptor(descriptor, rem, USBH_DT_INTERFACE,
-			0x03, -1, -1) != HAL_SUCCESS)
-		return NULL;
-
 	const usbh_interface_descriptor_t * const ifdesc = (const usbh_interface_descriptor_t *)descriptor;
 
 	if ((ifdesc->bAlternateSetting != 0)
@@ -147,6 +471,10 @@ alloc_ok:
 		goto deinit;
 	}
 
+#if HAL_USBHHID_USE_PARSER
+	_load_report_descriptor(hidp, dev, &iif);
+#endif
+
 	hidp->state = USBHHID_STATE_ACTIVE;
 
 	return (usbh_baseclassdriver_t *)hidp;
@@ -293,6 +621,61 @@ usbh_urbstatus_t usbhhidSetProtocol(USBHHIDDriver *hidp, uint8_t protocol) {
 			protocol, hidp->ifnum, 0, NULL);
 }
 
+#if HAL_USBHHID_USE_PARSER
+int usbhhidFindField(USBHHIDDriver *hidp, uint16_t usage_page, uint16_t usage) {
+	uint8_t i;
+	osalDbgCheck(hidp);
+	for (i = 0; i < hidp->field_count; i++) {
+		const usbhhid_field_t *const f = &hidp->fields[i];
+		if ((f->usage_page == usage_page) && (f->usage == usage))
+			return i;
+	}
+	return -1;
+}
+
+/* Decodes the fields of an input report; values[i] is written for each
+ * field i of the report, others are left untouched. The cost is bounded by
+ * the size of the field table. Returns the number of fields decoded. */
+uint8_t usbhhidDecodeReport(USBHHIDDriver *hidp, const uint8_t *report,
+		uint16_t len, int32_t *values) {
+	uint8_t report_id = 0;
+	uint8_t count = 0;
+	uint8_t i;
+
+	osalDbgCheck(hidp && report && values);
+
+	if (hidp->report_ids) {
+		if (len == 0)
+			return 0;
+		report_id = *report++;
+		len--;
+	}
+
+	for (i = 0; i < hidp->field_count; i++) {
+		const usbhhid_field_t *const f = &hidp->fields[i];
+		const uint16_t first = f->bit_offset >> 3;
+		const uint16_t last = (f->bit_offset + f->bit_size - 1) >> 3;
+		const uint32_t mask = (f->bit_size == 32) ? 0xFFFFFFFFU : ((1U << f->bit_size) - 1);
+		uint64_t raw = 0;
+		uint32_t v;
+		uint16_t b;
+
+		if ((f->report_id != report_id) || (last >= len))
+			continue;
+
+		for (b = last + 1; b > first; b--)
+			raw = (raw << 8) | report[b - 1];
+		v = (uint32_t)(raw >> (f->bit_offset & 7)) & mask;
+		if ((f->flags & USBHHID_FIELD_SIGNED) && (v & (1U << (f->bit_size - 1))))
+			v |= ~mask;
+
+		values[i] = (int32_t)v;
+		count++;
+	}
+	return count;
+}
+#endif
+
 static void _hid_object_init(USBHHIDDriver *hidp) {
 	osalDbgCheck(hidp != NULL);
 	memset(hidp, 0, sizeof(*hidp));
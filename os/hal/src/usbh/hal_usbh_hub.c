@@ -46,8 +46,13 @@ static const usbh_classdriver_vmt_t usbhhubClassDriverVMT = {
 	_hub_unload
 };
 
+static const usbh_classdriver_match_t usbhhubClassDriverMatch[] = {
+	USBH_MATCH_DEVICE(-1, -1, 0x09, 0x00, 0x00),
+};
+
 const usbh_classdriverinfo_t usbhhubClassDriverInfo = {
-	"HUB", &usbhhubClassDriverVMT
+	"HUB", &usbhhubClassDriverVMT,
+	usbhhubClassDriverMatch, sizeof_array(usbhhubClassDriverMatch)
 };
 
 
@@ -101,6 +106,7 @@ static void _urb_complete(usbh_urb_t *urb) {
 			*sc++ |= *r++;
 
 		uurbinfof("HUB: change, %08x", hubdp->statuschange);
+		_usbh_statuschangeI(hubdp->dev->host);
 	}	break;
 	case USBH_URBSTATUS_DISCONNECTED:
 		uurbwarn("HUB: URB disconnected, aborting poll");
@@ -120,9 +126,8 @@ static usbh_baseclassdriver_t *_hub_load(usbh_device_t *dev,
 
 	USBHHubDriver *hubdp;
 
-	if (_usbh_match_descriptor(descriptor, rem, USBH_DT_DEVICE,
-			0x09, 0x00, 0x00) != HAL_SUCCESS)
-		return NULL;
+	(void)descriptor;
+	(void)rem;
 
 	generic_iterator_t iep, icfg;
 	if_iterator_t iif;
@@ -40,6 +40,23 @@ static void _lun_object_deinit(USBHMassStorageLUNDriver *lunp);
 /* USB Class driver loader for MSD                                           */
 /*===========================================================================*/
 
+#if HAL_USBHMSD_USE_PIPELINE
+/* URBs of a Bulk-Only transaction, queued ahead of the host controller */
+typedef struct {
+	usbh_urb_t cbw;
+	usbh_urb_t data[HAL_USBHMSD_PIPELINE_URBS];
+	usbh_urb_t csw;
+
+	uint8_t *next;				/* first data byte not queued yet */
+	uint32_t rem;				/* data bytes not queued yet */
+	uint32_t actual;			/* data bytes moved */
+	uint8_t pending;			/* data URBs in flight */
+	bool stopped;				/* a data URB failed or was short */
+	usbh_urbstatus_t status;	/* data phase status */
+	thread_reference_t thread;	/* waiting for the data phase */
+} msd_pipeline_t;
+#endif
+
 struct USBHMassStorageDriver {
 	/* inherited from abstract class driver */
 	_usbh_base_classdriver_data
@@ -51,6 +68,10 @@ struct USBHMassStorageDriver {
 	uint32_t tag;
 
 	USBHMassStorageLUNDriver *luns;
+
+#if HAL_USBHMSD_USE_PIPELINE
+	msd_pipeline_t pipeline;
+#endif
 };
 
 static USBHMassStorageDriver USBHMSD[HAL_USBHMSD_MAX_INSTANCES];
@@ -65,8 +86,13 @@ static const usbh_classdriver_vmt_t class_driver_vmt = {
 	_msd_unload
 };
 
+static const usbh_classdriver_match_t class_driver_match[] = {
+	USBH_MATCH_INTERFACE(0x08, 0x06, 0x50),
+};
+
 const usbh_classdriverinfo_t usbhmsdClassDriverInfo = {
-	"MSD", &class_driver_vmt
+	"MSD", &class_driver_vmt,
+	class_driver_match, sizeof_array(class_driver_match)
 };
 
 #define MSD_REQ_RESET							0xFF
@@ -78,10 +104,6 @@ static usbh_baseclassdriver_t *_msd_load(usbh_device_t *dev, const uint8_t *desc
 	uint8_t luns;
 	usbh_urbstatus_t stat;
 
-	if (_usbh_match_descriptor(descriptor, rem, USBH_DT_INTERFACE,
-			0x08, 0x06, 0x50) != HAL_SUCCESS)
-		return NULL;
-
 	const usbh_interface_descriptor_t * const ifdesc = (const usbh_interface_descriptor_t *)descriptor;
 
 	if ((ifdesc->bAlternateSetting != 0)
@@ -172,6 +194,7 @@ alloc_ok:
 			msdp->luns = &MSBLKD[i];
 			MSBLKD[i].msdp = msdp;
 			MSBLKD[i].state = BLK_ACTIVE;
+			memset(&MSBLKD[i].stats, 0, sizeof(MSBLKD[i].stats));
 			luns--;
 		}
 	}
@@ -258,14 +281,121 @@ static bool _msd_bot_reset(USBHMassStorageDriver *msdp) {
 			USBH_REQTYPE_CLASSOUT(USBH_REQTYPE_RECIP_INTERFACE),
 			0xFF, 0, msdp->ifnum, 0, NULL);
 	if (res != USBH_URBSTATUS_OK) {
-		return FALSE;
+		return HAL_FAILED;
 	}
 
 	osalThreadSleepMilliseconds(100);
 
-	return usbhEPReset(&msdp->epin) && usbhEPReset(&msdp->epout);
+	if ((usbhEPReset(&msdp->epin) != HAL_SUCCESS)
+			|| (usbhEPReset(&msdp->epout) != HAL_SUCCESS)) {
+		return HAL_FAILED;
+	}
+	return HAL_SUCCESS;
 }
 
+#if HAL_USBHMSD_USE_PIPELINE
+/* Queues the next data chunk on a free data URB */
+static void _msd_pipeline_queueI(msd_pipeline_t *pl, usbh_urb_t *urb) {
+	const uint32_t len = (pl->rem > HAL_USBHMSD_PIPELINE_CHUNK)
+			? HAL_USBHMSD_PIPELINE_CHUNK : pl->rem;
+
+	urb->buff = pl->next;
+	urb->requestedLength = len;
+	usbhURBObjectResetI(urb);
+	pl->next += len;
+	pl->rem -= len;
+	pl->pending++;
+	usbhURBSubmitI(urb);
+
+	/* the last chunk is queued, pre-arm the CSW behind it */
+	if ((pl->rem == 0) && !pl->stopped) {
+		usbhURBSubmitI(&pl->csw);
+	}
+}
+
+/* Cancels the data and CSW URBs still queued */
+static void _msd_pipeline_cancelI(msd_pipeline_t *pl) {
+	uint8_t i;
+
+	pl->stopped = TRUE;
+	for (i = 0; i < HAL_USBHMSD_PIPELINE_URBS; i++) {
+		if (usbhURBIsBusy(&pl->data[i]))
+			usbhURBCancelI(&pl->data[i]);
+	}
+	if (usbhURBIsBusy(&pl->csw))
+		usbhURBCancelI(&pl->csw);
+}
+
+/* Cancels the data and CSW URBs still queued, and waits for them */
+static void _msd_pipeline_cancelS(msd_pipeline_t *pl) {
+	uint8_t i;
+
+	pl->stopped = TRUE;
+	for (i = 0; i < HAL_USBHMSD_PIPELINE_URBS; i++) {
+		if (usbhURBIsBusy(&pl->data[i]))
+			usbhURBCancelAndWaitS(&pl->data[i]);
+	}
+	if (usbhURBIsBusy(&pl->csw))
+		usbhURBCancelAndWaitS(&pl->csw);
+}
+
+/* Data URB completion: runs before the host controller moves to the next
+ * queued URB, so the chunk after the last one is queued in time */
+static void _msd_data_cb(usbh_urb_t *urb) {
+	USBHMassStorageDriver *const msdp = (USBHMassStorageDriver *)urb->userData;
+	msd_pipeline_t *const pl = &msdp->pipeline;
+
+	pl->actual += urb->actualLength;
+	pl->pending--;
+
+	if ((urb->status != USBH_URBSTATUS_OK)
+			|| (urb->actualLength < urb->requestedLength)) {
+		/* failed or short: the data phase ends here, and the CSW must not
+		 * be received by the next queued data URB */
+		if (!pl->stopped) {
+			pl->status = urb->status;
+			_msd_pipeline_cancelI(pl);
+		}
+	} else if (!pl->stopped && pl->rem) {
+		_msd_pipeline_queueI(pl, urb);
+	}
+
+	if (pl->pending == 0)
+		osalThreadResumeI(&pl->thread, MSG_OK);
+}
+
+/* Queues the CBW, the first data chunks and possibly the CSW */
+static void _msd_pipeline_startS(USBHMassStorageDriver *msdp, msd_cbw_t *cbw,
+		void *data, msd_csw_t *csw) {
+	msd_pipeline_t *const pl = &msdp->pipeline;
+	usbh_ep_t *const ep = cbw->bmCBWFlags & MSD_CBWFLAGS_D2H ? &msdp->epin : &msdp->epout;
+	uint8_t i;
+
+	pl->next = (uint8_t *)data;
+	pl->rem = cbw->dCBWDataTransferLength;
+	pl->actual = 0;
+	pl->pending = 0;
+	pl->stopped = FALSE;
+	pl->status = USBH_URBSTATUS_OK;
+	pl->thread = NULL;
+
+	usbhURBObjectInit(&pl->cbw, &msdp->epout, NULL, NULL, cbw, sizeof(*cbw));
+	usbhURBObjectInit(&pl->csw, &msdp->epin, NULL, NULL, csw, sizeof(*csw));
+	for (i = 0; i < HAL_USBHMSD_PIPELINE_URBS; i++) {
+		usbhURBObjectInit(&pl->data[i], ep, _msd_data_cb, msdp, NULL, 0);
+	}
+
+	usbhURBSubmitI(&pl->cbw);
+	if (pl->rem == 0) {
+		usbhURBSubmitI(&pl->csw);
+		return;
+	}
+	for (i = 0; (i < HAL_USBHMSD_PIPELINE_URBS) && pl->rem && !pl->stopped; i++) {
+		_msd_pipeline_queueI(pl, &pl->data[i]);
+	}
+}
+#endif
+
 static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassStorageLUNDriver *lunp, void *data) {
 
 	USBHMassStorageDriver *const msdp = lunp->msdp;
@@ -273,6 +403,10 @@ static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassSt
 	uint32_t data_actual_len, actual_len;
 	usbh_urbstatus_t status;
 	USBH_DEFINE_BUFFER(msd_csw_t csw);
+#if HAL_USBHMSD_USE_PIPELINE
+	msd_pipeline_t *const pl = &msdp->pipeline;
+	bool csw_armed;
+#endif
 
 	tran->cbw->bCBWLUN = (uint8_t)(lunp - &msdp->luns[0]);
 	tran->cbw->dCBWSignature = MSD_CBW_SIGNATURE;
@@ -280,8 +414,21 @@ static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassSt
 	tran->data_processed = 0;
 
 	/* control phase */
+#if HAL_USBHMSD_USE_PIPELINE
+	osalSysLock();
+	_msd_pipeline_startS(msdp, tran->cbw, data, &csw);
+	osalOsRescheduleS();
+	if (usbhURBWaitTimeoutS(&pl->cbw, OSAL_MS2I(1000)) == MSG_TIMEOUT)
+		_usbh_urb_abort_and_waitS(&pl->cbw, USBH_URBSTATUS_TIMEOUT);
+	status = pl->cbw.status;
+	actual_len = pl->cbw.actualLength;
+	if ((status != USBH_URBSTATUS_OK) || (actual_len != sizeof(*tran->cbw)))
+		_msd_pipeline_cancelS(pl);
+	osalSysUnlock();
+#else
 	status = usbhBulkTransfer(&msdp->epout, tran->cbw,
 					sizeof(*tran->cbw), &actual_len, OSAL_MS2I(1000));
+#endif
 
 	if (status == USBH_URBSTATUS_CANCELLED) {
 		uclassdrverr("\tMSD: Control phase: USBH_URBSTATUS_CANCELLED");
@@ -300,11 +447,27 @@ static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassSt
 	data_actual_len = 0;
 	if (tran->cbw->dCBWDataTransferLength) {
 		usbh_ep_t *const ep = tran->cbw->bmCBWFlags & MSD_CBWFLAGS_D2H ? &msdp->epin : &msdp->epout;
+#if HAL_USBHMSD_USE_PIPELINE
+		osalSysLock();
+		if (pl->pending
+				&& (osalThreadSuspendTimeoutS(&pl->thread, OSAL_MS2I(20000)) == MSG_TIMEOUT)
+				&& !pl->stopped) {
+			pl->status = USBH_URBSTATUS_TIMEOUT;
+		}
+		if (pl->stopped || pl->pending) {
+			/* the CSW may still be queued, or being halted */
+			_msd_pipeline_cancelS(pl);
+		}
+		status = pl->status;
+		data_actual_len = pl->actual;
+		osalSysUnlock();
+#else
 		status = usbhBulkTransfer(
 				ep,
 				data,
 				tran->cbw->dCBWDataTransferLength,
 				&data_actual_len, OSAL_MS2I(20000));
+#endif
 
 		if (status == USBH_URBSTATUS_CANCELLED) {
 			uclassdrverr("\tMSD: Data phase: USBH_URBSTATUS_CANCELLED");
@@ -325,8 +488,24 @@ static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassSt
 
 
 	/* status phase */
+#if HAL_USBHMSD_USE_PIPELINE
+	osalSysLock();
+	csw_armed = !pl->stopped;
+	if (csw_armed) {
+		if (usbhURBWaitTimeoutS(&pl->csw, OSAL_MS2I(1000)) == MSG_TIMEOUT)
+			_usbh_urb_abort_and_waitS(&pl->csw, USBH_URBSTATUS_TIMEOUT);
+		status = pl->csw.status;
+		actual_len = pl->csw.actualLength;
+	}
+	osalSysUnlock();
+	if (!csw_armed) {
+		status = usbhBulkTransfer(&msdp->epin, &csw,
+					sizeof(csw), &actual_len, OSAL_MS2I(1000));
+	}
+#else
 	status = usbhBulkTransfer(&msdp->epin, &csw,
 				sizeof(csw), &actual_len, OSAL_MS2I(1000));
+#endif
 
 	if (status == USBH_URBSTATUS_STALL) {
 		uclassdrvwarn("\tMSD: Status phase: USBH_URBSTATUS_STALL, clear halt and retry");
@@ -403,6 +582,10 @@ static msd_bot_result_t _msd_bot_transaction(msd_transaction_t *tran, USBHMassSt
 #define SCSI_CMD_READ_10 						0x28
 #define SCSI_CMD_WRITE_10						0x2A
 
+/* Read 16 and Write 16 */
+#define SCSI_CMD_READ_16 						0x88
+#define SCSI_CMD_WRITE_16						0x8A
+
 /* Request sense */
 #define SCSI_CMD_REQUEST_SENSE 					0x03
 typedef __PACKED_STRUCT {
@@ -460,6 +643,16 @@ typedef __PACKED_STRUCT {
 	uint32_t block_size;
 } scsi_readcapacity10_response_t;
 
+/* Read Capacity 16 */
+#define SCSI_CMD_SERVICE_ACTION_IN_16			0x9E
+#define SCSI_SA_READ_CAPACITY_16				0x10
+typedef __PACKED_STRUCT {
+	uint32_t last_block_addr_hi;
+	uint32_t last_block_addr_lo;
+	uint32_t block_size;
+	uint8_t reserved[20];
+} scsi_readcapacity16_response_t;
+
 /* Start/Stop Unit */
 #define SCSI_CMD_START_STOP_UNIT				0x1B
 typedef __PACKED_STRUCT {
@@ -485,17 +678,26 @@ static msd_result_t _scsi_perform_transaction(USBHMassStorageLUNDriver *lunp,
 	msd_bot_result_t res;
 	res = _msd_bot_transaction(transaction, lunp, data);
 	if (res != MSD_BOTRESULT_OK) {
+		if (res == MSD_BOTRESULT_ERROR)
+			lunp->stats.transport_errors++;
 		return (msd_result_t)res;
 	}
 
 	if (transaction->csw_status == CSW_STATUS_FAILED) {
+		lunp->stats.check_conditions++;
 		if (transaction->cbw->CBWCB[0] != SCSI_CMD_REQUEST_SENSE) {
 			/* do auto-sense (except for SCSI_CMD_REQUEST_SENSE!) */
 			uclassdrvwarn("\tMSD: Command failed, auto-sense");
 			USBH_DEFINE_BUFFER(scsi_sense_response_t sense);
+			lunp->sense_key = SCSI_SENSE_KEY_GOOD;
+			lunp->asc = SCSI_ASENSE_NO_ADDITIONAL_INFORMATION;
+			lunp->ascq = SCSI_ASENSEQ_NO_QUALIFIER;
 			if (scsi_requestsense(lunp, &sense) == MSD_RESULT_OK) {
 				uclassdrvwarnf("\tMSD: REQUEST SENSE: Sense key=%x, ASC=%02x, ASCQ=%02x",
 						sense.byte[2] & 0xf, sense.byte[12], sense.byte[13]);
+				lunp->sense_key = sense.byte[2] & 0xf;
+				lunp->asc = sense.byte[12];
+				lunp->ascq = sense.byte[13];
 			}
 		}
 		return MSD_RESULT_FAILED;
@@ -590,31 +792,24 @@ static msd_result_t scsi_readcapacity10(USBHMassStorageLUNDriver *lunp, scsi_rea
 }
 
 
-static msd_result_t scsi_read10(USBHMassStorageLUNDriver *lunp, uint32_t lba, uint16_t n, uint8_t *data, uint32_t *actual_len) {
+static msd_result_t scsi_readcapacity16(USBHMassStorageLUNDriver *lunp, scsi_readcapacity16_response_t *resp) {
 	USBH_DEFINE_BUFFER(msd_cbw_t cbw);
 	msd_transaction_t transaction;
 	msd_result_t res;
 
 	memset(cbw.CBWCB, 0, sizeof(cbw.CBWCB));
-	cbw.dCBWDataTransferLength = n * lunp->info.blk_size;
+	cbw.dCBWDataTransferLength = sizeof(scsi_readcapacity16_response_t);
 	cbw.bmCBWFlags = MSD_CBWFLAGS_D2H;
-	cbw.bCBWCBLength = 10;
-	cbw.CBWCB[0] = SCSI_CMD_READ_10;
-	cbw.CBWCB[2] = (uint8_t)(lba >> 24);
-	cbw.CBWCB[3] = (uint8_t)(lba >> 16);
-	cbw.CBWCB[4] = (uint8_t)(lba >> 8);
-	cbw.CBWCB[5] = (uint8_t)(lba);
-	cbw.CBWCB[7] = (uint8_t)(n >> 8);
-	cbw.CBWCB[8] = (uint8_t)(n);
+	cbw.bCBWCBLength = 16;
+	cbw.CBWCB[0] = SCSI_CMD_SERVICE_ACTION_IN_16;
+	cbw.CBWCB[1] = SCSI_SA_READ_CAPACITY_16;
+	cbw.CBWCB[13] = sizeof(scsi_readcapacity16_response_t);
 	transaction.cbw = &cbw;
 
-	res = _scsi_perform_transaction(lunp, &transaction, data);
-	if (actual_len) {
-		*actual_len = transaction.data_processed;
-	}
+	res = _scsi_perform_transaction(lunp, &transaction, resp);
 	if (res == MSD_RESULT_OK) {
 		//transaction is OK; check length
-		if (transaction.data_processed < cbw.dCBWDataTransferLength) {
+		if (transaction.data_processed < 12) {
 			res = MSD_RESULT_TRANSPORT_ERROR;
 		}
 	}
@@ -622,25 +817,39 @@ static msd_result_t scsi_read10(USBHMassStorageLUNDriver *lunp, uint32_t lba, ui
 	return res;
 }
 
-static msd_result_t scsi_write10(USBHMassStorageLUNDriver *lunp, uint32_t lba, uint16_t n, const uint8_t *data, uint32_t *actual_len) {
+/* READ/WRITE(10), or READ/WRITE(16) on large media */
+static msd_result_t scsi_readwrite(USBHMassStorageLUNDriver *lunp, bool write,
+		uint32_t lba, uint16_t n, uint8_t *data, uint32_t *actual_len) {
 	USBH_DEFINE_BUFFER(msd_cbw_t cbw);
 	msd_transaction_t transaction;
 	msd_result_t res;
 
 	memset(cbw.CBWCB, 0, sizeof(cbw.CBWCB));
 	cbw.dCBWDataTransferLength = n * lunp->info.blk_size;
-	cbw.bmCBWFlags = MSD_CBWFLAGS_H2D;
-	cbw.bCBWCBLength = 10;
-	cbw.CBWCB[0] = SCSI_CMD_WRITE_10;
-	cbw.CBWCB[2] = (uint8_t)(lba >> 24);
-	cbw.CBWCB[3] = (uint8_t)(lba >> 16);
-	cbw.CBWCB[4] = (uint8_t)(lba >> 8);
-	cbw.CBWCB[5] = (uint8_t)(lba);
-	cbw.CBWCB[7] = (uint8_t)(n >> 8);
-	cbw.CBWCB[8] = (uint8_t)(n);
+	cbw.bmCBWFlags = write ? MSD_CBWFLAGS_H2D : MSD_CBWFLAGS_D2H;
+	if (lunp->cdb16) {
+		cbw.bCBWCBLength = 16;
+		cbw.CBWCB[0] = write ? SCSI_CMD_WRITE_16 : SCSI_CMD_READ_16;
+		/* LBA bits 63..32 are zero */
+		cbw.CBWCB[6] = (uint8_t)(lba >> 24);
+		cbw.CBWCB[7] = (uint8_t)(lba >> 16);
+		cbw.CBWCB[8] = (uint8_t)(lba >> 8);
+		cbw.CBWCB[9] = (uint8_t)(lba);
+		cbw.CBWCB[12] = (uint8_t)(n >> 8);
+		cbw.CBWCB[13] = (uint8_t)(n);
+	} else {
+		cbw.bCBWCBLength = 10;
+		cbw.CBWCB[0] = write ? SCSI_CMD_WRITE_10 : SCSI_CMD_READ_10;
+		cbw.CBWCB[2] = (uint8_t)(lba >> 24);
+		cbw.CBWCB[3] = (uint8_t)(lba >> 16);
+		cbw.CBWCB[4] = (uint8_t)(lba >> 8);
+		cbw.CBWCB[5] = (uint8_t)(lba);
+		cbw.CBWCB[7] = (uint8_t)(n >> 8);
+		cbw.CBWCB[8] = (uint8_t)(n);
+	}
 	transaction.cbw = &cbw;
 
-	res = _scsi_perform_transaction(lunp, &transaction, (void *)data);
+	res = _scsi_perform_transaction(lunp, &transaction, data);
 	if (actual_len) {
 		*actual_len = transaction.data_processed;
 	}
@@ -654,6 +863,65 @@ static msd_result_t scsi_write10(USBHMassStorageLUNDriver *lunp, uint32_t lba, u
 	return res;
 }
 
+/* Tells if a command that completed with an error may succeed if reissued */
+static bool _sense_is_transient(const USBHMassStorageLUNDriver *lunp) {
+	switch (lunp->sense_key) {
+	case SCSI_SENSE_KEY_GOOD:				/* REQUEST SENSE failed too */
+	case SCSI_SENSE_KEY_RECOVERED_ERROR:
+	case SCSI_SENSE_KEY_UNIT_ATTENTION:
+	case SCSI_SENSE_KEY_ABORTED_COMMAND:
+	case SCSI_SENSE_KEY_MEDIUM_ERROR:
+		return TRUE;
+	case SCSI_SENSE_KEY_NOT_READY:
+		return lunp->asc != SCSI_ASENSE_MEDIUM_NOT_PRESENT;
+	default:
+		return FALSE;
+	}
+}
+
+/* READ/WRITE with error recovery: a failed transaction has already been
+ * recovered with clear-halt or BOT reset by _msd_bot_transaction, repeated
+ * transport errors get a full BOT reset, failed commands are reissued
+ * only if the sense data reports a transient condition */
+static msd_result_t scsi_readwrite_retry(USBHMassStorageLUNDriver *lunp, bool write,
+		uint32_t lba, uint16_t n, uint8_t *data) {
+	msd_result_t res;
+	uint32_t actual_len;
+	uint8_t retry;
+
+	for (retry = 0; ; retry++) {
+		res = scsi_readwrite(lunp, write, lba, n, data, &actual_len);
+		if (res == MSD_RESULT_OK) {
+			if (retry)
+				lunp->stats.recovered++;
+			return res;
+		}
+
+		if ((res == MSD_RESULT_DISCONNECTED)
+				|| (retry >= HAL_USBHMSD_MAX_RETRIES)
+				|| ((res == MSD_RESULT_FAILED) && !_sense_is_transient(lunp))) {
+			break;
+		}
+
+		if ((res == MSD_RESULT_TRANSPORT_ERROR) && retry) {
+			uclassdrvwarn("\tMSD: Repeated transport error, reset recovery");
+			lunp->stats.resets++;
+			if (_msd_bot_reset(lunp->msdp) != HAL_SUCCESS) {
+				/* the device is not answering control requests either */
+				break;
+			}
+		}
+
+		uclassdrvwarnf("\tMSD: %s failed (res=%d), retry %d",
+				write ? "WRITE" : "READ", res, retry + 1);
+		lunp->stats.retries++;
+		osalThreadSleepMilliseconds(HAL_USBHMSD_RETRY_DELAY << retry);
+	}
+
+	lunp->stats.failed++;
+	return res;
+}
+
 
 
 /*===========================================================================*/
@@ -771,6 +1039,22 @@ bool usbhmsdLUNConnect(USBHMassStorageLUNDriver *lunp) {
 
 		lunp->info.blk_size = __REV(cap.block_size);
 		lunp->info.blk_num = __REV(cap.last_block_addr) + 1;
+		lunp->cdb16 = FALSE;
+	}
+
+	if (lunp->info.blk_num == 0) {
+		/* more than 2^32 blocks, only reachable with 16-byte CDBs */
+		USBH_DEFINE_BUFFER(scsi_readcapacity16_response_t cap);
+		uclassdrvinfo("READ CAPACITY(16)...");
+		res = scsi_readcapacity16(lunp, &cap);
+		if (res != MSD_RESULT_OK) {
+			goto failed;
+		}
+
+		/* the block device interface addresses 2^32 blocks at most */
+		lunp->info.blk_size = __REV(cap.block_size);
+		lunp->info.blk_num = 0xFFFFFFFFU;
+		lunp->cdb16 = TRUE;
 	}
 
 	uclassdrvinfof("\tBlock size=%dbytes, blocks=%u (~%u MB)", lunp->info.blk_size, lunp->info.blk_num,
@@ -815,7 +1099,6 @@ bool usbhmsdLUNRead(USBHMassStorageLUNDriver *lunp, uint32_t startblk,
 	bool ret = HAL_FAILED;
 	uint16_t blocks;
 	msd_result_t res;
-	uint32_t actual_len;
 
 	chSemWait(&lunp->sem);
 	if (lunp->state != BLK_READY) {
@@ -830,14 +1113,8 @@ bool usbhmsdLUNRead(USBHMassStorageLUNDriver *lunp, uint32_t startblk,
 		} else {
 			blocks = (uint16_t)n;
 		}
-		res = scsi_read10(lunp, startblk, blocks, buffer, &actual_len);
-		if (res == MSD_RESULT_DISCONNECTED) {
-			goto exit;
-		} else if (res == MSD_RESULT_TRANSPORT_ERROR) {
-			//retry?
-			goto exit;
-		} else if (res == MSD_RESULT_FAILED) {
-			//retry?
+		res = scsi_readwrite_retry(lunp, FALSE, startblk, blocks, buffer);
+		if (res != MSD_RESULT_OK) {
 			goto exit;
 		}
 		n -= blocks;
@@ -860,7 +1137,6 @@ bool usbhmsdLUNWrite(USBHMassStorageLUNDriver *lunp, uint32_t startblk,
 	bool ret = HAL_FAILED;
 	uint16_t blocks;
 	msd_result_t res;
-	uint32_t actual_len;
 
 	chSemWait(&lunp->sem);
 	if (lunp->state != BLK_READY) {
@@ -875,14 +1151,8 @@ bool usbhmsdLUNWrite(USBHMassStorageLUNDriver *lunp, uint32_t startblk,
 		} else {
 			blocks = (uint16_t)n;
 		}
-		res = scsi_write10(lunp, startblk, blocks, buffer, &actual_len);
-		if (res == MSD_RESULT_DISCONNECTED) {
-			goto exit;
-		} else if (res == MSD_RESULT_TRANSPORT_ERROR) {
-			//retry?
-			goto exit;
-		} else if (res == MSD_RESULT_FAILED) {
-			//retry?
+		res = scsi_readwrite_retry(lunp, TRUE, startblk, blocks, (uint8_t *)buffer);
+		if (res != MSD_RESULT_OK) {
 			goto exit;
 		}
 		n -= blocks;
@@ -50,8 +50,12 @@ static const usbh_classdriver_vmt_t class_driver_vmt = {
 	_uvc_load,
 	_uvc_unload
 };
+static const usbh_classdriver_match_t class_driver_match[] = {
+	USBH_MATCH_IAD(0x0e, 0x03, 0x00),
+};
 const usbh_classdriverinfo_t usbhuvcClassDriverInfo = {
-	"UVC", &class_driver_vmt
+	"UVC", &class_driver_vmt,
+	class_driver_match, sizeof_array(class_driver_match)
 };
 
 static bool _request(USBHUVCDriver *uvcdp,
@@ -95,6 +99,18 @@ bool usbhuvcVSRequest(USBHUVCDriver *uvcdp,
 	return _request(uvcdp, bRequest, 0, control, wLength, data, if_get(&uvcdp->ivs)->bInterfaceNumber);
 }
 
+/* Next alternate setting of the streaming interface through the descriptor
+ * index, or next interface descriptor without the index. */
+static void _vs_iter_next(const descidx_t *idx, if_iterator_t *iif, uint8_t *n) {
+	if (!descidx_valid(idx)) {
+		if_iter_next(iif);
+	} else if ((*n = descidx_if_next_alt(idx, *n)) != DESCIDX_NONE) {
+		descidx_if_iter(idx, *n, iif);
+	} else {
+		iif->valid = 0;
+	}
+}
+
 static bool _set_vs_alternate(USBHUVCDriver *uvcdp, uint16_t min_ep_size) {
 
 	if (min_ep_size == 0) {
@@ -102,15 +118,26 @@ static bool _set_vs_alternate(USBHUVCDriver *uvcdp, uint16_t min_ep_size) {
 		return usbhStdReqSetInterface(uvcdp->dev, if_get(&uvcdp->ivs)->bInterfaceNumber, 0);
 	}
 
+	/* Only the alternate settings of the streaming interface are walked
+	 * when the descriptor index is available. */
+	const descidx_t *const idx = &uvcdp->dev->cfgIndex;
 	if_iterator_t iif = uvcdp->ivs;
 	generic_iterator_t iep;
 	const usbh_endpoint_descriptor_t *ep = NULL;
 	uint8_t alt = 0;
 	uint16_t sz = 0xffff;
+	uint8_t n = DESCIDX_NONE;
 
 	uclassdrvinfof("Searching alternate setting with min_ep_size=%d", min_ep_size);
 
-	for (; iif.valid; if_iter_next(&iif)) {
+	if (descidx_valid(idx)) {
+		n = descidx_if_first(idx, if_get(&uvcdp->ivs)->bInterfaceNumber);
+		if (n == DESCIDX_NONE)
+			return HAL_FAILED;
+		descidx_if_iter(idx, n, &iif);
+	}
+
+	for (; iif.valid; _vs_iter_next(idx, &iif, &n)) {
 		const usbh_interface_descriptor_t *const ifdesc = if_get(&iif);
 
 		if ((ifdesc->bInterfaceClass != UVC_CC_VIDEO)
@@ -277,8 +304,176 @@ static void _cb_iso(usbh_urb_t *urb) {
 	usbhURBSubmitI(urb);
 }
 
+#if HAL_USBHUVC_USE_FRAMES
+#define FID_UNKNOWN		0xff
 
-bool usbhuvcStreamStart(USBHUVCDriver *uvcdp, uint16_t min_ep_sz) {
+static usbhuvc_frame_t *_frame_takeI(USBHUVCDriver *uvcdp) {
+	uint8_t i;
+
+	if (uvcdp->frames_free == 0)
+		return NULL;
+
+	for (i = 0; (uvcdp->frames_free & (1U << i)) == 0; i++)
+		;
+	uvcdp->frames_free &= ~(1U << i);
+
+	usbhuvc_frame_t *const frame = &uvcdp->frames[i];
+	frame->len = 0;
+	frame->flags = 0;
+	return frame;
+}
+
+static void _frame_postI(USBHUVCDriver *uvcdp) {
+	usbhuvc_frame_t *const frame = uvcdp->frame;
+	uvcdp->frame = NULL;
+
+	frame->type = USBHUVC_MESSAGETYPE_FRAME;
+	frame->length = 0;
+	frame->timestamp = osalOsGetSystemTimeX();
+	frame->seq = uvcdp->frame_seq++;
+
+	if (chMBPostI(&uvcdp->mb, (msg_t)frame) != MSG_OK) {
+		uurberr("UVC: error, mailbox overrun");
+		uvcdp->frames_free |= 1U << (frame - uvcdp->frames);
+		uvcdp->frame_stats.dropped_frames++;
+		return;
+	}
+
+	uvcdp->frame_stats.frames++;
+	if (frame->flags & (UVC_HDR_ERR | USBHUVC_FRAME_LOST))
+		uvcdp->frame_stats.error_frames++;
+	if (frame->flags & USBHUVC_FRAME_OVERFLOW)
+		uvcdp->frame_stats.overflows++;
+}
+
+/* Points the URB at the current write position of the frame being assembled,
+ * minus the expected header length, so that the payload lands in place. The
+ * bytes the header overwrites are saved and restored on completion. Falls
+ * back to the packet buffer when there's no room. */
+static void _frame_armI(USBHUVCDriver *uvcdp, usbh_urb_t *urb) {
+	usbhuvc_frame_t *const frame = uvcdp->frame;
+	const uint16_t mps = uvcdp->ep_iso.wMaxPacketSize;
+	const uint8_t hdr = uvcdp->hdr_len;
+
+	if ((frame != NULL) && (frame->len >= hdr) && (frame->len + mps <= frame->size)) {
+		uint8_t *const dest = frame->buff + frame->len - hdr;
+		memcpy(uvcdp->hdr_save, dest, hdr);
+		urb->buff = dest;
+	} else {
+		urb->buff = uvcdp->mp_data_buffer;
+	}
+}
+
+static void _frame_append(usbhuvc_frame_t *frame, const uint8_t *payload, uint32_t len) {
+	if (frame->len + len > frame->size) {
+		frame->flags |= USBHUVC_FRAME_OVERFLOW;
+		return;
+	}
+	if (payload != frame->buff + frame->len)
+		memmove(frame->buff + frame->len, payload, len);
+	frame->len += len;
+}
+
+static void _cb_iso_frames(usbh_urb_t *urb) {
+	USBHUVCDriver *uvcdp = (USBHUVCDriver *)urb->userData;
+	uint8_t *const buff = (uint8_t *)urb->buff;
+	const bool inplace = (buff != uvcdp->mp_data_buffer);
+	const uint8_t *payload = NULL;
+	uint32_t len = 0;
+	uint8_t flags = 0;
+
+	if ((urb->status == USBH_URBSTATUS_DISCONNECTED)
+			|| (urb->status == USBH_URBSTATUS_CANCELLED)) {
+		uurbwarn("UVC: ISO IN status = DISCONNECTED/CANCELLED, aborting");
+		if (inplace)
+			memcpy(buff, uvcdp->hdr_save, uvcdp->hdr_len);
+		return;
+	}
+
+	if (urb->status != USBH_URBSTATUS_OK) {
+		uurberrf("UVC: ISO IN error, unexpected status = %d", urb->status);
+		uvcdp->frame_stats.dropped_packets++;
+		uvcdp->lost = true;
+	} else if (urb->actualLength >= 2) {
+		const uint8_t hdr = buff[0];
+		if ((hdr < 2) || (hdr > urb->actualLength)) {
+			uurberrf("UVC: ISO IN, bHeaderLength=%d, actualLength=%d", hdr, urb->actualLength);
+			uvcdp->frame_stats.dropped_packets++;
+			uvcdp->lost = true;
+		} else {
+			flags = buff[1];
+			len = urb->actualLength - hdr;
+			payload = buff + hdr;
+			if (inplace && (hdr != uvcdp->hdr_len)) {
+				/* header length changed: move the payload where it was expected */
+				memmove(buff + uvcdp->hdr_len, payload, len);
+				payload = buff + uvcdp->hdr_len;
+			}
+			uvcdp->hdr_len = (hdr > USBHUVC_MAX_HEADER_SZ) ? USBHUVC_MAX_HEADER_SZ : hdr;
+		}
+	} else if (urb->actualLength > 0) {
+		uurberrf("UVC: ISO IN, actualLength=%d", urb->actualLength);
+		uvcdp->frame_stats.dropped_packets++;
+		uvcdp->lost = true;
+	}
+
+	/* a lost packet belongs either to the frame being assembled or, if it
+	 * carried the start of the next one, to the next frame */
+	if (uvcdp->lost && uvcdp->frame)
+		uvcdp->frame->flags |= USBHUVC_FRAME_LOST;
+
+	if (inplace)
+		memcpy(buff, uvcdp->hdr_save, (size_t)(payload ? payload - buff : uvcdp->hdr_len));
+
+	if (payload != NULL) {
+		const uint8_t fid = flags & UVC_HDR_FID;
+
+		if (fid != uvcdp->fid) {
+			/* a new frame starts without EOF on the previous one */
+			if (uvcdp->frame && uvcdp->frame->len)
+				_frame_postI(uvcdp);
+			/* the first FID seen may be in the middle of a frame */
+			if (uvcdp->fid != FID_UNKNOWN)
+				uvcdp->synced = true;
+			uvcdp->fid = fid;
+		}
+
+		if (uvcdp->synced && (uvcdp->frame == NULL)) {
+			uvcdp->frame = _frame_takeI(uvcdp);
+			if (uvcdp->frame == NULL) {
+				uurbwarn("UVC: no free frame, dropping");
+				uvcdp->frame_stats.dropped_frames++;
+				uvcdp->synced = false;
+			}
+		}
+
+		if (uvcdp->frame) {
+			if (uvcdp->lost && (uvcdp->frame->len == 0))
+				uvcdp->frame->flags |= USBHUVC_FRAME_LOST;
+			_frame_append(uvcdp->frame, payload, len);
+			uvcdp->frame->flags |= flags & (UVC_HDR_ERR | UVC_HDR_STILL);
+			if (flags & UVC_HDR_EOF)
+				_frame_postI(uvcdp);
+		}
+
+		if (flags & UVC_HDR_EOF)
+			uvcdp->synced = true;
+		uvcdp->lost = false;
+	}
+
+	usbhURBObjectResetI(urb);
+	_frame_armI(uvcdp, urb);
+	usbhURBSubmitI(urb);
+}
+#endif
+
+
+#if HAL_USBHUVC_USE_FRAMES
+static bool _stream_start(USBHUVCDriver *uvcdp, uint16_t min_ep_sz,
+		usbhuvc_frame_t *frames, uint8_t n) {
+#else
+static bool _stream_start(USBHUVCDriver *uvcdp, uint16_t min_ep_sz) {
+#endif
 	bool ret = HAL_FAILED;
 
 	osalSysLock();
@@ -304,6 +499,36 @@ bool usbhuvcStreamStart(USBHUVCDriver *uvcdp, uint16_t min_ep_sz) {
 	if (_set_vs_alternate(uvcdp, min_ep_sz) != HAL_SUCCESS)
 		goto exit;
 
+#if HAL_USBHUVC_USE_FRAMES
+	if (frames != NULL) {
+		//packet buffer, used when a payload can't go straight to a frame
+		uvcdp->mp_data_buffer = chHeapAlloc(NULL, uvcdp->ep_iso.wMaxPacketSize);
+		if (uvcdp->mp_data_buffer == NULL) {
+			uclassdrverr("Couldn't reserve RAM");
+			goto failed;
+		}
+		chMBResumeX(&uvcdp->mb);
+
+		uvcdp->frames = frames;
+		uvcdp->frames_n = n;
+		uvcdp->frames_free = (n == 32) ? 0xffffffffU : ((1U << n) - 1);
+		uvcdp->frame = NULL;
+		uvcdp->fid = FID_UNKNOWN;
+		uvcdp->synced = false;
+		uvcdp->lost = false;
+		uvcdp->hdr_len = 2;
+		memset(&uvcdp->frame_stats, 0, sizeof(uvcdp->frame_stats));
+
+		usbhEPOpen(&uvcdp->ep_iso);
+		usbhURBObjectInit(&uvcdp->urb_iso, &uvcdp->ep_iso, _cb_iso_frames, uvcdp,
+				uvcdp->mp_data_buffer, uvcdp->ep_iso.wMaxPacketSize);
+		usbhURBSubmit(&uvcdp->urb_iso);
+
+		ret = HAL_SUCCESS;
+		goto exit;
+	}
+#endif
+
 	//reserve working RAM
 	data_sz = (uvcdp->ep_iso.wMaxPacketSize + sizeof(usbhuvc_message_data_t) + 3) & ~3;
 	datapackets = HAL_USBHUVC_WORK_RAM_SIZE / data_sz;
@@ -350,8 +575,10 @@ bool usbhuvcStreamStart(USBHUVCDriver *uvcdp, uint16_t min_ep_sz) {
 
 failed:
 	_set_vs_alternate(uvcdp, 0);
-	if (uvcdp->mp_data_buffer)
+	if (uvcdp->mp_data_buffer) {
 		chHeapFree(uvcdp->mp_data_buffer);
+		uvcdp->mp_data_buffer = 0;
+	}
 
 exit:
 	osalSysLock();
@@ -363,6 +590,35 @@ exit:
 	return ret;
 }
 
+bool usbhuvcStreamStart(USBHUVCDriver *uvcdp, uint16_t min_ep_sz) {
+#if HAL_USBHUVC_USE_FRAMES
+	return _stream_start(uvcdp, min_ep_sz, NULL, 0);
+#else
+	return _stream_start(uvcdp, min_ep_sz);
+#endif
+}
+
+#if HAL_USBHUVC_USE_FRAMES
+/* Streams into the application frame buffers (2 to 32), each with buff and
+ * size set. Complete frames are posted to the mailbox as
+ * USBHUVC_MESSAGETYPE_FRAME messages and must be given back with
+ * usbhuvcFreeFrame(). */
+bool usbhuvcStreamStartFrames(USBHUVCDriver *uvcdp, uint16_t min_ep_sz,
+		usbhuvc_frame_t *frames, uint8_t n) {
+	osalDbgCheck((frames != NULL) && (n >= 2) && (n <= 32));
+	return _stream_start(uvcdp, min_ep_sz, frames, n);
+}
+
+void usbhuvcFreeFrame(USBHUVCDriver *uvcdp, usbhuvc_frame_t *frame) {
+	osalSysLock();
+	if (uvcdp->frames != NULL) {
+		osalDbgCheck((frame >= uvcdp->frames) && (frame < uvcdp->frames + uvcdp->frames_n));
+		uvcdp->frames_free |= 1U << (frame - uvcdp->frames);
+	}
+	osalSysUnlock();
+}
+#endif
+
 bool usbhuvcStreamStop(USBHUVCDriver *uvcdp) {
 	osalSysLock();
 	osalDbgCheck(uvcdp && (uvcdp->state != USBHUVC_STATE_UNINITIALIZED) &&
@@ -378,6 +634,10 @@ bool usbhuvcStreamStop(USBHUVCDriver *uvcdp) {
 
 	//purge the mailbox
 	chMBResetI(&uvcdp->mb);		//TODO: the status messages are lost!!
+#if HAL_USBHUVC_USE_FRAMES
+	uvcdp->frames = NULL;
+	uvcdp->frame = NULL;
+#endif
 	chMtxLockS(&uvcdp->mtx);
 	osalSysUnlock();
 
@@ -497,10 +757,6 @@ static usbh_baseclassdriver_t *_uvc_load(usbh_device_t *dev, const uint8_t *desc
 	USBHUVCDriver *uvcdp;
 	uint8_t i;
 
-	if (_usbh_match_descriptor(descriptor, rem, USBH_DT_INTERFACE_ASSOCIATION,
-			0x0e, 0x03, 0x00) != HAL_SUCCESS)
-		return NULL;
-
 	/* alloc driver */
 	for (i = 0; i < HAL_USBHUVC_MAX_INSTANCES; i++) {
 		if (USBHUVCD[i].dev == NULL) {
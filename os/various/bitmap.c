@@ -69,6 +69,122 @@ static inline size_t pos_in_word(size_t bit) {
   return bit % (sizeof(bitmap_word_t) * 8);
 }
 
+/**
+ * @brief Bits in a word.
+ */
+#define WORD_BITS         (sizeof(bitmap_word_t) * 8)
+
+/**
+ * @brief Get number of trailing zero bits.
+ *
+ * @param[in] w         the word, must not be zero
+ *
+ * @return              Position of the lowest set bit.
+ */
+static inline size_t ctz(bitmap_word_t w) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_ctz(w);
+#else
+  size_t n = 0;
+
+  while ((w & 1U) == 0U) {
+    w >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+/**
+ * @brief Get number of set bits.
+ *
+ * @param[in] w         the word
+ *
+ * @return              Number of bits set in the word.
+ */
+static inline size_t popcount(bitmap_word_t w) {
+#if defined(__GNUC__)
+  return (size_t)__builtin_popcount(w);
+#else
+  size_t n = 0;
+
+  while (w != 0U) {
+    w &= w - 1U;
+    n++;
+  }
+  return n;
+#endif
+}
+
+/**
+ * @brief Mask of bits at and above position in word.
+ *
+ * @param[in] pos       bit position in word
+ */
+static inline bitmap_word_t mask_from(size_t pos) {
+  return ~(bitmap_word_t)0 << pos;
+}
+
+/**
+ * @brief Search first word bit matching @p inv polarity.
+ *
+ * @param[in] map       the @p bitmap_t structure
+ * @param[in] from      number of the first bit to be checked
+ * @param[in] inv       0 to search set bits, all ones to search clear bits
+ *
+ * @return              Number of the bit or @p BITMAP_NONE.
+ */
+static size_t find_first(const bitmap_t *map, size_t from, bitmap_word_t inv) {
+  size_t w = word(from);
+  bitmap_word_t v;
+
+  if (w >= map->len)
+    return BITMAP_NONE;
+
+  v = (map->array[w] ^ inv) & mask_from(pos_in_word(from));
+  while (v == 0) {
+    if (++w >= map->len)
+      return BITMAP_NONE;
+    v = map->array[w] ^ inv;
+  }
+
+  return w * WORD_BITS + ctz(v);
+}
+
+/**
+ * @brief Apply set or clear to a run of bits.
+ *
+ * @param[out] map      the @p bitmap_t structure
+ * @param[in] bit       number of the first bit
+ * @param[in] count     number of bits
+ * @param[in] set       @p true to set bits, @p false to clear them
+ */
+static void fill_range(bitmap_t *map, size_t bit, size_t count, bool set) {
+  size_t w, last;
+  bitmap_word_t m;
+
+  if (count == 0)
+    return;
+
+  w = word(bit);
+  last = word(bit + count - 1);
+  osalDbgCheck(last < map->len);
+
+  while (w <= last) {
+    m = ~(bitmap_word_t)0;
+    if (w == word(bit))
+      m &= mask_from(pos_in_word(bit));
+    if (w == last)
+      m &= ~(bitmap_word_t)0 >> (WORD_BITS - 1 - pos_in_word(bit + count - 1));
+
+    if (set)
+      map->array[w] |= m;
+    else
+      map->array[w] &= ~m;
+    w++;
+  }
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -155,4 +271,70 @@ bitmap_word_t bitmapGet(const bitmap_t *map, size_t bit) {
 size_t bitmapGetBitsCount(const bitmap_t *map) {
   return map->len * sizeof(bitmap_word_t) * 8;
 }
+
+/**
+ * @brief Search first set bit in an @p bitmap_t structure.
+ * @note  Whole words are skipped at once.
+ *
+ * @param[in] map       the @p bitmap_t structure
+ * @param[in] from      number of the first bit to be checked
+ *
+ * @return              Number of the first set bit at or after @p from.
+ * @retval BITMAP_NONE  if there is no set bit.
+ */
+size_t bitmapFindFirstSet(const bitmap_t *map, size_t from) {
+  return find_first(map, from, 0);
+}
+
+/**
+ * @brief Search first cleared bit in an @p bitmap_t structure.
+ * @note  Whole words are skipped at once.
+ *
+ * @param[in] map       the @p bitmap_t structure
+ * @param[in] from      number of the first bit to be checked
+ *
+ * @return              Number of the first cleared bit at or after @p from.
+ * @retval BITMAP_NONE  if there is no cleared bit.
+ */
+size_t bitmapFindFirstClear(const bitmap_t *map, size_t from) {
+  return find_first(map, from, ~(bitmap_word_t)0);
+}
+
+/**
+ * @brief Set a run of bits in an @p bitmap_t structure.
+ *
+ * @param[out] map      the @p bitmap_t structure
+ * @param[in] bit       number of the first bit to be set
+ * @param[in] count     number of bits to be set
+ */
+void bitmapSetRange(bitmap_t *map, size_t bit, size_t count) {
+  fill_range(map, bit, count, true);
+}
+
+/**
+ * @brief Clear a run of bits in an @p bitmap_t structure.
+ *
+ * @param[out] map      the @p bitmap_t structure
+ * @param[in] bit       number of the first bit to be cleared
+ * @param[in] count     number of bits to be cleared
+ */
+void bitmapClearRange(bitmap_t *map, size_t bit, size_t count) {
+  fill_range(map, bit, count, false);
+}
+
+/**
+ * @brief Get amount of set bits in an @p bitmap_t structure.
+ *
+ * @param[in] map       the @p bitmap_t structure
+ *
+ * @return              Number of set bits.
+ */
+size_t bitmapPopcount(const bitmap_t *map) {
+  size_t i, n = 0;
+
+  for (i = 0; i < map->len; i++)
+    n += popcount(map->array[i]);
+
+  return n;
+}
 /** @} */
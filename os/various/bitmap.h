@@ -29,6 +29,11 @@
 /* Module constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Returned by search functions when no matching bit exists.
+ */
+#define BITMAP_NONE                       ((size_t)-1)
+
 /*===========================================================================*/
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -55,6 +60,19 @@ typedef struct {
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Iterates over set bits of an @p bitmap_t structure.
+ * @note    Bits may be cleared inside the loop body, bits set behind the
+ *          current position are not visited.
+ *
+ * @param[in] map       the @p bitmap_t structure
+ * @param[out] bit      @p size_t variable receiving the bit numbers
+ */
+#define bitmapForEachSet(map, bit)                                          \
+  for ((bit) = bitmapFindFirstSet((map), 0);                                \
+       (bit) != BITMAP_NONE;                                                \
+       (bit) = bitmapFindFirstSet((map), (bit) + 1))
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -68,6 +86,11 @@ extern "C" {
   void bitmapInvert(bitmap_t *map, size_t bit);
   bitmap_word_t bitmapGet(const bitmap_t *map, size_t bit);
   size_t bitmapGetBitsCount(const bitmap_t *map);
+  size_t bitmapFindFirstSet(const bitmap_t *map, size_t from);
+  size_t bitmapFindFirstClear(const bitmap_t *map, size_t from);
+  void bitmapSetRange(bitmap_t *map, size_t bit, size_t count);
+  void bitmapClearRange(bitmap_t *map, size_t bit, size_t count);
+  size_t bitmapPopcount(const bitmap_t *map);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,567 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blkcache.c
+ * @brief   Caching block device driver source.
+ *
+ * @addtogroup blkcache
+ * @{
+ */
+
+#include "hal.h"
+
+#include "blkcache.h"
+
+#include <string.h>
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Invalid line index.
+ */
+#define NO_LINE                 0xFFFFFFFFU
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint8_t *line_data(const BlockCache *bcp, uint32_t idx) {
+  return &bcp->config->buffer[idx * bcp->config->blk_size];
+}
+
+static bool overflow(const BlockCache *bcp, uint32_t startblk, uint32_t n) {
+  return (startblk > bcp->blk_num) || (n > bcp->blk_num - startblk);
+}
+
+static void touch(BlockCache *bcp, uint32_t idx) {
+  bcp->config->lines[idx].stamp = ++bcp->tick;
+}
+
+/**
+ * @brief   Finds the line holding a block.
+ *
+ * @return  Line index, @p NO_LINE if the block is not cached.
+ */
+static uint32_t lookup(const BlockCache *bcp, uint32_t blk) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t idx = blk % cfg->sets;
+  uint32_t w;
+
+  for (w = 0; w < cfg->ways; w++, idx += cfg->sets) {
+    if (cfg->lines[idx].blk == blk) {
+      return idx;
+    }
+  }
+  return NO_LINE;
+}
+
+/**
+ * @brief   Chooses the line to be replaced in a set.
+ * @details An empty line if any, the least recently used one otherwise.
+ */
+static uint32_t victim(const BlockCache *bcp, uint32_t set) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t idx = set, best = set;
+  uint32_t w;
+
+  for (w = 0; w < cfg->ways; w++, idx += cfg->sets) {
+    if (cfg->lines[idx].blk == BLKCACHE_NO_BLOCK) {
+      return idx;
+    }
+    /* Wrap safe comparison of the access times.*/
+    if ((int32_t)(cfg->lines[idx].stamp - cfg->lines[best].stamp) < 0) {
+      best = idx;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief   Empties a line, writing it back if dirty.
+ */
+static bool evict(BlockCache *bcp, uint32_t idx) {
+
+  blkcache_line_t *lp = &bcp->config->lines[idx];
+
+  if (lp->dirty) {
+    if (HAL_SUCCESS != blkWrite(bcp->config->blkdev, lp->blk,
+                                line_data(bcp, idx), 1)) {
+      return HAL_FAILED;
+    }
+    lp->dirty = false;
+    bcp->stats.writebacks++;
+  }
+  lp->blk = BLKCACHE_NO_BLOCK;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes back all the dirty lines.
+ * @details Dirty lines holding consecutive blocks in the same way are
+ *          contiguous in the storage and written with a single access.
+ */
+static bool flush_lines(BlockCache *bcp) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  blkcache_line_t *lines = cfg->lines;
+  uint32_t w, s, idx, run;
+
+  for (w = 0; w < cfg->ways; w++) {
+    s = 0;
+    while (s < cfg->sets) {
+      idx = w * cfg->sets + s;
+      if (!lines[idx].dirty) {
+        s++;
+        continue;
+      }
+      run = 1;
+      while ((s + run < cfg->sets) && lines[idx + run].dirty &&
+             (lines[idx + run].blk == lines[idx].blk + run)) {
+        run++;
+      }
+      if (HAL_SUCCESS != blkWrite(cfg->blkdev, lines[idx].blk,
+                                  line_data(bcp, idx), run)) {
+        return HAL_FAILED;
+      }
+      bcp->stats.writebacks += run;
+      s += run;
+      while (run-- > 0U) {
+        lines[idx++].dirty = false;
+      }
+    }
+  }
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Loads a block and the following ones with a single access.
+ * @details The blocks go in consecutive sets of the way holding the least
+ *          recently used line of the first set. The window stops at the
+ *          end of the storage area and before any block already cached.
+ *
+ * @return  Line index of @p blk, @p NO_LINE on failure.
+ */
+static uint32_t prefetch(BlockCache *bcp, uint32_t blk) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t set = blk % cfg->sets;
+  uint32_t first = victim(bcp, set);
+  uint32_t cnt = cfg->readahead;
+  uint32_t k;
+
+  if (cnt > cfg->sets - set) {
+    cnt = cfg->sets - set;
+  }
+  if (cnt > bcp->blk_num - blk) {
+    cnt = bcp->blk_num - blk;
+  }
+  for (k = 1; k < cnt; k++) {
+    if (lookup(bcp, blk + k) != NO_LINE) {
+      cnt = k;
+      break;
+    }
+  }
+
+  for (k = 0; k < cnt; k++) {
+    if (HAL_SUCCESS != evict(bcp, first + k)) {
+      return NO_LINE;
+    }
+  }
+  if (HAL_SUCCESS != blkRead(cfg->blkdev, blk, line_data(bcp, first), cnt)) {
+    return NO_LINE;
+  }
+  for (k = 0; k < cnt; k++) {
+    cfg->lines[first + k].blk = blk + k;
+    touch(bcp, first + k);
+  }
+  bcp->stats.prefetched += cnt - 1U;
+  return first;
+}
+
+/**
+ * @brief   Reads a single block through the cache.
+ */
+static bool read_single(BlockCache *bcp, uint32_t blk, uint8_t *buffer) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t idx = lookup(bcp, blk);
+
+  if (idx != NO_LINE) {
+    bcp->stats.read_hits++;
+  }
+  else {
+    bcp->stats.read_misses++;
+    if ((cfg->readahead > 1U) && (blk == bcp->next_blk)) {
+      idx = prefetch(bcp, blk);
+      if (idx == NO_LINE) {
+        return HAL_FAILED;
+      }
+    }
+    else {
+      idx = victim(bcp, blk % cfg->sets);
+      if (HAL_SUCCESS != evict(bcp, idx)) {
+        return HAL_FAILED;
+      }
+      if (HAL_SUCCESS != blkRead(cfg->blkdev, blk, line_data(bcp, idx), 1)) {
+        return HAL_FAILED;
+      }
+      cfg->lines[idx].blk = blk;
+    }
+  }
+
+  memcpy(buffer, line_data(bcp, idx), cfg->blk_size);
+  touch(bcp, idx);
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Writes a single block in the cache.
+ */
+static bool write_single(BlockCache *bcp, uint32_t blk,
+                         const uint8_t *buffer) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t idx = lookup(bcp, blk);
+
+  if (idx != NO_LINE) {
+    bcp->stats.write_hits++;
+  }
+  else {
+    bcp->stats.write_misses++;
+    idx = victim(bcp, blk % cfg->sets);
+    if (HAL_SUCCESS != evict(bcp, idx)) {
+      return HAL_FAILED;
+    }
+    cfg->lines[idx].blk = blk;
+  }
+
+  memcpy(line_data(bcp, idx), buffer, cfg->blk_size);
+  cfg->lines[idx].dirty = true;
+  touch(bcp, idx);
+  return HAL_SUCCESS;
+}
+
+/*
+ * Interface implementation.
+ */
+static bool is_inserted(void *instance) {
+  BlockCache *bcp = instance;
+  return blkIsInserted(bcp->config->blkdev);
+}
+
+static bool is_protected(void *instance) {
+  BlockCache *bcp = instance;
+  return blkIsWriteProtected(bcp->config->blkdev);
+}
+
+static bool connect(void *instance) {
+  BlockCache *bcp = instance;
+  BlockDeviceInfo bdi;
+
+  if (BLK_READY == bcp->state) {
+    return HAL_SUCCESS;
+  }
+  if ((HAL_SUCCESS != blkConnect(bcp->config->blkdev)) ||
+      (HAL_SUCCESS != blkGetInfo(bcp->config->blkdev, &bdi)) ||
+      (bdi.blk_size != bcp->config->blk_size)) {
+    return HAL_FAILED;
+  }
+  bcp->blk_num = bdi.blk_num;
+  bcp->state = BLK_READY;
+  return HAL_SUCCESS;
+}
+
+static bool disconnect(void *instance) {
+  BlockCache *bcp = instance;
+  bool ret = HAL_SUCCESS;
+
+  if (BLK_READY == bcp->state) {
+    ret = flush_lines(bcp);
+    blkcacheInvalidate(bcp);
+    bcp->state = BLK_ACTIVE;
+  }
+  if (HAL_SUCCESS != blkDisconnect(bcp->config->blkdev)) {
+    ret = HAL_FAILED;
+  }
+  return ret;
+}
+
+static bool read(void *instance, uint32_t startblk,
+                 uint8_t *buffer, uint32_t n) {
+
+  BlockCache *bcp = instance;
+  const uint32_t bs = bcp->config->blk_size;
+  uint32_t i, run, idx;
+
+  if ((BLK_READY != bcp->state) || overflow(bcp, startblk, n)) {
+    return HAL_FAILED;
+  }
+
+  if (n == 1U) {
+    if (HAL_SUCCESS != read_single(bcp, startblk, buffer)) {
+      return HAL_FAILED;
+    }
+  }
+  else {
+    /* Multi-block reads do not allocate lines, cached blocks are copied
+       and the runs of uncached blocks read directly.*/
+    i = 0;
+    while (i < n) {
+      idx = lookup(bcp, startblk + i);
+      if (idx != NO_LINE) {
+        memcpy(&buffer[i * bs], line_data(bcp, idx), bs);
+        touch(bcp, idx);
+        bcp->stats.read_hits++;
+        i++;
+        continue;
+      }
+      run = 1;
+      while ((i + run < n) && (lookup(bcp, startblk + i + run) == NO_LINE)) {
+        run++;
+      }
+      if (HAL_SUCCESS != blkRead(bcp->config->blkdev, startblk + i,
+                                 &buffer[i * bs], run)) {
+        return HAL_FAILED;
+      }
+      bcp->stats.read_misses += run;
+      i += run;
+    }
+  }
+
+  bcp->next_blk = startblk + n;
+  return HAL_SUCCESS;
+}
+
+static bool write(void *instance, uint32_t startblk,
+                  const uint8_t *buffer, uint32_t n) {
+
+  BlockCache *bcp = instance;
+  const uint32_t bs = bcp->config->blk_size;
+  uint32_t i, idx;
+
+  if ((BLK_READY != bcp->state) || overflow(bcp, startblk, n)) {
+    return HAL_FAILED;
+  }
+
+  if (n == 1U) {
+    return write_single(bcp, startblk, buffer);
+  }
+
+  /* Multi-block writes go straight to the device, the cached copies are
+     refreshed and become clean.*/
+  if (HAL_SUCCESS != blkWrite(bcp->config->blkdev, startblk, buffer, n)) {
+    return HAL_FAILED;
+  }
+  bcp->stats.write_misses += n;
+  for (i = 0; i < n; i++) {
+    idx = lookup(bcp, startblk + i);
+    if (idx != NO_LINE) {
+      memcpy(line_data(bcp, idx), &buffer[i * bs], bs);
+      bcp->config->lines[idx].dirty = false;
+    }
+  }
+  return HAL_SUCCESS;
+}
+
+static bool sync(void *instance) {
+
+  BlockCache *bcp = instance;
+  if (BLK_READY != bcp->state) {
+    return HAL_FAILED;
+  }
+  else if (HAL_SUCCESS != flush_lines(bcp)) {
+    return HAL_FAILED;
+  }
+  else {
+    return blkSync(bcp->config->blkdev);
+  }
+}
+
+static bool get_info(void *instance, BlockDeviceInfo *bdip) {
+
+  BlockCache *bcp = instance;
+  if (BLK_READY != bcp->state) {
+    return HAL_FAILED;
+  }
+  else {
+    bdip->blk_num = bcp->blk_num;
+    bdip->blk_size = bcp->config->blk_size;
+    return HAL_SUCCESS;
+  }
+}
+
+/**
+ *
+ */
+static const struct BaseBlockDeviceVMT vmt = {
+    (size_t)0,
+    is_inserted,
+    is_protected,
+    connect,
+    disconnect,
+    read,
+    write,
+    sync,
+    get_info
+};
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Caching block device object initialization.
+ *
+ * @param[in] bcp   pointer to @p BlockCache object
+ *
+ * @init
+ */
+void blkcacheObjectInit(BlockCache *bcp) {
+
+  bcp->vmt = &vmt;
+  bcp->state = BLK_STOP;
+  bcp->config = NULL;
+}
+
+/**
+ * @brief   Starts the caching block device.
+ * @details If the underlying device is already connected the cache is ready
+ *          immediately, otherwise it becomes ready on @p blkConnect().
+ *
+ * @param[in] bcp       pointer to @p BlockCache object
+ * @param[in] config    pointer to the @p BlockCacheConfig object
+ *
+ * @api
+ */
+void blkcacheStart(BlockCache *bcp, const BlockCacheConfig *config) {
+
+  BlockDeviceInfo bdi;
+
+  osalDbgCheck((bcp != NULL) && (config != NULL) &&
+               (config->blkdev != NULL) && (config->buffer != NULL) &&
+               (config->lines != NULL) && (config->sets > 0U) &&
+               (config->ways > 0U) && (config->blk_size > 0U));
+  osalDbgAssert(bcp->state == BLK_STOP, "invalid state");
+
+  bcp->config = config;
+  bcp->tick = 0;
+  bcp->next_blk = BLKCACHE_NO_BLOCK;
+  blkcacheInvalidate(bcp);
+  blkcacheResetStats(bcp);
+
+  bcp->state = BLK_ACTIVE;
+  if ((HAL_SUCCESS == blkGetInfo(config->blkdev, &bdi)) &&
+      (bdi.blk_size == config->blk_size)) {
+    bcp->blk_num = bdi.blk_num;
+    bcp->state = BLK_READY;
+  }
+}
+
+/**
+ * @brief   Stops the caching block device.
+ * @details Dirty lines are written back.
+ *
+ * @param[in] bcp       pointer to @p BlockCache object
+ *
+ * @api
+ */
+void blkcacheStop(BlockCache *bcp) {
+
+  osalDbgCheck(bcp != NULL);
+  osalDbgAssert((bcp->state == BLK_ACTIVE) || (bcp->state == BLK_READY),
+                "invalid state");
+
+  if (bcp->state == BLK_READY) {
+    (void)flush_lines(bcp);
+  }
+  bcp->state = BLK_STOP;
+}
+
+/**
+ * @brief   Writes back the dirty lines.
+ * @details Unlike @p blkSync() the underlying device is not synchronized.
+ *
+ * @param[in] bcp       pointer to @p BlockCache object
+ *
+ * @return              The operation status.
+ *
+ * @api
+ */
+bool blkcacheFlush(BlockCache *bcp) {
+
+  osalDbgCheck(bcp != NULL);
+
+  if (bcp->state != BLK_READY) {
+    return HAL_FAILED;
+  }
+  return flush_lines(bcp);
+}
+
+/**
+ * @brief   Empties the cache without writing back the dirty lines.
+ * @note    To be used when the medium has been replaced.
+ *
+ * @param[in] bcp       pointer to @p BlockCache object
+ *
+ * @api
+ */
+void blkcacheInvalidate(BlockCache *bcp) {
+
+  const BlockCacheConfig *cfg = bcp->config;
+  uint32_t i;
+
+  osalDbgCheck(cfg != NULL);
+
+  for (i = 0; i < cfg->sets * cfg->ways; i++) {
+    cfg->lines[i].blk = BLKCACHE_NO_BLOCK;
+    cfg->lines[i].stamp = 0;
+    cfg->lines[i].dirty = false;
+  }
+  bcp->next_blk = BLKCACHE_NO_BLOCK;
+}
+
+/**
+ * @brief   Clears the cache statistics.
+ *
+ * @param[in] bcp       pointer to @p BlockCache object
+ *
+ * @api
+ */
+void blkcacheResetStats(BlockCache *bcp) {
+
+  osalDbgCheck(bcp != NULL);
+
+  memset(&bcp->stats, 0, sizeof(bcp->stats));
+}
+
+/** @} */
@@ -0,0 +1,157 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    blkcache.h
+ * @brief   Caching block device driver header.
+ * @details A @p BlockCache is a block device stacked on another block device.
+ *          Single block accesses, like the FAT and directory sectors of a
+ *          file system, go through a set associative write-back cache with
+ *          LRU replacement. Multi-block accesses only look up the cache, so
+ *          that bulk data does not evict the metadata.
+ *
+ * @addtogroup blkcache
+ * @{
+ */
+
+#ifndef BLKCACHE_H_
+#define BLKCACHE_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Block number of an empty cache line.
+ */
+#define BLKCACHE_NO_BLOCK       0xFFFFFFFFU
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+typedef struct BlockCache BlockCache;
+
+/**
+ * @brief   Cache line descriptor.
+ */
+typedef struct {
+  uint32_t      blk;          /**< @brief Cached block, or empty.*/
+  uint32_t      stamp;        /**< @brief Last access time, for LRU.*/
+  bool          dirty;        /**< @brief Line newer than the device.*/
+} blkcache_line_t;
+
+/**
+ * @brief   Cache statistics.
+ */
+typedef struct {
+  uint32_t      read_hits;    /**< @brief Blocks read from the cache.*/
+  uint32_t      read_misses;  /**< @brief Blocks read from the device.*/
+  uint32_t      write_hits;   /**< @brief Blocks written in the cache.*/
+  uint32_t      write_misses; /**< @brief Blocks written to the device.*/
+  uint32_t      writebacks;   /**< @brief Dirty blocks written back.*/
+  uint32_t      prefetched;   /**< @brief Blocks loaded by read-ahead.*/
+} blkcache_stats_t;
+
+/**
+ * @brief   Caching block device configuration.
+ * @note    The line storage is made of @p ways areas of @p sets blocks each,
+ *          so that consecutive blocks can be moved with a single access.
+ */
+typedef struct {
+  /**
+   * @brief   Underlying block device.
+   */
+  BaseBlockDevice     *blkdev;
+  /**
+   * @brief   Line storage, @p sets * @p ways * @p blk_size bytes.
+   */
+  uint8_t             *buffer;
+  /**
+   * @brief   Line descriptors, @p sets * @p ways elements.
+   */
+  blkcache_line_t     *lines;
+  /**
+   * @brief   Number of sets.
+   */
+  uint32_t            sets;
+  /**
+   * @brief   Number of lines per set.
+   */
+  uint32_t            ways;
+  /**
+   * @brief   Block size of the underlying device.
+   */
+  uint32_t            blk_size;
+  /**
+   * @brief   Maximum number of blocks loaded on a sequential miss.
+   * @details Zero or one disables the read-ahead.
+   */
+  uint32_t            readahead;
+} BlockCacheConfig;
+
+/**
+ * @brief   @p BlockCache specific data.
+ */
+#define _blkcache_device_data                                               \
+  _base_block_device_data                                                   \
+  const BlockCacheConfig  *config;                                          \
+  uint32_t                blk_num;                                          \
+  uint32_t                tick;                                             \
+  uint32_t                next_blk;                                         \
+  blkcache_stats_t        stats;
+
+/**
+ * @brief   Caching block device.
+ */
+struct BlockCache {
+  /** @brief Virtual Methods Table.*/
+  const struct BaseBlockDeviceVMT *vmt;
+  _blkcache_device_data
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void blkcacheObjectInit(BlockCache *bcp);
+  void blkcacheStart(BlockCache *bcp, const BlockCacheConfig *config);
+  void blkcacheStop(BlockCache *bcp);
+  bool blkcacheFlush(BlockCache *bcp);
+  void blkcacheInvalidate(BlockCache *bcp);
+  void blkcacheResetStats(BlockCache *bcp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLKCACHE_H_ */
+
+/** @} */
@@ -36,10 +36,15 @@
 
 /**
  * @brief   CRC default configuration.
+ * @note    When @p CRCSW_SLICING is greater than one the tables hold
+ *          @p CRCSW_SLICING consecutive sets of 256 entries, set @p k being
+ *          derived from set @p k-1 as
+ *          <tt>T[k][i] = T[0][T[k-1][i] & 0xFF] ^ (T[k-1][i] >> 8)</tt>.
  */
 
 #if CRCSW_CRC32_TABLE == TRUE || defined(__DOXYGEN__)
-static const uint32_t crc32_table[256] = {
+static const uint32_t crc32_table[256 * CRCSW_SLICING] = {
+  /* Table 0. */
   0x00000000, 0x77073096, 0xee0e612c, 0x990951ba,
   0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
   0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
@@ -103,12 +108,472 @@ static const uint32_t crc32_table[256] = {
   0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6,
   0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
   0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-  0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+  0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
+#if CRCSW_SLICING >= 4
+  /* Table 1. */
+  0x00000000, 0x191b3141, 0x32366282, 0x2b2d53c3,
+  0x646cc504, 0x7d77f445, 0x565aa786, 0x4f4196c7,
+  0xc8d98a08, 0xd1c2bb49, 0xfaefe88a, 0xe3f4d9cb,
+  0xacb54f0c, 0xb5ae7e4d, 0x9e832d8e, 0x87981ccf,
+  0x4ac21251, 0x53d92310, 0x78f470d3, 0x61ef4192,
+  0x2eaed755, 0x37b5e614, 0x1c98b5d7, 0x05838496,
+  0x821b9859, 0x9b00a918, 0xb02dfadb, 0xa936cb9a,
+  0xe6775d5d, 0xff6c6c1c, 0xd4413fdf, 0xcd5a0e9e,
+  0x958424a2, 0x8c9f15e3, 0xa7b24620, 0xbea97761,
+  0xf1e8e1a6, 0xe8f3d0e7, 0xc3de8324, 0xdac5b265,
+  0x5d5daeaa, 0x44469feb, 0x6f6bcc28, 0x7670fd69,
+  0x39316bae, 0x202a5aef, 0x0b07092c, 0x121c386d,
+  0xdf4636f3, 0xc65d07b2, 0xed705471, 0xf46b6530,
+  0xbb2af3f7, 0xa231c2b6, 0x891c9175, 0x9007a034,
+  0x179fbcfb, 0x0e848dba, 0x25a9de79, 0x3cb2ef38,
+  0x73f379ff, 0x6ae848be, 0x41c51b7d, 0x58de2a3c,
+  0xf0794f05, 0xe9627e44, 0xc24f2d87, 0xdb541cc6,
+  0x94158a01, 0x8d0ebb40, 0xa623e883, 0xbf38d9c2,
+  0x38a0c50d, 0x21bbf44c, 0x0a96a78f, 0x138d96ce,
+  0x5ccc0009, 0x45d73148, 0x6efa628b, 0x77e153ca,
+  0xbabb5d54, 0xa3a06c15, 0x888d3fd6, 0x91960e97,
+  0xded79850, 0xc7cca911, 0xece1fad2, 0xf5facb93,
+  0x7262d75c, 0x6b79e61d, 0x4054b5de, 0x594f849f,
+  0x160e1258, 0x0f152319, 0x243870da, 0x3d23419b,
+  0x65fd6ba7, 0x7ce65ae6, 0x57cb0925, 0x4ed03864,
+  0x0191aea3, 0x188a9fe2, 0x33a7cc21, 0x2abcfd60,
+  0xad24e1af, 0xb43fd0ee, 0x9f12832d, 0x8609b26c,
+  0xc94824ab, 0xd05315ea, 0xfb7e4629, 0xe2657768,
+  0x2f3f79f6, 0x362448b7, 0x1d091b74, 0x04122a35,
+  0x4b53bcf2, 0x52488db3, 0x7965de70, 0x607eef31,
+  0xe7e6f3fe, 0xfefdc2bf, 0xd5d0917c, 0xcccba03d,
+  0x838a36fa, 0x9a9107bb, 0xb1bc5478, 0xa8a76539,
+  0x3b83984b, 0x2298a90a, 0x09b5fac9, 0x10aecb88,
+  0x5fef5d4f, 0x46f46c0e, 0x6dd93fcd, 0x74c20e8c,
+  0xf35a1243, 0xea412302, 0xc16c70c1, 0xd8774180,
+  0x9736d747, 0x8e2de606, 0xa500b5c5, 0xbc1b8484,
+  0x71418a1a, 0x685abb5b, 0x4377e898, 0x5a6cd9d9,
+  0x152d4f1e, 0x0c367e5f, 0x271b2d9c, 0x3e001cdd,
+  0xb9980012, 0xa0833153, 0x8bae6290, 0x92b553d1,
+  0xddf4c516, 0xc4eff457, 0xefc2a794, 0xf6d996d5,
+  0xae07bce9, 0xb71c8da8, 0x9c31de6b, 0x852aef2a,
+  0xca6b79ed, 0xd37048ac, 0xf85d1b6f, 0xe1462a2e,
+  0x66de36e1, 0x7fc507a0, 0x54e85463, 0x4df36522,
+  0x02b2f3e5, 0x1ba9c2a4, 0x30849167, 0x299fa026,
+  0xe4c5aeb8, 0xfdde9ff9, 0xd6f3cc3a, 0xcfe8fd7b,
+  0x80a96bbc, 0x99b25afd, 0xb29f093e, 0xab84387f,
+  0x2c1c24b0, 0x350715f1, 0x1e2a4632, 0x07317773,
+  0x4870e1b4, 0x516bd0f5, 0x7a468336, 0x635db277,
+  0xcbfad74e, 0xd2e1e60f, 0xf9ccb5cc, 0xe0d7848d,
+  0xaf96124a, 0xb68d230b, 0x9da070c8, 0x84bb4189,
+  0x03235d46, 0x1a386c07, 0x31153fc4, 0x280e0e85,
+  0x674f9842, 0x7e54a903, 0x5579fac0, 0x4c62cb81,
+  0x8138c51f, 0x9823f45e, 0xb30ea79d, 0xaa1596dc,
+  0xe554001b, 0xfc4f315a, 0xd7626299, 0xce7953d8,
+  0x49e14f17, 0x50fa7e56, 0x7bd72d95, 0x62cc1cd4,
+  0x2d8d8a13, 0x3496bb52, 0x1fbbe891, 0x06a0d9d0,
+  0x5e7ef3ec, 0x4765c2ad, 0x6c48916e, 0x7553a02f,
+  0x3a1236e8, 0x230907a9, 0x0824546a, 0x113f652b,
+  0x96a779e4, 0x8fbc48a5, 0xa4911b66, 0xbd8a2a27,
+  0xf2cbbce0, 0xebd08da1, 0xc0fdde62, 0xd9e6ef23,
+  0x14bce1bd, 0x0da7d0fc, 0x268a833f, 0x3f91b27e,
+  0x70d024b9, 0x69cb15f8, 0x42e6463b, 0x5bfd777a,
+  0xdc656bb5, 0xc57e5af4, 0xee530937, 0xf7483876,
+  0xb809aeb1, 0xa1129ff0, 0x8a3fcc33, 0x9324fd72,
+  /* Table 2. */
+  0x00000000, 0x01c26a37, 0x0384d46e, 0x0246be59,
+  0x0709a8dc, 0x06cbc2eb, 0x048d7cb2, 0x054f1685,
+  0x0e1351b8, 0x0fd13b8f, 0x0d9785d6, 0x0c55efe1,
+  0x091af964, 0x08d89353, 0x0a9e2d0a, 0x0b5c473d,
+  0x1c26a370, 0x1de4c947, 0x1fa2771e, 0x1e601d29,
+  0x1b2f0bac, 0x1aed619b, 0x18abdfc2, 0x1969b5f5,
+  0x1235f2c8, 0x13f798ff, 0x11b126a6, 0x10734c91,
+  0x153c5a14, 0x14fe3023, 0x16b88e7a, 0x177ae44d,
+  0x384d46e0, 0x398f2cd7, 0x3bc9928e, 0x3a0bf8b9,
+  0x3f44ee3c, 0x3e86840b, 0x3cc03a52, 0x3d025065,
+  0x365e1758, 0x379c7d6f, 0x35dac336, 0x3418a901,
+  0x3157bf84, 0x3095d5b3, 0x32d36bea, 0x331101dd,
+  0x246be590, 0x25a98fa7, 0x27ef31fe, 0x262d5bc9,
+  0x23624d4c, 0x22a0277b, 0x20e69922, 0x2124f315,
+  0x2a78b428, 0x2bbade1f, 0x29fc6046, 0x283e0a71,
+  0x2d711cf4, 0x2cb376c3, 0x2ef5c89a, 0x2f37a2ad,
+  0x709a8dc0, 0x7158e7f7, 0x731e59ae, 0x72dc3399,
+  0x7793251c, 0x76514f2b, 0x7417f172, 0x75d59b45,
+  0x7e89dc78, 0x7f4bb64f, 0x7d0d0816, 0x7ccf6221,
+  0x798074a4, 0x78421e93, 0x7a04a0ca, 0x7bc6cafd,
+  0x6cbc2eb0, 0x6d7e4487, 0x6f38fade, 0x6efa90e9,
+  0x6bb5866c, 0x6a77ec5b, 0x68315202, 0x69f33835,
+  0x62af7f08, 0x636d153f, 0x612bab66, 0x60e9c151,
+  0x65a6d7d4, 0x6464bde3, 0x662203ba, 0x67e0698d,
+  0x48d7cb20, 0x4915a117, 0x4b531f4e, 0x4a917579,
+  0x4fde63fc, 0x4e1c09cb, 0x4c5ab792, 0x4d98dda5,
+  0x46c49a98, 0x4706f0af, 0x45404ef6, 0x448224c1,
+  0x41cd3244, 0x400f5873, 0x4249e62a, 0x438b8c1d,
+  0x54f16850, 0x55330267, 0x5775bc3e, 0x56b7d609,
+  0x53f8c08c, 0x523aaabb, 0x507c14e2, 0x51be7ed5,
+  0x5ae239e8, 0x5b2053df, 0x5966ed86, 0x58a487b1,
+  0x5deb9134, 0x5c29fb03, 0x5e6f455a, 0x5fad2f6d,
+  0xe1351b80, 0xe0f771b7, 0xe2b1cfee, 0xe373a5d9,
+  0xe63cb35c, 0xe7fed96b, 0xe5b86732, 0xe47a0d05,
+  0xef264a38, 0xeee4200f, 0xeca29e56, 0xed60f461,
+  0xe82fe2e4, 0xe9ed88d3, 0xebab368a, 0xea695cbd,
+  0xfd13b8f0, 0xfcd1d2c7, 0xfe976c9e, 0xff5506a9,
+  0xfa1a102c, 0xfbd87a1b, 0xf99ec442, 0xf85cae75,
+  0xf300e948, 0xf2c2837f, 0xf0843d26, 0xf1465711,
+  0xf4094194, 0xf5cb2ba3, 0xf78d95fa, 0xf64fffcd,
+  0xd9785d60, 0xd8ba3757, 0xdafc890e, 0xdb3ee339,
+  0xde71f5bc, 0xdfb39f8b, 0xddf521d2, 0xdc374be5,
+  0xd76b0cd8, 0xd6a966ef, 0xd4efd8b6, 0xd52db281,
+  0xd062a404, 0xd1a0ce33, 0xd3e6706a, 0xd2241a5d,
+  0xc55efe10, 0xc49c9427, 0xc6da2a7e, 0xc7184049,
+  0xc25756cc, 0xc3953cfb, 0xc1d382a2, 0xc011e895,
+  0xcb4dafa8, 0xca8fc59f, 0xc8c97bc6, 0xc90b11f1,
+  0xcc440774, 0xcd866d43, 0xcfc0d31a, 0xce02b92d,
+  0x91af9640, 0x906dfc77, 0x922b422e, 0x93e92819,
+  0x96a63e9c, 0x976454ab, 0x9522eaf2, 0x94e080c5,
+  0x9fbcc7f8, 0x9e7eadcf, 0x9c381396, 0x9dfa79a1,
+  0x98b56f24, 0x99770513, 0x9b31bb4a, 0x9af3d17d,
+  0x8d893530, 0x8c4b5f07, 0x8e0de15e, 0x8fcf8b69,
+  0x8a809dec, 0x8b42f7db, 0x89044982, 0x88c623b5,
+  0x839a6488, 0x82580ebf, 0x801eb0e6, 0x81dcdad1,
+  0x8493cc54, 0x8551a663, 0x8717183a, 0x86d5720d,
+  0xa9e2d0a0, 0xa820ba97, 0xaa6604ce, 0xaba46ef9,
+  0xaeeb787c, 0xaf29124b, 0xad6fac12, 0xacadc625,
+  0xa7f18118, 0xa633eb2f, 0xa4755576, 0xa5b73f41,
+  0xa0f829c4, 0xa13a43f3, 0xa37cfdaa, 0xa2be979d,
+  0xb5c473d0, 0xb40619e7, 0xb640a7be, 0xb782cd89,
+  0xb2cddb0c, 0xb30fb13b, 0xb1490f62, 0xb08b6555,
+  0xbbd72268, 0xba15485f, 0xb853f606, 0xb9919c31,
+  0xbcde8ab4, 0xbd1ce083, 0xbf5a5eda, 0xbe9834ed,
+  /* Table 3. */
+  0x00000000, 0xb8bc6765, 0xaa09c88b, 0x12b5afee,
+  0x8f629757, 0x37def032, 0x256b5fdc, 0x9dd738b9,
+  0xc5b428ef, 0x7d084f8a, 0x6fbde064, 0xd7018701,
+  0x4ad6bfb8, 0xf26ad8dd, 0xe0df7733, 0x58631056,
+  0x5019579f, 0xe8a530fa, 0xfa109f14, 0x42acf871,
+  0xdf7bc0c8, 0x67c7a7ad, 0x75720843, 0xcdce6f26,
+  0x95ad7f70, 0x2d111815, 0x3fa4b7fb, 0x8718d09e,
+  0x1acfe827, 0xa2738f42, 0xb0c620ac, 0x087a47c9,
+  0xa032af3e, 0x188ec85b, 0x0a3b67b5, 0xb28700d0,
+  0x2f503869, 0x97ec5f0c, 0x8559f0e2, 0x3de59787,
+  0x658687d1, 0xdd3ae0b4, 0xcf8f4f5a, 0x7733283f,
+  0xeae41086, 0x525877e3, 0x40edd80d, 0xf851bf68,
+  0xf02bf8a1, 0x48979fc4, 0x5a22302a, 0xe29e574f,
+  0x7f496ff6, 0xc7f50893, 0xd540a77d, 0x6dfcc018,
+  0x359fd04e, 0x8d23b72b, 0x9f9618c5, 0x272a7fa0,
+  0xbafd4719, 0x0241207c, 0x10f48f92, 0xa848e8f7,
+  0x9b14583d, 0x23a83f58, 0x311d90b6, 0x89a1f7d3,
+  0x1476cf6a, 0xaccaa80f, 0xbe7f07e1, 0x06c36084,
+  0x5ea070d2, 0xe61c17b7, 0xf4a9b859, 0x4c15df3c,
+  0xd1c2e785, 0x697e80e0, 0x7bcb2f0e, 0xc377486b,
+  0xcb0d0fa2, 0x73b168c7, 0x6104c729, 0xd9b8a04c,
+  0x446f98f5, 0xfcd3ff90, 0xee66507e, 0x56da371b,
+  0x0eb9274d, 0xb6054028, 0xa4b0efc6, 0x1c0c88a3,
+  0x81dbb01a, 0x3967d77f, 0x2bd27891, 0x936e1ff4,
+  0x3b26f703, 0x839a9066, 0x912f3f88, 0x299358ed,
+  0xb4446054, 0x0cf80731, 0x1e4da8df, 0xa6f1cfba,
+  0xfe92dfec, 0x462eb889, 0x549b1767, 0xec277002,
+  0x71f048bb, 0xc94c2fde, 0xdbf98030, 0x6345e755,
+  0x6b3fa09c, 0xd383c7f9, 0xc1366817, 0x798a0f72,
+  0xe45d37cb, 0x5ce150ae, 0x4e54ff40, 0xf6e89825,
+  0xae8b8873, 0x1637ef16, 0x048240f8, 0xbc3e279d,
+  0x21e91f24, 0x99557841, 0x8be0d7af, 0x335cb0ca,
+  0xed59b63b, 0x55e5d15e, 0x47507eb0, 0xffec19d5,
+  0x623b216c, 0xda874609, 0xc832e9e7, 0x708e8e82,
+  0x28ed9ed4, 0x9051f9b1, 0x82e4565f, 0x3a58313a,
+  0xa78f0983, 0x1f336ee6, 0x0d86c108, 0xb53aa66d,
+  0xbd40e1a4, 0x05fc86c1, 0x1749292f, 0xaff54e4a,
+  0x322276f3, 0x8a9e1196, 0x982bbe78, 0x2097d91d,
+  0x78f4c94b, 0xc048ae2e, 0xd2fd01c0, 0x6a4166a5,
+  0xf7965e1c, 0x4f2a3979, 0x5d9f9697, 0xe523f1f2,
+  0x4d6b1905, 0xf5d77e60, 0xe762d18e, 0x5fdeb6eb,
+  0xc2098e52, 0x7ab5e937, 0x680046d9, 0xd0bc21bc,
+  0x88df31ea, 0x3063568f, 0x22d6f961, 0x9a6a9e04,
+  0x07bda6bd, 0xbf01c1d8, 0xadb46e36, 0x15080953,
+  0x1d724e9a, 0xa5ce29ff, 0xb77b8611, 0x0fc7e174,
+  0x9210d9cd, 0x2aacbea8, 0x38191146, 0x80a57623,
+  0xd8c66675, 0x607a0110, 0x72cfaefe, 0xca73c99b,
+  0x57a4f122, 0xef189647, 0xfdad39a9, 0x45115ecc,
+  0x764dee06, 0xcef18963, 0xdc44268d, 0x64f841e8,
+  0xf92f7951, 0x41931e34, 0x5326b1da, 0xeb9ad6bf,
+  0xb3f9c6e9, 0x0b45a18c, 0x19f00e62, 0xa14c6907,
+  0x3c9b51be, 0x842736db, 0x96929935, 0x2e2efe50,
+  0x2654b999, 0x9ee8defc, 0x8c5d7112, 0x34e11677,
+  0xa9362ece, 0x118a49ab, 0x033fe645, 0xbb838120,
+  0xe3e09176, 0x5b5cf613, 0x49e959fd, 0xf1553e98,
+  0x6c820621, 0xd43e6144, 0xc68bceaa, 0x7e37a9cf,
+  0xd67f4138, 0x6ec3265d, 0x7c7689b3, 0xc4caeed6,
+  0x591dd66f, 0xe1a1b10a, 0xf3141ee4, 0x4ba87981,
+  0x13cb69d7, 0xab770eb2, 0xb9c2a15c, 0x017ec639,
+  0x9ca9fe80, 0x241599e5, 0x36a0360b, 0x8e1c516e,
+  0x866616a7, 0x3eda71c2, 0x2c6fde2c, 0x94d3b949,
+  0x090481f0, 0xb1b8e695, 0xa30d497b, 0x1bb12e1e,
+  0x43d23e48, 0xfb6e592d, 0xe9dbf6c3, 0x516791a6,
+  0xccb0a91f, 0x740cce7a, 0x66b96194, 0xde0506f1,
+#endif
+#if CRCSW_SLICING >= 8
+  /* Table 4. */
+  0x00000000, 0x3d6029b0, 0x7ac05360, 0x47a07ad0,
+  0xf580a6c0, 0xc8e08f70, 0x8f40f5a0, 0xb220dc10,
+  0x30704bc1, 0x0d106271, 0x4ab018a1, 0x77d03111,
+  0xc5f0ed01, 0xf890c4b1, 0xbf30be61, 0x825097d1,
+  0x60e09782, 0x5d80be32, 0x1a20c4e2, 0x2740ed52,
+  0x95603142, 0xa80018f2, 0xefa06222, 0xd2c04b92,
+  0x5090dc43, 0x6df0f5f3, 0x2a508f23, 0x1730a693,
+  0xa5107a83, 0x98705333, 0xdfd029e3, 0xe2b00053,
+  0xc1c12f04, 0xfca106b4, 0xbb017c64, 0x866155d4,
+  0x344189c4, 0x0921a074, 0x4e81daa4, 0x73e1f314,
+  0xf1b164c5, 0xccd14d75, 0x8b7137a5, 0xb6111e15,
+  0x0431c205, 0x3951ebb5, 0x7ef19165, 0x4391b8d5,
+  0xa121b886, 0x9c419136, 0xdbe1ebe6, 0xe681c256,
+  0x54a11e46, 0x69c137f6, 0x2e614d26, 0x13016496,
+  0x9151f347, 0xac31daf7, 0xeb91a027, 0xd6f18997,
+  0x64d15587, 0x59b17c37, 0x1e1106e7, 0x23712f57,
+  0x58f35849, 0x659371f9, 0x22330b29, 0x1f532299,
+  0xad73fe89, 0x9013d739, 0xd7b3ade9, 0xead38459,
+  0x68831388, 0x55e33a38, 0x124340e8, 0x2f236958,
+  0x9d03b548, 0xa0639cf8, 0xe7c3e628, 0xdaa3cf98,
+  0x3813cfcb, 0x0573e67b, 0x42d39cab, 0x7fb3b51b,
+  0xcd93690b, 0xf0f340bb, 0xb7533a6b, 0x8a3313db,
+  0x0863840a, 0x3503adba, 0x72a3d76a, 0x4fc3feda,
+  0xfde322ca, 0xc0830b7a, 0x872371aa, 0xba43581a,
+  0x9932774d, 0xa4525efd, 0xe3f2242d, 0xde920d9d,
+  0x6cb2d18d, 0x51d2f83d, 0x167282ed, 0x2b12ab5d,
+  0xa9423c8c, 0x9422153c, 0xd3826fec, 0xeee2465c,
+  0x5cc29a4c, 0x61a2b3fc, 0x2602c92c, 0x1b62e09c,
+  0xf9d2e0cf, 0xc4b2c97f, 0x8312b3af, 0xbe729a1f,
+  0x0c52460f, 0x31326fbf, 0x7692156f, 0x4bf23cdf,
+  0xc9a2ab0e, 0xf4c282be, 0xb362f86e, 0x8e02d1de,
+  0x3c220dce, 0x0142247e, 0x46e25eae, 0x7b82771e,
+  0xb1e6b092, 0x8c869922, 0xcb26e3f2, 0xf646ca42,
+  0x44661652, 0x79063fe2, 0x3ea64532, 0x03c66c82,
+  0x8196fb53, 0xbcf6d2e3, 0xfb56a833, 0xc6368183,
+  0x74165d93, 0x49767423, 0x0ed60ef3, 0x33b62743,
+  0xd1062710, 0xec660ea0, 0xabc67470, 0x96a65dc0,
+  0x248681d0, 0x19e6a860, 0x5e46d2b0, 0x6326fb00,
+  0xe1766cd1, 0xdc164561, 0x9bb63fb1, 0xa6d61601,
+  0x14f6ca11, 0x2996e3a1, 0x6e369971, 0x5356b0c1,
+  0x70279f96, 0x4d47b626, 0x0ae7ccf6, 0x3787e546,
+  0x85a73956, 0xb8c710e6, 0xff676a36, 0xc2074386,
+  0x4057d457, 0x7d37fde7, 0x3a978737, 0x07f7ae87,
+  0xb5d77297, 0x88b75b27, 0xcf1721f7, 0xf2770847,
+  0x10c70814, 0x2da721a4, 0x6a075b74, 0x576772c4,
+  0xe547aed4, 0xd8278764, 0x9f87fdb4, 0xa2e7d404,
+  0x20b743d5, 0x1dd76a65, 0x5a7710b5, 0x67173905,
+  0xd537e515, 0xe857cca5, 0xaff7b675, 0x92979fc5,
+  0xe915e8db, 0xd475c16b, 0x93d5bbbb, 0xaeb5920b,
+  0x1c954e1b, 0x21f567ab, 0x66551d7b, 0x5b3534cb,
+  0xd965a31a, 0xe4058aaa, 0xa3a5f07a, 0x9ec5d9ca,
+  0x2ce505da, 0x11852c6a, 0x562556ba, 0x6b457f0a,
+  0x89f57f59, 0xb49556e9, 0xf3352c39, 0xce550589,
+  0x7c75d999, 0x4115f029, 0x06b58af9, 0x3bd5a349,
+  0xb9853498, 0x84e51d28, 0xc34567f8, 0xfe254e48,
+  0x4c059258, 0x7165bbe8, 0x36c5c138, 0x0ba5e888,
+  0x28d4c7df, 0x15b4ee6f, 0x521494bf, 0x6f74bd0f,
+  0xdd54611f, 0xe03448af, 0xa794327f, 0x9af41bcf,
+  0x18a48c1e, 0x25c4a5ae, 0x6264df7e, 0x5f04f6ce,
+  0xed242ade, 0xd044036e, 0x97e479be, 0xaa84500e,
+  0x4834505d, 0x755479ed, 0x32f4033d, 0x0f942a8d,
+  0xbdb4f69d, 0x80d4df2d, 0xc774a5fd, 0xfa148c4d,
+  0x78441b9c, 0x4524322c, 0x028448fc, 0x3fe4614c,
+  0x8dc4bd5c, 0xb0a494ec, 0xf704ee3c, 0xca64c78c,
+  /* Table 5. */
+  0x00000000, 0xcb5cd3a5, 0x4dc8a10b, 0x869472ae,
+  0x9b914216, 0x50cd91b3, 0xd659e31d, 0x1d0530b8,
+  0xec53826d, 0x270f51c8, 0xa19b2366, 0x6ac7f0c3,
+  0x77c2c07b, 0xbc9e13de, 0x3a0a6170, 0xf156b2d5,
+  0x03d6029b, 0xc88ad13e, 0x4e1ea390, 0x85427035,
+  0x9847408d, 0x531b9328, 0xd58fe186, 0x1ed33223,
+  0xef8580f6, 0x24d95353, 0xa24d21fd, 0x6911f258,
+  0x7414c2e0, 0xbf481145, 0x39dc63eb, 0xf280b04e,
+  0x07ac0536, 0xccf0d693, 0x4a64a43d, 0x81387798,
+  0x9c3d4720, 0x57619485, 0xd1f5e62b, 0x1aa9358e,
+  0xebff875b, 0x20a354fe, 0xa6372650, 0x6d6bf5f5,
+  0x706ec54d, 0xbb3216e8, 0x3da66446, 0xf6fab7e3,
+  0x047a07ad, 0xcf26d408, 0x49b2a6a6, 0x82ee7503,
+  0x9feb45bb, 0x54b7961e, 0xd223e4b0, 0x197f3715,
+  0xe82985c0, 0x23755665, 0xa5e124cb, 0x6ebdf76e,
+  0x73b8c7d6, 0xb8e41473, 0x3e7066dd, 0xf52cb578,
+  0x0f580a6c, 0xc404d9c9, 0x4290ab67, 0x89cc78c2,
+  0x94c9487a, 0x5f959bdf, 0xd901e971, 0x125d3ad4,
+  0xe30b8801, 0x28575ba4, 0xaec3290a, 0x659ffaaf,
+  0x789aca17, 0xb3c619b2, 0x35526b1c, 0xfe0eb8b9,
+  0x0c8e08f7, 0xc7d2db52, 0x4146a9fc, 0x8a1a7a59,
+  0x971f4ae1, 0x5c439944, 0xdad7ebea, 0x118b384f,
+  0xe0dd8a9a, 0x2b81593f, 0xad152b91, 0x6649f834,
+  0x7b4cc88c, 0xb0101b29, 0x36846987, 0xfdd8ba22,
+  0x08f40f5a, 0xc3a8dcff, 0x453cae51, 0x8e607df4,
+  0x93654d4c, 0x58399ee9, 0xdeadec47, 0x15f13fe2,
+  0xe4a78d37, 0x2ffb5e92, 0xa96f2c3c, 0x6233ff99,
+  0x7f36cf21, 0xb46a1c84, 0x32fe6e2a, 0xf9a2bd8f,
+  0x0b220dc1, 0xc07ede64, 0x46eaacca, 0x8db67f6f,
+  0x90b34fd7, 0x5bef9c72, 0xdd7beedc, 0x16273d79,
+  0xe7718fac, 0x2c2d5c09, 0xaab92ea7, 0x61e5fd02,
+  0x7ce0cdba, 0xb7bc1e1f, 0x31286cb1, 0xfa74bf14,
+  0x1eb014d8, 0xd5ecc77d, 0x5378b5d3, 0x98246676,
+  0x852156ce, 0x4e7d856b, 0xc8e9f7c5, 0x03b52460,
+  0xf2e396b5, 0x39bf4510, 0xbf2b37be, 0x7477e41b,
+  0x6972d4a3, 0xa22e0706, 0x24ba75a8, 0xefe6a60d,
+  0x1d661643, 0xd63ac5e6, 0x50aeb748, 0x9bf264ed,
+  0x86f75455, 0x4dab87f0, 0xcb3ff55e, 0x006326fb,
+  0xf135942e, 0x3a69478b, 0xbcfd3525, 0x77a1e680,
+  0x6aa4d638, 0xa1f8059d, 0x276c7733, 0xec30a496,
+  0x191c11ee, 0xd240c24b, 0x54d4b0e5, 0x9f886340,
+  0x828d53f8, 0x49d1805d, 0xcf45f2f3, 0x04192156,
+  0xf54f9383, 0x3e134026, 0xb8873288, 0x73dbe12d,
+  0x6eded195, 0xa5820230, 0x2316709e, 0xe84aa33b,
+  0x1aca1375, 0xd196c0d0, 0x5702b27e, 0x9c5e61db,
+  0x815b5163, 0x4a0782c6, 0xcc93f068, 0x07cf23cd,
+  0xf6999118, 0x3dc542bd, 0xbb513013, 0x700de3b6,
+  0x6d08d30e, 0xa65400ab, 0x20c07205, 0xeb9ca1a0,
+  0x11e81eb4, 0xdab4cd11, 0x5c20bfbf, 0x977c6c1a,
+  0x8a795ca2, 0x41258f07, 0xc7b1fda9, 0x0ced2e0c,
+  0xfdbb9cd9, 0x36e74f7c, 0xb0733dd2, 0x7b2fee77,
+  0x662adecf, 0xad760d6a, 0x2be27fc4, 0xe0beac61,
+  0x123e1c2f, 0xd962cf8a, 0x5ff6bd24, 0x94aa6e81,
+  0x89af5e39, 0x42f38d9c, 0xc467ff32, 0x0f3b2c97,
+  0xfe6d9e42, 0x35314de7, 0xb3a53f49, 0x78f9ecec,
+  0x65fcdc54, 0xaea00ff1, 0x28347d5f, 0xe368aefa,
+  0x16441b82, 0xdd18c827, 0x5b8cba89, 0x90d0692c,
+  0x8dd55994, 0x46898a31, 0xc01df89f, 0x0b412b3a,
+  0xfa1799ef, 0x314b4a4a, 0xb7df38e4, 0x7c83eb41,
+  0x6186dbf9, 0xaada085c, 0x2c4e7af2, 0xe712a957,
+  0x15921919, 0xdececabc, 0x585ab812, 0x93066bb7,
+  0x8e035b0f, 0x455f88aa, 0xc3cbfa04, 0x089729a1,
+  0xf9c19b74, 0x329d48d1, 0xb4093a7f, 0x7f55e9da,
+  0x6250d962, 0xa90c0ac7, 0x2f987869, 0xe4c4abcc,
+  /* Table 6. */
+  0x00000000, 0xa6770bb4, 0x979f1129, 0x31e81a9d,
+  0xf44f2413, 0x52382fa7, 0x63d0353a, 0xc5a73e8e,
+  0x33ef4e67, 0x959845d3, 0xa4705f4e, 0x020754fa,
+  0xc7a06a74, 0x61d761c0, 0x503f7b5d, 0xf64870e9,
+  0x67de9cce, 0xc1a9977a, 0xf0418de7, 0x56368653,
+  0x9391b8dd, 0x35e6b369, 0x040ea9f4, 0xa279a240,
+  0x5431d2a9, 0xf246d91d, 0xc3aec380, 0x65d9c834,
+  0xa07ef6ba, 0x0609fd0e, 0x37e1e793, 0x9196ec27,
+  0xcfbd399c, 0x69ca3228, 0x582228b5, 0xfe552301,
+  0x3bf21d8f, 0x9d85163b, 0xac6d0ca6, 0x0a1a0712,
+  0xfc5277fb, 0x5a257c4f, 0x6bcd66d2, 0xcdba6d66,
+  0x081d53e8, 0xae6a585c, 0x9f8242c1, 0x39f54975,
+  0xa863a552, 0x0e14aee6, 0x3ffcb47b, 0x998bbfcf,
+  0x5c2c8141, 0xfa5b8af5, 0xcbb39068, 0x6dc49bdc,
+  0x9b8ceb35, 0x3dfbe081, 0x0c13fa1c, 0xaa64f1a8,
+  0x6fc3cf26, 0xc9b4c492, 0xf85cde0f, 0x5e2bd5bb,
+  0x440b7579, 0xe27c7ecd, 0xd3946450, 0x75e36fe4,
+  0xb044516a, 0x16335ade, 0x27db4043, 0x81ac4bf7,
+  0x77e43b1e, 0xd19330aa, 0xe07b2a37, 0x460c2183,
+  0x83ab1f0d, 0x25dc14b9, 0x14340e24, 0xb2430590,
+  0x23d5e9b7, 0x85a2e203, 0xb44af89e, 0x123df32a,
+  0xd79acda4, 0x71edc610, 0x4005dc8d, 0xe672d739,
+  0x103aa7d0, 0xb64dac64, 0x87a5b6f9, 0x21d2bd4d,
+  0xe47583c3, 0x42028877, 0x73ea92ea, 0xd59d995e,
+  0x8bb64ce5, 0x2dc14751, 0x1c295dcc, 0xba5e5678,
+  0x7ff968f6, 0xd98e6342, 0xe86679df, 0x4e11726b,
+  0xb8590282, 0x1e2e0936, 0x2fc613ab, 0x89b1181f,
+  0x4c162691, 0xea612d25, 0xdb8937b8, 0x7dfe3c0c,
+  0xec68d02b, 0x4a1fdb9f, 0x7bf7c102, 0xdd80cab6,
+  0x1827f438, 0xbe50ff8c, 0x8fb8e511, 0x29cfeea5,
+  0xdf879e4c, 0x79f095f8, 0x48188f65, 0xee6f84d1,
+  0x2bc8ba5f, 0x8dbfb1eb, 0xbc57ab76, 0x1a20a0c2,
+  0x8816eaf2, 0x2e61e146, 0x1f89fbdb, 0xb9fef06f,
+  0x7c59cee1, 0xda2ec555, 0xebc6dfc8, 0x4db1d47c,
+  0xbbf9a495, 0x1d8eaf21, 0x2c66b5bc, 0x8a11be08,
+  0x4fb68086, 0xe9c18b32, 0xd82991af, 0x7e5e9a1b,
+  0xefc8763c, 0x49bf7d88, 0x78576715, 0xde206ca1,
+  0x1b87522f, 0xbdf0599b, 0x8c184306, 0x2a6f48b2,
+  0xdc27385b, 0x7a5033ef, 0x4bb82972, 0xedcf22c6,
+  0x28681c48, 0x8e1f17fc, 0xbff70d61, 0x198006d5,
+  0x47abd36e, 0xe1dcd8da, 0xd034c247, 0x7643c9f3,
+  0xb3e4f77d, 0x1593fcc9, 0x247be654, 0x820cede0,
+  0x74449d09, 0xd23396bd, 0xe3db8c20, 0x45ac8794,
+  0x800bb91a, 0x267cb2ae, 0x1794a833, 0xb1e3a387,
+  0x20754fa0, 0x86024414, 0xb7ea5e89, 0x119d553d,
+  0xd43a6bb3, 0x724d6007, 0x43a57a9a, 0xe5d2712e,
+  0x139a01c7, 0xb5ed0a73, 0x840510ee, 0x22721b5a,
+  0xe7d525d4, 0x41a22e60, 0x704a34fd, 0xd63d3f49,
+  0xcc1d9f8b, 0x6a6a943f, 0x5b828ea2, 0xfdf58516,
+  0x3852bb98, 0x9e25b02c, 0xafcdaab1, 0x09baa105,
+  0xfff2d1ec, 0x5985da58, 0x686dc0c5, 0xce1acb71,
+  0x0bbdf5ff, 0xadcafe4b, 0x9c22e4d6, 0x3a55ef62,
+  0xabc30345, 0x0db408f1, 0x3c5c126c, 0x9a2b19d8,
+  0x5f8c2756, 0xf9fb2ce2, 0xc813367f, 0x6e643dcb,
+  0x982c4d22, 0x3e5b4696, 0x0fb35c0b, 0xa9c457bf,
+  0x6c636931, 0xca146285, 0xfbfc7818, 0x5d8b73ac,
+  0x03a0a617, 0xa5d7ada3, 0x943fb73e, 0x3248bc8a,
+  0xf7ef8204, 0x519889b0, 0x6070932d, 0xc6079899,
+  0x304fe870, 0x9638e3c4, 0xa7d0f959, 0x01a7f2ed,
+  0xc400cc63, 0x6277c7d7, 0x539fdd4a, 0xf5e8d6fe,
+  0x647e3ad9, 0xc209316d, 0xf3e12bf0, 0x55962044,
+  0x90311eca, 0x3646157e, 0x07ae0fe3, 0xa1d90457,
+  0x579174be, 0xf1e67f0a, 0xc00e6597, 0x66796e23,
+  0xa3de50ad, 0x05a95b19, 0x34414184, 0x92364a30,
+  /* Table 7. */
+  0x00000000, 0xccaa009e, 0x4225077d, 0x8e8f07e3,
+  0x844a0efa, 0x48e00e64, 0xc66f0987, 0x0ac50919,
+  0xd3e51bb5, 0x1f4f1b2b, 0x91c01cc8, 0x5d6a1c56,
+  0x57af154f, 0x9b0515d1, 0x158a1232, 0xd92012ac,
+  0x7cbb312b, 0xb01131b5, 0x3e9e3656, 0xf23436c8,
+  0xf8f13fd1, 0x345b3f4f, 0xbad438ac, 0x767e3832,
+  0xaf5e2a9e, 0x63f42a00, 0xed7b2de3, 0x21d12d7d,
+  0x2b142464, 0xe7be24fa, 0x69312319, 0xa59b2387,
+  0xf9766256, 0x35dc62c8, 0xbb53652b, 0x77f965b5,
+  0x7d3c6cac, 0xb1966c32, 0x3f196bd1, 0xf3b36b4f,
+  0x2a9379e3, 0xe639797d, 0x68b67e9e, 0xa41c7e00,
+  0xaed97719, 0x62737787, 0xecfc7064, 0x205670fa,
+  0x85cd537d, 0x496753e3, 0xc7e85400, 0x0b42549e,
+  0x01875d87, 0xcd2d5d19, 0x43a25afa, 0x8f085a64,
+  0x562848c8, 0x9a824856, 0x140d4fb5, 0xd8a74f2b,
+  0xd2624632, 0x1ec846ac, 0x9047414f, 0x5ced41d1,
+  0x299dc2ed, 0xe537c273, 0x6bb8c590, 0xa712c50e,
+  0xadd7cc17, 0x617dcc89, 0xeff2cb6a, 0x2358cbf4,
+  0xfa78d958, 0x36d2d9c6, 0xb85dde25, 0x74f7debb,
+  0x7e32d7a2, 0xb298d73c, 0x3c17d0df, 0xf0bdd041,
+  0x5526f3c6, 0x998cf358, 0x1703f4bb, 0xdba9f425,
+  0xd16cfd3c, 0x1dc6fda2, 0x9349fa41, 0x5fe3fadf,
+  0x86c3e873, 0x4a69e8ed, 0xc4e6ef0e, 0x084cef90,
+  0x0289e689, 0xce23e617, 0x40ace1f4, 0x8c06e16a,
+  0xd0eba0bb, 0x1c41a025, 0x92cea7c6, 0x5e64a758,
+  0x54a1ae41, 0x980baedf, 0x1684a93c, 0xda2ea9a2,
+  0x030ebb0e, 0xcfa4bb90, 0x412bbc73, 0x8d81bced,
+  0x8744b5f4, 0x4beeb56a, 0xc561b289, 0x09cbb217,
+  0xac509190, 0x60fa910e, 0xee7596ed, 0x22df9673,
+  0x281a9f6a, 0xe4b09ff4, 0x6a3f9817, 0xa6959889,
+  0x7fb58a25, 0xb31f8abb, 0x3d908d58, 0xf13a8dc6,
+  0xfbff84df, 0x37558441, 0xb9da83a2, 0x7570833c,
+  0x533b85da, 0x9f918544, 0x111e82a7, 0xddb48239,
+  0xd7718b20, 0x1bdb8bbe, 0x95548c5d, 0x59fe8cc3,
+  0x80de9e6f, 0x4c749ef1, 0xc2fb9912, 0x0e51998c,
+  0x04949095, 0xc83e900b, 0x46b197e8, 0x8a1b9776,
+  0x2f80b4f1, 0xe32ab46f, 0x6da5b38c, 0xa10fb312,
+  0xabcaba0b, 0x6760ba95, 0xe9efbd76, 0x2545bde8,
+  0xfc65af44, 0x30cfafda, 0xbe40a839, 0x72eaa8a7,
+  0x782fa1be, 0xb485a120, 0x3a0aa6c3, 0xf6a0a65d,
+  0xaa4de78c, 0x66e7e712, 0xe868e0f1, 0x24c2e06f,
+  0x2e07e976, 0xe2ade9e8, 0x6c22ee0b, 0xa088ee95,
+  0x79a8fc39, 0xb502fca7, 0x3b8dfb44, 0xf727fbda,
+  0xfde2f2c3, 0x3148f25d, 0xbfc7f5be, 0x736df520,
+  0xd6f6d6a7, 0x1a5cd639, 0x94d3d1da, 0x5879d144,
+  0x52bcd85d, 0x9e16d8c3, 0x1099df20, 0xdc33dfbe,
+  0x0513cd12, 0xc9b9cd8c, 0x4736ca6f, 0x8b9ccaf1,
+  0x8159c3e8, 0x4df3c376, 0xc37cc495, 0x0fd6c40b,
+  0x7aa64737, 0xb60c47a9, 0x3883404a, 0xf42940d4,
+  0xfeec49cd, 0x32464953, 0xbcc94eb0, 0x70634e2e,
+  0xa9435c82, 0x65e95c1c, 0xeb665bff, 0x27cc5b61,
+  0x2d095278, 0xe1a352e6, 0x6f2c5505, 0xa386559b,
+  0x061d761c, 0xcab77682, 0x44387161, 0x889271ff,
+  0x825778e6, 0x4efd7878, 0xc0727f9b, 0x0cd87f05,
+  0xd5f86da9, 0x19526d37, 0x97dd6ad4, 0x5b776a4a,
+  0x51b26353, 0x9d1863cd, 0x1397642e, 0xdf3d64b0,
+  0x83d02561, 0x4f7a25ff, 0xc1f5221c, 0x0d5f2282,
+  0x079a2b9b, 0xcb302b05, 0x45bf2ce6, 0x89152c78,
+  0x50353ed4, 0x9c9f3e4a, 0x121039a9, 0xdeba3937,
+  0xd47f302e, 0x18d530b0, 0x965a3753, 0x5af037cd,
+  0xff6b144a, 0x33c114d4, 0xbd4e1337, 0x71e413a9,
+  0x7b211ab0, 0xb78b1a2e, 0x39041dcd, 0xf5ae1d53,
+  0x2c8e0fff, 0xe0240f61, 0x6eab0882, 0xa201081c,
+  0xa8c40105, 0x646e019b, 0xeae10678, 0x264b06e6,
+#endif
 };
 #endif
 
 #if CRCSW_CRC16_TABLE || defined(__DOXYGEN__)
-static const uint32_t crc16_table[256] = {
+static const uint32_t crc16_table[256 * CRCSW_SLICING] = {
+  /* Table 0. */
   0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
   0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
   0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
@@ -140,7 +605,242 @@ static const uint32_t crc16_table[256] = {
   0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
   0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
   0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
-  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+#if CRCSW_SLICING >= 4
+  /* Table 1. */
+  0x0000, 0x9001, 0x6001, 0xF000, 0xC002, 0x5003, 0xA003, 0x3002,
+  0xC007, 0x5006, 0xA006, 0x3007, 0x0005, 0x9004, 0x6004, 0xF005,
+  0xC00D, 0x500C, 0xA00C, 0x300D, 0x000F, 0x900E, 0x600E, 0xF00F,
+  0x000A, 0x900B, 0x600B, 0xF00A, 0xC008, 0x5009, 0xA009, 0x3008,
+  0xC019, 0x5018, 0xA018, 0x3019, 0x001B, 0x901A, 0x601A, 0xF01B,
+  0x001E, 0x901F, 0x601F, 0xF01E, 0xC01C, 0x501D, 0xA01D, 0x301C,
+  0x0014, 0x9015, 0x6015, 0xF014, 0xC016, 0x5017, 0xA017, 0x3016,
+  0xC013, 0x5012, 0xA012, 0x3013, 0x0011, 0x9010, 0x6010, 0xF011,
+  0xC031, 0x5030, 0xA030, 0x3031, 0x0033, 0x9032, 0x6032, 0xF033,
+  0x0036, 0x9037, 0x6037, 0xF036, 0xC034, 0x5035, 0xA035, 0x3034,
+  0x003C, 0x903D, 0x603D, 0xF03C, 0xC03E, 0x503F, 0xA03F, 0x303E,
+  0xC03B, 0x503A, 0xA03A, 0x303B, 0x0039, 0x9038, 0x6038, 0xF039,
+  0x0028, 0x9029, 0x6029, 0xF028, 0xC02A, 0x502B, 0xA02B, 0x302A,
+  0xC02F, 0x502E, 0xA02E, 0x302F, 0x002D, 0x902C, 0x602C, 0xF02D,
+  0xC025, 0x5024, 0xA024, 0x3025, 0x0027, 0x9026, 0x6026, 0xF027,
+  0x0022, 0x9023, 0x6023, 0xF022, 0xC020, 0x5021, 0xA021, 0x3020,
+  0xC061, 0x5060, 0xA060, 0x3061, 0x0063, 0x9062, 0x6062, 0xF063,
+  0x0066, 0x9067, 0x6067, 0xF066, 0xC064, 0x5065, 0xA065, 0x3064,
+  0x006C, 0x906D, 0x606D, 0xF06C, 0xC06E, 0x506F, 0xA06F, 0x306E,
+  0xC06B, 0x506A, 0xA06A, 0x306B, 0x0069, 0x9068, 0x6068, 0xF069,
+  0x0078, 0x9079, 0x6079, 0xF078, 0xC07A, 0x507B, 0xA07B, 0x307A,
+  0xC07F, 0x507E, 0xA07E, 0x307F, 0x007D, 0x907C, 0x607C, 0xF07D,
+  0xC075, 0x5074, 0xA074, 0x3075, 0x0077, 0x9076, 0x6076, 0xF077,
+  0x0072, 0x9073, 0x6073, 0xF072, 0xC070, 0x5071, 0xA071, 0x3070,
+  0x0050, 0x9051, 0x6051, 0xF050, 0xC052, 0x5053, 0xA053, 0x3052,
+  0xC057, 0x5056, 0xA056, 0x3057, 0x0055, 0x9054, 0x6054, 0xF055,
+  0xC05D, 0x505C, 0xA05C, 0x305D, 0x005F, 0x905E, 0x605E, 0xF05F,
+  0x005A, 0x905B, 0x605B, 0xF05A, 0xC058, 0x5059, 0xA059, 0x3058,
+  0xC049, 0x5048, 0xA048, 0x3049, 0x004B, 0x904A, 0x604A, 0xF04B,
+  0x004E, 0x904F, 0x604F, 0xF04E, 0xC04C, 0x504D, 0xA04D, 0x304C,
+  0x0044, 0x9045, 0x6045, 0xF044, 0xC046, 0x5047, 0xA047, 0x3046,
+  0xC043, 0x5042, 0xA042, 0x3043, 0x0041, 0x9040, 0x6040, 0xF041,
+  /* Table 2. */
+  0x0000, 0xC051, 0xC0A1, 0x00F0, 0xC141, 0x0110, 0x01E0, 0xC1B1,
+  0xC281, 0x02D0, 0x0220, 0xC271, 0x03C0, 0xC391, 0xC361, 0x0330,
+  0xC501, 0x0550, 0x05A0, 0xC5F1, 0x0440, 0xC411, 0xC4E1, 0x04B0,
+  0x0780, 0xC7D1, 0xC721, 0x0770, 0xC6C1, 0x0690, 0x0660, 0xC631,
+  0xCA01, 0x0A50, 0x0AA0, 0xCAF1, 0x0B40, 0xCB11, 0xCBE1, 0x0BB0,
+  0x0880, 0xC8D1, 0xC821, 0x0870, 0xC9C1, 0x0990, 0x0960, 0xC931,
+  0x0F00, 0xCF51, 0xCFA1, 0x0FF0, 0xCE41, 0x0E10, 0x0EE0, 0xCEB1,
+  0xCD81, 0x0DD0, 0x0D20, 0xCD71, 0x0CC0, 0xCC91, 0xCC61, 0x0C30,
+  0xD401, 0x1450, 0x14A0, 0xD4F1, 0x1540, 0xD511, 0xD5E1, 0x15B0,
+  0x1680, 0xD6D1, 0xD621, 0x1670, 0xD7C1, 0x1790, 0x1760, 0xD731,
+  0x1100, 0xD151, 0xD1A1, 0x11F0, 0xD041, 0x1010, 0x10E0, 0xD0B1,
+  0xD381, 0x13D0, 0x1320, 0xD371, 0x12C0, 0xD291, 0xD261, 0x1230,
+  0x1E00, 0xDE51, 0xDEA1, 0x1EF0, 0xDF41, 0x1F10, 0x1FE0, 0xDFB1,
+  0xDC81, 0x1CD0, 0x1C20, 0xDC71, 0x1DC0, 0xDD91, 0xDD61, 0x1D30,
+  0xDB01, 0x1B50, 0x1BA0, 0xDBF1, 0x1A40, 0xDA11, 0xDAE1, 0x1AB0,
+  0x1980, 0xD9D1, 0xD921, 0x1970, 0xD8C1, 0x1890, 0x1860, 0xD831,
+  0xE801, 0x2850, 0x28A0, 0xE8F1, 0x2940, 0xE911, 0xE9E1, 0x29B0,
+  0x2A80, 0xEAD1, 0xEA21, 0x2A70, 0xEBC1, 0x2B90, 0x2B60, 0xEB31,
+  0x2D00, 0xED51, 0xEDA1, 0x2DF0, 0xEC41, 0x2C10, 0x2CE0, 0xECB1,
+  0xEF81, 0x2FD0, 0x2F20, 0xEF71, 0x2EC0, 0xEE91, 0xEE61, 0x2E30,
+  0x2200, 0xE251, 0xE2A1, 0x22F0, 0xE341, 0x2310, 0x23E0, 0xE3B1,
+  0xE081, 0x20D0, 0x2020, 0xE071, 0x21C0, 0xE191, 0xE161, 0x2130,
+  0xE701, 0x2750, 0x27A0, 0xE7F1, 0x2640, 0xE611, 0xE6E1, 0x26B0,
+  0x2580, 0xE5D1, 0xE521, 0x2570, 0xE4C1, 0x2490, 0x2460, 0xE431,
+  0x3C00, 0xFC51, 0xFCA1, 0x3CF0, 0xFD41, 0x3D10, 0x3DE0, 0xFDB1,
+  0xFE81, 0x3ED0, 0x3E20, 0xFE71, 0x3FC0, 0xFF91, 0xFF61, 0x3F30,
+  0xF901, 0x3950, 0x39A0, 0xF9F1, 0x3840, 0xF811, 0xF8E1, 0x38B0,
+  0x3B80, 0xFBD1, 0xFB21, 0x3B70, 0xFAC1, 0x3A90, 0x3A60, 0xFA31,
+  0xF601, 0x3650, 0x36A0, 0xF6F1, 0x3740, 0xF711, 0xF7E1, 0x37B0,
+  0x3480, 0xF4D1, 0xF421, 0x3470, 0xF5C1, 0x3590, 0x3560, 0xF531,
+  0x3300, 0xF351, 0xF3A1, 0x33F0, 0xF241, 0x3210, 0x32E0, 0xF2B1,
+  0xF181, 0x31D0, 0x3120, 0xF171, 0x30C0, 0xF091, 0xF061, 0x3030,
+  /* Table 3. */
+  0x0000, 0xFC01, 0xB801, 0x4400, 0x3001, 0xCC00, 0x8800, 0x7401,
+  0x6002, 0x9C03, 0xD803, 0x2402, 0x5003, 0xAC02, 0xE802, 0x1403,
+  0xC004, 0x3C05, 0x7805, 0x8404, 0xF005, 0x0C04, 0x4804, 0xB405,
+  0xA006, 0x5C07, 0x1807, 0xE406, 0x9007, 0x6C06, 0x2806, 0xD407,
+  0xC00B, 0x3C0A, 0x780A, 0x840B, 0xF00A, 0x0C0B, 0x480B, 0xB40A,
+  0xA009, 0x5C08, 0x1808, 0xE409, 0x9008, 0x6C09, 0x2809, 0xD408,
+  0x000F, 0xFC0E, 0xB80E, 0x440F, 0x300E, 0xCC0F, 0x880F, 0x740E,
+  0x600D, 0x9C0C, 0xD80C, 0x240D, 0x500C, 0xAC0D, 0xE80D, 0x140C,
+  0xC015, 0x3C14, 0x7814, 0x8415, 0xF014, 0x0C15, 0x4815, 0xB414,
+  0xA017, 0x5C16, 0x1816, 0xE417, 0x9016, 0x6C17, 0x2817, 0xD416,
+  0x0011, 0xFC10, 0xB810, 0x4411, 0x3010, 0xCC11, 0x8811, 0x7410,
+  0x6013, 0x9C12, 0xD812, 0x2413, 0x5012, 0xAC13, 0xE813, 0x1412,
+  0x001E, 0xFC1F, 0xB81F, 0x441E, 0x301F, 0xCC1E, 0x881E, 0x741F,
+  0x601C, 0x9C1D, 0xD81D, 0x241C, 0x501D, 0xAC1C, 0xE81C, 0x141D,
+  0xC01A, 0x3C1B, 0x781B, 0x841A, 0xF01B, 0x0C1A, 0x481A, 0xB41B,
+  0xA018, 0x5C19, 0x1819, 0xE418, 0x9019, 0x6C18, 0x2818, 0xD419,
+  0xC029, 0x3C28, 0x7828, 0x8429, 0xF028, 0x0C29, 0x4829, 0xB428,
+  0xA02B, 0x5C2A, 0x182A, 0xE42B, 0x902A, 0x6C2B, 0x282B, 0xD42A,
+  0x002D, 0xFC2C, 0xB82C, 0x442D, 0x302C, 0xCC2D, 0x882D, 0x742C,
+  0x602F, 0x9C2E, 0xD82E, 0x242F, 0x502E, 0xAC2F, 0xE82F, 0x142E,
+  0x0022, 0xFC23, 0xB823, 0x4422, 0x3023, 0xCC22, 0x8822, 0x7423,
+  0x6020, 0x9C21, 0xD821, 0x2420, 0x5021, 0xAC20, 0xE820, 0x1421,
+  0xC026, 0x3C27, 0x7827, 0x8426, 0xF027, 0x0C26, 0x4826, 0xB427,
+  0xA024, 0x5C25, 0x1825, 0xE424, 0x9025, 0x6C24, 0x2824, 0xD425,
+  0x003C, 0xFC3D, 0xB83D, 0x443C, 0x303D, 0xCC3C, 0x883C, 0x743D,
+  0x603E, 0x9C3F, 0xD83F, 0x243E, 0x503F, 0xAC3E, 0xE83E, 0x143F,
+  0xC038, 0x3C39, 0x7839, 0x8438, 0xF039, 0x0C38, 0x4838, 0xB439,
+  0xA03A, 0x5C3B, 0x183B, 0xE43A, 0x903B, 0x6C3A, 0x283A, 0xD43B,
+  0xC037, 0x3C36, 0x7836, 0x8437, 0xF036, 0x0C37, 0x4837, 0xB436,
+  0xA035, 0x5C34, 0x1834, 0xE435, 0x9034, 0x6C35, 0x2835, 0xD434,
+  0x0033, 0xFC32, 0xB832, 0x4433, 0x3032, 0xCC33, 0x8833, 0x7432,
+  0x6031, 0x9C30, 0xD830, 0x2431, 0x5030, 0xAC31, 0xE831, 0x1430,
+#endif
+#if CRCSW_SLICING >= 8
+  /* Table 4. */
+  0x0000, 0xC03D, 0xC079, 0x0044, 0xC0F1, 0x00CC, 0x0088, 0xC0B5,
+  0xC1E1, 0x01DC, 0x0198, 0xC1A5, 0x0110, 0xC12D, 0xC169, 0x0154,
+  0xC3C1, 0x03FC, 0x03B8, 0xC385, 0x0330, 0xC30D, 0xC349, 0x0374,
+  0x0220, 0xC21D, 0xC259, 0x0264, 0xC2D1, 0x02EC, 0x02A8, 0xC295,
+  0xC781, 0x07BC, 0x07F8, 0xC7C5, 0x0770, 0xC74D, 0xC709, 0x0734,
+  0x0660, 0xC65D, 0xC619, 0x0624, 0xC691, 0x06AC, 0x06E8, 0xC6D5,
+  0x0440, 0xC47D, 0xC439, 0x0404, 0xC4B1, 0x048C, 0x04C8, 0xC4F5,
+  0xC5A1, 0x059C, 0x05D8, 0xC5E5, 0x0550, 0xC56D, 0xC529, 0x0514,
+  0xCF01, 0x0F3C, 0x0F78, 0xCF45, 0x0FF0, 0xCFCD, 0xCF89, 0x0FB4,
+  0x0EE0, 0xCEDD, 0xCE99, 0x0EA4, 0xCE11, 0x0E2C, 0x0E68, 0xCE55,
+  0x0CC0, 0xCCFD, 0xCCB9, 0x0C84, 0xCC31, 0x0C0C, 0x0C48, 0xCC75,
+  0xCD21, 0x0D1C, 0x0D58, 0xCD65, 0x0DD0, 0xCDED, 0xCDA9, 0x0D94,
+  0x0880, 0xC8BD, 0xC8F9, 0x08C4, 0xC871, 0x084C, 0x0808, 0xC835,
+  0xC961, 0x095C, 0x0918, 0xC925, 0x0990, 0xC9AD, 0xC9E9, 0x09D4,
+  0xCB41, 0x0B7C, 0x0B38, 0xCB05, 0x0BB0, 0xCB8D, 0xCBC9, 0x0BF4,
+  0x0AA0, 0xCA9D, 0xCAD9, 0x0AE4, 0xCA51, 0x0A6C, 0x0A28, 0xCA15,
+  0xDE01, 0x1E3C, 0x1E78, 0xDE45, 0x1EF0, 0xDECD, 0xDE89, 0x1EB4,
+  0x1FE0, 0xDFDD, 0xDF99, 0x1FA4, 0xDF11, 0x1F2C, 0x1F68, 0xDF55,
+  0x1DC0, 0xDDFD, 0xDDB9, 0x1D84, 0xDD31, 0x1D0C, 0x1D48, 0xDD75,
+  0xDC21, 0x1C1C, 0x1C58, 0xDC65, 0x1CD0, 0xDCED, 0xDCA9, 0x1C94,
+  0x1980, 0xD9BD, 0xD9F9, 0x19C4, 0xD971, 0x194C, 0x1908, 0xD935,
+  0xD861, 0x185C, 0x1818, 0xD825, 0x1890, 0xD8AD, 0xD8E9, 0x18D4,
+  0xDA41, 0x1A7C, 0x1A38, 0xDA05, 0x1AB0, 0xDA8D, 0xDAC9, 0x1AF4,
+  0x1BA0, 0xDB9D, 0xDBD9, 0x1BE4, 0xDB51, 0x1B6C, 0x1B28, 0xDB15,
+  0x1100, 0xD13D, 0xD179, 0x1144, 0xD1F1, 0x11CC, 0x1188, 0xD1B5,
+  0xD0E1, 0x10DC, 0x1098, 0xD0A5, 0x1010, 0xD02D, 0xD069, 0x1054,
+  0xD2C1, 0x12FC, 0x12B8, 0xD285, 0x1230, 0xD20D, 0xD249, 0x1274,
+  0x1320, 0xD31D, 0xD359, 0x1364, 0xD3D1, 0x13EC, 0x13A8, 0xD395,
+  0xD681, 0x16BC, 0x16F8, 0xD6C5, 0x1670, 0xD64D, 0xD609, 0x1634,
+  0x1760, 0xD75D, 0xD719, 0x1724, 0xD791, 0x17AC, 0x17E8, 0xD7D5,
+  0x1540, 0xD57D, 0xD539, 0x1504, 0xD5B1, 0x158C, 0x15C8, 0xD5F5,
+  0xD4A1, 0x149C, 0x14D8, 0xD4E5, 0x1450, 0xD46D, 0xD429, 0x1414,
+  /* Table 5. */
+  0x0000, 0xD101, 0xE201, 0x3300, 0x8401, 0x5500, 0x6600, 0xB701,
+  0x4801, 0x9900, 0xAA00, 0x7B01, 0xCC00, 0x1D01, 0x2E01, 0xFF00,
+  0x9002, 0x4103, 0x7203, 0xA302, 0x1403, 0xC502, 0xF602, 0x2703,
+  0xD803, 0x0902, 0x3A02, 0xEB03, 0x5C02, 0x8D03, 0xBE03, 0x6F02,
+  0x6007, 0xB106, 0x8206, 0x5307, 0xE406, 0x3507, 0x0607, 0xD706,
+  0x2806, 0xF907, 0xCA07, 0x1B06, 0xAC07, 0x7D06, 0x4E06, 0x9F07,
+  0xF005, 0x2104, 0x1204, 0xC305, 0x7404, 0xA505, 0x9605, 0x4704,
+  0xB804, 0x6905, 0x5A05, 0x8B04, 0x3C05, 0xED04, 0xDE04, 0x0F05,
+  0xC00E, 0x110F, 0x220F, 0xF30E, 0x440F, 0x950E, 0xA60E, 0x770F,
+  0x880F, 0x590E, 0x6A0E, 0xBB0F, 0x0C0E, 0xDD0F, 0xEE0F, 0x3F0E,
+  0x500C, 0x810D, 0xB20D, 0x630C, 0xD40D, 0x050C, 0x360C, 0xE70D,
+  0x180D, 0xC90C, 0xFA0C, 0x2B0D, 0x9C0C, 0x4D0D, 0x7E0D, 0xAF0C,
+  0xA009, 0x7108, 0x4208, 0x9309, 0x2408, 0xF509, 0xC609, 0x1708,
+  0xE808, 0x3909, 0x0A09, 0xDB08, 0x6C09, 0xBD08, 0x8E08, 0x5F09,
+  0x300B, 0xE10A, 0xD20A, 0x030B, 0xB40A, 0x650B, 0x560B, 0x870A,
+  0x780A, 0xA90B, 0x9A0B, 0x4B0A, 0xFC0B, 0x2D0A, 0x1E0A, 0xCF0B,
+  0xC01F, 0x111E, 0x221E, 0xF31F, 0x441E, 0x951F, 0xA61F, 0x771E,
+  0x881E, 0x591F, 0x6A1F, 0xBB1E, 0x0C1F, 0xDD1E, 0xEE1E, 0x3F1F,
+  0x501D, 0x811C, 0xB21C, 0x631D, 0xD41C, 0x051D, 0x361D, 0xE71C,
+  0x181C, 0xC91D, 0xFA1D, 0x2B1C, 0x9C1D, 0x4D1C, 0x7E1C, 0xAF1D,
+  0xA018, 0x7119, 0x4219, 0x9318, 0x2419, 0xF518, 0xC618, 0x1719,
+  0xE819, 0x3918, 0x0A18, 0xDB19, 0x6C18, 0xBD19, 0x8E19, 0x5F18,
+  0x301A, 0xE11B, 0xD21B, 0x031A, 0xB41B, 0x651A, 0x561A, 0x871B,
+  0x781B, 0xA91A, 0x9A1A, 0x4B1B, 0xFC1A, 0x2D1B, 0x1E1B, 0xCF1A,
+  0x0011, 0xD110, 0xE210, 0x3311, 0x8410, 0x5511, 0x6611, 0xB710,
+  0x4810, 0x9911, 0xAA11, 0x7B10, 0xCC11, 0x1D10, 0x2E10, 0xFF11,
+  0x9013, 0x4112, 0x7212, 0xA313, 0x1412, 0xC513, 0xF613, 0x2712,
+  0xD812, 0x0913, 0x3A13, 0xEB12, 0x5C13, 0x8D12, 0xBE12, 0x6F13,
+  0x6016, 0xB117, 0x8217, 0x5316, 0xE417, 0x3516, 0x0616, 0xD717,
+  0x2817, 0xF916, 0xCA16, 0x1B17, 0xAC16, 0x7D17, 0x4E17, 0x9F16,
+  0xF014, 0x2115, 0x1215, 0xC314, 0x7415, 0xA514, 0x9614, 0x4715,
+  0xB815, 0x6914, 0x5A14, 0x8B15, 0x3C14, 0xED15, 0xDE15, 0x0F14,
+  /* Table 6. */
+  0x0000, 0xC010, 0xC023, 0x0033, 0xC045, 0x0055, 0x0066, 0xC076,
+  0xC089, 0x0099, 0x00AA, 0xC0BA, 0x00CC, 0xC0DC, 0xC0EF, 0x00FF,
+  0xC111, 0x0101, 0x0132, 0xC122, 0x0154, 0xC144, 0xC177, 0x0167,
+  0x0198, 0xC188, 0xC1BB, 0x01AB, 0xC1DD, 0x01CD, 0x01FE, 0xC1EE,
+  0xC221, 0x0231, 0x0202, 0xC212, 0x0264, 0xC274, 0xC247, 0x0257,
+  0x02A8, 0xC2B8, 0xC28B, 0x029B, 0xC2ED, 0x02FD, 0x02CE, 0xC2DE,
+  0x0330, 0xC320, 0xC313, 0x0303, 0xC375, 0x0365, 0x0356, 0xC346,
+  0xC3B9, 0x03A9, 0x039A, 0xC38A, 0x03FC, 0xC3EC, 0xC3DF, 0x03CF,
+  0xC441, 0x0451, 0x0462, 0xC472, 0x0404, 0xC414, 0xC427, 0x0437,
+  0x04C8, 0xC4D8, 0xC4EB, 0x04FB, 0xC48D, 0x049D, 0x04AE, 0xC4BE,
+  0x0550, 0xC540, 0xC573, 0x0563, 0xC515, 0x0505, 0x0536, 0xC526,
+  0xC5D9, 0x05C9, 0x05FA, 0xC5EA, 0x059C, 0xC58C, 0xC5BF, 0x05AF,
+  0x0660, 0xC670, 0xC643, 0x0653, 0xC625, 0x0635, 0x0606, 0xC616,
+  0xC6E9, 0x06F9, 0x06CA, 0xC6DA, 0x06AC, 0xC6BC, 0xC68F, 0x069F,
+  0xC771, 0x0761, 0x0752, 0xC742, 0x0734, 0xC724, 0xC717, 0x0707,
+  0x07F8, 0xC7E8, 0xC7DB, 0x07CB, 0xC7BD, 0x07AD, 0x079E, 0xC78E,
+  0xC881, 0x0891, 0x08A2, 0xC8B2, 0x08C4, 0xC8D4, 0xC8E7, 0x08F7,
+  0x0808, 0xC818, 0xC82B, 0x083B, 0xC84D, 0x085D, 0x086E, 0xC87E,
+  0x0990, 0xC980, 0xC9B3, 0x09A3, 0xC9D5, 0x09C5, 0x09F6, 0xC9E6,
+  0xC919, 0x0909, 0x093A, 0xC92A, 0x095C, 0xC94C, 0xC97F, 0x096F,
+  0x0AA0, 0xCAB0, 0xCA83, 0x0A93, 0xCAE5, 0x0AF5, 0x0AC6, 0xCAD6,
+  0xCA29, 0x0A39, 0x0A0A, 0xCA1A, 0x0A6C, 0xCA7C, 0xCA4F, 0x0A5F,
+  0xCBB1, 0x0BA1, 0x0B92, 0xCB82, 0x0BF4, 0xCBE4, 0xCBD7, 0x0BC7,
+  0x0B38, 0xCB28, 0xCB1B, 0x0B0B, 0xCB7D, 0x0B6D, 0x0B5E, 0xCB4E,
+  0x0CC0, 0xCCD0, 0xCCE3, 0x0CF3, 0xCC85, 0x0C95, 0x0CA6, 0xCCB6,
+  0xCC49, 0x0C59, 0x0C6A, 0xCC7A, 0x0C0C, 0xCC1C, 0xCC2F, 0x0C3F,
+  0xCDD1, 0x0DC1, 0x0DF2, 0xCDE2, 0x0D94, 0xCD84, 0xCDB7, 0x0DA7,
+  0x0D58, 0xCD48, 0xCD7B, 0x0D6B, 0xCD1D, 0x0D0D, 0x0D3E, 0xCD2E,
+  0xCEE1, 0x0EF1, 0x0EC2, 0xCED2, 0x0EA4, 0xCEB4, 0xCE87, 0x0E97,
+  0x0E68, 0xCE78, 0xCE4B, 0x0E5B, 0xCE2D, 0x0E3D, 0x0E0E, 0xCE1E,
+  0x0FF0, 0xCFE0, 0xCFD3, 0x0FC3, 0xCFB5, 0x0FA5, 0x0F96, 0xCF86,
+  0xCF79, 0x0F69, 0x0F5A, 0xCF4A, 0x0F3C, 0xCF2C, 0xCF1F, 0x0F0F,
+  /* Table 7. */
+  0x0000, 0xCCC1, 0xD981, 0x1540, 0xF301, 0x3FC0, 0x2A80, 0xE641,
+  0xA601, 0x6AC0, 0x7F80, 0xB341, 0x5500, 0x99C1, 0x8C81, 0x4040,
+  0x0C01, 0xC0C0, 0xD580, 0x1941, 0xFF00, 0x33C1, 0x2681, 0xEA40,
+  0xAA00, 0x66C1, 0x7381, 0xBF40, 0x5901, 0x95C0, 0x8080, 0x4C41,
+  0x1802, 0xD4C3, 0xC183, 0x0D42, 0xEB03, 0x27C2, 0x3282, 0xFE43,
+  0xBE03, 0x72C2, 0x6782, 0xAB43, 0x4D02, 0x81C3, 0x9483, 0x5842,
+  0x1403, 0xD8C2, 0xCD82, 0x0143, 0xE702, 0x2BC3, 0x3E83, 0xF242,
+  0xB202, 0x7EC3, 0x6B83, 0xA742, 0x4103, 0x8DC2, 0x9882, 0x5443,
+  0x3004, 0xFCC5, 0xE985, 0x2544, 0xC305, 0x0FC4, 0x1A84, 0xD645,
+  0x9605, 0x5AC4, 0x4F84, 0x8345, 0x6504, 0xA9C5, 0xBC85, 0x7044,
+  0x3C05, 0xF0C4, 0xE584, 0x2945, 0xCF04, 0x03C5, 0x1685, 0xDA44,
+  0x9A04, 0x56C5, 0x4385, 0x8F44, 0x6905, 0xA5C4, 0xB084, 0x7C45,
+  0x2806, 0xE4C7, 0xF187, 0x3D46, 0xDB07, 0x17C6, 0x0286, 0xCE47,
+  0x8E07, 0x42C6, 0x5786, 0x9B47, 0x7D06, 0xB1C7, 0xA487, 0x6846,
+  0x2407, 0xE8C6, 0xFD86, 0x3147, 0xD706, 0x1BC7, 0x0E87, 0xC246,
+  0x8206, 0x4EC7, 0x5B87, 0x9746, 0x7107, 0xBDC6, 0xA886, 0x6447,
+  0x6008, 0xACC9, 0xB989, 0x7548, 0x9309, 0x5FC8, 0x4A88, 0x8649,
+  0xC609, 0x0AC8, 0x1F88, 0xD349, 0x3508, 0xF9C9, 0xEC89, 0x2048,
+  0x6C09, 0xA0C8, 0xB588, 0x7949, 0x9F08, 0x53C9, 0x4689, 0x8A48,
+  0xCA08, 0x06C9, 0x1389, 0xDF48, 0x3909, 0xF5C8, 0xE088, 0x2C49,
+  0x780A, 0xB4CB, 0xA18B, 0x6D4A, 0x8B0B, 0x47CA, 0x528A, 0x9E4B,
+  0xDE0B, 0x12CA, 0x078A, 0xCB4B, 0x2D0A, 0xE1CB, 0xF48B, 0x384A,
+  0x740B, 0xB8CA, 0xAD8A, 0x614B, 0x870A, 0x4BCB, 0x5E8B, 0x924A,
+  0xD20A, 0x1ECB, 0x0B8B, 0xC74A, 0x210B, 0xEDCA, 0xF88A, 0x344B,
+  0x500C, 0x9CCD, 0x898D, 0x454C, 0xA30D, 0x6FCC, 0x7A8C, 0xB64D,
+  0xF60D, 0x3ACC, 0x2F8C, 0xE34D, 0x050C, 0xC9CD, 0xDC8D, 0x104C,
+  0x5C0D, 0x90CC, 0x858C, 0x494D, 0xAF0C, 0x63CD, 0x768D, 0xBA4C,
+  0xFA0C, 0x36CD, 0x238D, 0xEF4C, 0x090D, 0xC5CC, 0xD08C, 0x1C4D,
+  0x480E, 0x84CF, 0x918F, 0x5D4E, 0xBB0F, 0x77CE, 0x628E, 0xAE4F,
+  0xEE0F, 0x22CE, 0x378E, 0xFB4F, 0x1D0E, 0xD1CF, 0xC48F, 0x084E,
+  0x440F, 0x88CE, 0x9D8E, 0x514F, 0xB70E, 0x7BCF, 0x6E8F, 0xA24E,
+  0xE20E, 0x2ECF, 0x3B8F, 0xF74E, 0x110F, 0xDDCE, 0xC88E, 0x044F,
+#endif
 };
 #endif
 
@@ -161,7 +861,8 @@ const CRCConfig crcsw_crc32_config = {
   .final_val         = 0xFFFFFFFF,
   .reflect_data      = 1,
   .reflect_remainder = 1,
-  .table             = crc32_table
+  .table             = crc32_table,
+  .slices            = CRCSW_SLICING
 };
 #endif
 
@@ -173,7 +874,8 @@ const CRCConfig crcsw_crc16_config = {
   .final_val         = 0x0,
   .reflect_data      = 1,
   .reflect_remainder = 1,
-  .table             = crc16_table
+  .table             = crc16_table,
+  .slices            = CRCSW_SLICING
 };
 #endif
 
@@ -185,6 +887,97 @@ const CRCConfig crcsw_crc16_config = {
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if (CRCSW_CRC32_TABLE == TRUE) || (CRCSW_CRC16_TABLE == TRUE)
+/**
+ * @brief   Table driven reflected CRC update, one byte per step.
+ *
+ * @param[in] table     first set of 256 lookup entries
+ * @param[in] crc       current CRC remainder
+ * @param[in] p         pointer to the data
+ * @param[in] n         number of bytes
+ * @return              The updated CRC remainder.
+ */
+static uint32_t crc_table_bytes(const uint32_t *table, uint32_t crc,
+                                const uint8_t *p, size_t n) {
+
+  while (n > 0U) {
+    crc = table[(crc ^ *p++) & 0xFFU] ^ (crc >> 8);
+    n--;
+  }
+
+  return crc;
+}
+
+#if (CRCSW_SLICING > 1) || defined(__DOXYGEN__)
+/**
+ * @brief   Table driven reflected CRC update, sliced over 4 or 8 bytes.
+ * @details Unaligned leading bytes and trailing bytes are processed one at
+ *          a time, the word aligned body is processed 4 or 8 bytes per step
+ *          using @p slices lookup tables.
+ * @note    Words are loaded in little endian order.
+ *
+ * @param[in] table     @p slices consecutive sets of 256 lookup entries
+ * @param[in] slices    number of lookup tables, 4 or 8
+ * @param[in] crc       current CRC remainder
+ * @param[in] p         pointer to the data
+ * @param[in] n         number of bytes
+ * @return              The updated CRC remainder.
+ */
+static uint32_t crc_table_sliced(const uint32_t *table, uint32_t slices,
+                                 uint32_t crc, const uint8_t *p, size_t n) {
+  const uint32_t *t0 = &table[0 * 256];
+  const uint32_t *t1 = &table[1 * 256];
+  const uint32_t *t2 = &table[2 * 256];
+  const uint32_t *t3 = &table[3 * 256];
+  const uint32_t *w;
+  size_t head;
+
+  /* Head, up to the first word aligned address.*/
+  head = (size_t)(-(uintptr_t)p) & (sizeof (uint32_t) - 1U);
+  if (head > n) {
+    head = n;
+  }
+  crc = crc_table_bytes(t0, crc, p, head);
+  p += head;
+  n -= head;
+
+  /* Body.*/
+  w = (const uint32_t *)(const void *)p;
+#if CRCSW_SLICING >= 8
+  if (slices >= 8U) {
+    const uint32_t *t4 = &table[4 * 256];
+    const uint32_t *t5 = &table[5 * 256];
+    const uint32_t *t6 = &table[6 * 256];
+    const uint32_t *t7 = &table[7 * 256];
+
+    while (n >= 8U) {
+      uint32_t lo = *w++ ^ crc;
+      uint32_t hi = *w++;
+
+      crc = t7[lo & 0xFFU] ^ t6[(lo >> 8) & 0xFFU] ^
+            t5[(lo >> 16) & 0xFFU] ^ t4[lo >> 24] ^
+            t3[hi & 0xFFU] ^ t2[(hi >> 8) & 0xFFU] ^
+            t1[(hi >> 16) & 0xFFU] ^ t0[hi >> 24];
+      n -= 8U;
+    }
+  }
+#else
+  (void)slices;
+#endif
+  while (n >= 4U) {
+    uint32_t lo = *w++ ^ crc;
+
+    crc = t3[lo & 0xFFU] ^ t2[(lo >> 8) & 0xFFU] ^
+          t1[(lo >> 16) & 0xFFU] ^ t0[lo >> 24];
+    n -= 4U;
+  }
+
+  /* Tail.*/
+  return crc_table_bytes(t0, crc, (const uint8_t *)w, n);
+}
+#endif /* CRCSW_SLICING > 1 */
+#endif /* CRCSW_CRC32_TABLE || CRCSW_CRC16_TABLE */
+
 #if (CRCSW_PROGRAMMABLE == TRUE)
 static uint32_t reflect(uint32_t data, uint8_t nBits) {
   uint32_t reflection = 0x00000000;
@@ -219,7 +1012,6 @@ static uint32_t reflect(uint32_t data, uint8_t nBits) {
  */
 void crc_lld_init(void) {
   crcObjectInit(&CRCD1);
-  CRCD1.crc = CRCD1.config->initial_val;
 }
 
 /**
@@ -280,26 +1072,33 @@ void crc_lld_reset(CRCDriver *crcp) {
  * @notapi
  */
 uint32_t crc_lld_calc(CRCDriver *crcp, size_t n, const void *buf) {
-  uint32_t i;
-  uint32_t crc;
+  uint32_t crc = crcp->crc;
+
+  // Mask off bits to poly size
+  uint32_t mask = 1 << (crcp->config->poly_size - 1);
+  mask |= (mask - 1);
+
 #if (CRCSW_CRC32_TABLE == TRUE) || (CRCSW_CRC16_TABLE == TRUE)
   if (crcp->config->table != NULL) {
-    for (i = 0; i < n; i++) {
-      uint8_t data = *((uint8_t*)buf + i);
-      uint8_t idx = (crcp->crc ^ data);
-      crcp->crc = (crcp->config->table[idx] ^ (crcp->crc >> 8));
+#if CRCSW_SLICING > 1
+    if ((crcp->config->slices >= 4U) && (n >= 2U * sizeof (uint32_t))) {
+      crc = crc_table_sliced(crcp->config->table, crcp->config->slices,
+                             crc, (const uint8_t *)buf, n);
     }
-    crc = crcp->crc;
+    else
+#endif
+    {
+      crc = crc_table_bytes(crcp->config->table, crc,
+                            (const uint8_t *)buf, n);
+    }
+    crcp->crc = crc;
   }
 #endif
 
 #if (CRCSW_PROGRAMMABLE == TRUE)
-  // Mask off bits to poly size
-  uint32_t mask = 1 << (crcp->config->poly_size - 1);
-  mask |= (mask - 1);
-
-  crc = crcp->crc;
   if (crcp->config->table == NULL) {
+    uint32_t i;
+
     for (i = 0; i < n; i++) {
       uint8_t data = *((uint8_t*)buf + i);
       uint8_t bit;
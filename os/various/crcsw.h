@@ -59,10 +59,31 @@
 #define CRCSW_CRC16_TABLE               FALSE
 #endif
 
+/**
+ * @brief   Number of lookup tables used by the table driven engine.
+ * @details With a value of 4 or 8 the built-in CRC32 and CRC16 tables are
+ *          extended with the additional sets and the word aligned part of
+ *          the buffer is processed 4 or 8 bytes per step (slicing-by-N).
+ * @note    Each additional table costs 1kB of flash.
+ * @note    The default is 1, classic byte at a time lookup.
+ */
+#if !defined(CRCSW_SLICING) || defined(__DOXYGEN__)
+#define CRCSW_SLICING                   1
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (CRCSW_SLICING != 1) && (CRCSW_SLICING != 4) && (CRCSW_SLICING != 8)
+#error "CRCSW_SLICING must be 1, 4 or 8"
+#endif
+
+#if (CRCSW_SLICING > 1) && defined(__BYTE_ORDER__) &&                       \
+    (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "CRCSW_SLICING requires a little endian architecture"
+#endif
+
 #if CRCSW_USE_CRC1 && CRC_USE_DMA
 #error "Software CRC does not support DMA(CRC_USE_DMA)"
 #endif
@@ -113,6 +134,12 @@ typedef struct {
    * @brief The crc lookup table to use when calculating CRC.
    */
   const uint32_t           *table;
+  /**
+   * @brief Number of consecutive 256 entries sets in @p table.
+   * @note  Values of 4 or 8 enable the sliced engine if @p CRCSW_SLICING
+   *        allows it, any other value selects the byte at a time lookup.
+   */
+  uint32_t                 slices;
 } CRCConfig;
 
 
@@ -38,4 +38,56 @@
 #endif
 #endif
 
+/*-----------------------------------------------------------------------*/
+/* Drive registry.                                                       */
+/* Every physical drive number maps to a @p BaseBlockDevice, the built-in */
+/* devices above are registered by default. The registry holds up to     */
+/* FATFS_MAX_DRIVES entries, FF_VOLUMES unless defined in ffconf.h.      */
+
+/**
+ * @brief   Type of a drive block range operation.
+ *
+ * @param[in] blkdev    pointer to the @p BaseBlockDevice object
+ * @param[in] startblk  first block of the range
+ * @param[in] n         number of blocks of the range
+ *
+ * @return              The operation status.
+ */
+typedef bool (*fatfs_blkop_t)(BaseBlockDevice *blkdev,
+                              uint32_t startblk, uint32_t n);
+
+/**
+ * @brief   Drive descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Block device backing the drive.
+   */
+  BaseBlockDevice     *blkdev;
+  /**
+   * @brief   Called before multi-block writes with the number of blocks
+   *          about to be written, so that the medium can pre-erase them.
+   *          @p NULL if not supported.
+   */
+  fatfs_blkop_t       pre_erase;
+  /**
+   * @brief   Called on CTRL_TRIM with the blocks no longer in use,
+   *          @p NULL if not supported.
+   */
+  fatfs_blkop_t       trim;
+  /**
+   * @brief   Erase block size in blocks, zero if unknown.
+   */
+  uint32_t            erase_size;
+} fatfs_drive_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  bool fatfsRegisterDrive(uint8_t pdrv, const fatfs_drive_t *drive);
+  void fatfsUnregisterDrive(uint8_t pdrv);
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* FATFS_DEVICES_H_ */
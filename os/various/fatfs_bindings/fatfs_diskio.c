@@ -16,12 +16,6 @@
 #error "cannot specify both MMC_SPI and FATFSDEV_MMC drivers"
 #endif
 
-// sanity check for no FAT option selected
-// why is the FAT sources being pulled into the build?
-#if !HAL_USE_MMC_SPI && !HAL_USE_SDC & !HAL_USBH_USE_MSD
-#error "MMC_SPI, FATFSDEV_MMC or USBH_MSD driver must be specified. None was."
-#endif
-
 #if !defined(FATFS_HAL_DEVICE)
 #if HAL_USE_MMC_SPI
 #define FATFS_HAL_DEVICE MMCD1
@@ -43,46 +37,128 @@ extern SDCDriver FATFS_HAL_DEVICE;
 extern RTCDriver RTCD1;
 #endif
 
+#if !defined(FATFS_MAX_DRIVES)
+#define FATFS_MAX_DRIVES FF_VOLUMES
+#endif
+
+#if !defined(FATFS_USE_PRE_ERASE)
+#define FATFS_USE_PRE_ERASE TRUE
+#endif
+
 
 /*-----------------------------------------------------------------------*/
-/* Inidialize a Drive                                                    */
+/* Built-in drives                                                       */
 
-DSTATUS disk_initialize (
-    BYTE pdrv         /* Physical drive number (0..) */
-)
-{
-  DSTATUS stat;
+#if HAL_USE_MMC_SPI
+static bool mmc_trim(BaseBlockDevice *blkdev, uint32_t startblk, uint32_t n) {
+  return mmcErase((MMCDriver *)blkdev, startblk, startblk + n - 1);
+}
+
+/* Pre-erase needs the SPI command layer of the MMC driver, not exported.*/
+static const fatfs_drive_t mmc_drive = {
+  (BaseBlockDevice *)&FATFS_HAL_DEVICE, NULL, mmc_trim, 0
+};
+#endif
+
+#if HAL_USE_SDC
+#if FATFS_USE_PRE_ERASE
+/* Sends ACMD23 (SET_WR_BLK_ERASE_COUNT), the card may then erase the
+   blocks of the next multi-block write in advance. It is a hint, cards
+   ignoring it write correctly anyway.*/
+static bool sdc_pre_erase(BaseBlockDevice *blkdev, uint32_t startblk,
+                          uint32_t n) {
+  SDCDriver *sdcp = (SDCDriver *)blkdev;
+  uint32_t resp[1];
+
+  (void)startblk;
+
+  if ((sdcp->cardmode & SDC_MODE_CARDTYPE_MASK) == SDC_MODE_CARDTYPE_MMC)
+    return HAL_SUCCESS;
+  if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_APP_CMD, sdcp->rca, resp) ||
+      MMCSD_R1_ERROR(resp[0]))
+    return HAL_FAILED;
+  if (sdc_lld_send_cmd_short_crc(sdcp, MMCSD_CMD_SET_BLOCK_COUNT,
+                                 n & 0x007FFFFFU, resp) ||
+      MMCSD_R1_ERROR(resp[0]))
+    return HAL_FAILED;
+  return HAL_SUCCESS;
+}
+#endif
+
+static bool sdc_trim(BaseBlockDevice *blkdev, uint32_t startblk, uint32_t n) {
+  return sdcErase((SDCDriver *)blkdev, startblk, startblk + n - 1);
+}
+
+static const fatfs_drive_t sdc_drive = {
+  (BaseBlockDevice *)&FATFS_HAL_DEVICE,
+#if FATFS_USE_PRE_ERASE
+  sdc_pre_erase,
+#else
+  NULL,
+#endif
+  sdc_trim,
+  256 /* 512b blocks in one erase block */
+};
+#endif
+
+#if HAL_USBH_USE_MSD
+static const fatfs_drive_t msd_drive = {
+  (BaseBlockDevice *)&MSBLKD[0], NULL, NULL, 0
+};
+#endif
 
-  switch (pdrv) {
+/* Without built-in drives all the drives are registered by the
+   application, RAM disks or cached devices for example.*/
+static const fatfs_drive_t *drives[FATFS_MAX_DRIVES] = {
+#if !HAL_USE_MMC_SPI && !HAL_USE_SDC && !HAL_USBH_USE_MSD
+  NULL
+#endif
 #if HAL_USE_MMC_SPI
-  case FATFSDEV_MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&FATFS_HAL_DEVICE))
-      stat |=  STA_PROTECT;
-    return stat;
+  [FATFSDEV_MMC] = &mmc_drive,
 #elif HAL_USE_SDC
-  case FATFSDEV_MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&FATFS_HAL_DEVICE))
-      stat |=  STA_PROTECT;
-    return stat;
+  [FATFSDEV_MMC] = &sdc_drive,
 #endif
-#if HAL_USBH_USE_MSD
-  case FATFSDEV_MSD:
-	stat = 0;
-	/* It is initialized externally, just reads the status.*/
-	if (blkGetDriverState(&MSBLKD[0]) != BLK_READY)
-	  stat |= STA_NOINIT;
-	return stat;
+#if HAL_USBH_USE_MSD && (FATFSDEV_MSD < FATFS_MAX_DRIVES)
+  [FATFSDEV_MSD] = &msd_drive,
 #endif
-  }
-  return STA_NOINIT;
+};
+
+static const fatfs_drive_t *get_drive(BYTE pdrv) {
+  if (pdrv >= FATFS_MAX_DRIVES)
+    return NULL;
+  return drives[pdrv];
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Register a Drive                                                      */
+
+bool fatfsRegisterDrive(uint8_t pdrv, const fatfs_drive_t *drive) {
+
+  osalDbgCheck((drive != NULL) && (drive->blkdev != NULL));
+
+  if (pdrv >= FATFS_MAX_DRIVES)
+    return HAL_FAILED;
+  drives[pdrv] = drive;
+  return HAL_SUCCESS;
+}
+
+void fatfsUnregisterDrive(uint8_t pdrv) {
+
+  if (pdrv < FATFS_MAX_DRIVES)
+    drives[pdrv] = NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Inidialize a Drive                                                    */
+
+DSTATUS disk_initialize (
+    BYTE pdrv         /* Physical drive number (0..) */
+)
+{
+  /* It is initialized externally, just reads the status.*/
+  return disk_status(pdrv);
 }
 
 
@@ -94,38 +170,16 @@ DSTATUS disk_status (
     BYTE pdrv         /* Physical drive number (0..) */
 )
 {
-  DSTATUS stat;
-
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case FATFSDEV_MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (mmcIsWriteProtected(&FATFS_HAL_DEVICE))
-      stat |= STA_PROTECT;
-    return stat;
-#elif HAL_USE_SDC
-  case FATFSDEV_MMC:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      stat |= STA_NOINIT;
-    if (sdcIsWriteProtected(&FATFS_HAL_DEVICE))
-      stat |= STA_PROTECT;
-    return stat;
-#endif
-#if HAL_USBH_USE_MSD
-  case FATFSDEV_MSD:
-    stat = 0;
-    /* It is initialized externally, just reads the status.*/
-    if (blkGetDriverState(&MSBLKD[0]) != BLK_READY)
-      stat |= STA_NOINIT;
-    return stat;
-#endif
-  }
-  return STA_NOINIT;
+  const fatfs_drive_t *drive = get_drive(pdrv);
+  DSTATUS stat = 0;
+
+  if (drive == NULL)
+    return STA_NOINIT;
+  if (blkGetDriverState(drive->blkdev) != BLK_READY)
+    stat |= STA_NOINIT;
+  if (blkIsWriteProtected(drive->blkdev))
+    stat |= STA_PROTECT;
+  return stat;
 }
 
 
@@ -140,41 +194,16 @@ DRESULT disk_read (
     UINT count        /* Number of sectors to read (1..255) */
 )
 {
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case FATFSDEV_MMC:
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      return RES_NOTRDY;
-    if (mmcStartSequentialRead(&FATFS_HAL_DEVICE, sector))
-      return RES_ERROR;
-    while (count > 0) {
-      if (mmcSequentialRead(&FATFS_HAL_DEVICE, buff))
-        return RES_ERROR;
-      buff += MMCSD_BLOCK_SIZE;
-      count--;
-    }
-    if (mmcStopSequentialRead(&FATFS_HAL_DEVICE))
-        return RES_ERROR;
-    return RES_OK;
-#elif HAL_USE_SDC
-  case FATFSDEV_MMC:
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      return RES_NOTRDY;
-    if (sdcRead(&FATFS_HAL_DEVICE, sector, buff, count))
-      return RES_ERROR;
-    return RES_OK;
-#endif
-#if HAL_USBH_USE_MSD
-  case FATFSDEV_MSD:
-	/* It is initialized externally, just reads the status.*/
-	if (blkGetDriverState(&MSBLKD[0]) != BLK_READY)
-		return RES_NOTRDY;
-	if (usbhmsdLUNRead(&MSBLKD[0], sector, buff, count))
-		return RES_ERROR;
-	return RES_OK;
-#endif
-  }
-  return RES_PARERR;
+  const fatfs_drive_t *drive = get_drive(pdrv);
+
+  if (drive == NULL)
+    return RES_PARERR;
+  if (blkGetDriverState(drive->blkdev) != BLK_READY)
+    return RES_NOTRDY;
+  /* All the sectors in a single device access.*/
+  if (blkRead(drive->blkdev, sector, buff, count))
+    return RES_ERROR;
+  return RES_OK;
 }
 
 
@@ -190,57 +219,29 @@ DRESULT disk_write (
     UINT count        /* Number of sectors to write (1..255) */
 )
 {
-
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case FATFSDEV_MMC:
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-        return RES_NOTRDY;
-    if (mmcIsWriteProtected(&FATFS_HAL_DEVICE))
-        return RES_WRPRT;
-    if (mmcStartSequentialWrite(&FATFS_HAL_DEVICE, sector))
-        return RES_ERROR;
-
-    while (count > 0) {
-        // invalidate cache on buffer
-        cacheBufferFlush(buff, MMCSD_BLOCK_SIZE);
-
-        if (mmcSequentialWrite(&FATFS_HAL_DEVICE, buff))
-            return RES_ERROR;
-        buff += MMCSD_BLOCK_SIZE;
-        count--;
-    }
-    if (mmcStopSequentialWrite(&FATFS_HAL_DEVICE))
-        return RES_ERROR;
-    return RES_OK;
-#elif HAL_USE_SDC
-  case FATFSDEV_MMC:
-    if (blkGetDriverState(&FATFS_HAL_DEVICE) != BLK_READY)
-      return RES_NOTRDY;
-
-    // invalidate cache on buffer
-    cacheBufferFlush(buff, count * MMCSD_BLOCK_SIZE);
-
-    if (sdcWrite(&FATFS_HAL_DEVICE, sector, buff, count))
-        return RES_ERROR;
-
-    return RES_OK;
-#endif
-#if HAL_USBH_USE_MSD
-  case FATFSDEV_MSD:
-	/* It is initialized externally, just reads the status.*/
-	if (blkGetDriverState(&MSBLKD[0]) != BLK_READY)
-		return RES_NOTRDY;
-
-    // invalidate cache on buffer
-    cacheBufferFlush(buff, count * MSBLKD[0].info.blk_size);
-
-	if (usbhmsdLUNWrite(&MSBLKD[0], sector, buff, count))
-		return RES_ERROR;
-	return RES_OK;
-#endif
-  }
-  return RES_PARERR;
+  const fatfs_drive_t *drive = get_drive(pdrv);
+  BlockDeviceInfo bdi;
+
+  if (drive == NULL)
+    return RES_PARERR;
+  if (blkGetDriverState(drive->blkdev) != BLK_READY)
+    return RES_NOTRDY;
+  if (blkIsWriteProtected(drive->blkdev))
+    return RES_WRPRT;
+  if (blkGetInfo(drive->blkdev, &bdi))
+    return RES_ERROR;
+
+  // invalidate cache on buffer
+  cacheBufferFlush(buff, count * bdi.blk_size);
+
+  /* The pre-erase hint is only a performance matter, its failure is not
+     an error.*/
+  if ((count > 1) && (drive->pre_erase != NULL))
+    (void)drive->pre_erase(drive->blkdev, sector, count);
+
+  if (blkWrite(drive->blkdev, sector, buff, count))
+    return RES_ERROR;
+  return RES_OK;
 }
 #endif /* _FS_READONLY */
 
@@ -255,77 +256,47 @@ DRESULT disk_ioctl (
     void *buff        /* Buffer to send/receive control data */
 )
 {
-  (void)buff;
+  const fatfs_drive_t *drive = get_drive(pdrv);
+  BlockDeviceInfo bdi;
 
-  switch (pdrv) {
-#if HAL_USE_MMC_SPI
-  case FATFSDEV_MMC:
-    switch (cmd) {
-    case CTRL_SYNC:
-        return RES_OK;
-#if FF_MAX_SS > FF_MIN_SS
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
-#endif
-#if FF_USE_TRIM
-    case CTRL_TRIM:
-        mmcErase(&FATFS_HAL_DEVICE, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
-#endif
-    default:
-        return RES_PARERR;
-    }
-#elif HAL_USE_SDC
-  case FATFSDEV_MMC:
-    switch (cmd) {
-    case CTRL_SYNC:
-        return RES_OK;
-    case GET_SECTOR_COUNT:
-        *((DWORD *)buff) = mmcsdGetCardCapacity(&FATFS_HAL_DEVICE);
-        return RES_OK;
-#if FF_MAX_SS > FF_MIN_SS
-    case GET_SECTOR_SIZE:
-        *((WORD *)buff) = MMCSD_BLOCK_SIZE;
-        return RES_OK;
-#endif
-    case GET_BLOCK_SIZE:
-        *((DWORD *)buff) = 256; /* 512b blocks in one erase block */
-        return RES_OK;
-#if FF_USE_TRIM
-    case CTRL_TRIM:
-        sdcErase(&FATFS_HAL_DEVICE, *((DWORD *)buff), *((DWORD *)buff + 1));
-        return RES_OK;
-#endif
-    default:
-        return RES_PARERR;
-    }
-#endif
-#if HAL_USBH_USE_MSD
-    case FATFSDEV_MSD:
-      switch (cmd) {
-      case CTRL_SYNC:
-          return RES_OK;
-      case GET_SECTOR_COUNT:
-          *((DWORD *)buff) = MSBLKD[0].info.blk_num;
-          return RES_OK;
+  if (drive == NULL)
+    return RES_PARERR;
+
+  switch (cmd) {
+  case CTRL_SYNC:
+    if (blkSync(drive->blkdev))
+      return RES_ERROR;
+    return RES_OK;
+  case GET_SECTOR_COUNT:
+    if (blkGetInfo(drive->blkdev, &bdi))
+      return RES_NOTRDY;
+    *((DWORD *)buff) = bdi.blk_num;
+    return RES_OK;
 #if FF_MAX_SS > FF_MIN_SS
-      case GET_SECTOR_SIZE:
-          *((WORD *)buff) = MSBLKD[0].info.blk_size;
-          return RES_OK;
+  case GET_SECTOR_SIZE:
+    if (blkGetInfo(drive->blkdev, &bdi))
+      return RES_NOTRDY;
+    *((WORD *)buff) = bdi.blk_size;
+    return RES_OK;
 #endif
+  case GET_BLOCK_SIZE:
+    if (drive->erase_size == 0)
+      return RES_PARERR;
+    *((DWORD *)buff) = drive->erase_size;
+    return RES_OK;
 #if FF_USE_TRIM
-#error "unimplemented yet!"
-//    case CTRL_TRIM:
-//      ....
-//      return RES_OK;
-#endif
-      default:
-          return RES_PARERR;
-      }
+  case CTRL_TRIM:
+    /* buff holds the first and the last sector of the range.*/
+    if (drive->trim == NULL)
+      return RES_OK;
+    if (drive->trim(drive->blkdev, ((DWORD *)buff)[0],
+                    ((DWORD *)buff)[1] - ((DWORD *)buff)[0] + 1))
+      return RES_ERROR;
+    return RES_OK;
 #endif
+  default:
+    return RES_PARERR;
   }
-  return RES_PARERR;
 }
 
 DWORD get_fattime(void) {
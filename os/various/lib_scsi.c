@@ -41,10 +41,47 @@
 /*===========================================================================*/
 
 typedef struct {
-  uint32_t first_lba;
-  uint16_t blk_cnt;
+  uint64_t first_lba;
+  uint32_t blk_cnt;
 } data_request_t;
 
+/**
+ * @brief   Size of the block limits VPD page.
+ */
+#define VPD_BLOCK_LIMITS_LEN      64U
+
+/**
+ * @brief   Size of the logical block provisioning VPD page.
+ */
+#define VPD_LBP_LEN               8U
+
+/**
+ * @brief   Size of the read capacity (16) response.
+ */
+#define READ_CAPACITY16_LEN       32U
+
+/**
+ * @brief   Size of the UNMAP parameter list header.
+ */
+#define UNMAP_HEADER_LEN          8U
+
+/**
+ * @brief   Size of an UNMAP block descriptor.
+ */
+#define UNMAP_DESCRIPTOR_LEN      16U
+
+/**
+ * @brief   Checks if the transport transmits asynchronously.
+ */
+#define async_transmit(trp)                                                 \
+  (((trp)->start_transmit != NULL) && ((trp)->wait_transmit != NULL))
+
+/**
+ * @brief   Checks if the transport receives asynchronously.
+ */
+#define async_receive(trp)                                                  \
+  (((trp)->start_receive != NULL) && ((trp)->wait_receive != NULL))
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -65,18 +102,71 @@ typedef struct {
 static data_request_t decode_data_request(const uint8_t *cmd) {
 
   data_request_t req;
-  uint32_t lba;
-  uint16_t blk;
 
-  memcpy(&lba, &cmd[2], sizeof(lba));
-  memcpy(&blk, &cmd[7], sizeof(blk));
+  if ((cmd[0] == SCSI_CMD_READ_16) || (cmd[0] == SCSI_CMD_WRITE_16)) {
+    uint64_t lba;
+    uint32_t blk;
 
-  req.first_lba = be32_to_cpu(lba);
-  req.blk_cnt = be16_to_cpu(blk);
+    memcpy(&lba, &cmd[2], sizeof(lba));
+    memcpy(&blk, &cmd[10], sizeof(blk));
+
+    req.first_lba = be64_to_cpu(lba);
+    req.blk_cnt = be32_to_cpu(blk);
+  }
+  else {
+    uint32_t lba;
+    uint16_t blk;
+
+    memcpy(&lba, &cmd[2], sizeof(lba));
+    memcpy(&blk, &cmd[7], sizeof(blk));
+
+    req.first_lba = be32_to_cpu(lba);
+    req.blk_cnt = be16_to_cpu(blk);
+  }
 
   return req;
 }
 
+/**
+ * @brief   Stores a big endian 32 bits value into a byte array.
+ *
+ * @notapi
+ */
+static void put_be32(uint8_t *p, uint32_t v) {
+
+  v = cpu_to_be32(v);
+  memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * @brief   Stores a big endian 64 bits value into a byte array.
+ *
+ * @notapi
+ */
+static void put_be64(uint8_t *p, uint64_t v) {
+
+  v = cpu_to_be64(v);
+  memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * @brief   Size of the data buffer in bytes.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ *
+ * @notapi
+ */
+static size_t buffer_size(SCSITarget *scsip) {
+
+  BlockDeviceInfo bdi;
+
+  if (scsip->config->blkbuf_size != 0U) {
+    return scsip->config->blkbuf_size;
+  }
+  blkGetInfo(scsip->config->blkdev, &bdi);
+  return bdi.blk_size;
+}
+
 /**
  * @brief   Fills sense structure.
  *
@@ -138,6 +228,106 @@ static bool transmit_data(SCSITarget *scsip, const uint8_t *data, uint32_t len)
   }
 }
 
+/**
+ * @brief   Starts data transmission via transport channel.
+ * @details Falls back to a synchronous transmission if the transport has no
+ *          asynchronous transmit calls, the result is then kept in @p done.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] data    pointer to data buffer
+ * @param[in] len     number of bytes to be transmitted
+ * @param[out] done   bytes transmitted by a synchronous transport
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool start_transmit(SCSITarget *scsip, const uint8_t *data,
+                           uint32_t len, uint32_t *done) {
+
+  const SCSITransport *trp = scsip->config->transport;
+
+  if (async_transmit(trp)) {
+    return trp->start_transmit(trp, data, len);
+  }
+  else {
+    *done = trp->transmit(trp, data, len);
+    return SCSI_SUCCESS;
+  }
+}
+
+/**
+ * @brief   Waits for the data transmission started by @p start_transmit().
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] done    bytes transmitted by a synchronous transport
+ *
+ * @return            Number of transmitted bytes.
+ *
+ * @notapi
+ */
+static uint32_t wait_transmit(SCSITarget *scsip, uint32_t done) {
+
+  const SCSITransport *trp = scsip->config->transport;
+
+  if (async_transmit(trp)) {
+    return trp->wait_transmit(trp);
+  }
+  else {
+    return done;
+  }
+}
+
+/**
+ * @brief   Starts data reception via transport channel.
+ * @details Falls back to a synchronous reception if the transport has no
+ *          asynchronous receive calls, the result is then kept in @p done.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[out] data   pointer to data buffer
+ * @param[in] len     number of bytes to be received
+ * @param[out] done   bytes received by a synchronous transport
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool start_receive(SCSITarget *scsip, uint8_t *data,
+                          uint32_t len, uint32_t *done) {
+
+  const SCSITransport *trp = scsip->config->transport;
+
+  if (async_receive(trp)) {
+    return trp->start_receive(trp, data, len);
+  }
+  else {
+    *done = trp->receive(trp, data, len);
+    return SCSI_SUCCESS;
+  }
+}
+
+/**
+ * @brief   Waits for the data reception started by @p start_receive().
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] done    bytes received by a synchronous transport
+ *
+ * @return            Number of received bytes.
+ *
+ * @notapi
+ */
+static uint32_t wait_receive(SCSITarget *scsip, uint32_t done) {
+
+  const SCSITransport *trp = scsip->config->transport;
+
+  if (async_receive(trp)) {
+    return trp->wait_receive(trp);
+  }
+  else {
+    return done;
+  }
+}
+
 /**
  * @brief   Stub for unhandled SCSI commands.
  * @details Sets error flags in sense data structure and returns error error.
@@ -162,6 +352,65 @@ static bool cmd_ignored(SCSITarget *scsip, const uint8_t *cmd) {
   return SCSI_SUCCESS;
 }
 
+/**
+ * @brief   SCSI inquiry command handler for the generated VPD pages.
+ * @details The supported pages list is always available, the block limits
+ *          and logical block provisioning pages only if the block device
+ *          can unmap. Pages are built in the data buffer.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] cmd     pointer to SCSI command data
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool inquiry_vpd(SCSITarget *scsip, const uint8_t *cmd) {
+
+  uint8_t *buf = scsip->config->blkbuf;
+  uint32_t alloc = (uint32_t)cmd[3] << 8 | cmd[4];
+  uint32_t len;
+
+  buf[0] = scsip->config->inquiry_response->peripheral;
+  buf[1] = cmd[2];
+  switch (cmd[2]) {
+  case 0xB0:
+    /* Block limits page, the descriptor count is bounded by the buffer
+       which receives the UNMAP parameter list.*/
+    len = VPD_BLOCK_LIMITS_LEN;
+    memset(&buf[2], 0, len - 2U);
+    buf[3] = len - 4U;
+    put_be32(&buf[20], 0xFFFFFFFFU);
+    put_be32(&buf[24], (uint32_t)((buffer_size(scsip) - UNMAP_HEADER_LEN) /
+                                  UNMAP_DESCRIPTOR_LEN));
+    break;
+  case 0xB2:
+    /* Logical block provisioning page, LBPU set.*/
+    len = VPD_LBP_LEN;
+    memset(&buf[2], 0, len - 2U);
+    buf[3] = len - 4U;
+    buf[5] = 0x80;
+    break;
+  default:
+    /* Supported pages page.*/
+    buf[2] = 0;
+    buf[4] = 0x00;
+    buf[5] = 0x80;
+    if (scsip->config->unmap != NULL) {
+      buf[6] = 0xB0;
+      buf[7] = 0xB2;
+      buf[3] = 4;
+    }
+    else {
+      buf[3] = 2;
+    }
+    len = 4U + buf[3];
+    break;
+  }
+
+  return transmit_data(scsip, buf, len < alloc ? len : alloc);
+}
+
 /**
  * @brief   SCSI inquiry command handler.
  *
@@ -179,6 +428,11 @@ static bool inquiry(SCSITarget *scsip, const uint8_t *cmd) {
     return transmit_data(scsip, (const uint8_t *)scsip->config->unit_serial_number_inquiry_response,
                                 sizeof(scsi_unit_serial_number_inquiry_response_t));
   }
+  else if ((cmd[1] & 0b1) && ((cmd[2] == 0x00) ||
+           ((scsip->config->unmap != NULL) &&
+            ((cmd[2] == 0xB0) || (cmd[2] == 0xB2))))) {
+    return inquiry_vpd(scsip, cmd);
+  }
   else if ((cmd[1] & 0b11) || cmd[2] != 0) {
     set_sense(scsip, SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                      SCSI_ASENSE_INVALID_FIELD_IN_CDB,
@@ -312,23 +566,80 @@ static bool read_capacity10(SCSITarget *scsip, const uint8_t *cmd) {
 }
 
 /**
- * @brief   Checks data request for media overflow.
+ * @brief   SCSI read capacity (16) command handler.
+ * @details The logical block provisioning management bit is set if the
+ *          block device can unmap. The response is built in the data buffer.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] cmd     pointer to SCSI command data
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool read_capacity16(SCSITarget *scsip, const uint8_t *cmd) {
+
+  uint8_t *buf = scsip->config->blkbuf;
+  BlockDeviceInfo bdi;
+  uint32_t alloc;
+
+  memcpy(&alloc, &cmd[10], sizeof(alloc));
+  alloc = be32_to_cpu(alloc);
+
+  blkGetInfo(scsip->config->blkdev, &bdi);
+  memset(buf, 0, READ_CAPACITY16_LEN);
+  put_be64(&buf[0], (uint64_t)bdi.blk_num - 1U);
+  put_be32(&buf[8], bdi.blk_size);
+  if (scsip->config->unmap != NULL) {
+    buf[14] = 0x80;
+  }
+
+  return transmit_data(scsip, buf,
+                       READ_CAPACITY16_LEN < alloc ? READ_CAPACITY16_LEN : alloc);
+}
+
+/**
+ * @brief   SCSI service action in (16) command handler.
  *
  * @param[in] scsip   pointer to @p SCSITarget structure
  * @param[in] cmd     pointer to SCSI command data
  *
  * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool service_action_in16(SCSITarget *scsip, const uint8_t *cmd) {
+
+  if ((cmd[1] & 0x1F) == SCSI_SA_READ_CAPACITY_16) {
+    return read_capacity16(scsip, cmd);
+  }
+  else {
+    set_sense(scsip, SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                     SCSI_ASENSE_INVALID_FIELD_IN_CDB,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    return SCSI_FAILED;
+  }
+}
+
+/**
+ * @brief   Checks a block range for media overflow.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] lba     first block of the range
+ * @param[in] cnt     number of blocks of the range
+ *
+ * @return            The operation status.
  * @retval true       When media overflow detected.
  * @retval false      Otherwise.
  *
  * @notapi
  */
-static bool data_overflow(SCSITarget *scsip, const data_request_t *req) {
+static bool range_overflow(SCSITarget *scsip, uint64_t lba, uint32_t cnt) {
 
   BlockDeviceInfo bdi;
   blkGetInfo(scsip->config->blkdev, &bdi);
 
-  if (req->first_lba + req->blk_cnt > bdi.blk_num) {
+  if ((lba > bdi.blk_num) || (cnt > bdi.blk_num - lba)) {
     set_sense(scsip, SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                      SCSI_ASENSE_LBA_OUT_OF_RANGE,
                      SCSI_ASENSEQ_NO_QUALIFIER);
@@ -340,44 +651,342 @@ static bool data_overflow(SCSITarget *scsip, const data_request_t *req) {
 }
 
 /**
- * @brief   SCSI read/write (10) command handler.
+ * @brief   Checks data request for media overflow.
  *
  * @param[in] scsip   pointer to @p SCSITarget structure
  * @param[in] cmd     pointer to SCSI command data
  *
  * @return            The operation status.
+ * @retval true       When media overflow detected.
+ * @retval false      Otherwise.
  *
  * @notapi
  */
-static bool data_read_write10(SCSITarget *scsip, const uint8_t *cmd) {
+static bool data_overflow(SCSITarget *scsip, const data_request_t *req) {
+
+  return range_overflow(scsip, req->first_lba, req->blk_cnt);
+}
+
+/**
+ * @brief   Splits the data buffer for a transfer.
+ * @details With room for two blocks or more the buffer is split in two
+ *          halves, otherwise a single block buffer is used.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] bs      block size
+ * @param[out] buf    the one or two buffer halves
+ *
+ * @return            Number of blocks per half, zero if not double buffered.
+ *
+ * @notapi
+ */
+static uint32_t split_buffer(SCSITarget *scsip, size_t bs, uint8_t *buf[2]) {
+
+  uint32_t chunk = scsip->config->blkbuf_size / 2U / bs;
+
+  buf[0] = scsip->config->blkbuf;
+  buf[1] = scsip->config->blkbuf + chunk * bs;
+  return chunk;
+}
+
+/**
+ * @brief   Streams blocks from the block device to the transport.
+ * @details While one half of the buffer is transmitted the next blocks are
+ *          read into the other half.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] req     decoded data request
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool data_read(SCSITarget *scsip, const data_request_t *req) {
+
+  BaseBlockDevice *blkdev = scsip->config->blkdev;
+  BlockDeviceInfo bdi;
+  uint8_t *buf[2];
+  uint32_t lba = (uint32_t)req->first_lba;
+  uint32_t left = req->blk_cnt;
+  uint32_t chunk, cnt, next, done = 0;
+  bool dbl, blkerr = false;
+  unsigned idx = 0;
+  size_t bs;
+
+  blkGetInfo(blkdev, &bdi);
+  bs = bdi.blk_size;
+  chunk = split_buffer(scsip, bs, buf);
+  dbl = chunk > 0U;
+  if (!dbl) {
+    chunk = 1;
+  }
+
+  cnt = left < chunk ? left : chunk;
+  if ((cnt > 0U) && (HAL_SUCCESS != blkRead(blkdev, lba, buf[0], cnt))) {
+    blkerr = true;
+  }
+
+  while ((left > 0U) && !blkerr) {
+    cnt = left < chunk ? left : chunk;
+    if (SCSI_SUCCESS != start_transmit(scsip, buf[idx], cnt * bs, &done)) {
+      scsip->residue = left * bs;
+      return SCSI_FAILED;
+    }
+    left -= cnt;
+    lba += cnt;
+
+    /* Reads ahead while the transport is busy.*/
+    next = left < chunk ? left : chunk;
+    if ((next > 0U) && dbl) {
+      blkerr = HAL_SUCCESS != blkRead(blkdev, lba, buf[idx ^ 1U], next);
+    }
+
+    done = wait_transmit(scsip, done);
+    if (done != cnt * bs) {
+      scsip->residue = (left + cnt) * bs - done;
+      return SCSI_FAILED;
+    }
+
+    if ((next > 0U) && !dbl) {
+      blkerr = HAL_SUCCESS != blkRead(blkdev, lba, buf[0], next);
+    }
+    if (dbl) {
+      idx ^= 1U;
+    }
+  }
+
+  if (blkerr) {
+    warnprintf("SCSI read error at LBA %u.\r\n", (unsigned)lba);
+    set_sense(scsip, SCSI_SENSE_KEY_MEDIUM_ERROR,
+                     SCSI_ASENSE_UNRECOVERED_READ_ERROR,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    scsip->residue = left * bs;
+    return SCSI_FAILED;
+  }
+
+  return SCSI_SUCCESS;
+}
+
+/**
+ * @brief   Streams blocks from the transport to the block device.
+ * @details While one half of the buffer is written the next blocks are
+ *          received into the other half. After a block device error the
+ *          remaining data is still received, as the host sends it anyway,
+ *          but discarded.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] req     decoded data request
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool data_write(SCSITarget *scsip, const data_request_t *req) {
+
+  BaseBlockDevice *blkdev = scsip->config->blkdev;
+  BlockDeviceInfo bdi;
+  uint8_t *buf[2];
+  uint32_t lba = (uint32_t)req->first_lba;
+  uint32_t left = req->blk_cnt;
+  uint32_t chunk, cnt, next, done = 0, failed = 0;
+  bool dbl, blkerr = false;
+  unsigned idx = 0;
+  size_t bs;
+
+  blkGetInfo(blkdev, &bdi);
+  bs = bdi.blk_size;
+  chunk = split_buffer(scsip, bs, buf);
+  dbl = chunk > 0U;
+  if (!dbl) {
+    chunk = 1;
+  }
+
+  cnt = left < chunk ? left : chunk;
+  if ((cnt > 0U) &&
+      (SCSI_SUCCESS != start_receive(scsip, buf[0], cnt * bs, &done))) {
+    scsip->residue = left * bs;
+    return SCSI_FAILED;
+  }
+
+  while (left > 0U) {
+    cnt = left < chunk ? left : chunk;
+    done = wait_receive(scsip, done);
+    if (done != cnt * bs) {
+      scsip->residue = left * bs - done;
+      return SCSI_FAILED;
+    }
+    left -= cnt;
+
+    /* Receives ahead while the block device is busy.*/
+    next = left < chunk ? left : chunk;
+    if ((next > 0U) && dbl) {
+      if (SCSI_SUCCESS != start_receive(scsip, buf[idx ^ 1U], next * bs, &done)) {
+        scsip->residue = left * bs;
+        return SCSI_FAILED;
+      }
+    }
+
+    if (!blkerr && (HAL_SUCCESS != blkWrite(blkdev, lba, buf[idx], cnt))) {
+      warnprintf("SCSI write error at LBA %u.\r\n", (unsigned)lba);
+      blkerr = true;
+      failed = left + cnt;
+    }
+    lba += cnt;
+
+    if ((next > 0U) && !dbl) {
+      if (SCSI_SUCCESS != start_receive(scsip, buf[0], next * bs, &done)) {
+        scsip->residue = left * bs;
+        return SCSI_FAILED;
+      }
+    }
+    if (dbl) {
+      idx ^= 1U;
+    }
+  }
+
+  if (blkerr) {
+    set_sense(scsip, SCSI_SENSE_KEY_MEDIUM_ERROR,
+                     SCSI_ASENSE_WRITE_FAULT,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    scsip->residue = failed * bs;
+    return SCSI_FAILED;
+  }
+
+  return SCSI_SUCCESS;
+}
+
+/**
+ * @brief   SCSI read/write (10) and (16) command handler.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] cmd     pointer to SCSI command data
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool data_read_write(SCSITarget *scsip, const uint8_t *cmd) {
 
   data_request_t req = decode_data_request(cmd);
 
   if (data_overflow(scsip, &req)) {
     return SCSI_FAILED;
   }
+  else if ((cmd[0] == SCSI_CMD_READ_10) || (cmd[0] == SCSI_CMD_READ_16)) {
+    return data_read(scsip, &req);
+  }
   else {
-    const SCSITransport *tr = scsip->config->transport;
-    BaseBlockDevice *blkdev = scsip->config->blkdev;
-    BlockDeviceInfo bdi;
-    blkGetInfo(blkdev, &bdi);
-    size_t bs = bdi.blk_size;
-    uint8_t *buf = scsip->config->blkbuf;
-
-    size_t i = 0;
-    for (i=0; i<req.blk_cnt; i++) {
-      if (cmd[0] == SCSI_CMD_READ_10) {
-        // TODO: block error handling
-        blkRead(blkdev, req.first_lba + i, buf, 1);
-        tr->transmit(tr, buf, bs);
-      }
-      else {
-        // TODO: block error handling
-        tr->receive(tr, buf, bs);
-        blkWrite(blkdev, req.first_lba + i, buf, 1);
-      }
+    return data_write(scsip, &req);
+  }
+}
+
+/**
+ * @brief   SCSI synchronize cache (10) and (16) command handler.
+ * @details The whole block device is synchronized whatever the range.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] cmd     pointer to SCSI command data
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool synchronize_cache(SCSITarget *scsip, const uint8_t *cmd) {
+  (void)cmd;
+
+  if (HAL_SUCCESS != blkSync(scsip->config->blkdev)) {
+    warnprintf("SCSI cache synchronization failed.\r\n");
+    set_sense(scsip, SCSI_SENSE_KEY_MEDIUM_ERROR,
+                     SCSI_ASENSE_WRITE_FAULT,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    return SCSI_FAILED;
+  }
+  else {
+    return SCSI_SUCCESS;
+  }
+}
+
+/**
+ * @brief   SCSI unmap command handler.
+ * @details The parameter list is received in the data buffer, each block
+ *          descriptor is range checked then passed to the unmap call of the
+ *          target configuration.
+ *
+ * @param[in] scsip   pointer to @p SCSITarget structure
+ * @param[in] cmd     pointer to SCSI command data
+ *
+ * @return            The operation status.
+ *
+ * @notapi
+ */
+static bool unmap(SCSITarget *scsip, const uint8_t *cmd) {
+
+  const SCSITransport *trp = scsip->config->transport;
+  uint8_t *buf = scsip->config->blkbuf;
+  uint32_t len = (uint32_t)cmd[7] << 8 | cmd[8];
+  uint32_t i, n, cnt;
+  uint64_t lba;
+
+  if (scsip->config->unmap == NULL) {
+    scsip->residue = len;
+    return cmd_unhandled(scsip, cmd);
+  }
+  if (len == 0U) {
+    return SCSI_SUCCESS;
+  }
+  if (len > buffer_size(scsip)) {
+    set_sense(scsip, SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                     SCSI_ASENSE_PARAMETER_LIST_LENGTH_ERROR,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    scsip->residue = len;
+    return SCSI_FAILED;
+  }
+
+  n = trp->receive(trp, buf, len);
+  if (n != len) {
+    scsip->residue = len - n;
+    return SCSI_FAILED;
+  }
+
+  if (len >= UNMAP_HEADER_LEN) {
+    n = (uint32_t)buf[2] << 8 | buf[3];
+  }
+  if ((len < UNMAP_HEADER_LEN) || (UNMAP_HEADER_LEN + n > len)) {
+    set_sense(scsip, SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                     SCSI_ASENSE_PARAMETER_LIST_LENGTH_ERROR,
+                     SCSI_ASENSEQ_NO_QUALIFIER);
+    return SCSI_FAILED;
+  }
+  n /= UNMAP_DESCRIPTOR_LEN;
+
+  /* All the descriptors are checked before anything is discarded.*/
+  for (i = 0; i < n; i++) {
+    const uint8_t *desc = &buf[UNMAP_HEADER_LEN + i * UNMAP_DESCRIPTOR_LEN];
+
+    memcpy(&lba, &desc[0], sizeof(lba));
+    memcpy(&cnt, &desc[8], sizeof(cnt));
+    if (range_overflow(scsip, be64_to_cpu(lba), be32_to_cpu(cnt))) {
+      return SCSI_FAILED;
     }
   }
+
+  for (i = 0; i < n; i++) {
+    const uint8_t *desc = &buf[UNMAP_HEADER_LEN + i * UNMAP_DESCRIPTOR_LEN];
+
+    memcpy(&lba, &desc[0], sizeof(lba));
+    memcpy(&cnt, &desc[8], sizeof(cnt));
+    lba = be64_to_cpu(lba);
+    cnt = be32_to_cpu(cnt);
+    if ((cnt > 0U) && (HAL_SUCCESS != scsip->config->unmap(
+                         scsip->config->blkdev, (uint32_t)lba, cnt))) {
+      warnprintf("SCSI unmap error at LBA %u.\r\n", (unsigned)lba);
+      set_sense(scsip, SCSI_SENSE_KEY_MEDIUM_ERROR,
+                       SCSI_ASENSE_WRITE_FAULT,
+                       SCSI_ASENSEQ_NO_QUALIFIER);
+      return SCSI_FAILED;
+    }
+  }
+
   return SCSI_SUCCESS;
 }
 
@@ -444,12 +1053,38 @@ bool scsiExecCmd(SCSITarget *scsip, const uint8_t *cmd) {
 
   case SCSI_CMD_READ_10:
     dbgprintf("SCSI_CMD_READ_10\r\n");
-    ret = data_read_write10(scsip, cmd);
+    ret = data_read_write(scsip, cmd);
     break;
 
   case SCSI_CMD_WRITE_10:
     dbgprintf("SCSI_CMD_WRITE_10\r\n");
-    ret = data_read_write10(scsip, cmd);
+    ret = data_read_write(scsip, cmd);
+    break;
+
+  case SCSI_CMD_READ_16:
+    dbgprintf("SCSI_CMD_READ_16\r\n");
+    ret = data_read_write(scsip, cmd);
+    break;
+
+  case SCSI_CMD_WRITE_16:
+    dbgprintf("SCSI_CMD_WRITE_16\r\n");
+    ret = data_read_write(scsip, cmd);
+    break;
+
+  case SCSI_CMD_SERVICE_ACTION_IN_16:
+    dbgprintf("SCSI_CMD_SERVICE_ACTION_IN_16\r\n");
+    ret = service_action_in16(scsip, cmd);
+    break;
+
+  case SCSI_CMD_SYNCHRONIZE_CACHE_10:
+  case SCSI_CMD_SYNCHRONIZE_CACHE_16:
+    dbgprintf("SCSI_CMD_SYNCHRONIZE_CACHE\r\n");
+    ret = synchronize_cache(scsip, cmd);
+    break;
+
+  case SCSI_CMD_UNMAP:
+    dbgprintf("SCSI_CMD_UNMAP\r\n");
+    ret = unmap(scsip, cmd);
     break;
 
   case SCSI_CMD_TEST_UNIT_READY:
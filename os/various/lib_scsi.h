@@ -41,6 +41,14 @@
 #define SCSI_CMD_READ_10                        0x28
 #define SCSI_CMD_WRITE_10                       0x2A
 #define SCSI_CMD_VERIFY_10                      0x2F
+#define SCSI_CMD_SYNCHRONIZE_CACHE_10           0x35
+#define SCSI_CMD_UNMAP                          0x42
+#define SCSI_CMD_READ_16                        0x88
+#define SCSI_CMD_WRITE_16                       0x8A
+#define SCSI_CMD_SYNCHRONIZE_CACHE_16           0x91
+#define SCSI_CMD_SERVICE_ACTION_IN_16           0x9E
+
+#define SCSI_SA_READ_CAPACITY_16                0x10
 
 #define SCSI_SENSE_KEY_GOOD                     0x00
 #define SCSI_SENSE_KEY_RECOVERED_ERROR          0x01
@@ -58,6 +66,7 @@
 #define SCSI_SENSE_KEY_MISCOMPARE               0x0E
 
 #define SCSI_ASENSE_NO_ADDITIONAL_INFORMATION   0x00
+#define SCSI_ASENSE_WRITE_FAULT                 0x03
 #define SCSI_ASENSE_LOGICAL_UNIT_NOT_READY      0x04
 #define SCSI_ASENSE_INVALID_FIELD_IN_CDB        0x24
 #define SCSI_ASENSE_NOT_READY_TO_READY_CHANGE   0x28
@@ -65,6 +74,9 @@
 #define SCSI_ASENSE_FORMAT_ERROR                0x31
 #define SCSI_ASENSE_INVALID_COMMAND             0x20
 #define SCSI_ASENSE_LBA_OUT_OF_RANGE            0x21
+#define SCSI_ASENSE_UNRECOVERED_READ_ERROR      0x11
+#define SCSI_ASENSE_PARAMETER_LIST_LENGTH_ERROR 0x1A
+#define SCSI_ASENSE_INVALID_FIELD_IN_PARAMETER_LIST 0x26
 #define SCSI_ASENSE_MEDIUM_NOT_PRESENT          0x3A
 
 #define SCSI_ASENSEQ_NO_QUALIFIER               0x00
@@ -198,6 +210,56 @@ typedef uint32_t (*scsi_transport_transmit_t)(const SCSITransport *transport,
 typedef uint32_t (*scsi_transport_receive_t)(const SCSITransport *transport,
                                              uint8_t *data, size_t len);
 
+/**
+ * @brief   Type of a SCSI transport asynchronous transmit start call.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ * @param[in] data      pointer to payload buffer, must stay valid until
+ *                      the matching wait call returns
+ * @param[in] len       payload length
+ *
+ * @return              The operation status.
+ */
+typedef bool (*scsi_transport_start_transmit_t)(const SCSITransport *transport,
+                                                const uint8_t *data, size_t len);
+
+/**
+ * @brief   Type of a SCSI transport asynchronous receive start call.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ * @param[out] data     pointer to receive buffer, must stay valid until
+ *                      the matching wait call returns
+ * @param[in] len       number of bytes to be received
+ *
+ * @return              The operation status.
+ */
+typedef bool (*scsi_transport_start_receive_t)(const SCSITransport *transport,
+                                               uint8_t *data, size_t len);
+
+/**
+ * @brief   Type of a SCSI transport asynchronous completion wait call.
+ *
+ * @param[in] transport pointer to the @p SCSITransport object
+ *
+ * @return              Number of bytes moved by the started transfer.
+ */
+typedef uint32_t (*scsi_transport_wait_t)(const SCSITransport *transport);
+
+/**
+ * @brief   Type of a block device unmap call.
+ * @details Tells the block device that a range of blocks no longer holds
+ *          useful data, flash based devices can erase it in background
+ *          instead of preserving it.
+ *
+ * @param[in] blkdev    pointer to the @p BaseBlockDevice object
+ * @param[in] startblk  first block to be unmapped
+ * @param[in] n         number of blocks to be unmapped
+ *
+ * @return              The operation status.
+ */
+typedef bool (*scsi_unmap_t)(BaseBlockDevice *blkdev,
+                             uint32_t startblk, uint32_t n);
+
 /**
  * @brief   SCSI transport structure.
  */
@@ -210,6 +272,26 @@ struct SCSITransport {
    * @brief   Receive call provided by lower level driver.
    */
   scsi_transport_receive_t      receive;
+  /**
+   * @brief   Asynchronous transmit start call, optional.
+   * @note    The asynchronous calls let the block device work while data
+   *          is moved. Each direction is optional on its own: a start call
+   *          is used only together with its wait call, if either one is
+   *          @p NULL the synchronous call of that direction is used.
+   */
+  scsi_transport_start_transmit_t start_transmit;
+  /**
+   * @brief   Asynchronous transmit completion wait call, optional.
+   */
+  scsi_transport_wait_t         wait_transmit;
+  /**
+   * @brief   Asynchronous receive start call, optional.
+   */
+  scsi_transport_start_receive_t start_receive;
+  /**
+   * @brief   Asynchronous receive completion wait call, optional.
+   */
+  scsi_transport_wait_t         wait_receive;
   /**
    * @brief   Transport handler provided by lower level driver.
    */
@@ -229,9 +311,17 @@ typedef struct {
    */
   BaseBlockDevice               *blkdev;
   /**
-   * @brief   Pointer to data buffer for single block.
+   * @brief   Pointer to data buffer, at least one block.
    */
   uint8_t                       *blkbuf;
+  /**
+   * @brief   Size of the data buffer in bytes.
+   * @details A buffer of two or more blocks is split in two halves and
+   *          READ/WRITE transfers are pipelined: the block device fills or
+   *          drains one half while the transport moves the other one.
+   *          Zero means a single block buffer.
+   */
+  size_t                        blkbuf_size;
   /**
    * @brief   Pointer to SCSI inquiry response object.
    */
@@ -240,6 +330,12 @@ typedef struct {
    * @brief   Pointer to SCSI unit serial number inquiry response object.
    */
   const scsi_unit_serial_number_inquiry_response_t *unit_serial_number_inquiry_response;
+  /**
+   * @brief   Block device unmap call, @p NULL if not supported.
+   * @details When provided logical block provisioning is advertised to the
+   *          host and UNMAP commands are passed to the block device.
+   */
+  scsi_unmap_t                  unmap;
 } SCSITargetConfig;
 
 /**
@@ -127,3 +127,184 @@ uint16_t middle_of_3(uint16_t a, uint16_t b, uint16_t c)
   }
   return middle;
 }
+
+/*
+ * Double heap median filter.
+ * The window is kept as a max-heap of the lower half and a min-heap of the
+ * upper half sharing the median at heap position 0: positions -1, -2, ...
+ * belong to the max-heap, positions 1, 2, ... to the min-heap. Each sample
+ * knows its heap position so the oldest one is replaced in place and
+ * sifted, every update is O(log N) compares and swaps.
+ */
+
+#define HEAP(conf, i)     ((conf)->slots[(i) + (conf)->size / 2].heap)
+#define VALUE(conf, i)    ((conf)->slots[HEAP(conf, i)].value)
+#define MIN_CT(conf)      (((conf)->count - 1) / 2)   /* Items in min-heap */
+#define MAX_CT(conf)      ((conf)->count / 2)         /* Items in max-heap */
+
+static bool heap_less(median_heap_t* conf, int i, int j)
+{
+  return VALUE(conf, i) < VALUE(conf, j);
+}
+
+static void heap_exchange(median_heap_t* conf, int i, int j)
+{
+  uint16_t t = HEAP(conf, i);
+
+  HEAP(conf, i) = HEAP(conf, j);
+  HEAP(conf, j) = t;
+  conf->slots[HEAP(conf, i)].pos = (int16_t)i;
+  conf->slots[HEAP(conf, j)].pos = (int16_t)j;
+}
+
+/* Swaps i and j if item i is less than item j. */
+static bool heap_cmp_exch(median_heap_t* conf, int i, int j)
+{
+  if (heap_less(conf, i, j))
+  {
+    heap_exchange(conf, i, j);
+    return true;
+  }
+  return false;
+}
+
+static void min_sort_down(median_heap_t* conf, int i)
+{
+  for (; i <= MIN_CT(conf); i *= 2)
+  {
+    if ((i > 1) && (i < MIN_CT(conf)) && heap_less(conf, i + 1, i))
+    {
+      ++i;                                        /* Pick the smaller child */
+    }
+    if (!heap_cmp_exch(conf, i, i / 2))
+    {
+      break;
+    }
+  }
+}
+
+static void max_sort_down(median_heap_t* conf, int i)
+{
+  for (; i >= -MAX_CT(conf); i *= 2)
+  {
+    if ((i < -1) && (i > -MAX_CT(conf)) && heap_less(conf, i, i - 1))
+    {
+      --i;                                        /* Pick the larger child */
+    }
+    if (!heap_cmp_exch(conf, i / 2, i))
+    {
+      break;
+    }
+  }
+}
+
+/* Returns true if the item reached the median position. */
+static bool min_sort_up(median_heap_t* conf, int i)
+{
+  while ((i > 0) && heap_cmp_exch(conf, i, i / 2))
+  {
+    i /= 2;
+  }
+  return i == 0;
+}
+
+static bool max_sort_up(median_heap_t* conf, int i)
+{
+  while ((i < 0) && heap_cmp_exch(conf, i / 2, i))
+  {
+    i /= 2;
+  }
+  return i == 0;
+}
+
+void median_heap_init(median_heap_t* conf, median_slot_t* buffer, uint16_t size)
+{
+  uint16_t i;
+
+  conf->slots = buffer;
+  conf->size = size;
+  conf->count = 0;
+  conf->idx = 0;
+
+  /* Age slots are laid out alternating around the median position. */
+  for (i = 0; i < size; i++)
+  {
+    int16_t pos = (int16_t)((i + 1) / 2) * ((i & 1) ? -1 : 1);
+
+    conf->slots[i].value = 0;
+    conf->slots[i].pos = pos;
+    HEAP(conf, pos) = i;
+  }
+}
+
+uint16_t median_heap_filter(median_heap_t* conf, uint16_t datum)
+{
+  bool is_new = conf->count < conf->size;
+  int p = conf->slots[conf->idx].pos;
+  uint16_t old = conf->slots[conf->idx].value;
+
+  conf->slots[conf->idx].value = datum;           /* Replace the oldest datum */
+  if (++conf->idx >= conf->size)
+  {
+    conf->idx = 0;
+  }
+  if (is_new)
+  {
+    conf->count++;
+  }
+
+  if (p > 0)                                      /* Datum is in the min-heap */
+  {
+    if (!is_new && (old < datum))
+    {
+      min_sort_down(conf, p * 2);
+    }
+    else if (min_sort_up(conf, p))
+    {
+      max_sort_down(conf, -1);
+    }
+  }
+  else if (p < 0)                                 /* Datum is in the max-heap */
+  {
+    if (!is_new && (datum < old))
+    {
+      max_sort_down(conf, p * 2);
+    }
+    else if (max_sort_up(conf, p))
+    {
+      min_sort_down(conf, 1);
+    }
+  }
+  else                                            /* Datum is the median */
+  {
+    if (MAX_CT(conf) > 0)
+    {
+      max_sort_down(conf, -1);
+    }
+    if (MIN_CT(conf) > 0)
+    {
+      min_sort_down(conf, 1);
+    }
+  }
+
+  return VALUE(conf, 0);
+}
+
+/*
+ * Filters an interleaved buffer, e.g. filled by ADC DMA, in one call.
+ * Sample c of frame f is in[f * channels + c] and is filtered by confs[c],
+ * results are written with the same layout, out may be equal to in.
+ */
+void median_heap_filter_batch(median_heap_t* confs, uint16_t channels,
+                              const uint16_t* in, uint16_t* out, size_t frames)
+{
+  uint16_t c;
+
+  while (frames-- > 0)
+  {
+    for (c = 0; c < channels; c++)
+    {
+      *out++ = median_heap_filter(&confs[c], *in++);
+    }
+  }
+}
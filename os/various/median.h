@@ -35,8 +35,28 @@ typedef struct
   pair_t big;          /* Pointer to head (largest) of linked list.*/
 } median_t;
 
+typedef struct
+{
+  uint16_t value;      /* Sample, indexed by age slot */
+  int16_t pos;         /* Heap position of the sample, indexed by age slot */
+  uint16_t heap;       /* Age slot of the sample at a heap position */
+} median_slot_t;
+
+typedef struct
+{
+  uint16_t size;       /* Window width, odd, 3 or more */
+  uint16_t count;      /* Number of samples received, up to size */
+  uint16_t idx;        /* Age slot of the next sample */
+  median_slot_t* slots;/* Buffer of size slots */
+} median_heap_t;
+
 void median_init(median_t* conf, uint16_t stopper, pair_t* buffer, uint16_t size);
 uint16_t median_filter(median_t* conf, uint16_t datum);
 uint16_t middle_of_3(uint16_t a, uint16_t b, uint16_t c);
 
+void median_heap_init(median_heap_t* conf, median_slot_t* buffer, uint16_t size);
+uint16_t median_heap_filter(median_heap_t* conf, uint16_t datum);
+void median_heap_filter_batch(median_heap_t* confs, uint16_t channels,
+                              const uint16_t* in, uint16_t* out, size_t frames);
+
 #endif /* MEDIAN_H_ */
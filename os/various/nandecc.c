@@ -0,0 +1,742 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    nandecc.c
+ * @brief   NAND page ECC source.
+ * @details Each 512 bytes subpage gets its own code in the spare area.
+ *          The Hamming code is the usual SLC one, row and column parities
+ *          in pairs, correcting one bit and detecting two. The BCH codes
+ *          work on GF(2^13): the parity is computed a byte at a time from
+ *          a table, on read the parity of the data is computed again and
+ *          the syndromes, Berlekamp-Massey and the Chien search are only
+ *          run when it differs.
+ *          The codes are stored so that an erased page, data and spare
+ *          all 0xFF, reads back as valid, bit flips included.
+ *
+ * @addtogroup nandecc
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+#include "nandecc.h"
+
+#include <string.h>
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Hamming code bits, two per address bit of the subpage.
+ */
+#define HAMMING_BITS            24U
+
+/**
+ * @brief   GF(2^13) parameters, primitive polynomial x^13+x^4+x^3+x+1.
+ */
+#define GF_M                    13U
+#define GF_N                    ((1U << GF_M) - 1U)
+#define GF_POLY                 0x201BU
+
+/**
+ * @brief   BCH limits.
+ */
+#define BCH_MAX_T               8U
+#define BCH_MAX_WORDS           ((GF_M * BCH_MAX_T + 31U) / 32U)
+#define BCH_MAX_BYTES           ((GF_M * BCH_MAX_T + 7U) / 8U)
+
+/**
+ * @brief   Data bits in a subpage.
+ */
+#define SUBPAGE_BITS            (NANDECC_SUBPAGE_SIZE * 8U)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local types.                                                       */
+/*===========================================================================*/
+
+#if (NANDECC_USE_BCH == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   BCH code.
+ * @details The parity register is left aligned: the coefficient of
+ *          x^(deg-1) is the MSB of the first word.
+ */
+typedef struct {
+  uint32_t      t;                            /**< @brief Bits corrected.*/
+  uint32_t      deg;                          /**< @brief Parity bits.*/
+  uint32_t      words;                        /**< @brief Register words.*/
+  uint32_t      table[256][BCH_MAX_WORDS];    /**< @brief Byte remainders.*/
+  uint8_t       mask[BCH_MAX_BYTES];          /**< @brief Erased page code
+                                                   inversion.*/
+} bch_t;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+static bool initialized;
+
+/**
+ * @brief   Parity of a byte.
+ */
+static uint8_t ham_parity[256];
+
+/**
+ * @brief   Positions of the bits set in a byte, XORed together.
+ */
+static uint8_t ham_column[256];
+
+#if (NANDECC_USE_BCH == TRUE) || defined(__DOXYGEN__)
+static uint16_t gf_exp[GF_N];
+static uint16_t gf_log[GF_N + 1U];
+static bch_t bch4, bch8;
+#endif
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Hamming code of a subpage.
+ * @details Bit 2k is the parity of the bits whose position in the subpage
+ *          has bit k set, bit 2k+1 of those with bit k clear. The rows are
+ *          the byte parities, XORing the index of the odd bytes gives all
+ *          the row parities at once.
+ */
+static uint32_t hamming_calc(const uint8_t *data) {
+
+  uint32_t i, k, pos, all, code = 0U, rows = 0U, cols = 0U;
+
+  for (i = 0; i < NANDECC_SUBPAGE_SIZE; i++) {
+    cols ^= data[i];
+    rows ^= i & (0U - (uint32_t)ham_parity[data[i]]);
+  }
+  pos = (rows << 3) | ham_column[cols];
+  all = ham_parity[cols];
+  for (k = 0; k < HAMMING_BITS / 2U; k++) {
+    code |= (((pos >> k) & 1U) << (2U * k)) |
+            ((((pos >> k) & 1U) ^ all) << (2U * k + 1U));
+  }
+  return code;
+}
+
+static void hamming_encode(const uint8_t *data, uint8_t *code) {
+
+  uint32_t c = ~hamming_calc(data);
+
+  code[0] = (uint8_t)c;
+  code[1] = (uint8_t)(c >> 8);
+  code[2] = (uint8_t)(c >> 16);
+}
+
+static int32_t hamming_correct(uint8_t *data, const uint8_t *code) {
+
+  uint32_t s, k, pos = 0U;
+
+  s = ~((uint32_t)code[0] | ((uint32_t)code[1] << 8) |
+        ((uint32_t)code[2] << 16));
+  s = (s ^ hamming_calc(data)) & ((1U << HAMMING_BITS) - 1U);
+  if (s == 0U) {
+    return 0;
+  }
+
+  /* A data bit flips exactly one parity of each pair.*/
+  if (((s ^ (s >> 1)) & 0x555555U) == 0x555555U) {
+    for (k = 0; k < HAMMING_BITS / 2U; k++) {
+      pos |= ((s >> (2U * k)) & 1U) << k;
+    }
+    data[pos >> 3] ^= (uint8_t)(1U << (pos & 7U));
+    return 1;
+  }
+
+  /* A single bit of the code itself.*/
+  if ((s & (s - 1U)) == 0U) {
+    return 1;
+  }
+  return NANDECC_UNCORRECTABLE;
+}
+
+/**
+ * @brief   Bits of the controller code of a page.
+ * @details Two per bit of the bit position in the page data.
+ */
+static uint32_t hw_code_bits(const NANDConfig *cfg) {
+
+  uint32_t n, bits = 0U;
+
+  for (n = cfg->page_data_size * 8U; n > 1U; n >>= 1) {
+    bits += 2U;
+  }
+  return bits;
+}
+
+/**
+ * @brief   Corrects a page with the controller code.
+ * @details Unlike the software code bit 2k+1 is the parity of the bits
+ *          whose position has bit k set, bit 2k of those with bit k clear.
+ */
+static int32_t hw_correct(const NANDConfig *cfg, uint8_t *data,
+                          uint32_t code, uint32_t ecc) {
+
+  const uint32_t bits = hw_code_bits(cfg);
+  uint32_t s, k, pos = 0U;
+
+  s = code ^ ecc;
+  if (bits < 32U) {
+    s &= (1U << bits) - 1U;
+  }
+  if (s == 0U) {
+    return 0;
+  }
+
+  /* A single bit of the code itself.*/
+  if ((s & (s - 1U)) == 0U) {
+    return 1;
+  }
+
+  /* A data bit flips exactly one parity of each pair.*/
+  for (k = 0; k < bits / 2U; k++) {
+    if ((((s >> (2U * k)) ^ (s >> (2U * k + 1U))) & 1U) == 0U) {
+      return NANDECC_UNCORRECTABLE;
+    }
+    pos |= ((s >> (2U * k + 1U)) & 1U) << k;
+  }
+  data[pos >> 3] ^= (uint8_t)(1U << (pos & 7U));
+  return 1;
+}
+
+#if (NANDECC_USE_BCH == TRUE) || defined(__DOXYGEN__)
+static uint16_t gf_mul(uint16_t a, uint16_t b) {
+
+  if ((a == 0U) || (b == 0U)) {
+    return 0U;
+  }
+  return gf_exp[(gf_log[a] + gf_log[b]) % GF_N];
+}
+
+static uint16_t gf_div(uint16_t a, uint16_t b) {
+
+  if (a == 0U) {
+    return 0U;
+  }
+  return gf_exp[(gf_log[a] + GF_N - gf_log[b]) % GF_N];
+}
+
+static void reg_shift(uint32_t *r, uint32_t words, unsigned n) {
+
+  uint32_t i;
+
+  for (i = 0; i + 1U < words; i++) {
+    r[i] = (r[i] << n) | (r[i + 1U] >> (32U - n));
+  }
+  r[i] <<= n;
+}
+
+/**
+ * @brief   Parity of a subpage, the remainder of data * x^deg by the
+ *          generator polynomial, left aligned.
+ */
+static void bch_calc(const bch_t *bch, const uint8_t *data, uint8_t *par) {
+
+  uint32_t r[BCH_MAX_WORDS] = {0};
+  const uint32_t *t;
+  uint32_t i, w;
+
+  for (i = 0; i < NANDECC_SUBPAGE_SIZE; i++) {
+    t = bch->table[(r[0] >> 24) ^ data[i]];
+    reg_shift(r, bch->words, 8U);
+    for (w = 0; w < bch->words; w++) {
+      r[w] ^= t[w];
+    }
+  }
+  for (i = 0; i < (bch->deg + 7U) / 8U; i++) {
+    par[i] = (uint8_t)(r[i / 4U] >> (24U - 8U * (i % 4U)));
+  }
+}
+
+/**
+ * @brief   Builds the generator polynomial and the byte table of a code.
+ * @details The generator is the product of the minimal polynomials of
+ *          alpha^1, alpha^3 ... alpha^(2t-1), each of degree 13.
+ */
+static void bch_init(bch_t *bch, uint32_t t) {
+
+  uint8_t g[GF_M * BCH_MAX_T + 1U] = {1U};
+  uint8_t ng[GF_M * BCH_MAX_T + 1U];
+  uint32_t gr[BCH_MAX_WORDS] = {0};
+  uint8_t ff[NANDECC_SUBPAGE_SIZE];
+  uint16_t mp[GF_M + 1U];
+  uint32_t i, j, k, e, deg = 0U, mdeg;
+
+  for (i = 1U; i < 2U * t; i += 2U) {
+    /* Minimal polynomial, product of (x + alpha^e) over the conjugates.*/
+    memset(mp, 0, sizeof(mp));
+    mp[0] = 1U;
+    mdeg = 0U;
+    e = i;
+    do {
+      mdeg++;
+      for (k = mdeg; k > 0U; k--) {
+        mp[k] = mp[k - 1U] ^ gf_mul(mp[k], gf_exp[e]);
+      }
+      mp[0] = gf_mul(mp[0], gf_exp[e]);
+      e = (e * 2U) % GF_N;
+    } while (e != i);
+
+    /* Its coefficients are binary, multiplied into the generator.*/
+    memset(ng, 0, sizeof(ng));
+    for (k = 0; k <= deg; k++) {
+      for (j = 0; (g[k] != 0U) && (j <= mdeg); j++) {
+        ng[k + j] ^= (uint8_t)mp[j];
+      }
+    }
+    memcpy(g, ng, sizeof(g));
+    deg += mdeg;
+  }
+  osalDbgAssert(deg == GF_M * t, "unexpected generator degree");
+
+  bch->t = t;
+  bch->deg = deg;
+  bch->words = (deg + 31U) / 32U;
+  for (k = 0; k < deg; k++) {
+    if (g[deg - 1U - k] != 0U) {
+      gr[k / 32U] |= 0x80000000U >> (k % 32U);
+    }
+  }
+  for (i = 0; i < 256U; i++) {
+    uint32_t *r = bch->table[i];
+    memset(r, 0, sizeof(bch->table[i]));
+    r[0] = i << 24;
+    for (j = 0; j < 8U; j++) {
+      bool fb = (r[0] & 0x80000000U) != 0U;
+      reg_shift(r, bch->words, 1U);
+      if (fb) {
+        for (k = 0; k < bch->words; k++) {
+          r[k] ^= gr[k];
+        }
+      }
+    }
+  }
+
+  /* Inverting the parity of an erased subpage makes its code all ones.*/
+  memset(ff, 0xFF, sizeof(ff));
+  bch_calc(bch, ff, bch->mask);
+  for (i = 0; i < (deg + 7U) / 8U; i++) {
+    bch->mask[i] ^= 0xFFU;
+  }
+}
+
+static void bch_encode(const bch_t *bch, const uint8_t *data, uint8_t *code) {
+
+  uint32_t i;
+
+  bch_calc(bch, data, code);
+  for (i = 0; i < (bch->deg + 7U) / 8U; i++) {
+    code[i] ^= bch->mask[i];
+  }
+}
+
+/**
+ * @brief   Corrects a subpage.
+ * @details Codeword bits are numbered from the last parity bit, x^0, to
+ *          the first data bit. The syndromes are taken on the remainder,
+ *          the received parity XOR the one of the received data, which is
+ *          congruent to the codeword.
+ */
+static int32_t bch_correct(const bch_t *bch, uint8_t *data,
+                           const uint8_t *code) {
+
+  const uint32_t t = bch->t, nbytes = (bch->deg + 7U) / 8U;
+  const uint32_t nbits = SUBPAGE_BITS + bch->deg;
+  uint8_t diff[BCH_MAX_BYTES];
+  uint16_t s[2U * BCH_MAX_T + 1U] = {0};
+  uint16_t c[2U * BCH_MAX_T + 1U] = {1U};
+  uint16_t b[2U * BCH_MAX_T + 1U] = {1U};
+  uint16_t tmp[2U * BCH_MAX_T + 1U];
+  uint32_t ev[BCH_MAX_T + 1U];
+  uint32_t pos[BCH_MAX_T];
+  uint32_t i, j, n, l = 0U, m = 1U, roots = 0U;
+  uint16_t d, bd = 1U, sum;
+  bool dirty = false;
+
+  bch_calc(bch, data, diff);
+  for (i = 0; i < nbytes; i++) {
+    diff[i] ^= code[i] ^ bch->mask[i];
+  }
+  if ((bch->deg % 8U) != 0U) {
+    diff[nbytes - 1U] &= (uint8_t)(0xFFU << (8U - bch->deg % 8U));
+  }
+  for (i = 0; i < nbytes; i++) {
+    dirty = dirty || (diff[i] != 0U);
+  }
+  if (!dirty) {
+    return 0;
+  }
+
+  /* Syndromes, the even ones are squares.*/
+  for (i = 0; i < bch->deg; i++) {
+    if ((diff[i / 8U] & (0x80U >> (i % 8U))) != 0U) {
+      for (j = 1U; j < 2U * t; j += 2U) {
+        s[j] ^= gf_exp[((bch->deg - 1U - i) * j) % GF_N];
+      }
+    }
+  }
+  for (j = 2U; j <= 2U * t; j += 2U) {
+    s[j] = gf_mul(s[j / 2U], s[j / 2U]);
+  }
+
+  /* Berlekamp-Massey, c is the error locator.*/
+  for (n = 0; n < 2U * t; n++) {
+    d = s[n + 1U];
+    for (i = 1U; i <= l; i++) {
+      d ^= gf_mul(c[i], s[n + 1U - i]);
+    }
+    if (d == 0U) {
+      m++;
+      continue;
+    }
+    memcpy(tmp, c, sizeof(tmp));
+    for (i = 0; i + m <= 2U * t; i++) {
+      c[i + m] ^= gf_mul(gf_div(d, bd), b[i]);
+    }
+    if (2U * l <= n) {
+      l = n + 1U - l;
+      memcpy(b, tmp, sizeof(b));
+      bd = d;
+      m = 1U;
+    }
+    else {
+      m++;
+    }
+  }
+  if (l > t) {
+    return NANDECC_UNCORRECTABLE;
+  }
+
+  /* Chien search, an error at x^k is a root at alpha^-k.*/
+  for (i = 1U; i <= l; i++) {
+    ev[i] = gf_log[c[i]];
+  }
+  for (n = 0; n < nbits; n++) {
+    sum = 1U;
+    for (i = 1U; i <= l; i++) {
+      if (c[i] != 0U) {
+        sum ^= gf_exp[ev[i]];
+        ev[i] = (ev[i] >= i) ? ev[i] - i : ev[i] + GF_N - i;
+      }
+    }
+    if (sum == 0U) {
+      if (roots == l) {
+        return NANDECC_UNCORRECTABLE;
+      }
+      pos[roots++] = n;
+    }
+  }
+  if (roots != l) {
+    return NANDECC_UNCORRECTABLE;
+  }
+
+  for (i = 0; i < roots; i++) {
+    if (pos[i] >= bch->deg) {
+      j = nbits - 1U - pos[i];
+      data[j / 8U] ^= (uint8_t)(0x80U >> (j % 8U));
+    }
+  }
+  return (int32_t)roots;
+}
+
+static const bch_t *bch_get(nandecc_type_t type) {
+
+  return (type == NANDECC_BCH4) ? &bch4 : &bch8;
+}
+#endif /* NANDECC_USE_BCH == TRUE */
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds the code tables.
+ * @note    Must be called once before any other function.
+ *
+ * @init
+ */
+void nandeccInit(void) {
+
+  uint32_t i, b;
+
+  if (initialized) {
+    return;
+  }
+
+  for (i = 0; i < 256U; i++) {
+    for (b = 0; b < 8U; b++) {
+      if ((i & (1U << b)) != 0U) {
+        ham_parity[i] ^= 1U;
+        ham_column[i] ^= (uint8_t)b;
+      }
+    }
+  }
+
+#if NANDECC_USE_BCH == TRUE
+  b = 1U;
+  for (i = 0; i < GF_N; i++) {
+    gf_exp[i] = (uint16_t)b;
+    gf_log[b] = (uint16_t)i;
+    b <<= 1;
+    if ((b & (1U << GF_M)) != 0U) {
+      b ^= GF_POLY;
+    }
+  }
+  bch_init(&bch4, 4U);
+  bch_init(&bch8, 8U);
+#endif
+
+  initialized = true;
+}
+
+/**
+ * @brief   Computes the code of a subpage.
+ *
+ * @param[in] type      the ECC type
+ * @param[in] data      @p NANDECC_SUBPAGE_SIZE bytes of data
+ * @param[out] code     @p NANDECC_CODE_SIZE(type) bytes of code
+ *
+ * @api
+ */
+void nandeccEncode(nandecc_type_t type, const uint8_t *data, uint8_t *code) {
+
+  osalDbgCheck((data != NULL) && (code != NULL));
+  osalDbgAssert(initialized, "not initialized");
+
+#if NANDECC_USE_BCH == TRUE
+  if (type != NANDECC_HAMMING) {
+    bch_encode(bch_get(type), data, code);
+    return;
+  }
+#endif
+  hamming_encode(data, code);
+}
+
+/**
+ * @brief   Corrects a subpage.
+ *
+ * @param[in] type      the ECC type
+ * @param[in,out] data  @p NANDECC_SUBPAGE_SIZE bytes of data
+ * @param[in] code      @p NANDECC_CODE_SIZE(type) bytes of code, as read
+ * @return              The number of bits corrected, data and code.
+ * @retval NANDECC_UNCORRECTABLE too many errors, data left untouched.
+ *
+ * @api
+ */
+int32_t nandeccCorrect(nandecc_type_t type, uint8_t *data,
+                       const uint8_t *code) {
+
+  osalDbgCheck((data != NULL) && (code != NULL));
+  osalDbgAssert(initialized, "not initialized");
+
+#if NANDECC_USE_BCH == TRUE
+  if (type != NANDECC_HAMMING) {
+    return bch_correct(bch_get(type), data, code);
+  }
+#endif
+  return hamming_correct(data, code);
+}
+
+/**
+ * @brief   Computes the codes of a page and stores them in its spare area.
+ * @note    Not usable with the controller code.
+ *
+ * @param[in] nandp     pointer to the @p NANDDriver object
+ * @param[in] eccp      pointer to the @p NandECCConfig object
+ * @param[in,out] buf   page buffer, data plus spare bytes
+ *
+ * @api
+ */
+void nandeccEncodePage(NANDDriver *nandp, const NandECCConfig *eccp,
+                       uint8_t *buf) {
+
+  const NANDConfig *cfg = nandp->config;
+  const uint32_t cs = NANDECC_CODE_SIZE(eccp->type);
+  uint8_t *code = &buf[cfg->page_data_size + eccp->spare_offset];
+  uint32_t i;
+
+  osalDbgCheck(!eccp->hw);
+  osalDbgCheck((cfg->page_data_size % NANDECC_SUBPAGE_SIZE) == 0U);
+  osalDbgCheck(eccp->spare_offset + cs *
+               (cfg->page_data_size / NANDECC_SUBPAGE_SIZE) <=
+               cfg->page_spare_size);
+
+  for (i = 0; i < cfg->page_data_size; i += NANDECC_SUBPAGE_SIZE) {
+    nandeccEncode(eccp->type, &buf[i], code);
+    code += cs;
+  }
+}
+
+/**
+ * @brief   Corrects a page with the codes in its spare area.
+ * @note    The spare area is not corrected.
+ * @note    Not usable with the controller code.
+ *
+ * @param[in] nandp     pointer to the @p NANDDriver object
+ * @param[in] eccp      pointer to the @p NandECCConfig object
+ * @param[in,out] buf   page buffer, data plus spare bytes
+ * @return              The highest number of bits corrected in a subpage.
+ * @retval NANDECC_UNCORRECTABLE a subpage could not be corrected, the
+ *                      other ones are.
+ *
+ * @api
+ */
+int32_t nandeccCorrectPage(NANDDriver *nandp, const NandECCConfig *eccp,
+                           uint8_t *buf) {
+
+  const NANDConfig *cfg = nandp->config;
+  const uint32_t cs = NANDECC_CODE_SIZE(eccp->type);
+  const uint8_t *code = &buf[cfg->page_data_size + eccp->spare_offset];
+  int32_t ret = 0, n;
+  bool failed = false;
+  uint32_t i;
+
+  osalDbgCheck(!eccp->hw);
+  osalDbgCheck((cfg->page_data_size % NANDECC_SUBPAGE_SIZE) == 0U);
+  osalDbgCheck(eccp->spare_offset + cs *
+               (cfg->page_data_size / NANDECC_SUBPAGE_SIZE) <=
+               cfg->page_spare_size);
+
+  for (i = 0; i < cfg->page_data_size; i += NANDECC_SUBPAGE_SIZE) {
+    n = nandeccCorrect(eccp->type, &buf[i], code);
+    code += cs;
+    if (n == NANDECC_UNCORRECTABLE) {
+      failed = true;
+    }
+    else if (n > ret) {
+      ret = n;
+    }
+  }
+  return failed ? NANDECC_UNCORRECTABLE : ret;
+}
+
+/**
+ * @brief   Writes a whole page with its codes.
+ * @note    With the controller code the data and the spare area are
+ *          programmed separately.
+ *
+ * @param[in] nandp     pointer to the @p NANDDriver object
+ * @param[in] eccp      pointer to the @p NandECCConfig object
+ * @param[in] die       die number in nand flash
+ * @param[in] logun     logical unit number in nand flash
+ * @param[in] plane     plane number in nand flash
+ * @param[in] block     block number
+ * @param[in] page      page number related to begin of block
+ * @param[in,out] buf   page buffer, data plus spare bytes, half word
+ *                      aligned, the codes are stored in it
+ * @return              The operation status reported by NAND IC (0x70
+ *                      command).
+ *
+ * @api
+ */
+uint8_t nandeccWritePage(NANDDriver *nandp, const NandECCConfig *eccp,
+                         uint32_t die, uint32_t logun, uint32_t plane,
+                         uint32_t block, uint32_t page, uint8_t *buf) {
+
+  const NANDConfig *cfg = nandp->config;
+  uint8_t *code = &buf[cfg->page_data_size + eccp->spare_offset];
+  uint32_t ecc;
+  uint8_t status;
+
+  if (eccp->hw) {
+    osalDbgCheck((eccp->type == NANDECC_HAMMING) &&
+                 (eccp->spare_offset + NANDECC_HW_CODE_SIZE <=
+                  cfg->page_spare_size));
+
+    status = nandWritePageData(nandp, die, logun, plane, block, page, buf,
+                               cfg->page_data_size, &ecc);
+    if ((status & NAND_STATUS_FAIL) != 0U) {
+      return status;
+    }
+
+    /* Inverted, an erased page has a zero code and reads as clean.*/
+    ecc = ~ecc;
+    code[0] = (uint8_t)ecc;
+    code[1] = (uint8_t)(ecc >> 8);
+    code[2] = (uint8_t)(ecc >> 16);
+    code[3] = (uint8_t)(ecc >> 24);
+    return nandWritePageSpare(nandp, die, logun, plane, block, page,
+                              &buf[cfg->page_data_size],
+                              cfg->page_spare_size);
+  }
+
+  nandeccEncodePage(nandp, eccp, buf);
+  return nandWritePageWhole(nandp, die, logun, plane, block, page, buf,
+                            cfg->page_data_size + cfg->page_spare_size);
+}
+
+/**
+ * @brief   Reads a whole page and corrects it.
+ *
+ * @param[in] nandp     pointer to the @p NANDDriver object
+ * @param[in] eccp      pointer to the @p NandECCConfig object
+ * @param[in] die       die number in nand flash
+ * @param[in] logun     logical unit number in nand flash
+ * @param[in] plane     plane number in nand flash
+ * @param[in] block     block number
+ * @param[in] page      page number related to begin of block
+ * @param[out] buf      page buffer, data plus spare bytes, half word
+ *                      aligned
+ * @return              The highest number of bits corrected in a subpage.
+ * @retval NANDECC_UNCORRECTABLE a subpage could not be corrected.
+ *
+ * @api
+ */
+int32_t nandeccReadPage(NANDDriver *nandp, const NandECCConfig *eccp,
+                        uint32_t die, uint32_t logun, uint32_t plane,
+                        uint32_t block, uint32_t page, uint8_t *buf) {
+
+  const NANDConfig *cfg = nandp->config;
+  const uint8_t *code = &buf[cfg->page_data_size + eccp->spare_offset];
+  uint32_t ecc;
+
+  if (eccp->hw) {
+    osalDbgCheck((eccp->type == NANDECC_HAMMING) &&
+                 (eccp->spare_offset + NANDECC_HW_CODE_SIZE <=
+                  cfg->page_spare_size));
+
+    nandReadPageData(nandp, die, logun, plane, block, page, buf,
+                     cfg->page_data_size, &ecc);
+    nandReadPageSpare(nandp, die, logun, plane, block, page,
+                      &buf[cfg->page_data_size], cfg->page_spare_size);
+    return hw_correct(cfg, buf,
+                      ~((uint32_t)code[0] | ((uint32_t)code[1] << 8) |
+                        ((uint32_t)code[2] << 16) |
+                        ((uint32_t)code[3] << 24)), ecc);
+  }
+
+  nandReadPageWhole(nandp, die, logun, plane, block, page, buf,
+                    cfg->page_data_size + cfg->page_spare_size);
+  return nandeccCorrectPage(nandp, eccp, buf);
+}
+
+#endif /* HAL_USE_NAND == TRUE */
+
+/** @} */
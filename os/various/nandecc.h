@@ -0,0 +1,152 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    nandecc.h
+ * @brief   NAND page ECC header.
+ *
+ * @addtogroup nandecc
+ * @{
+ */
+
+#ifndef NANDECC_H_
+#define NANDECC_H_
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Data bytes covered by each code.
+ */
+#define NANDECC_SUBPAGE_SIZE    512U
+
+/**
+ * @brief   Returned when a subpage holds more errors than the code can
+ *          correct.
+ */
+#define NANDECC_UNCORRECTABLE   (-1)
+
+/**
+ * @brief   Bytes of the controller code in the spare area.
+ */
+#define NANDECC_HW_CODE_SIZE    4U
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Enables the BCH codes.
+ * @note    The GF(2^13) tables and the BCH remainder tables take about
+ *          41kB of RAM, disabling this option leaves the Hamming code only.
+ */
+#if !defined(NANDECC_USE_BCH) || defined(__DOXYGEN__)
+#define NANDECC_USE_BCH         TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   ECC types.
+ * @details The value is the number of bits corrected per subpage.
+ */
+typedef enum {
+  NANDECC_HAMMING = 1,          /**< 1 bit, 2 detected, 3 bytes, SLC.     */
+#if (NANDECC_USE_BCH == TRUE) || defined(__DOXYGEN__)
+  NANDECC_BCH4 = 4,             /**< 4 bits, 7 bytes.                     */
+  NANDECC_BCH8 = 8              /**< 8 bits, 13 bytes.                    */
+#endif
+} nandecc_type_t;
+
+/**
+ * @brief   ECC configuration.
+ */
+typedef struct {
+  /**
+   * @brief   Code type.
+   */
+  nandecc_type_t      type;
+  /**
+   * @brief   Offset of the codes in the spare area.
+   * @note    The codes of the subpages are stored one after the other.
+   */
+  uint32_t            spare_offset;
+  /**
+   * @brief   Uses the Hamming code computed by the NAND controller.
+   * @details The code covers the whole page data, one bit is corrected
+   *          per page instead of per subpage. It is stored in
+   *          @p NANDECC_HW_CODE_SIZE bytes at @p spare_offset.
+   * @note    Only valid with @p NANDECC_HAMMING and with the page
+   *          functions, the LLD must return the code through the @p ecc
+   *          parameter of @p nandWritePageData() and @p nandReadPageData().
+   * @note    The controller gives the code once the data is programmed,
+   *          the spare area is programmed separately so the device must
+   *          allow two partial programs of a page.
+   */
+  bool                hw;
+} NandECCConfig;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Code size in bytes for a subpage.
+ *
+ * @param[in] type      the ECC type
+ */
+#define NANDECC_CODE_SIZE(type)                                             \
+  ((type) == 1 ? 3U : (13U * (uint32_t)(type) + 7U) / 8U)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void nandeccInit(void);
+  void nandeccEncode(nandecc_type_t type, const uint8_t *data, uint8_t *code);
+  int32_t nandeccCorrect(nandecc_type_t type, uint8_t *data,
+                         const uint8_t *code);
+  void nandeccEncodePage(NANDDriver *nandp, const NandECCConfig *eccp,
+                         uint8_t *buf);
+  int32_t nandeccCorrectPage(NANDDriver *nandp, const NandECCConfig *eccp,
+                             uint8_t *buf);
+  uint8_t nandeccWritePage(NANDDriver *nandp, const NandECCConfig *eccp,
+                           uint32_t die, uint32_t logun, uint32_t plane,
+                           uint32_t block, uint32_t page, uint8_t *buf);
+  int32_t nandeccReadPage(NANDDriver *nandp, const NandECCConfig *eccp,
+                          uint32_t die, uint32_t logun, uint32_t plane,
+                          uint32_t block, uint32_t page, uint8_t *buf);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_NAND */
+
+#endif /* NANDECC_H_ */
+
+/** @} */
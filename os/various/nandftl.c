@@ -0,0 +1,994 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    nandftl.c
+ * @brief   NAND flash translation layer source.
+ * @details Each written page carries a tag in the spare area: sector
+ *          number, sequence number, erase count of the block and CRC of
+ *          the data, protected by its own CRC. A page and its tag are
+ *          programmed together, the previous copy of the sector is left
+ *          in place, so that after a power loss the copy with the highest
+ *          sequence number is the last one completely written.
+ *          There are separate write heads for the host, the garbage
+ *          collector and the static wear leveling, so that data moved
+ *          because it lasted is not mixed with the data being rewritten.
+ *
+ * @addtogroup nandftl
+ * @{
+ */
+
+#include "hal.h"
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+#include "nandftl.h"
+
+#include <string.h>
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Write heads.
+ */
+#define HOST_HEAD               0U
+#define GC_HEAD                 1U
+#define WL_HEAD                 2U
+
+/**
+ * @brief   Invalid block index.
+ */
+#define NO_BLOCK                0xFFFFFFFFU
+
+/**
+ * @brief   Erase count not found while mounting.
+ */
+#define NO_COUNT                0xFFFFFFFFU
+
+/**
+ * @brief   Free blocks needed before a host write.
+ * @details One is taken by a write head, the other one is left to the
+ *          collector, which frees at least one block each time.
+ */
+#define MIN_FREE                2U
+
+/**
+ * @brief   Minimum number of reserved blocks.
+ * @details Free blocks and the unwritten parts of the heads, plus one
+ *          block worth of stale pages for the collector to make progress.
+ */
+#define MIN_RESERVED            (MIN_FREE + NANDFTL_HEADS + 1U)
+
+/**
+ * @name    Tag check results
+ * @{
+ */
+#define TAG_ERASED              0U
+#define TAG_VALID               1U
+#define TAG_INVALID             2U
+/** @} */
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Physical block address.
+ */
+typedef struct {
+  uint32_t      die;
+  uint32_t      logun;
+  uint32_t      plane;
+  uint32_t      block;
+} phys_t;
+
+/**
+ * @brief   Decoded page tag.
+ */
+typedef struct {
+  uint32_t      lpn;
+  uint32_t      seq;
+  uint32_t      erase_count;
+  uint16_t      dcrc;
+} tag_t;
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   CRC-16/CCITT, four bits at a time.
+ */
+static const uint16_t crc16_nibbles[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint16_t crc16(const uint8_t *p, size_t n) {
+
+  uint16_t crc = 0xFFFFU;
+
+  while (n-- > 0U) {
+    crc = (uint16_t)(crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (*p >> 4)];
+    crc = (uint16_t)(crc << 4) ^ crc16_nibbles[(crc >> 12) ^ (*p & 0x0FU)];
+    p++;
+  }
+  return crc;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32(const uint8_t *p) {
+
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void encode_tag(uint8_t *t, const tag_t *tag) {
+
+  uint16_t crc;
+
+  put32(&t[0], tag->lpn);
+  put32(&t[4], tag->seq);
+  put32(&t[8], tag->erase_count);
+  t[12] = (uint8_t)tag->dcrc;
+  t[13] = (uint8_t)(tag->dcrc >> 8);
+  crc = crc16(t, NANDFTL_TAG_SIZE - 2U);
+  t[14] = (uint8_t)crc;
+  t[15] = (uint8_t)(crc >> 8);
+}
+
+static unsigned decode_tag(const uint8_t *t, tag_t *tag) {
+
+  unsigned i;
+
+  for (i = 0; i < NANDFTL_TAG_SIZE; i++) {
+    if (t[i] != 0xFFU) {
+      break;
+    }
+  }
+  if (i == NANDFTL_TAG_SIZE) {
+    return TAG_ERASED;
+  }
+  if (crc16(t, NANDFTL_TAG_SIZE - 2U) != (t[14] | (t[15] << 8))) {
+    return TAG_INVALID;
+  }
+  tag->lpn = get32(&t[0]);
+  tag->seq = get32(&t[4]);
+  tag->erase_count = get32(&t[8]);
+  tag->dcrc = (uint16_t)(t[12] | (t[13] << 8));
+  return TAG_VALID;
+}
+
+/**
+ * @brief   Translates a block index of the FTL into a NAND address.
+ */
+static void locate(const NandFTL *ftlp, uint32_t blk, phys_t *ph) {
+
+  const NANDConfig *cfg = ftlp->config->nandp->config;
+  uint32_t n = ftlp->config->first_block + blk;
+
+  ph->block = n % cfg->blocks;
+  n /= cfg->blocks;
+  ph->plane = n % cfg->planes;
+  n /= cfg->planes;
+  ph->logun = n % cfg->loguns;
+  ph->die   = n / cfg->loguns;
+}
+
+static uint32_t ppb(const NandFTL *ftlp) {
+
+  return ftlp->config->nandp->config->pages_per_block;
+}
+
+static void lock(NandFTL *ftlp) {
+
+  osalMutexLock(&ftlp->mutex);
+#if NAND_USE_MUTUAL_EXCLUSION
+  nandAcquireBus(ftlp->config->nandp);
+#endif
+}
+
+static void unlock(NandFTL *ftlp) {
+
+#if NAND_USE_MUTUAL_EXCLUSION
+  nandReleaseBus(ftlp->config->nandp);
+#endif
+  osalMutexUnlock(&ftlp->mutex);
+}
+
+static unsigned read_tag(NandFTL *ftlp, uint32_t blk, uint32_t page,
+                         tag_t *tag) {
+
+  uint8_t *buf = ftlp->config->buffer;
+  phys_t ph;
+
+  locate(ftlp, blk, &ph);
+  nandReadPageSpare(ftlp->config->nandp, ph.die, ph.logun, ph.plane,
+                    ph.block, page, buf,
+                    NANDFTL_TAG_OFFSET + NANDFTL_TAG_SIZE);
+  return decode_tag(&buf[NANDFTL_TAG_OFFSET], tag);
+}
+
+/**
+ * @brief   Reads a whole page in the page buffer, corrected if ECC is used.
+ * @note    Uncorrectable pages are left to the data CRC check.
+ */
+static void read_page(NandFTL *ftlp, const phys_t *ph, uint32_t page) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  const NANDConfig *ncfg = cfg->nandp->config;
+
+  nandReadPageWhole(cfg->nandp, ph->die, ph->logun, ph->plane, ph->block,
+                    page, cfg->buffer,
+                    ncfg->page_data_size + ncfg->page_spare_size);
+  if ((cfg->ecc != NULL) &&
+      (nandeccCorrectPage(cfg->nandp, cfg->ecc, cfg->buffer) > 0)) {
+    ftlp->stats.ecc_corrected++;
+  }
+}
+
+static void mark_bad(NandFTL *ftlp, uint32_t blk) {
+
+  phys_t ph;
+
+  locate(ftlp, blk, &ph);
+  nandMarkBad(ftlp->config->nandp, ph.die, ph.logun, ph.plane, ph.block);
+  ftlp->config->blkinfo[blk].state = NANDFTL_BLK_BAD;
+  ftlp->stats.bad_blocks++;
+}
+
+static void set_dirty(NandFTL *ftlp, uint32_t blk) {
+
+  ftlp->config->blkinfo[blk].state = NANDFTL_BLK_DIRTY;
+  ftlp->free_blocks++;
+}
+
+/**
+ * @brief   Erases a free block.
+ * @details A block failing to erase is marked bad and no longer free.
+ */
+static bool erase_block(NandFTL *ftlp, uint32_t blk) {
+
+  nandftl_block_t *bi = &ftlp->config->blkinfo[blk];
+  phys_t ph;
+  uint8_t status;
+
+  locate(ftlp, blk, &ph);
+  status = nandErase(ftlp->config->nandp, ph.die, ph.logun, ph.plane,
+                     ph.block);
+  bi->erase_count++;
+  ftlp->stats.erases++;
+  ftlp->wl_erases++;
+  if ((status & NAND_STATUS_FAIL) != 0U) {
+    ftlp->free_blocks--;
+    mark_bad(ftlp, blk);
+    return HAL_FAILED;
+  }
+  bi->state = NANDFTL_BLK_ERASED;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Opens a new block on a write head.
+ * @details Dynamic wear leveling, the free block with the lowest erase
+ *          count is taken, except for the wear leveling head which takes
+ *          the one with the highest, cold data parks on worn blocks. An
+ *          already erased block is preferred on a tie.
+ */
+static bool alloc_block(NandFTL *ftlp, unsigned h) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  nandftl_block_t *bi;
+  uint32_t i, best, ec, bec;
+
+  while (true) {
+    best = NO_BLOCK;
+    bec = 0;
+    for (i = 0; i < cfg->blocks; i++) {
+      bi = &cfg->blkinfo[i];
+      if ((bi->state != NANDFTL_BLK_ERASED) &&
+          (bi->state != NANDFTL_BLK_DIRTY)) {
+        continue;
+      }
+      ec = h == WL_HEAD ? ~bi->erase_count : bi->erase_count;
+      if ((best == NO_BLOCK) || (ec < bec) ||
+          ((ec == bec) && (bi->state == NANDFTL_BLK_ERASED))) {
+        best = i;
+        bec = ec;
+      }
+    }
+    if (best == NO_BLOCK) {
+      return HAL_FAILED;
+    }
+    if ((cfg->blkinfo[best].state == NANDFTL_BLK_ERASED) ||
+        (HAL_SUCCESS == erase_block(ftlp, best))) {
+      break;
+    }
+  }
+
+  ftlp->free_blocks--;
+  cfg->blkinfo[best].state = NANDFTL_BLK_OPEN;
+  ftlp->head[h].blk = best;
+  ftlp->head[h].page = 0;
+  return HAL_SUCCESS;
+}
+
+static void close_head(NandFTL *ftlp, unsigned h) {
+
+  uint32_t blk = ftlp->head[h].blk;
+
+  if (blk == NO_BLOCK) {
+    return;
+  }
+  ftlp->head[h].blk = NO_BLOCK;
+  if (ftlp->config->blkinfo[blk].state == NANDFTL_BLK_OPEN) {
+    ftlp->config->blkinfo[blk].state = NANDFTL_BLK_FULL;
+    if (ftlp->config->blkinfo[blk].valid == 0U) {
+      set_dirty(ftlp, blk);
+    }
+  }
+}
+
+/**
+ * @brief   Drops a page holding a superseded sector.
+ */
+static void unmap(NandFTL *ftlp, uint32_t ppn) {
+
+  uint32_t blk = ppn / ppb(ftlp);
+  nandftl_block_t *bi = &ftlp->config->blkinfo[blk];
+
+  bi->valid--;
+  if (bi->valid == 0U) {
+    if (bi->state == NANDFTL_BLK_FULL) {
+      set_dirty(ftlp, blk);
+    }
+    else if (bi->state == NANDFTL_BLK_RETIRED) {
+      mark_bad(ftlp, blk);
+    }
+  }
+}
+
+/**
+ * @brief   Writes a sector at a write head.
+ * @details On a program failure the block is retired, the collector moves
+ *          its sectors, and the page is written again elsewhere with a
+ *          higher sequence number.
+ *
+ * @param[in] ftlp      pointer to the @p NandFTL object
+ * @param[in] h         write head
+ * @param[in] lpn       sector number
+ * @param[in] data      sector data, can be the page buffer itself
+ * @param[in] dcrc      CRC of the data
+ */
+static bool program(NandFTL *ftlp, unsigned h, uint32_t lpn,
+                    const uint8_t *data, uint16_t dcrc) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  const NANDConfig *ncfg = cfg->nandp->config;
+  uint8_t *buf = cfg->buffer;
+  nandftl_head_t *hp = &ftlp->head[h];
+  uint32_t blk, page;
+  phys_t ph;
+  tag_t tag;
+  uint8_t status;
+
+  while (true) {
+    if ((hp->blk == NO_BLOCK) || (hp->page == ppb(ftlp))) {
+      close_head(ftlp, h);
+      if (HAL_SUCCESS != alloc_block(ftlp, h)) {
+        return HAL_FAILED;
+      }
+    }
+    blk = hp->blk;
+    page = hp->page++;
+
+    if (data != buf) {
+      memcpy(buf, data, ncfg->page_data_size);
+    }
+    memset(&buf[ncfg->page_data_size], 0xFF, ncfg->page_spare_size);
+    tag.lpn = lpn;
+    tag.seq = ftlp->seq++;
+    tag.erase_count = cfg->blkinfo[blk].erase_count;
+    tag.dcrc = dcrc;
+    encode_tag(&buf[ncfg->page_data_size + NANDFTL_TAG_OFFSET], &tag);
+    if (cfg->ecc != NULL) {
+      nandeccEncodePage(cfg->nandp, cfg->ecc, buf);
+    }
+
+    locate(ftlp, blk, &ph);
+    status = nandWritePageWhole(cfg->nandp, ph.die, ph.logun, ph.plane,
+                                ph.block, page, buf,
+                                ncfg->page_data_size + ncfg->page_spare_size);
+    ftlp->stats.page_writes++;
+    if ((status & NAND_STATUS_FAIL) == 0U) {
+      break;
+    }
+
+    hp->blk = NO_BLOCK;
+    cfg->blkinfo[blk].state = NANDFTL_BLK_RETIRED;
+    if (cfg->blkinfo[blk].valid == 0U) {
+      mark_bad(ftlp, blk);
+    }
+  }
+
+  if (cfg->map[lpn] != NANDFTL_NO_PAGE) {
+    unmap(ftlp, cfg->map[lpn]);
+  }
+  cfg->map[lpn] = blk * ppb(ftlp) + page;
+  cfg->blkinfo[blk].valid++;
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Moves the current sectors of a block to a write head.
+ * @details When the last one is gone the block becomes free, or bad if it
+ *          was retired.
+ */
+static bool relocate(NandFTL *ftlp, uint32_t blk, unsigned h,
+                     uint32_t *counter) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  const NANDConfig *ncfg = cfg->nandp->config;
+  uint32_t page;
+  phys_t ph;
+  tag_t tag;
+
+  locate(ftlp, blk, &ph);
+  for (page = 0; (page < ppb(ftlp)) && (cfg->blkinfo[blk].valid > 0U);
+       page++) {
+    if ((TAG_VALID != read_tag(ftlp, blk, page, &tag)) ||
+        (tag.lpn >= ftlp->pages) ||
+        (cfg->map[tag.lpn] != blk * ppb(ftlp) + page)) {
+      continue;
+    }
+    read_page(ftlp, &ph, page);
+    if (crc16(cfg->buffer, ncfg->page_data_size) != tag.dcrc) {
+      /* Moved anyway with the original CRC, the error is not hidden.*/
+      ftlp->stats.crc_errors++;
+    }
+    if (HAL_SUCCESS != program(ftlp, h, tag.lpn, cfg->buffer, tag.dcrc)) {
+      return HAL_FAILED;
+    }
+    (*counter)++;
+  }
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Collects the block with the fewest current sectors.
+ * @details Retired blocks come first.
+ */
+static bool collect(NandFTL *ftlp) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  nandftl_block_t *bi;
+  uint32_t i, best = NO_BLOCK;
+
+  for (i = 0; i < cfg->blocks; i++) {
+    bi = &cfg->blkinfo[i];
+    if (bi->state == NANDFTL_BLK_RETIRED) {
+      best = i;
+      break;
+    }
+    if ((bi->state == NANDFTL_BLK_FULL) &&
+        ((best == NO_BLOCK) || (bi->valid < cfg->blkinfo[best].valid) ||
+         ((bi->valid == cfg->blkinfo[best].valid) &&
+          (bi->erase_count < cfg->blkinfo[best].erase_count)))) {
+      best = i;
+    }
+  }
+  if ((best == NO_BLOCK) || (cfg->blkinfo[best].valid >= ppb(ftlp))) {
+    return HAL_FAILED;
+  }
+  return relocate(ftlp, best, GC_HEAD, &ftlp->stats.gc_copies);
+}
+
+/**
+ * @brief   Static wear leveling.
+ * @details When the erase counts spread too much the data of the least
+ *          erased block, likely never rewritten, is moved so that the
+ *          block returns in use. The data has its own head, mixed with
+ *          the hot data it would make the collector move it again.
+ */
+static bool wear_level(NandFTL *ftlp) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  nandftl_block_t *bi;
+  uint32_t i, cold = NO_BLOCK, max = 0;
+
+  ftlp->wl_erases = 0;
+  if (cfg->wl_threshold == 0U) {
+    return HAL_SUCCESS;
+  }
+  for (i = 0; i < cfg->blocks; i++) {
+    bi = &cfg->blkinfo[i];
+    if (bi->state == NANDFTL_BLK_BAD) {
+      continue;
+    }
+    if (bi->erase_count > max) {
+      max = bi->erase_count;
+    }
+    if ((bi->state == NANDFTL_BLK_FULL) &&
+        ((cold == NO_BLOCK) ||
+         (bi->erase_count < cfg->blkinfo[cold].erase_count))) {
+      cold = i;
+    }
+  }
+  if ((cold == NO_BLOCK) ||
+      (max - cfg->blkinfo[cold].erase_count <= cfg->wl_threshold)) {
+    return HAL_SUCCESS;
+  }
+  return relocate(ftlp, cold, WL_HEAD, &ftlp->stats.wl_copies);
+}
+
+/**
+ * @brief   Collects blocks until a host write can proceed.
+ */
+static bool ensure_free(NandFTL *ftlp) {
+
+  uint32_t n = 0;
+
+  while (ftlp->free_blocks < MIN_FREE) {
+    if ((n++ == ftlp->config->blocks) || (HAL_SUCCESS != collect(ftlp))) {
+      return HAL_FAILED;
+    }
+  }
+  return HAL_SUCCESS;
+}
+
+/**
+ * @brief   Rebuilds the map and the block descriptors from the tags.
+ * @details Partially written blocks are not written further, blocks with
+ *          no current sector are erased before use. Blocks found erased
+ *          get the average erase count.
+ *          The data of the last programmed page of each block is checked
+ *          too, power may have gone away after its tag was programmed but
+ *          before its data was. If it is corrupted and it was the current
+ *          copy of its sector the previous copy is kept instead.
+ */
+static bool mount(NandFTL *ftlp) {
+
+  const NandFTLConfig *cfg = ftlp->config;
+  nandftl_block_t *bi;
+  uint32_t blk, page, old, bad = 0, known = 0;
+  uint64_t sum = 0;
+  bool any = false, mapped;
+  uint32_t maxseq = 0;
+  phys_t ph;
+  tag_t tag, oldtag;
+
+  for (page = 0; page < ftlp->pages; page++) {
+    cfg->map[page] = NANDFTL_NO_PAGE;
+  }
+
+  for (blk = 0; blk < cfg->blocks; blk++) {
+    bi = &cfg->blkinfo[blk];
+    bi->valid = 0;
+    bi->erase_count = NO_COUNT;
+    locate(ftlp, blk, &ph);
+    if (nandIsBad(cfg->nandp, ph.die, ph.logun, ph.plane, ph.block, 0)) {
+      bi->state = NANDFTL_BLK_BAD;
+      bad++;
+      continue;
+    }
+    bi->state = NANDFTL_BLK_DIRTY;
+
+    /* Set while the last programmed page is the current copy of its sector,
+       old is then the copy it replaced.*/
+    mapped = false;
+    old = NANDFTL_NO_PAGE;
+    for (page = 0; page < ppb(ftlp); page++) {
+      unsigned res = read_tag(ftlp, blk, page, &tag);
+      if (res == TAG_ERASED) {
+        break;
+      }
+      bi->state = NANDFTL_BLK_FULL;
+      mapped = false;
+      if (res != TAG_VALID) {
+        continue;
+      }
+      if ((bi->erase_count == NO_COUNT) ||
+          (tag.erase_count > bi->erase_count)) {
+        bi->erase_count = tag.erase_count;
+      }
+      if (!any || ((int32_t)(tag.seq - maxseq) > 0)) {
+        maxseq = tag.seq;
+        any = true;
+      }
+      if (tag.lpn >= ftlp->pages) {
+        continue;
+      }
+      old = cfg->map[tag.lpn];
+      if (old != NANDFTL_NO_PAGE) {
+        if ((TAG_VALID == read_tag(ftlp, old / ppb(ftlp), old % ppb(ftlp),
+                                   &oldtag)) &&
+            ((int32_t)(tag.seq - oldtag.seq) < 0)) {
+          continue;
+        }
+        cfg->blkinfo[old / ppb(ftlp)].valid--;
+      }
+      cfg->map[tag.lpn] = blk * ppb(ftlp) + page;
+      bi->valid++;
+      mapped = true;
+    }
+    if (mapped) {
+      read_page(ftlp, &ph, page - 1U);
+      if (crc16(cfg->buffer, cfg->nandp->config->page_data_size) !=
+          tag.dcrc) {
+        cfg->map[tag.lpn] = old;
+        if (old != NANDFTL_NO_PAGE) {
+          cfg->blkinfo[old / ppb(ftlp)].valid++;
+        }
+        bi->valid--;
+        ftlp->stats.torn_pages++;
+      }
+    }
+    if (bi->erase_count != NO_COUNT) {
+      sum += bi->erase_count;
+      known++;
+    }
+  }
+
+  if (bad + MIN_RESERVED - 1U > cfg->reserved_blocks) {
+    return HAL_FAILED;
+  }
+
+  ftlp->free_blocks = 0;
+  for (blk = 0; blk < cfg->blocks; blk++) {
+    bi = &cfg->blkinfo[blk];
+    if (bi->state == NANDFTL_BLK_BAD) {
+      continue;
+    }
+    if (bi->erase_count == NO_COUNT) {
+      bi->erase_count = known > 0U ? (uint32_t)(sum / known) : 0U;
+    }
+    if ((bi->state == NANDFTL_BLK_FULL) && (bi->valid == 0U)) {
+      bi->state = NANDFTL_BLK_DIRTY;
+    }
+    if (bi->state == NANDFTL_BLK_DIRTY) {
+      ftlp->free_blocks++;
+    }
+  }
+
+  ftlp->seq = any ? maxseq + 1U : 0U;
+  for (blk = 0; blk < NANDFTL_HEADS; blk++) {
+    ftlp->head[blk].blk = NO_BLOCK;
+  }
+  ftlp->wl_erases = 0;
+  return HAL_SUCCESS;
+}
+
+/*
+ * Interface implementation.
+ */
+static bool is_inserted(void *instance) {
+  NandFTL *ftlp = instance;
+  return (BLK_ACTIVE == ftlp->state) || (BLK_READY == ftlp->state);
+}
+
+static bool is_protected(void *instance) {
+  (void)instance;
+  return false;
+}
+
+static bool connect(void *instance) {
+  NandFTL *ftlp = instance;
+  bool ret = HAL_SUCCESS;
+
+  if (BLK_READY == ftlp->state) {
+    return HAL_SUCCESS;
+  }
+  if (BLK_ACTIVE != ftlp->state) {
+    return HAL_FAILED;
+  }
+  lock(ftlp);
+  ret = mount(ftlp);
+  if (HAL_SUCCESS == ret) {
+    ftlp->state = BLK_READY;
+  }
+  unlock(ftlp);
+  return ret;
+}
+
+static bool disconnect(void *instance) {
+  NandFTL *ftlp = instance;
+
+  if (BLK_READY == ftlp->state) {
+    ftlp->state = BLK_ACTIVE;
+  }
+  return HAL_SUCCESS;
+}
+
+static bool read(void *instance, uint32_t startblk,
+                 uint8_t *buffer, uint32_t n) {
+
+  NandFTL *ftlp = instance;
+  const NandFTLConfig *cfg = ftlp->config;
+  const NANDConfig *ncfg = cfg->nandp->config;
+  const uint8_t *tp = &cfg->buffer[ncfg->page_data_size + NANDFTL_TAG_OFFSET];
+  bool ret = HAL_SUCCESS;
+  uint32_t i, ppn;
+  phys_t ph;
+  tag_t tag;
+
+  if ((BLK_READY != ftlp->state) || (startblk > ftlp->pages) ||
+      (n > ftlp->pages - startblk)) {
+    return HAL_FAILED;
+  }
+
+  lock(ftlp);
+  for (i = 0; i < n; i++, buffer += ncfg->page_data_size) {
+    ppn = cfg->map[startblk + i];
+    ftlp->stats.host_reads++;
+    if (ppn == NANDFTL_NO_PAGE) {
+      memset(buffer, 0xFF, ncfg->page_data_size);
+      continue;
+    }
+    locate(ftlp, ppn / ppb(ftlp), &ph);
+    read_page(ftlp, &ph, ppn % ppb(ftlp));
+    if ((TAG_VALID != decode_tag(tp, &tag)) ||
+        (crc16(cfg->buffer, ncfg->page_data_size) != tag.dcrc)) {
+      ftlp->stats.crc_errors++;
+      ret = HAL_FAILED;
+    }
+    memcpy(buffer, cfg->buffer, ncfg->page_data_size);
+  }
+  unlock(ftlp);
+  return ret;
+}
+
+static bool write(void *instance, uint32_t startblk,
+                  const uint8_t *buffer, uint32_t n) {
+
+  NandFTL *ftlp = instance;
+  const uint32_t size = ftlp->config->nandp->config->page_data_size;
+  bool ret = HAL_SUCCESS;
+  uint32_t i;
+
+  if ((BLK_READY != ftlp->state) || (startblk > ftlp->pages) ||
+      (n > ftlp->pages - startblk)) {
+    return HAL_FAILED;
+  }
+
+  lock(ftlp);
+  for (i = 0; i < n; i++, buffer += size) {
+    if ((HAL_SUCCESS != ensure_free(ftlp)) ||
+        (HAL_SUCCESS != program(ftlp, HOST_HEAD, startblk + i, buffer,
+                                crc16(buffer, size)))) {
+      ret = HAL_FAILED;
+      break;
+    }
+    ftlp->stats.host_writes++;
+    if ((ftlp->wl_erases >= NANDFTL_WL_INTERVAL) &&
+        (ftlp->free_blocks >= MIN_FREE) &&
+        (HAL_SUCCESS != wear_level(ftlp))) {
+      ret = HAL_FAILED;
+      break;
+    }
+  }
+  unlock(ftlp);
+  return ret;
+}
+
+static bool sync(void *instance) {
+
+  NandFTL *ftlp = instance;
+  if (BLK_READY != ftlp->state) {
+    return HAL_FAILED;
+  }
+  return HAL_SUCCESS;
+}
+
+static bool get_info(void *instance, BlockDeviceInfo *bdip) {
+
+  NandFTL *ftlp = instance;
+  if (BLK_READY != ftlp->state) {
+    return HAL_FAILED;
+  }
+  else {
+    bdip->blk_num = ftlp->pages;
+    bdip->blk_size = ftlp->config->nandp->config->page_data_size;
+    return HAL_SUCCESS;
+  }
+}
+
+/**
+ *
+ */
+static const struct BaseBlockDeviceVMT vmt = {
+    (size_t)0,
+    is_inserted,
+    is_protected,
+    connect,
+    disconnect,
+    read,
+    write,
+    sync,
+    get_info
+};
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   NAND FTL object initialization.
+ *
+ * @param[in] ftlp  pointer to @p NandFTL object
+ *
+ * @init
+ */
+void nandftlObjectInit(NandFTL *ftlp) {
+
+  ftlp->vmt = &vmt;
+  ftlp->state = BLK_STOP;
+  ftlp->config = NULL;
+  osalMutexObjectInit(&ftlp->mutex);
+}
+
+/**
+ * @brief   Starts the NAND FTL.
+ * @details The FTL is mounted scanning the spare areas of the blocks, it
+ *          is ready on success, otherwise a later @p blkConnect() retries.
+ *          Blocks not written by the FTL are reused as free blocks.
+ * @pre     The NAND driver must be started.
+ *
+ * @param[in] ftlp      pointer to @p NandFTL object
+ * @param[in] config    pointer to the @p NandFTLConfig object
+ *
+ * @api
+ */
+void nandftlStart(NandFTL *ftlp, const NandFTLConfig *config) {
+
+  osalDbgCheck((ftlp != NULL) && (config != NULL) &&
+               (config->nandp != NULL) && (config->map != NULL) &&
+               (config->blkinfo != NULL) && (config->buffer != NULL) &&
+               (config->reserved_blocks >= MIN_RESERVED) &&
+               (config->blocks > config->reserved_blocks));
+  osalDbgCheck(config->nandp->config->page_spare_size >=
+               NANDFTL_TAG_OFFSET + NANDFTL_TAG_SIZE);
+  osalDbgCheck((config->ecc == NULL) ||
+               ((config->ecc->spare_offset >=
+                 NANDFTL_TAG_OFFSET + NANDFTL_TAG_SIZE) &&
+                !config->ecc->hw));
+  osalDbgAssert(ftlp->state == BLK_STOP, "invalid state");
+
+  if (config->ecc != NULL) {
+    nandeccInit();
+  }
+  ftlp->config = config;
+  ftlp->pages = NANDFTL_SECTORS(config->blocks, config->reserved_blocks,
+                                config->nandp->config->pages_per_block);
+  nandftlResetStats(ftlp);
+
+  ftlp->state = BLK_ACTIVE;
+  lock(ftlp);
+  if (HAL_SUCCESS == mount(ftlp)) {
+    ftlp->state = BLK_READY;
+  }
+  unlock(ftlp);
+}
+
+/**
+ * @brief   Stops the NAND FTL.
+ * @note    Nothing is cached, power can be removed at any time.
+ *
+ * @param[in] ftlp      pointer to @p NandFTL object
+ *
+ * @api
+ */
+void nandftlStop(NandFTL *ftlp) {
+
+  osalDbgCheck(ftlp != NULL);
+  osalDbgAssert((ftlp->state == BLK_ACTIVE) || (ftlp->state == BLK_READY),
+                "invalid state");
+
+  lock(ftlp);
+  ftlp->state = BLK_STOP;
+  unlock(ftlp);
+}
+
+/**
+ * @brief   Background garbage collection.
+ * @details Each step either collects a block, while there are less than
+ *          @p gc_target free blocks, or performs a pending static wear
+ *          leveling move, or erases a free block in advance, so that host
+ *          writes seldom have to wait for it. To be called from a low
+ *          priority thread.
+ *
+ * @param[in] ftlp      pointer to @p NandFTL object
+ * @param[in] n         maximum number of steps
+ *
+ * @return              The number of steps performed, less than @p n when
+ *                      there is nothing left to do.
+ *
+ * @api
+ */
+uint32_t nandftlGarbageCollect(NandFTL *ftlp, uint32_t n) {
+
+  const NandFTLConfig *cfg;
+  uint32_t done = 0, blk;
+
+  osalDbgCheck(ftlp != NULL);
+
+  lock(ftlp);
+  cfg = ftlp->config;
+  while ((BLK_READY == ftlp->state) && (done < n)) {
+    if (ftlp->free_blocks < cfg->gc_target) {
+      if (HAL_SUCCESS != collect(ftlp)) {
+        break;
+      }
+    }
+    else if (ftlp->wl_erases >= NANDFTL_WL_INTERVAL) {
+      if (HAL_SUCCESS != wear_level(ftlp)) {
+        break;
+      }
+    }
+    else {
+      for (blk = 0; blk < cfg->blocks; blk++) {
+        if (cfg->blkinfo[blk].state == NANDFTL_BLK_DIRTY) {
+          break;
+        }
+      }
+      if (blk == cfg->blocks) {
+        break;
+      }
+      (void)erase_block(ftlp, blk);
+    }
+    done++;
+  }
+  unlock(ftlp);
+  return done;
+}
+
+/**
+ * @brief   Clears the FTL statistics.
+ *
+ * @param[in] ftlp      pointer to @p NandFTL object
+ *
+ * @api
+ */
+void nandftlResetStats(NandFTL *ftlp) {
+
+  osalDbgCheck(ftlp != NULL);
+
+  memset(&ftlp->stats, 0, sizeof(ftlp->stats));
+}
+
+#endif /* HAL_USE_NAND */
+
+/** @} */
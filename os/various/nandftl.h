@@ -0,0 +1,246 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    nandftl.h
+ * @brief   NAND flash translation layer header.
+ * @details A @p NandFTL is a block device stacked on a range of NAND
+ *          blocks. Sectors are NAND pages, written out of place to the
+ *          head of a log and located through a RAM map rebuilt at start
+ *          from the tags stored in the spare areas.
+ *
+ * @addtogroup nandftl
+ * @{
+ */
+
+#ifndef NANDFTL_H_
+#define NANDFTL_H_
+
+#if (HAL_USE_NAND == TRUE) || defined(__DOXYGEN__)
+
+#include "nandecc.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Map entry of a sector never written.
+ */
+#define NANDFTL_NO_PAGE         0xFFFFFFFFU
+
+/**
+ * @brief   Offset of the tag in the spare area, after the bad block mark.
+ */
+#define NANDFTL_TAG_OFFSET      2U
+
+/**
+ * @brief   Size of the tag in the spare area.
+ */
+#define NANDFTL_TAG_SIZE        16U
+
+/**
+ * @brief   Number of write heads.
+ */
+#define NANDFTL_HEADS           3U
+
+/**
+ * @name    Block states
+ * @{
+ */
+#define NANDFTL_BLK_ERASED      0U  /**< @brief Free, erased.             */
+#define NANDFTL_BLK_DIRTY       1U  /**< @brief Free, to be erased.       */
+#define NANDFTL_BLK_OPEN        2U  /**< @brief Being filled.             */
+#define NANDFTL_BLK_FULL        3U  /**< @brief Filled.                   */
+#define NANDFTL_BLK_RETIRED     4U  /**< @brief Program failed, to be
+                                         emptied and marked bad.          */
+#define NANDFTL_BLK_BAD         5U  /**< @brief Not usable.               */
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Erase operations between two static wear leveling checks.
+ */
+#if !defined(NANDFTL_WL_INTERVAL) || defined(__DOXYGEN__)
+#define NANDFTL_WL_INTERVAL     16U
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if NANDFTL_WL_INTERVAL < 1U
+#error "invalid NANDFTL_WL_INTERVAL value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+typedef struct NandFTL NandFTL;
+
+/**
+ * @brief   Block descriptor.
+ */
+typedef struct {
+  uint32_t      erase_count;  /**< @brief Erase cycles.*/
+  uint16_t      valid;        /**< @brief Pages holding current sectors.*/
+  uint8_t       state;        /**< @brief Block state.*/
+} nandftl_block_t;
+
+/**
+ * @brief   FTL statistics.
+ * @note    The write amplification is @p page_writes / @p host_writes.
+ */
+typedef struct {
+  uint32_t      host_reads;   /**< @brief Sectors read.*/
+  uint32_t      host_writes;  /**< @brief Sectors written.*/
+  uint32_t      page_writes;  /**< @brief Pages programmed.*/
+  uint32_t      gc_copies;    /**< @brief Pages moved by the collector.*/
+  uint32_t      wl_copies;    /**< @brief Pages moved by wear leveling.*/
+  uint32_t      erases;       /**< @brief Blocks erased.*/
+  uint32_t      bad_blocks;   /**< @brief Blocks retired at run time.*/
+  uint32_t      crc_errors;   /**< @brief Pages read back corrupted.*/
+  uint32_t      ecc_corrected;/**< @brief Pages read back with bit errors
+                                   corrected.*/
+  uint32_t      torn_pages;   /**< @brief Pages found half programmed by
+                                   the mount, the previous copy of their
+                                   sector is kept.*/
+} nandftl_stats_t;
+
+/**
+ * @brief   FTL configuration.
+ * @note    Physical blocks are numbered as in the NAND driver bad block
+ *          map, that is plane, logical unit and die in this order.
+ */
+typedef struct {
+  /**
+   * @brief   Underlying NAND driver, started.
+   */
+  NANDDriver          *nandp;
+  /**
+   * @brief   First physical block.
+   */
+  uint32_t            first_block;
+  /**
+   * @brief   Number of physical blocks.
+   */
+  uint32_t            blocks;
+  /**
+   * @brief   Blocks not exported, for garbage collection and bad blocks.
+   * @note    At least 6.
+   */
+  uint32_t            reserved_blocks;
+  /**
+   * @brief   Erase count spread starting a static wear leveling move.
+   * @details Zero disables static wear leveling.
+   */
+  uint32_t            wl_threshold;
+  /**
+   * @brief   Free blocks kept by @p nandftlGarbageCollect().
+   */
+  uint32_t            gc_target;
+  /**
+   * @brief   Sector map, (@p blocks - @p reserved_blocks) * pages per
+   *          block elements.
+   */
+  uint32_t            *map;
+  /**
+   * @brief   Block descriptors, @p blocks elements.
+   */
+  nandftl_block_t     *blkinfo;
+  /**
+   * @brief   Page buffer, data plus spare bytes, half word aligned.
+   */
+  uint8_t             *buffer;
+  /**
+   * @brief   Page ECC, @p NULL if not used.
+   * @note    The codes go after the tag in the spare area.
+   * @note    The controller code is not supported, the tag and the codes
+   *          must be programmed with the data.
+   */
+  const NandECCConfig *ecc;
+} NandFTLConfig;
+
+/**
+ * @brief   Write log head.
+ */
+typedef struct {
+  uint32_t            blk;
+  uint32_t            page;
+} nandftl_head_t;
+
+/**
+ * @brief   @p NandFTL specific data.
+ */
+#define _nandftl_device_data                                                \
+  _base_block_device_data                                                   \
+  const NandFTLConfig     *config;                                          \
+  mutex_t                 mutex;                                            \
+  uint32_t                pages;                                            \
+  uint32_t                seq;                                              \
+  uint32_t                free_blocks;                                      \
+  uint32_t                wl_erases;                                        \
+  nandftl_head_t          head[NANDFTL_HEADS];                              \
+  nandftl_stats_t         stats;
+
+/**
+ * @brief   NAND flash translation layer block device.
+ */
+struct NandFTL {
+  /** @brief Virtual Methods Table.*/
+  const struct BaseBlockDeviceVMT *vmt;
+  _nandftl_device_data
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of sectors exported for a configuration.
+ *
+ * @param[in] blocks    number of physical blocks
+ * @param[in] reserved  number of reserved blocks
+ * @param[in] pages     number of pages per block
+ */
+#define NANDFTL_SECTORS(blocks, reserved, pages)                            \
+  (((blocks) - (reserved)) * (pages))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void nandftlObjectInit(NandFTL *ftlp);
+  void nandftlStart(NandFTL *ftlp, const NandFTLConfig *config);
+  void nandftlStop(NandFTL *ftlp);
+  uint32_t nandftlGarbageCollect(NandFTL *ftlp, uint32_t n);
+  void nandftlResetStats(NandFTL *ftlp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_NAND */
+
+#endif /* NANDFTL_H_ */
+
+/** @} */
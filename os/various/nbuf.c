@@ -0,0 +1,342 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "osal.h"
+#include "nbuf.h"
+
+/**
+ * @file    nbuf.c
+ * @brief   N-buffer handler source.
+ *
+ * @addtogroup NBuf
+ * @{
+ */
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Takes a slot out of the free mask.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Slot index, @p NBUF_NO_SLOT if no slot is free.
+ */
+static uint8_t take_free(nbuf_t *handler) {
+
+  uint8_t slot;
+
+  if (handler->free == 0U)
+    return NBUF_NO_SLOT;
+
+#if defined(__GNUC__)
+  slot = (uint8_t)__builtin_ctz(handler->free);
+#else
+  for (slot = 0U; (handler->free & (1U << slot)) == 0U; ++slot)
+    ;
+#endif
+  handler->free &= ~(1U << slot);
+  return slot;
+}
+
+/**
+ * @brief   Appends a slot to the ready queue.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @param[in] slot      Slot index.
+ */
+static void enqueue(nbuf_t *handler, uint8_t slot) {
+
+  uint8_t tail;
+
+  tail = (uint8_t)((handler->head + handler->count) % handler->n);
+  handler->slots[tail].queue = slot;
+  handler->count++;
+}
+
+/**
+ * @brief   Removes the oldest slot from the ready queue.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Slot index.
+ */
+static uint8_t dequeue(nbuf_t *handler) {
+
+  uint8_t slot;
+
+  slot = handler->slots[handler->head].queue;
+  handler->head = (uint8_t)((handler->head + 1U) % handler->n);
+  handler->count--;
+  return slot;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the nbuf handler object.
+ *
+ * @param[in] handler Pointer to the nbuf handler object.
+ * @param[in] slots   Pointer to an array of @p n slots.
+ * @param[in] buffers Pointer to an array of @p n buffer pointers.
+ * @param[in] n       Number of buffers, from 2 to @p NBUF_MAX_SLOTS.
+ * @param[in] policy  Behavior of the back buffer swap when no slot is free.
+ *
+ * @init
+ */
+void nbufObjectInit(nbuf_t *handler, nbuf_slot_t *slots,
+                    void *const *buffers, size_t n, nbufpolicy_t policy) {
+
+  size_t i;
+
+  osalDbgCheck((n >= 2U) && (n <= NBUF_MAX_SLOTS));
+
+  for (i = 0U; i < n; ++i) {
+    slots[i].buffer = buffers[i];
+    slots[i].seq = 0U;
+    slots[i].queue = NBUF_NO_SLOT;
+  }
+  handler->slots = slots;
+  handler->n = (uint8_t)n;
+  handler->policy = policy;
+  handler->seq = 0U;
+  handler->dropped = 0U;
+  handler->head = 0U;
+  handler->count = 0U;
+  handler->back = 0U;
+  handler->front = NBUF_NO_SLOT;
+  handler->free = (n == 32U ? 0xFFFFFFFFU : (1U << n) - 1U) & ~1U;
+#if (NBUF_USE_WAIT == TRUE)
+  handler->reader = NULL;
+  handler->writer = NULL;
+#endif
+}
+
+/**
+ * @brief   Gets the current back buffer.
+ * @details If the producer has no back buffer, because the previous swap
+ *          found no free slot, a free slot is taken if available.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Pointer to the current back buffer, @p NULL if no slot is free.
+ *
+ * @iclass
+ */
+void *nbufGetBackI(nbuf_t *handler) {
+
+  osalDbgCheckClassI();
+
+  if (handler->back == NBUF_NO_SLOT) {
+    handler->back = take_free(handler);
+    if (handler->back == NBUF_NO_SLOT)
+      return NULL;
+  }
+  return handler->slots[handler->back].buffer;
+}
+
+/**
+ * @brief   Gets the current back buffer.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Pointer to the current back buffer, @p NULL if no slot is free.
+ *
+ * @api
+ */
+void *nbufGetBack(nbuf_t *handler) {
+
+  void *back;
+
+  osalSysLock();
+  back = nbufGetBackI(handler);
+  osalSysUnlock();
+  return back;
+}
+
+/**
+ * @brief   Swaps the current back buffer.
+ *
+ * @details The current back buffer, which holds new useful data, is tagged
+ *          with the next sequence number and appended to the ready queue.
+ *          A free slot becomes the new back buffer, if none is free the
+ *          policy decides: with @p NBUF_DROP_OLDEST the oldest ready slot
+ *          is recycled, with @p NBUF_BLOCK the producer is left without
+ *          back buffer until the consumer releases one.
+ *
+ * @pre   The producer owns a back buffer.
+ * @post  A new front buffer is ready and signaled.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Availability of a new back buffer.
+ *
+ * @iclass
+ */
+bool nbufSwapBackI(nbuf_t *handler) {
+
+  osalDbgCheckClassI();
+  osalDbgAssert(handler->back != NBUF_NO_SLOT, "no back buffer");
+
+  handler->slots[handler->back].seq = handler->seq++;
+  enqueue(handler, handler->back);
+
+  handler->back = take_free(handler);
+  if ((handler->back == NBUF_NO_SLOT) &&
+      (handler->policy == NBUF_DROP_OLDEST)) {
+    handler->back = dequeue(handler);
+    handler->dropped++;
+  }
+
+#if (NBUF_USE_WAIT == TRUE)
+  osalThreadResumeI(&handler->reader, MSG_OK);
+#endif
+  return handler->back != NBUF_NO_SLOT;
+}
+
+/**
+ * @brief   Swaps the current back buffer.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ *
+ * @see nbufSwapBackI
+ * @api
+ */
+void nbufSwapBack(nbuf_t *handler) {
+
+  osalSysLock();
+  (void)nbufSwapBackI(handler);
+#if (NBUF_USE_WAIT == TRUE)
+  osalOsRescheduleS();
+#endif
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Swaps the current front buffer.
+ *
+ * @details If a ready slot is queued, the current front buffer is released
+ *          to the free slots and the oldest ready slot becomes the new front
+ *          buffer. Otherwise the current front buffer is kept.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Pointer to the new front buffer, @p NULL if none was ready.
+ *
+ * @iclass
+ */
+void *nbufSwapFrontI(nbuf_t *handler) {
+
+  osalDbgCheckClassI();
+
+  if (handler->count == 0U)
+    return NULL;
+
+  if (handler->front != NBUF_NO_SLOT) {
+    handler->free |= 1U << handler->front;
+#if (NBUF_USE_WAIT == TRUE)
+    osalThreadResumeI(&handler->writer, MSG_OK);
+#endif
+  }
+  handler->front = dequeue(handler);
+  return handler->slots[handler->front].buffer;
+}
+
+/**
+ * @brief   Swaps the current front buffer.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Pointer to the new front buffer, @p NULL if none was ready.
+ *
+ * @see nbufSwapFrontI
+ * @api
+ */
+void *nbufSwapFront(nbuf_t *handler) {
+
+  void *front;
+
+  osalSysLock();
+  front = nbufSwapFrontI(handler);
+#if (NBUF_USE_WAIT == TRUE)
+  osalOsRescheduleS();
+#endif
+  osalSysUnlock();
+  return front;
+}
+
+#if (NBUF_USE_WAIT == TRUE) || defined(__DOXYGEN__)
+
+/**
+ * @brief   Gets the current back buffer, waiting for a free slot.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @param[in] timeout   Timeout of the wait operation.
+ * @return  Pointer to the current back buffer, @p NULL on timeout.
+ *
+ * @api
+ */
+void *nbufGetBackTimeout(nbuf_t *handler, sysinterval_t timeout) {
+
+  void *back;
+
+  osalSysLock();
+  while ((back = nbufGetBackI(handler)) == NULL) {
+    if (osalThreadSuspendTimeoutS(&handler->writer, timeout) != MSG_OK)
+      break;
+  }
+  osalSysUnlock();
+  return back;
+}
+
+/**
+ * @brief   Swaps the current front buffer, waiting for a ready slot.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @param[in] timeout   Timeout of the wait operation.
+ * @return  Pointer to the new front buffer, @p NULL on timeout.
+ *
+ * @api
+ */
+void *nbufSwapFrontTimeout(nbuf_t *handler, sysinterval_t timeout) {
+
+  void *front;
+
+  osalSysLock();
+  while ((front = nbufSwapFrontI(handler)) == NULL) {
+    if (osalThreadSuspendTimeoutS(&handler->reader, timeout) != MSG_OK)
+      break;
+  }
+  osalOsRescheduleS();
+  osalSysUnlock();
+  return front;
+}
+
+#endif  /* (NBUF_USE_WAIT == TRUE) || defined(__DOXYGEN__) */
+
+/** @} */
@@ -0,0 +1,207 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    nbuf.h
+ * @brief   N-buffer handler header.
+ * @details Generalization of the triple buffer to 2..32 slots: the producer
+ *          owns a back slot, the consumer owns a front slot, the other slots
+ *          are either free or queued as ready in publication order. Every
+ *          swap is an O(1) exchange of slot indexes, buffers are never
+ *          copied.
+ *
+ * @addtogroup NBuf
+ * @{
+ */
+
+#ifndef NBUF_H_
+#define NBUF_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum number of slots.
+ */
+#define NBUF_MAX_SLOTS        32U
+
+/**
+ * @brief   Invalid slot index.
+ */
+#define NBUF_NO_SLOT          0xFFU
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    N-buffer configuration options
+ * @{
+ */
+
+/**
+ * @brief   N-buffers provide blocking functions.
+ */
+#if !defined(NBUF_USE_WAIT) || defined(__DOXYGEN__)
+#define NBUF_USE_WAIT         TRUE
+#endif
+
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Behavior of the back buffer swap when no slot is free.
+ */
+typedef enum {
+  NBUF_DROP_OLDEST = 0,       /**< @brief Oldest ready slot is recycled.*/
+  NBUF_BLOCK = 1              /**< @brief Producer waits for a free slot.*/
+} nbufpolicy_t;
+
+/**
+ * @brief   N-buffer slot.
+ */
+typedef struct {
+  void *buffer;               /**< @brief Buffer pointer.*/
+  uint32_t seq;               /**< @brief Sequence number of the content.*/
+  uint8_t queue;              /**< @brief Ready queue storage entry.*/
+} nbuf_slot_t;
+
+/**
+ * @brief   N-buffer handler object.
+ */
+typedef struct {
+  nbuf_slot_t *slots;         /**< @brief Slots array.*/
+  uint32_t free;              /**< @brief Mask of the free slots.*/
+  uint32_t seq;               /**< @brief Next sequence number.*/
+  uint32_t dropped;           /**< @brief Number of dropped ready slots.*/
+  nbufpolicy_t policy;        /**< @brief Full queue policy.*/
+  uint8_t n;                  /**< @brief Number of slots.*/
+  uint8_t back;               /**< @brief Producer slot.*/
+  uint8_t front;              /**< @brief Consumer slot.*/
+  uint8_t head;               /**< @brief Oldest ready queue entry.*/
+  uint8_t count;              /**< @brief Number of ready slots.*/
+#if (NBUF_USE_WAIT == TRUE)
+  thread_reference_t reader;  /**< @brief Thread waiting for a ready slot.*/
+  thread_reference_t writer;  /**< @brief Thread waiting for a free slot.*/
+#endif
+} nbuf_t;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Checks if a new front buffer is ready.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Availability of a new front buffer.
+ *
+ * @iclass
+ */
+static inline
+bool nbufIsReadyI(nbuf_t *handler)
+{
+  osalDbgCheckClassI();
+
+  return handler->count > 0U;
+}
+
+/**
+ * @brief   Gets the number of ready slots dropped so far.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Number of dropped slots.
+ *
+ * @iclass
+ */
+static inline
+uint32_t nbufGetDroppedI(nbuf_t *handler)
+{
+  osalDbgCheckClassI();
+
+  return handler->dropped;
+}
+
+/**
+ * @brief   Gets the current front buffer.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Pointer to the current front buffer, @p NULL if none.
+ *
+ * @iclass
+ */
+static inline
+void *nbufGetFrontI(nbuf_t *handler) {
+
+  osalDbgCheckClassI();
+
+  if (handler->front == NBUF_NO_SLOT)
+    return NULL;
+  return handler->slots[handler->front].buffer;
+}
+
+/**
+ * @brief   Gets the sequence number of the current front buffer.
+ * @details Sequence numbers are assigned by @p nbufSwapBackI(), a gap
+ *          between consecutive front buffers means that slots were dropped.
+ *
+ * @param[in] handler   Pointer to the nbuf handler object.
+ * @return  Sequence number of the current front buffer.
+ *
+ * @iclass
+ */
+static inline
+uint32_t nbufGetFrontSeqI(nbuf_t *handler) {
+
+  osalDbgCheckClassI();
+  osalDbgAssert(handler->front != NBUF_NO_SLOT, "no front buffer");
+
+  return handler->slots[handler->front].seq;
+}
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void nbufObjectInit(nbuf_t *handler, nbuf_slot_t *slots,
+                      void *const *buffers, size_t n, nbufpolicy_t policy);
+  void *nbufGetBackI(nbuf_t *handler);
+  void *nbufGetBack(nbuf_t *handler);
+  bool nbufSwapBackI(nbuf_t *handler);
+  void nbufSwapBack(nbuf_t *handler);
+  void *nbufSwapFrontI(nbuf_t *handler);
+  void *nbufSwapFront(nbuf_t *handler);
+#if (NBUF_USE_WAIT == TRUE) || defined(__DOXYGEN__)
+  void *nbufGetBackTimeout(nbuf_t *handler, sysinterval_t timeout);
+  void *nbufSwapFrontTimeout(nbuf_t *handler, sysinterval_t timeout);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* NBUF_H_ */
+/** @} */
@@ -119,6 +119,24 @@ static void testCrc(const CRCConfig *config, uint32_t result) {
 }
 
 
+static void testCrcCombine(const CRCConfig *config, uint32_t result) {
+  uint32_t crc1, crc2;
+  const size_t len1 = 13;
+
+  crcAcquireUnit(&CRCD1);             /* Acquire ownership of the bus.    */
+  crcStart(&CRCD1, config);           /* Activate CRC driver              */
+  crcReset(&CRCD1);
+  crc1 = crcCalc(&CRCD1, len1, &data[0]);
+  crcReset(&CRCD1);
+  crc2 = crcCalc(&CRCD1, sizeof(data) - len1, &data[len1]);
+  crcStop(&CRCD1);                    /* Deactive CRC driver);            */
+  crcReleaseUnit(&CRCD1);             /* Release ownership of the bus.    */
+
+  osalDbgAssert(crcCombine(config, crc1, crc2, sizeof(data) - len1) == result,
+                "Combined CRC does not match expected result");
+}
+
+
 #if CRC_USE_DMA
 static void testCrcDma(const CRCConfig *config, uint32_t result) {
   gCrc = 0;
@@ -154,6 +172,8 @@ static THD_FUNCTION(crc_thread_1, p) {
     testCrc(&crc16_config, 0xc36a);
     /* CRC8 Calculation */
     testCrc(&crc8_config, 0x06);
+    /* CRC32 of two segments merged */
+    testCrcCombine(&crc32_config, 0x91267e8a);
 
 /* Test ST CRC with DMA */
 #if CRC_USE_DMA == TRUE
@@ -180,6 +200,7 @@ static THD_FUNCTION(crc_thread_1, p) {
 #if CRCSW_CRC32_TABLE == TRUE
     /* CRC32 Calculation with table lookup */
     testCrc(CRCSW_CRC32_TABLE_CONFIG, 0x91267e8a);
+    testCrcCombine(CRCSW_CRC32_TABLE_CONFIG, 0x91267e8a);
 #endif
 #if CRCSW_CRC16_TABLE == TRUE
     /* CRC16 Calculation with table lookup */
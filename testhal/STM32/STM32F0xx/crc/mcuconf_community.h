@@ -117,6 +117,7 @@
 #define CRCSW_CRC32_TABLE                   TRUE
 #define CRCSW_CRC16_TABLE                   TRUE
 #define CRCSW_PROGRAMMABLE                  TRUE
+#define CRCSW_SLICING                       1
 
 /*
  * EICU driver system settings.
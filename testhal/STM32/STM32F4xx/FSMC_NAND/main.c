@@ -58,6 +58,9 @@
 
 #define USE_KILL_BLOCK_TEST       FALSE
 
+/* The device must implement the cache and multi-plane commands.*/
+#define USE_EXTENDED_CMDS_TEST    TRUE
+
 #define FSMCNAND_TIME_SET         ((uint32_t) 2) //(8nS)
 #define FSMCNAND_TIME_WAIT        ((uint32_t) 6) //(30nS)
 #define FSMCNAND_TIME_HOLD        ((uint32_t) 1) //(5nS)
@@ -81,6 +84,10 @@
 #define NAND_TEST_KILL_BLOCK      8000
 #endif
 
+#if USE_EXTENDED_CMDS_TEST
+#define NAND_TEST_CACHE_PAGES     4
+#endif
+
 #if STM32_NAND_USE_NAND1
   #define NAND                    NANDD1
 #elif STM32_NAND_USE_NAND2
@@ -133,6 +140,16 @@ static bitmap_t badblock_map = {
     BAD_MAP_LEN
 };
 
+#if USE_EXTENDED_CMDS_TEST
+static uint8_t cache_buf[NAND_TEST_CACHE_PAGES * NAND_PAGE_SIZE];
+static time_measurement_t tmu_ext_driver_start;
+static bitmap_word_t ext_map_array[BAD_MAP_LEN];
+static bitmap_t ext_map = {
+    ext_map_array,
+    BAD_MAP_LEN
+};
+#endif
+
 /*
  *
  */
@@ -150,6 +167,23 @@ static const NANDConfig nandcfg = {
           (FSMCNAND_TIME_WAIT << 8) | FSMCNAND_TIME_SET)
 };
 
+#if USE_EXTENDED_CMDS_TEST
+static const NANDConfig nandcfg_ext = {
+  .dies = NAND_DIES_COUNT,
+  .loguns = NAND_LOGUNS_COUNT,
+  .planes = NAND_PLANES_COUNT,
+  .blocks = NAND_BLOCKS_COUNT,
+  .page_data_size = NAND_PAGE_DATA_SIZE,
+  .page_spare_size = NAND_PAGE_SPARE_SIZE,
+  .pages_per_block = NAND_PAGES_PER_BLOCK,
+  .rowcycles = NAND_ROW_WRITE_CYCLES,
+  .colcycles = NAND_COL_WRITE_CYCLES,
+  .extended_cmds = true,
+  .pmem = ((FSMCNAND_TIME_HIZ << 24) | (FSMCNAND_TIME_HOLD << 16) | \
+          (FSMCNAND_TIME_WAIT << 8) | FSMCNAND_TIME_SET)
+};
+#endif
+
 static volatile uint32_t BackgroundThdCnt = 0;
 static thread_reference_t background_thd_ptr = NULL;
 
@@ -507,6 +541,78 @@ static void general_test (NANDDriver *nandp, size_t first,
   red_led_off();
 }
 
+/*
+ *
+ */
+#if USE_EXTENDED_CMDS_TEST
+static void extended_cmds_test(NANDDriver *nandp, uint32_t block){
+
+  size_t i;
+  uint8_t op_status;
+
+  /* pipelined scan must find the same bad blocks */
+  chTMObjectInit(&tmu_ext_driver_start);
+  chTMStartMeasurementX(&tmu_ext_driver_start);
+  nandStart(nandp, &nandcfg_ext, &ext_map);
+  chTMStopMeasurementX(&tmu_ext_driver_start);
+  osalDbgCheck(0 == memcmp(badblock_map_array, ext_map_array,
+                           sizeof(ext_map_array))); /* scans differ */
+
+  /* This test requires good block.*/
+  osalDbgCheck(!nandIsBad(nandp, 0, 0, 0, block, 0));
+  op_status = nandEraseMultiPlane(nandp, 0, 0, block);
+  osalDbgCheck(0 == (op_status & 1)); /* operation failed */
+  osalDbgCheck(is_erased(nandp, block)); /* block was not erased */
+
+  for (i=0; i<sizeof(cache_buf); i++)
+    cache_buf[i] = rand() & 0xFF;
+  for (i=0; i<NAND_TEST_CACHE_PAGES; i++){
+    /* protect bad mark */
+    cache_buf[i * NAND_PAGE_SIZE + NAND_PAGE_DATA_SIZE]     = 0xFF;
+    cache_buf[i * NAND_PAGE_SIZE + NAND_PAGE_DATA_SIZE + 1] = 0xFF;
+  }
+
+  /* cache program, read back page by page */
+  op_status = nandWritePagesCached(nandp, 0, 0, 0, block, 0,
+                cache_buf, NAND_PAGE_SIZE, NAND_TEST_CACHE_PAGES);
+  osalDbgCheck(0 == (op_status & 1)); /* operation failed */
+  for (i=0; i<NAND_TEST_CACHE_PAGES; i++){
+    nandReadPageWhole(nandp, 0, 0, 0, block, i, nand_buf, NAND_PAGE_SIZE);
+    osalDbgCheck(0 == memcmp(&cache_buf[i * NAND_PAGE_SIZE], nand_buf,
+                             NAND_PAGE_SIZE)); /* Read back failed */
+  }
+
+  /* cache read, compared page by page */
+  memset(cache_buf, 0, sizeof(cache_buf));
+  nandReadPagesCached(nandp, 0, 0, 0, block, 0,
+                cache_buf, NAND_PAGE_SIZE, NAND_TEST_CACHE_PAGES);
+  for (i=0; i<NAND_TEST_CACHE_PAGES; i++){
+    nandReadPageWhole(nandp, 0, 0, 0, block, i, nand_buf, NAND_PAGE_SIZE);
+    osalDbgCheck(0 == memcmp(&cache_buf[i * NAND_PAGE_SIZE], nand_buf,
+                             NAND_PAGE_SIZE)); /* Cache read failed */
+  }
+
+  /* multi-plane program of the next page, one buffer page per plane */
+  osalDbgCheck(NAND_PLANES_COUNT <= NAND_TEST_CACHE_PAGES);
+  op_status = nandWritePageMultiPlane(nandp, 0, 0, block,
+                NAND_TEST_CACHE_PAGES, cache_buf, NAND_PAGE_SIZE);
+  osalDbgCheck(0 == (op_status & 1)); /* operation failed */
+  for (i=0; i<NAND_PLANES_COUNT; i++){
+    nandReadPageWhole(nandp, 0, 0, i, block, NAND_TEST_CACHE_PAGES,
+                nand_buf, NAND_PAGE_SIZE);
+    osalDbgCheck(0 == memcmp(&cache_buf[i * NAND_PAGE_SIZE], nand_buf,
+                             NAND_PAGE_SIZE)); /* Read back failed */
+  }
+
+  /* make clean */
+  op_status = nandEraseMultiPlane(nandp, 0, 0, block);
+  osalDbgCheck(0 == (op_status & 1)); /* operation failed */
+  osalDbgCheck(is_erased(nandp, block)); /* block was not erased */
+
+  nandStart(nandp, &nandcfg, &badblock_map);
+}
+#endif /* USE_EXTENDED_CMDS_TEST */
+
 /*
  *
  */
@@ -573,6 +679,14 @@ static void nand_test(bool use_badblock_map) {
    * perform ECC calculation test
    */
   ecc_test(&NAND, NAND_TEST_END_BLOCK);
+
+#if USE_EXTENDED_CMDS_TEST
+  /*
+   * compare the cache and multi-plane commands with the page ones
+   */
+  if (use_badblock_map)
+    extended_cmds_test(&NAND, NAND_TEST_END_BLOCK + 1);
+#endif
 }
 
 /*
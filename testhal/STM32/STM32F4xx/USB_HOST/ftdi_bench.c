@@ -0,0 +1,84 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "ftdi_bench.h"
+
+#if HAL_USE_USBH && HAL_USBH_USE_FTDI
+
+#include "usbh/debug.h"     /* for _usbh_dbg/_usbh_dbgf */
+
+/* An idle FTDI port keeps its Bulk IN endpoint busy: the chip NAKs until
+ * the latency timer expires and then sends the two modem status bytes.
+ * This measures the OTG interrupt rate that costs while nothing is received.
+ */
+bool ftdiBenchIdleRun(USBHFTDIPortDriver *ftdipp) {
+    USBHDriver *const host = usbhftdipGetHost(ftdipp);
+    usbh_ep_t *const ep = &ftdipp->epin;
+    uint32_t irqs, sofs, naks, parks;
+    systime_t st;
+    uint32_t ms;
+    int i;
+
+    _usbh_dbgf(host, "BENCH: Idle FTDI, NAK backoff %u frame(s)",
+            STM32_USBH_NAK_BACKOFF_FRAMES);
+
+    for (i = 0; i < FTDI_BENCH_SAMPLES; i++) {
+        if (usbhftdipGetState(ftdipp) != USBHFTDIP_STATE_READY)
+            return HAL_FAILED;
+
+        chSysLock();
+        irqs = host->irq_count;
+        sofs = host->sof_count;
+        naks = ep->nak_count;
+        parks = ep->park_count;
+        st = chVTGetSystemTimeX();
+        chSysUnlock();
+
+        chThdSleepMilliseconds(FTDI_BENCH_SAMPLE_MS);
+
+        chSysLock();
+        irqs = host->irq_count - irqs;
+        sofs = host->sof_count - sofs;
+        naks = ep->nak_count - naks;
+        parks = ep->park_count - parks;
+        ms = TIME_I2MS(chVTTimeElapsedSinceX(st));
+        chSysUnlock();
+
+        if (ms == 0)
+            ms = 1;
+        _usbh_dbgf(host, "BENCH: %u IRQ/s (%u SOF/s), Bulk IN %u NAK/s, %u parks/s",
+                (uint32_t)(((uint64_t)irqs * 1000U) / ms),
+                (uint32_t)(((uint64_t)sofs * 1000U) / ms),
+                (uint32_t)(((uint64_t)naks * 1000U) / ms),
+                (uint32_t)(((uint64_t)parks * 1000U) / ms));
+    }
+
+#if STM32_USBH_LATENCY_HISTOGRAM
+    /* frames the Bulk IN endpoint waited for a channel, log2 buckets */
+    for (i = 0; i < STM32_USBH_LATENCY_BUCKETS - 1; i++) {
+        _usbh_dbgf(host, "BENCH: latency <%u frames: %u",
+                1U << i, ep->latency[i]);
+    }
+    _usbh_dbgf(host, "BENCH: latency >=%u frames: %u",
+            1U << (i - 1), ep->latency[i]);
+#endif
+
+    return HAL_SUCCESS;
+}
+
+#endif
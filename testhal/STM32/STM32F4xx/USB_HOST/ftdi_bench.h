@@ -0,0 +1,42 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef FTDI_BENCH_H_
+#define FTDI_BENCH_H_
+
+#include "hal_usbh.h"
+
+#if HAL_USE_USBH && HAL_USBH_USE_FTDI
+
+#include "usbh/dev/ftdi.h"
+
+/* Duration of each sample; the port must be started and receive no data */
+#define FTDI_BENCH_SAMPLE_MS                1000
+
+/* Number of samples */
+#define FTDI_BENCH_SAMPLES                  5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    bool ftdiBenchIdleRun(USBHFTDIPortDriver *ftdipp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif /* FTDI_BENCH_H_ */
@@ -46,6 +46,7 @@ static uint8_t buf[] =
 
 #if HAL_USBH_USE_FTDI
 #include "usbh/dev/ftdi.h"
+#include "ftdi_bench.h"
 #include "shell.h"
 #include "chprintf.h"
 
@@ -110,6 +111,14 @@ start:
 
     usbhftdipStart(ftdipp, &config);
 
+    //idle interrupt rate benchmark
+    if (1) {
+        if (ftdiBenchIdleRun(ftdipp) != HAL_SUCCESS) {
+            _usbh_dbg(host, "FTDI: Disconnected");
+            goto start;
+        }
+    }
+
     //loopback
     if (0) {
         for(;;) {
@@ -304,6 +313,7 @@ start:
 #include "usbh/dev/msd.h"
 #include "ff.h"
 #include "fatfs_devices.h"
+#include "msd_bench.h"
 
 static FATFS MSDLUN0FS;
 
@@ -373,25 +383,10 @@ start:
     	_usbh_dbg(host, "BLK: Ready.");
 
 #if !UVC_TO_MSD_PHOTOS_CAPTURE
-        //raw read test
+        //raw read/write benchmark
         if (1) {
-#define RAW_READ_SZ_MB        1
-#define NBLOCKS                (sizeof(fbuff) / 512)
-#define NITERATIONS            ((RAW_READ_SZ_MB * 1024UL * 1024UL) / sizeof(fbuff))
-            uint32_t start = 0;
-            chThdSetPriority(HIGHPRIO);
-            _usbh_dbgf(host, "BLK: Raw read test (%dMB, %dB blocks)", RAW_READ_SZ_MB, sizeof(fbuff));
-            st = chVTGetSystemTime();
-            for (j = 0; j < NITERATIONS; j++) {
-                if (blkRead(&MSBLKD[0], start, fbuff, NBLOCKS) != HAL_SUCCESS)
-                    goto start;
-                start += NBLOCKS;
-            }
-            et = chVTGetSystemTime();
-            _usbh_dbgf(host, "BLK: Raw read in %d ms, %dkB/s",
-                    et - st,
-                    (RAW_READ_SZ_MB * 1024UL * 1000) / (et - st));
-            chThdSetPriority(NORMALPRIO);
+            if (msdBenchRun(&MSBLKD[0]) != HAL_SUCCESS)
+                goto start;
         }
 #endif
 
@@ -510,7 +505,16 @@ static void _hid_report_callback(USBHHIDDriver *hidp, uint16_t len) {
                 report[6],
                 report[7]);
     } else {
+#if HAL_USBHHID_USE_PARSER
+        static int32_t values[HAL_USBHHID_MAX_FIELDS];
+        rtcnt_t t = chSysGetRealtimeCounterX();
+        uint8_t n = usbhhidDecodeReport(hidp, report, len, values);
+        t = chSysGetRealtimeCounterX() - t;
+        _usbh_dbgf(hidp->dev->host, "Generic report, %d bytes, %d fields decoded in %u cycles",
+                len, n, (unsigned)t);
+#else
         _usbh_dbgf(hidp->dev->host, "Generic report, %d bytes", len);
+#endif
     }
 }
 
@@ -955,11 +959,13 @@ int main(void) {
 #endif
 
     for(;;) {
+#if !HAL_USBH_USE_MAIN_THREAD
 #if STM32_USBH_USE_OTG1
         usbhMainLoop(&USBHD1);
 #endif
 #if STM32_USBH_USE_OTG2
         usbhMainLoop(&USBHD2);
+#endif
 #endif
         chThdSleepMilliseconds(100);
 
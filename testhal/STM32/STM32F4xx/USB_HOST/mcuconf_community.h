@@ -105,6 +105,10 @@
 
 #define STM32_USBH_MIN_QSPACE               4
 #define STM32_USBH_CHANNELS_NP              4
+#define STM32_USBH_NAK_BACKOFF_FRAMES       1
+#define STM32_USBH_NP_SLICE_FRAMES          4
+#define STM32_USBH_PERIODIC_BUDGET          1350
+#define STM32_USBH_LATENCY_HISTOGRAM        FALSE
 
 /*
  * CRC driver system settings.
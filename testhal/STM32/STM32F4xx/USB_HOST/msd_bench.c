@@ -0,0 +1,145 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+#include "msd_bench.h"
+
+#if HAL_USE_USBH && HAL_USBH_USE_MSD
+
+#include "usbh/debug.h"     /* for _usbh_dbg/_usbh_dbgf */
+
+static uint32_t bench_buf[MSD_BENCH_SEQ_REQ_SZ / sizeof(uint32_t)];
+static uint32_t bench_seed;
+
+static uint32_t _rand(void) {
+    /* xorshift32 */
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 17;
+    bench_seed ^= bench_seed << 5;
+    return bench_seed;
+}
+
+static void _report(USBHDriver *host, const char *test, uint64_t bytes, systime_t st) {
+    uint32_t ms = TIME_I2MS(chVTTimeElapsedSinceX(st));
+    uint32_t kBps;
+
+    if (ms == 0)
+        ms = 1;
+    kBps = (uint32_t)((bytes * 1000U) / ((uint64_t)ms * 1024U));
+    _usbh_dbgf(host, "BENCH: %s: %u kB in %u ms, %u.%02u MB/s",
+            test, (uint32_t)(bytes / 1024U), ms,
+            kBps / 1024U, ((kBps % 1024U) * 100U) / 1024U);
+}
+
+static bool _seq(USBHMassStorageLUNDriver *lunp, bool write) {
+    USBHDriver *const host = usbhmsdLUNGetHost(lunp);
+    const uint32_t nblocks = MSD_BENCH_SEQ_REQ_SZ / lunp->info.blk_size;
+    uint32_t reqs = (MSD_BENCH_SEQ_SZ_MB * 1024UL * 1024UL) / MSD_BENCH_SEQ_REQ_SZ;
+    uint32_t start = 0;
+    uint64_t bytes = 0;
+    systime_t st;
+
+    if (reqs * nblocks > lunp->info.blk_num)
+        reqs = lunp->info.blk_num / nblocks;
+
+    st = chVTGetSystemTime();
+    while (reqs--) {
+        if (write) {
+            /* the read is not accounted */
+            systime_t rst = chVTGetSystemTime();
+            if (blkRead(lunp, start, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+            st = chTimeAddX(st, chVTTimeElapsedSinceX(rst));
+            if (blkWrite(lunp, start, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+        } else {
+            if (blkRead(lunp, start, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+        }
+        start += nblocks;
+        bytes += MSD_BENCH_SEQ_REQ_SZ;
+    }
+    _report(host, write ? "Sequential write" : "Sequential read", bytes, st);
+    return HAL_SUCCESS;
+}
+
+static bool _rnd(USBHMassStorageLUNDriver *lunp, bool write) {
+    USBHDriver *const host = usbhmsdLUNGetHost(lunp);
+    const uint32_t nblocks = MSD_BENCH_RND_REQ_SZ / lunp->info.blk_size;
+    const uint32_t slots = lunp->info.blk_num / nblocks;
+    uint64_t bytes = 0;
+    uint32_t i, blk;
+    systime_t st;
+
+    bench_seed = 0x2545F491;
+    st = chVTGetSystemTime();
+    for (i = 0; i < MSD_BENCH_RND_REQS; i++) {
+        blk = (_rand() % slots) * nblocks;
+        if (write) {
+            systime_t rst = chVTGetSystemTime();
+            if (blkRead(lunp, blk, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+            st = chTimeAddX(st, chVTTimeElapsedSinceX(rst));
+            if (blkWrite(lunp, blk, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+        } else {
+            if (blkRead(lunp, blk, (uint8_t *)bench_buf, nblocks) != HAL_SUCCESS)
+                return HAL_FAILED;
+        }
+        bytes += MSD_BENCH_RND_REQ_SZ;
+    }
+    _report(host, write ? "Random 4k write" : "Random 4k read", bytes, st);
+    return HAL_SUCCESS;
+}
+
+bool msdBenchRun(USBHMassStorageLUNDriver *lunp) {
+    USBHDriver *const host = usbhmsdLUNGetHost(lunp);
+    tprio_t prio;
+    bool ret = HAL_FAILED;
+
+    if ((lunp->info.blk_size == 0)
+            || (MSD_BENCH_SEQ_REQ_SZ % lunp->info.blk_size)
+            || (MSD_BENCH_RND_REQ_SZ % lunp->info.blk_size)
+            || (lunp->info.blk_num < MSD_BENCH_SEQ_REQ_SZ / lunp->info.blk_size)) {
+        _usbh_dbg(host, "BENCH: Unsupported block size");
+        return HAL_FAILED;
+    }
+
+    _usbh_dbgf(host, "BENCH: Pipeline %s",
+            HAL_USBHMSD_USE_PIPELINE ? "enabled" : "disabled");
+
+    prio = chThdSetPriority(HIGHPRIO);
+    if (_seq(lunp, FALSE) != HAL_SUCCESS)
+        goto exit;
+    if (_rnd(lunp, FALSE) != HAL_SUCCESS)
+        goto exit;
+#if MSD_BENCH_WRITE
+    if (_seq(lunp, TRUE) != HAL_SUCCESS)
+        goto exit;
+    if (_rnd(lunp, TRUE) != HAL_SUCCESS)
+        goto exit;
+#endif
+    ret = HAL_SUCCESS;
+
+exit:
+    chThdSetPriority(prio);
+    if (ret != HAL_SUCCESS)
+        _usbh_dbg(host, "BENCH: I/O error");
+    return ret;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+    ChibiOS-Contrib - Copyright (C) 2026
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef MSD_BENCH_H_
+#define MSD_BENCH_H_
+
+#include "hal_usbh.h"
+
+#if HAL_USE_USBH && HAL_USBH_USE_MSD
+
+#include "usbh/dev/msd.h"
+
+/* Data moved by each sequential test */
+#define MSD_BENCH_SEQ_SZ_MB                 4
+
+/* Size of the requests of the sequential tests */
+#define MSD_BENCH_SEQ_REQ_SZ                16384
+
+/* Number of requests of the random tests */
+#define MSD_BENCH_RND_REQS                  256
+
+/* Size of the requests of the random tests */
+#define MSD_BENCH_RND_REQ_SZ                4096
+
+/* Write tests write back what they have just read, the medium content is
+ * preserved unless the device is unplugged during the test */
+#define MSD_BENCH_WRITE                     TRUE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    bool msdBenchRun(USBHMassStorageLUNDriver *lunp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif /* MSD_BENCH_H_ */
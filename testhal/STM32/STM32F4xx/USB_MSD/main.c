@@ -50,7 +50,7 @@ static THD_FUNCTION(Thread1, arg) {
 
 RamDisk ramdisk;
 __attribute__((section("DATA_RAM"))) static uint8_t ramdisk_storage[RAMDISK_BLOCK_SIZE * RAMDISK_BLOCK_CNT];
-static uint8_t blkbuf[RAMDISK_BLOCK_SIZE];
+static uint8_t blkbuf[RAMDISK_BLOCK_SIZE * 8];
 
 BaseSequentialStream *GlobalDebugChannel;
 
@@ -102,7 +102,8 @@ int main(void) {
    * start mass storage
    */
   msdObjectInit(&USBMSD1);
-  msdStart(&USBMSD1, &USBD1, (BaseBlockDevice *)&ramdisk, blkbuf, NULL, NULL);
+  msdStart(&USBMSD1, &USBD1, (BaseBlockDevice *)&ramdisk, blkbuf, sizeof(blkbuf),
+           NULL, NULL);
 
   /*
    *
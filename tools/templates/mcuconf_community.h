@@ -114,6 +114,10 @@
 
 #define STM32_USBH_MIN_QSPACE               4
 #define STM32_USBH_CHANNELS_NP              4
+#define STM32_USBH_NAK_BACKOFF_FRAMES       0
+#define STM32_USBH_NP_SLICE_FRAMES          4
+#define STM32_USBH_PERIODIC_BUDGET          1350
+#define STM32_USBH_LATENCY_HISTOGRAM        FALSE
 
 /*
  * CRC driver system settings.
@@ -127,6 +131,7 @@
 #define CRCSW_CRC32_TABLE                   TRUE
 #define CRCSW_CRC16_TABLE                   TRUE
 #define CRCSW_PROGRAMMABLE                  TRUE
+#define CRCSW_SLICING                       1
 
 /*
  * EICU driver system settings.